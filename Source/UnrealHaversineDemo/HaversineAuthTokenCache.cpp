@@ -0,0 +1,392 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineAuthTokenCache.cpp
+// UnrealHaversineDemo
+//
+// Fetches SkyGolf authentication tokens ahead of the swings that need them
+//
+
+#include "HaversineAuthTokenCache.h"
+#include "SuperTagKitPlugin.h"
+#include "SuperTagAuthenticationManager.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarHaversineAuthTokenLifetimeSeconds(
+	TEXT("haversine.Auth.TokenLifetimeSeconds"),
+	3600.0f,
+	TEXT("How long a fetched authentication token is used before it is fetched again."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineAuthRefreshMarginSeconds(
+	TEXT("haversine.Auth.RefreshMarginSeconds"),
+	300.0f,
+	TEXT("Authentication tokens are refreshed this long before they expire."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineAuthRetryIntervalSeconds(
+	TEXT("haversine.Auth.RetryIntervalSeconds"),
+	2.0f,
+	TEXT("Delay between attempts to fetch a token SuperTagKit does not have yet."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineAuthFetchTimeoutSeconds(
+	TEXT("haversine.Auth.FetchTimeoutSeconds"),
+	30.0f,
+	TEXT("A token fetch that has not succeeded after this long fails, and swings waiting on it are discarded."),
+	ECVF_ReadOnly);
+
+// How often the refresh timer looks for due retries and expiring tokens, in seconds.
+static constexpr float TokenTickIntervalSeconds = 0.25f;
+
+FHaversineAuthTokenCacheConfig FHaversineAuthTokenCacheConfig::FromConsoleVariables()
+{
+	FHaversineAuthTokenCacheConfig Result;
+	Result.TokenLifetimeSeconds = FMath::Max(1.0f, CVarHaversineAuthTokenLifetimeSeconds.GetValueOnAnyThread());
+	Result.RefreshMarginSeconds = FMath::Clamp(CVarHaversineAuthRefreshMarginSeconds.GetValueOnAnyThread(), 0.0f, Result.TokenLifetimeSeconds * 0.5f);
+	Result.RetryIntervalSeconds = FMath::Max(0.1f, CVarHaversineAuthRetryIntervalSeconds.GetValueOnAnyThread());
+	Result.FetchTimeoutSeconds = FMath::Max(Result.RetryIntervalSeconds, CVarHaversineAuthFetchTimeoutSeconds.GetValueOnAnyThread());
+	return Result;
+}
+
+FHaversineAuthTokenCache::FHaversineAuthTokenCache(USuperTagAuthenticationManager* InAuthManager, const FHaversineAuthTokenCacheConfig& InConfig)
+	: AuthManager(InAuthManager)
+	, Config(InConfig)
+{
+}
+
+FHaversineAuthTokenCache::~FHaversineAuthTokenCache()
+{
+	Shutdown();
+}
+
+void FHaversineAuthTokenCache::Start()
+{
+	check(IsInGameThread());
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateSP(AsShared(), &FHaversineAuthTokenCache::Tick), TokenTickIntervalSeconds);
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Auth token cache started: %.0f s lifetime, refreshed %.0f s early, fetches time out after %.0f s"),
+		Config.TokenLifetimeSeconds, Config.RefreshMarginSeconds, Config.FetchTimeoutSeconds);
+}
+
+void FHaversineAuthTokenCache::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	TArray<TUniqueFunction<void()>> Parked;
+	{
+		FWriteScopeLock WriteLock(Lock);
+		if (bShutdown)
+		{
+			return;
+		}
+		bShutdown = true;
+
+		for (TPair<FString, FEntry>& Pair : Entries)
+		{
+			Parked.Append(MoveTemp(Pair.Value.Parked));
+			Pair.Value.Parked.Reset();
+		}
+	}
+
+	if (!Parked.IsEmpty())
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Auth token cache shutting down with %d swings still waiting for a token"), Parked.Num());
+	}
+
+	Released.fetch_add(Parked.Num(), std::memory_order_relaxed);
+	for (TUniqueFunction<void()>& Callback : Parked)
+	{
+		Callback();
+	}
+}
+
+bool FHaversineAuthTokenCache::BeginFetchLocked(FEntry& Entry, double NowSeconds, bool bRefreshIfExpiring)
+{
+	if (bShutdown || Entry.bFetchInFlight || NowSeconds < Entry.RetryNotBeforeSeconds)
+	{
+		return false;
+	}
+
+	const bool bValid = !Entry.Token.IsEmpty() && NowSeconds < Entry.ExpirySeconds;
+	const bool bExpiring = NowSeconds >= Entry.ExpirySeconds - Config.RefreshMarginSeconds;
+	if (bValid && !(bRefreshIfExpiring && bExpiring))
+	{
+		return false;
+	}
+
+	(bValid ? Refreshes : Fetches).fetch_add(1, std::memory_order_relaxed);
+	Entry.bFetchInFlight = true;
+	Entry.bAttemptRunning = true;
+	Entry.FetchStartedSeconds = NowSeconds;
+	return true;
+}
+
+EHaversineTokenLookup FHaversineAuthTokenCache::Lookup(const FString& HardwareId, FString& OutToken)
+{
+	const double NowSeconds = FPlatformTime::Seconds();
+	{
+		FReadScopeLock ReadLock(Lock);
+		const FEntry* Entry = Entries.Find(HardwareId);
+		if (Entry && !Entry->Token.IsEmpty() && NowSeconds < Entry->ExpirySeconds)
+		{
+			Hits.fetch_add(1, std::memory_order_relaxed);
+			OutToken = Entry->Token;
+			return EHaversineTokenLookup::Found;
+		}
+	}
+
+	Misses.fetch_add(1, std::memory_order_relaxed);
+
+	EHaversineTokenLookup Result = EHaversineTokenLookup::Unavailable;
+	bool bLaunch = false;
+	{
+		FWriteScopeLock WriteLock(Lock);
+
+		// The token may have arrived between the two locks
+		FEntry& Entry = Entries.FindOrAdd(HardwareId);
+		if (!Entry.Token.IsEmpty() && NowSeconds < Entry.ExpirySeconds)
+		{
+			OutToken = Entry.Token;
+			return EHaversineTokenLookup::Found;
+		}
+
+		// After shutdown nobody would resume a parked caller, so report in-flight fetches as unavailable
+		bLaunch = BeginFetchLocked(Entry, NowSeconds, false);
+		Result = Entry.bFetchInFlight && !bShutdown ? EHaversineTokenLookup::Pending : EHaversineTokenLookup::Unavailable;
+	}
+
+	if (bLaunch)
+	{
+		LaunchAttempt(HardwareId);
+	}
+	return Result;
+}
+
+void FHaversineAuthTokenCache::WhenFetched(const FString& HardwareId, TUniqueFunction<void()>&& Callback)
+{
+	{
+		FWriteScopeLock WriteLock(Lock);
+		FEntry* Entry = Entries.Find(HardwareId);
+		if (!bShutdown && Entry && Entry->bFetchInFlight)
+		{
+			Entry->Parked.Add(MoveTemp(Callback));
+			return;
+		}
+	}
+
+	// The fetch finished before the caller got here
+	Resumed.fetch_add(1, std::memory_order_relaxed);
+	Callback();
+}
+
+void FHaversineAuthTokenCache::AssociateSatellite(const FString& SatelliteId, const FString& HardwareId)
+{
+	{
+		FReadScopeLock ReadLock(Lock);
+		const FString* Known = HardwareIdsBySatellite.Find(SatelliteId);
+		if (Known && *Known == HardwareId)
+		{
+			return;
+		}
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+	HardwareIdsBySatellite.Add(SatelliteId, HardwareId);
+}
+
+void FHaversineAuthTokenCache::PrefetchForSatellite(const FString& SatelliteId)
+{
+	const double NowSeconds = FPlatformTime::Seconds();
+
+	// Satellites are seen many times a second while scanning; only take the write lock if there is work to do
+	FString HardwareId;
+	{
+		FReadScopeLock ReadLock(Lock);
+		const FString* Known = HardwareIdsBySatellite.Find(SatelliteId);
+		if (bShutdown || !Known)
+		{
+			return;
+		}
+		HardwareId = *Known;
+
+		const FEntry* Entry = Entries.Find(HardwareId);
+		if (Entry && (Entry->bFetchInFlight || NowSeconds < Entry->RetryNotBeforeSeconds
+			|| (!Entry->Token.IsEmpty() && NowSeconds < Entry->ExpirySeconds - Config.RefreshMarginSeconds)))
+		{
+			return;
+		}
+	}
+
+	bool bLaunch = false;
+	{
+		FWriteScopeLock WriteLock(Lock);
+		bLaunch = BeginFetchLocked(Entries.FindOrAdd(HardwareId), NowSeconds, true);
+	}
+
+	if (bLaunch)
+	{
+		LaunchAttempt(HardwareId);
+	}
+}
+
+bool FHaversineAuthTokenCache::Tick(float DeltaTime)
+{
+	const double NowSeconds = FPlatformTime::Seconds();
+
+	TArray<FString> Due;
+	{
+		FWriteScopeLock WriteLock(Lock);
+		for (TPair<FString, FEntry>& Pair : Entries)
+		{
+			FEntry& Entry = Pair.Value;
+			if (Entry.bFetchInFlight)
+			{
+				if (!Entry.bAttemptRunning && NowSeconds >= Entry.NextAttemptSeconds)
+				{
+					Entry.bAttemptRunning = true;
+					Due.Add(Pair.Key);
+				}
+			}
+			else if (!Entry.Token.IsEmpty() && NowSeconds < Entry.ExpirySeconds && BeginFetchLocked(Entry, NowSeconds, true))
+			{
+				Due.Add(Pair.Key);
+			}
+		}
+	}
+
+	for (const FString& HardwareId : Due)
+	{
+		LaunchAttempt(HardwareId);
+	}
+	return true;
+}
+
+void FHaversineAuthTokenCache::LaunchAttempt(const FString& HardwareId)
+{
+	// SuperTagKit may go to the network for a token, so never call it on the thread that asked
+	TWeakPtr<FHaversineAuthTokenCache, ESPMode::ThreadSafe> WeakThis = AsShared();
+	Async(EAsyncExecution::ThreadPool, [WeakThis, HardwareId]()
+	{
+		if (TSharedPtr<FHaversineAuthTokenCache, ESPMode::ThreadSafe> This = WeakThis.Pin())
+		{
+			This->RunAttempt(HardwareId);
+		}
+	});
+}
+
+void FHaversineAuthTokenCache::RunAttempt(const FString& HardwareId)
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const FString Token = AuthManager ? AuthManager->CachedAuthenticationToken(HardwareId) : FString();
+	AttemptCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+	Attempts.fetch_add(1, std::memory_order_relaxed);
+
+	CompleteAttempt(HardwareId, Token);
+}
+
+void FHaversineAuthTokenCache::CompleteAttempt(const FString& HardwareId, const FString& Token)
+{
+	const double NowSeconds = FPlatformTime::Seconds();
+
+	TArray<TUniqueFunction<void()>> Parked;
+	bool bFailed = false;
+	{
+		FWriteScopeLock WriteLock(Lock);
+		FEntry* Entry = Entries.Find(HardwareId);
+		if (!Entry)
+		{
+			return;
+		}
+		Entry->bAttemptRunning = false;
+
+		if (!Token.IsEmpty())
+		{
+			Entry->Token = Token;
+			Entry->ExpirySeconds = NowSeconds + Config.TokenLifetimeSeconds;
+			Entry->bFetchInFlight = false;
+		}
+		else if (bShutdown)
+		{
+			Entry->bFetchInFlight = false;
+		}
+		else if (NowSeconds - Entry->FetchStartedSeconds >= Config.FetchTimeoutSeconds)
+		{
+			// A refresh that fails leaves the current token in place until it expires
+			Entry->bFetchInFlight = false;
+			Entry->RetryNotBeforeSeconds = NowSeconds + Config.RetryIntervalSeconds;
+			bFailed = true;
+		}
+		else
+		{
+			// Try again from the timer
+			Entry->NextAttemptSeconds = NowSeconds + Config.RetryIntervalSeconds;
+			return;
+		}
+
+		Parked = MoveTemp(Entry->Parked);
+		Entry->Parked.Reset();
+	}
+
+	if (bFailed)
+	{
+		FetchFailures.fetch_add(1, std::memory_order_relaxed);
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ No authentication token for hardware %s after %.0f s"),
+			*HardwareId, Config.FetchTimeoutSeconds);
+	}
+
+	(bFailed ? Released : Resumed).fetch_add(Parked.Num(), std::memory_order_relaxed);
+	for (TUniqueFunction<void()>& Callback : Parked)
+	{
+		Callback();
+	}
+}
+
+FHaversineAuthTokenCacheStats FHaversineAuthTokenCache::GetStats() const
+{
+	const double NowSeconds = FPlatformTime::Seconds();
+
+	FHaversineAuthTokenCacheStats Stats;
+	{
+		FReadScopeLock ReadLock(Lock);
+		for (const TPair<FString, FEntry>& Pair : Entries)
+		{
+			Stats.Tokens += !Pair.Value.Token.IsEmpty() && NowSeconds < Pair.Value.ExpirySeconds ? 1 : 0;
+			Stats.FetchesInFlight += Pair.Value.bFetchInFlight ? 1 : 0;
+			Stats.Parked += Pair.Value.Parked.Num();
+		}
+	}
+	Stats.Hits = Hits.load(std::memory_order_relaxed);
+	Stats.Misses = Misses.load(std::memory_order_relaxed);
+	Stats.Fetches = Fetches.load(std::memory_order_relaxed);
+	Stats.Refreshes = Refreshes.load(std::memory_order_relaxed);
+	Stats.FetchFailures = FetchFailures.load(std::memory_order_relaxed);
+	Stats.Resumed = Resumed.load(std::memory_order_relaxed);
+	Stats.Released = Released.load(std::memory_order_relaxed);
+
+	const uint64 NumAttempts = Attempts.load(std::memory_order_relaxed);
+	if (NumAttempts > 0)
+	{
+		Stats.AverageAttemptMs = FPlatformTime::ToMilliseconds64(AttemptCycles.load(std::memory_order_relaxed)) / NumAttempts;
+	}
+	return Stats;
+}
+
+void FHaversineAuthTokenCache::LogStats() const
+{
+	const FHaversineAuthTokenCacheStats Stats = GetStats();
+	const uint64 Lookups = Stats.Hits + Stats.Misses;
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Auth token cache stats: %d tokens, %d fetching, %d swings parked | hits=%llu misses=%llu (%.1f%% hit rate) | fetches=%llu refreshes=%llu failed=%llu | resumed=%llu released=%llu | attempt avg %.1f ms"),
+		Stats.Tokens, Stats.FetchesInFlight, Stats.Parked, Stats.Hits, Stats.Misses, Lookups > 0 ? 100.0 * Stats.Hits / Lookups : 0.0,
+		Stats.Fetches, Stats.Refreshes, Stats.FetchFailures, Stats.Resumed, Stats.Released, Stats.AverageAttemptMs);
+}
@@ -0,0 +1,153 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Misc/ScopeRWLock.h"
+#include <atomic>
+
+class USuperTagAuthenticationManager;
+
+struct FHaversineAuthTokenCacheConfig
+{
+	/** How long a fetched token is trusted before it must be fetched again */
+	float TokenLifetimeSeconds = 3600.0f;
+
+	/** Tokens are refreshed this long before they expire, so readers never see a gap */
+	float RefreshMarginSeconds = 300.0f;
+
+	/** Delay between attempts while SuperTagKit has no token for a hardware ID yet */
+	float RetryIntervalSeconds = 2.0f;
+
+	/** A fetch that has produced no token after this long fails, and swings parked on it are released */
+	float FetchTimeoutSeconds = 30.0f;
+
+	/** Reads `haversine.Auth.*` console variables */
+	static FHaversineAuthTokenCacheConfig FromConsoleVariables();
+};
+
+/** Point-in-time counters for `FHaversineAuthTokenCache` */
+struct FHaversineAuthTokenCacheStats
+{
+	int32 Tokens = 0;
+	int32 FetchesInFlight = 0;
+	int32 Parked = 0;
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Fetches = 0;
+	uint64 Refreshes = 0;
+	uint64 FetchFailures = 0;
+
+	/** Parked callers run because their token arrived */
+	uint64 Resumed = 0;
+
+	/** Parked callers run without a token, because the fetch failed or the cache shut down */
+	uint64 Released = 0;
+
+	/** Time one call into SuperTagKit takes */
+	double AverageAttemptMs = 0.0;
+};
+
+enum class EHaversineTokenLookup : uint8
+{
+	Found,			// A valid token was returned
+	Pending,		// A fetch is in flight; park the caller with `WhenFetched`
+	Unavailable,	// The last fetch failed and no retry is due yet
+};
+
+/**
+ * SkyGolf authentication tokens per hardware ID, fetched ahead of time.
+ *
+ * Fetches run on the thread pool, never on the SDK or game thread. Once a satellite's hardware ID is known, seeing
+ * the satellite again (discovery or a state update) is enough to start fetching its token, so it is normally cached
+ * before the satellite connects. A timer refreshes tokens `RefreshMarginSeconds` before they expire; the old token
+ * stays readable until the new one replaces it.
+ *
+ * `Lookup` takes a shared read lock and copies a string, so worker threads can call it per swing. A caller that finds
+ * a fetch in flight parks a callback with `WhenFetched` instead of giving up.
+ *
+ * Create with MakeShared and call `Start` before use; fetches hold only weak references to the cache.
+ */
+class FHaversineAuthTokenCache : public TSharedFromThis<FHaversineAuthTokenCache, ESPMode::ThreadSafe>
+{
+public:
+	FHaversineAuthTokenCache(USuperTagAuthenticationManager* InAuthManager, const FHaversineAuthTokenCacheConfig& InConfig);
+	~FHaversineAuthTokenCache();
+
+	FHaversineAuthTokenCache(const FHaversineAuthTokenCache&) = delete;
+	FHaversineAuthTokenCache& operator=(const FHaversineAuthTokenCache&) = delete;
+
+	/** Starts the refresh timer. Must be called on the game thread. */
+	void Start();
+
+	/** Stops the refresh timer and releases every parked callback. Cached tokens stay readable, but nothing new is fetched. */
+	void Shutdown();
+
+	/**
+	 * Look up the token for a hardware ID. Safe to call from any thread.
+	 * Starts a fetch if there is no usable token and none is in flight.
+	 */
+	EHaversineTokenLookup Lookup(const FString& HardwareId, FString& OutToken);
+
+	/**
+	 * Run `Callback` once the fetch in flight for this hardware ID completes, successfully or not.
+	 * Runs it immediately, on the calling thread, if no fetch is in flight.
+	 */
+	void WhenFetched(const FString& HardwareId, TUniqueFunction<void()>&& Callback);
+
+	/** Remember which hardware ID a satellite reports, so its token can be prefetched when it is next seen */
+	void AssociateSatellite(const FString& SatelliteId, const FString& HardwareId);
+
+	/** Start fetching the satellite's token if its hardware ID is known and the token is missing or expiring */
+	void PrefetchForSatellite(const FString& SatelliteId);
+
+	FHaversineAuthTokenCacheStats GetStats() const;
+	void LogStats() const;
+
+private:
+	struct FEntry
+	{
+		FString Token;
+		double ExpirySeconds = 0.0;
+
+		/** Set from the first attempt until a token arrives or the fetch times out */
+		bool bFetchInFlight = false;
+		bool bAttemptRunning = false;
+		double FetchStartedSeconds = 0.0;
+		double NextAttemptSeconds = 0.0;
+
+		/** After a failed fetch, lookups return `Unavailable` until this time instead of fetching again */
+		double RetryNotBeforeSeconds = 0.0;
+
+		TArray<TUniqueFunction<void()>> Parked;
+	};
+
+	bool Tick(float DeltaTime);
+
+	/** @return true if the caller must launch an attempt for this entry, which is then marked in flight */
+	bool BeginFetchLocked(FEntry& Entry, double NowSeconds, bool bRefreshIfExpiring);
+	void LaunchAttempt(const FString& HardwareId);
+	void RunAttempt(const FString& HardwareId);
+	void CompleteAttempt(const FString& HardwareId, const FString& Token);
+
+	USuperTagAuthenticationManager* AuthManager;
+	FHaversineAuthTokenCacheConfig Config;
+
+	mutable FRWLock Lock;
+	TMap<FString, FEntry> Entries;
+	TMap<FString, FString> HardwareIdsBySatellite;
+	bool bShutdown = false;
+
+	std::atomic<uint64> Hits{0};
+	std::atomic<uint64> Misses{0};
+	std::atomic<uint64> Fetches{0};
+	std::atomic<uint64> Refreshes{0};
+	std::atomic<uint64> FetchFailures{0};
+	std::atomic<uint64> Resumed{0};
+	std::atomic<uint64> Released{0};
+	std::atomic<uint64> Attempts{0};
+	std::atomic<uint64> AttemptCycles{0};
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};
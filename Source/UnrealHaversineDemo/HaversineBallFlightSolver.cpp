@@ -0,0 +1,191 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineBallFlightSolver.cpp
+// UnrealHaversineDemo
+//
+// Batched fixed-step golf ball flight: drag, Magnus lift and spin decay
+//
+
+#include "HaversineBallFlightSolver.h"
+
+namespace
+{
+	// USGA ball and sea-level air
+	constexpr float BallMassKg = 0.04593f;
+	constexpr float BallRadiusM = 0.021335f;
+	constexpr float AirDensity = 1.225f;
+	constexpr float Gravity = 9.81f;
+
+	/** Spin loses about 4% per second in flight */
+	constexpr float SpinDecayPerSecond = 0.04f;
+
+	/** 0.5 * rho * A / m: turns a coefficient times v^2 into an acceleration */
+	constexpr float AeroFactor = 0.5f * AirDensity * UE_PI * BallRadiusM * BallRadiusM / BallMassKg;
+
+	/** A ball slower than this (a putt, a mishit) is treated as landed rather than simulated */
+	constexpr float MinSpeed = 0.1f;
+
+	struct FClubLaunch
+	{
+		const TCHAR* Keyword;
+		float SmashFactor;
+		float LaunchDegrees;
+		float SpinRpm;
+	};
+
+	// Typical tour-average launch figures, matched by a keyword in the club name
+	const FClubLaunch ClubLaunches[] =
+	{
+		{ TEXT("Driver"),	1.48f, 11.0f, 2700.0f },
+		{ TEXT("Wood"),		1.46f, 9.5f,  3600.0f },
+		{ TEXT("Hybrid"),	1.42f, 10.5f, 4400.0f },
+		{ TEXT("Wedge"),	1.25f, 26.0f, 9000.0f },
+		{ TEXT("Putter"),	1.00f, 2.0f,  0.0f },
+		{ TEXT("Iron"),		1.36f, 16.0f, 6000.0f },
+	};
+	const FClubLaunch DefaultClubLaunch = { TEXT(""), 1.36f, 16.0f, 6000.0f };
+
+	/** Sideways tilt of the spin axis; a gentle draw for right-handers and its mirror for left-handers */
+	constexpr float SpinAxisTiltDegrees = 4.0f;
+}
+
+FHaversineBallLaunch FHaversineBallLaunchEstimate::FromSwing(float ClubheadSpeedMph, const FString& Club, bool bRightHanded, const FVector3f& Forward, const FVector3f& Up)
+{
+	const FClubLaunch* Match = &DefaultClubLaunch;
+	for (const FClubLaunch& Candidate : ClubLaunches)
+	{
+		if (Club.Contains(Candidate.Keyword))
+		{
+			Match = &Candidate;
+			break;
+		}
+	}
+
+	const FVector3f Side = FVector3f::CrossProduct(Forward, Up);	// Horizontal, perpendicular to the target line
+	const float LaunchRadians = FMath::DegreesToRadians(Match->LaunchDegrees);
+	const float TiltRadians = FMath::DegreesToRadians(bRightHanded ? -SpinAxisTiltDegrees : SpinAxisTiltDegrees);
+
+	FHaversineBallLaunch Launch;
+	Launch.Speed = FMath::Max(0.0f, ClubheadSpeedMph) * 0.44704f * Match->SmashFactor;
+	Launch.Direction = (Forward * FMath::Cos(LaunchRadians) + Up * FMath::Sin(LaunchRadians)).GetSafeNormal();
+
+	// Backspin is about `Side`; tilting it toward `Up` turns some of the lift sideways
+	Launch.SpinAxis = (Side * FMath::Cos(TiltRadians) + Up * FMath::Sin(TiltRadians)).GetSafeNormal();
+	Launch.SpinRpm = Match->SpinRpm;
+	return Launch;
+}
+
+FHaversineBallFlightSolver::FHaversineBallFlightSolver(int32 InCapacity, float InStepHz)
+	: Capacity(FMath::Max(1, InCapacity))
+	, StepSeconds(1.0f / FMath::Clamp(InStepHz, 30.0f, 2000.0f))
+{
+	for (TArray<float>* Column : { &PosX, &PosY, &PosZ, &VelX, &VelY, &VelZ, &AxisX, &AxisY, &AxisZ, &Omega, &FlightTime })
+	{
+		Column->SetNumZeroed(Capacity);
+	}
+	Airborne.SetNumZeroed(Capacity);
+}
+
+void FHaversineBallFlightSolver::Launch(int32 Slot, const FHaversineBallLaunch& InLaunch)
+{
+	check(Slot >= 0 && Slot < Capacity);
+	if (!Airborne[Slot])
+	{
+		++NumInFlight;
+	}
+
+	const FVector3f Velocity = InLaunch.Direction.GetSafeNormal() * InLaunch.Speed;
+	const FVector3f Axis = InLaunch.SpinAxis.GetSafeNormal();
+	PosX[Slot] = 0.0f;
+	PosY[Slot] = 0.0f;
+	PosZ[Slot] = 0.0f;
+	VelX[Slot] = Velocity.X;
+	VelY[Slot] = Velocity.Y;
+	VelZ[Slot] = Velocity.Z;
+	AxisX[Slot] = Axis.X;
+	AxisY[Slot] = Axis.Y;
+	AxisZ[Slot] = Axis.Z;
+	Omega[Slot] = InLaunch.SpinRpm * (2.0f * UE_PI / 60.0f);
+	FlightTime[Slot] = 0.0f;
+	Airborne[Slot] = 1;
+}
+
+void FHaversineBallFlightSolver::Remove(int32 Slot)
+{
+	check(Slot >= 0 && Slot < Capacity);
+	if (Airborne[Slot])
+	{
+		Airborne[Slot] = 0;
+		--NumInFlight;
+	}
+}
+
+int32 FHaversineBallFlightSolver::Advance(float DeltaSeconds, TArray<int32>& OutLanded)
+{
+	// A long hitch is not worth catching up on step by step; the balls just lose that time
+	Accumulator = FMath::Min(Accumulator + FMath::Max(0.0f, DeltaSeconds), 0.25f);
+
+	int32 NumSteps = 0;
+	while (Accumulator >= StepSeconds)
+	{
+		Accumulator -= StepSeconds;
+		if (NumInFlight > 0)
+		{
+			Step(StepSeconds, OutLanded);
+		}
+		++NumSteps;
+	}
+	return NumSteps;
+}
+
+void FHaversineBallFlightSolver::Step(float Dt, TArray<int32>& OutLanded)
+{
+	const float SpinDecay = FMath::Max(0.0f, 1.0f - SpinDecayPerSecond * Dt);
+
+	for (int32 Slot = 0; Slot < Capacity; ++Slot)
+	{
+		if (!Airborne[Slot])
+		{
+			continue;
+		}
+
+		const float Vx = VelX[Slot];
+		const float Vy = VelY[Slot];
+		const float Vz = VelZ[Slot];
+		const float Speed = FMath::Sqrt(Vx * Vx + Vy * Vy + Vz * Vz);
+		const float InvSpeed = Speed > UE_KINDA_SMALL_NUMBER ? 1.0f / Speed : 0.0f;
+
+		// Drag and lift coefficients from the spin ratio (surface speed over air speed), fitted to wind-tunnel data
+		const float SpinRatio = FMath::Min(Omega[Slot] * BallRadiusM * InvSpeed, 0.5f);
+		const float Cd = 0.171f + 0.62f * SpinRatio;
+		const float Cl = SpinRatio < 0.3f ? SpinRatio * (1.99f - 3.25f * SpinRatio) : 0.305f;
+
+		// Drag opposes velocity: a = -k Cd |v| v
+		const float DragScale = -AeroFactor * Cd * Speed;
+
+		// Lift is along axis x v-hat with magnitude k Cl |v|^2, i.e. k Cl |v| (axis x v)
+		const float LiftScale = AeroFactor * Cl * Speed;
+		const float Lx = AxisY[Slot] * Vz - AxisZ[Slot] * Vy;
+		const float Ly = AxisZ[Slot] * Vx - AxisX[Slot] * Vz;
+		const float Lz = AxisX[Slot] * Vy - AxisY[Slot] * Vx;
+
+		// Semi-implicit Euler: new velocity, then position from it
+		VelX[Slot] = Vx + (DragScale * Vx + LiftScale * Lx) * Dt;
+		VelY[Slot] = Vy + (DragScale * Vy + LiftScale * Ly) * Dt;
+		VelZ[Slot] = Vz + (DragScale * Vz + LiftScale * Lz - Gravity) * Dt;
+		PosX[Slot] += VelX[Slot] * Dt;
+		PosY[Slot] += VelY[Slot] * Dt;
+		PosZ[Slot] += VelZ[Slot] * Dt;
+		Omega[Slot] *= SpinDecay;
+		FlightTime[Slot] += Dt;
+
+		if ((PosZ[Slot] <= 0.0f && VelZ[Slot] < 0.0f) || Speed < MinSpeed)
+		{
+			PosZ[Slot] = 0.0f;
+			Airborne[Slot] = 0;
+			--NumInFlight;
+			OutLanded.Add(Slot);
+		}
+	}
+}
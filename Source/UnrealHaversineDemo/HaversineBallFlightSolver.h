@@ -0,0 +1,89 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** How a ball leaves the club. Directions are unit vectors in world space (Z up). */
+struct FHaversineBallLaunch
+{
+	/** Ball speed in m/s */
+	float Speed = 0.0f;
+
+	/** Direction of travel at launch */
+	FVector3f Direction = FVector3f::ForwardVector;
+
+	/** Spin axis (right-hand rule); horizontal and perpendicular to the target line for pure backspin */
+	FVector3f SpinAxis = -FVector3f::RightVector;
+
+	/** Spin rate in revolutions per minute */
+	float SpinRpm = 0.0f;
+};
+
+/**
+ * Ball launch conditions estimated from what a swing reports: clubhead speed, club and handedness.
+ * A coarse per-club table (smash factor, launch angle, backspin), not a launch monitor.
+ */
+struct FHaversineBallLaunchEstimate
+{
+	/** @param Forward horizontal target line; @param Up world up */
+	static FHaversineBallLaunch FromSwing(float ClubheadSpeedMph, const FString& Club, bool bRightHanded, const FVector3f& Forward, const FVector3f& Up);
+};
+
+/**
+ * Fixed-step flight model for many golf balls at once: gravity, quadratic drag, Magnus lift and spin decay.
+ *
+ * Balls live in structure-of-arrays slots and every airborne ball is advanced by the same loop, so a frame with
+ * dozens of balls in the air costs one pass per step over a few contiguous float arrays instead of dozens of
+ * movement components. The step is fixed (`haversine.Balls.StepHz`) and independent of the frame rate; leftover
+ * time carries into the next `Advance`, so trajectories are the same at 30 and 144 fps.
+ *
+ * Positions are in metres relative to each ball's launch point, with the ground at Z = 0. Not thread-safe.
+ */
+class FHaversineBallFlightSolver
+{
+public:
+	explicit FHaversineBallFlightSolver(int32 InCapacity, float InStepHz = 240.0f);
+
+	int32 GetCapacity() const { return Capacity; }
+
+	/** Put a ball in flight in `Slot`, replacing whatever was there */
+	void Launch(int32 Slot, const FHaversineBallLaunch& Launch);
+
+	/** Take the ball in `Slot` out of the simulation */
+	void Remove(int32 Slot);
+
+	/**
+	 * Advance every airborne ball by whole fixed steps covering `DeltaSeconds`.
+	 * @param OutLanded slots whose ball reached the ground during this call
+	 * @return number of fixed steps taken
+	 */
+	int32 Advance(float DeltaSeconds, TArray<int32>& OutLanded);
+
+	bool IsAirborne(int32 Slot) const { return Airborne[Slot] != 0; }
+	int32 NumAirborne() const { return NumInFlight; }
+
+	/** Metres from the launch point */
+	FVector3f GetPosition(int32 Slot) const { return FVector3f(PosX[Slot], PosY[Slot], PosZ[Slot]); }
+	FVector3f GetVelocity(int32 Slot) const { return FVector3f(VelX[Slot], VelY[Slot], VelZ[Slot]); }
+
+	/** Seconds since launch */
+	float GetFlightTime(int32 Slot) const { return FlightTime[Slot]; }
+
+private:
+	void Step(float Dt, TArray<int32>& OutLanded);
+
+	int32 Capacity;
+	float StepSeconds;
+	float Accumulator = 0.0f;
+	int32 NumInFlight = 0;
+
+	TArray<float> PosX, PosY, PosZ;
+	TArray<float> VelX, VelY, VelZ;
+
+	/** Unit spin axis and angular speed in rad/s */
+	TArray<float> AxisX, AxisY, AxisZ;
+	TArray<float> Omega;
+	TArray<float> FlightTime;
+	TArray<uint8> Airborne;
+};
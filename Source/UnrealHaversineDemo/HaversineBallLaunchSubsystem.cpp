@@ -0,0 +1,351 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineBallLaunchSubsystem.cpp
+// UnrealHaversineDemo
+//
+// Launches pooled balls from processed swings and flies them with the batched solver
+//
+
+#include "HaversineBallLaunchSubsystem.h"
+#include "HaversineDemoSubsystem.h"
+#include "UnrealHaversineDemoProjectile.h"
+#include "SuperTagKitPlugin.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+
+static TAutoConsoleVariable<int32> CVarHaversineBallsPoolSize(
+	TEXT("haversine.Balls.PoolSize"),
+	64,
+	TEXT("Balls spawned when the world begins play and reused for every swing; 0 disables swing ball launches. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineBallsStepHz(
+	TEXT("haversine.Balls.StepHz"),
+	240.0f,
+	TEXT("Fixed step rate of the ball flight solver. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineBallsLingerSeconds(
+	TEXT("haversine.Balls.LingerSeconds"),
+	3.0f,
+	TEXT("How long a landed ball stays visible before it goes back to the pool. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineBallsBaySpacing(
+	TEXT("haversine.Balls.BaySpacing"),
+	300.0f,
+	TEXT("Distance in cm between the tees of consecutive satellites. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<FString> CVarHaversineBallsProjectileClass(
+	TEXT("haversine.Balls.ProjectileClass"),
+	TEXT("/Game/FirstPerson/Blueprints/BP_FirstPersonProjectile.BP_FirstPersonProjectile_C"),
+	TEXT("Projectile class pooled for swing balls; the C++ projectile (no mesh) is used if it cannot be loaded. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+namespace
+{
+	/** Where pooled balls wait, out of sight */
+	const FVector PoolParkingLocation(0.0, 0.0, -100000.0);
+
+	constexpr double MetersToUnits = 100.0;
+}
+
+bool UHaversineBallLaunchSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHaversineBallLaunchSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	const int32 PoolSize = CVarHaversineBallsPoolSize.GetValueOnGameThread();
+	if (PoolSize <= 0)
+	{
+		return;
+	}
+
+	LingerSeconds = CVarHaversineBallsLingerSeconds.GetValueOnGameThread();
+	BaySpacing = CVarHaversineBallsBaySpacing.GetValueOnGameThread();
+	Solver = MakeUnique<FHaversineBallFlightSolver>(PoolSize, CVarHaversineBallsStepHz.GetValueOnGameThread());
+	SpawnPool();
+
+	UGameInstance* GameInstance = InWorld.GetGameInstance();
+	if (UHaversineDemoSubsystem* Haversine = GameInstance ? GameInstance->GetSubsystem<UHaversineDemoSubsystem>() : nullptr)
+	{
+		Haversine->OnSwingsProcessed.AddDynamic(this, &UHaversineBallLaunchSubsystem::OnSwingsProcessed);
+	}
+}
+
+void UHaversineBallLaunchSubsystem::Deinitialize()
+{
+	const UWorld* World = GetWorld();
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	if (UHaversineDemoSubsystem* Haversine = GameInstance ? GameInstance->GetSubsystem<UHaversineDemoSubsystem>() : nullptr)
+	{
+		Haversine->OnSwingsProcessed.RemoveDynamic(this, &UHaversineBallLaunchSubsystem::OnSwingsProcessed);
+	}
+
+	if (Solver)
+	{
+		LogStats();
+	}
+
+	// The actors belong to the world and go with it
+	Solver.Reset();
+	Balls.Reset();
+	FreeSlots.Reset();
+	PooledActors.Reset();
+
+	Super::Deinitialize();
+}
+
+void UHaversineBallLaunchSubsystem::SpawnPool()
+{
+	UWorld* World = GetWorld();
+	TSubclassOf<AUnrealHaversineDemoProjectile> BallClass = LoadClass<AUnrealHaversineDemoProjectile>(nullptr, *CVarHaversineBallsProjectileClass.GetValueOnGameThread());
+	if (!BallClass)
+	{
+		BallClass = AUnrealHaversineDemoProjectile::StaticClass();
+	}
+
+	const FTransform ParkingTransform(FRotator::ZeroRotator, PoolParkingLocation);
+
+	const int32 Capacity = Solver->GetCapacity();
+	Balls.SetNum(Capacity);
+	PooledActors.Reserve(Capacity);
+	FreeSlots.Reserve(Capacity);
+	for (int32 Slot = Capacity - 1; Slot >= 0; --Slot)
+	{
+		// The pool is spawned before the world's actors begin play, and `AActor::BeginPlay` would then arm the
+		// projectile's default lifespan and destroy the ball a few seconds in. Pooled balls never expire.
+		AUnrealHaversineDemoProjectile* Ball = World->SpawnActorDeferred<AUnrealHaversineDemoProjectile>(BallClass, ParkingTransform,
+			nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		if (!Ball)
+		{
+			continue;
+		}
+		Ball->InitialLifeSpan = 0.0f;
+		Ball->FinishSpawning(ParkingTransform);
+		Ball->ReturnToPool();
+		Balls[Slot].Actor = Ball;
+		PooledActors.Add(Ball);
+		FreeSlots.Add(Slot);
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("✓ Ball pool ready: %d x %s"), FreeSlots.Num(), *BallClass->GetName());
+}
+
+void UHaversineBallLaunchSubsystem::OnSwingsProcessed(const TArray<FHaversineSwingEvent>& Swings)
+{
+	for (const FHaversineSwingEvent& Swing : Swings)
+	{
+		LaunchBall(Swing);
+	}
+}
+
+void UHaversineBallLaunchSubsystem::GetTee(const FString& SatelliteId, FVector& OutLocation, FVector& OutForward) const
+{
+	const UWorld* World = GetWorld();
+
+	// Tees line up to the right of the first player, facing where they face
+	FVector Origin = FVector::ZeroVector;
+	FVector Forward = FVector::ForwardVector;
+	if (const APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0))
+	{
+		Forward = Player->GetActorForwardVector().GetSafeNormal2D();
+		Origin = Player->GetActorLocation() + Forward * 200.0;
+	}
+	const FVector Right = FVector::CrossProduct(FVector::UpVector, Forward);
+
+	int32 Bay = 0;
+	const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	if (const UHaversineDemoSubsystem* Haversine = GameInstance ? GameInstance->GetSubsystem<UHaversineDemoSubsystem>() : nullptr)
+	{
+		FHaversineSatelliteRegistry::FReadScope Snapshot(Haversine->GetSatelliteRegistry());
+		Bay = FMath::Max(0, Snapshot->IndexOf(SatelliteId));
+	}
+	Origin += Right * (BaySpacing * Bay);
+
+	// Tee up on whatever is below
+	FHitResult Hit;
+	if (World && World->LineTraceSingleByChannel(Hit, Origin + FVector(0.0, 0.0, 200.0), Origin - FVector(0.0, 0.0, 2000.0), ECC_Visibility))
+	{
+		Origin = Hit.ImpactPoint + FVector(0.0, 0.0, 5.0);
+	}
+
+	OutLocation = Origin;
+	OutForward = Forward;
+}
+
+void UHaversineBallLaunchSubsystem::LaunchBall(const FHaversineSwingEvent& Swing)
+{
+	if (!Solver)
+	{
+		return;
+	}
+
+	const int32 Slot = AcquireSlot();
+	AUnrealHaversineDemoProjectile* Ball = Slot != INDEX_NONE ? Balls[Slot].Actor.Get() : nullptr;
+	if (!Ball)
+	{
+		return;
+	}
+
+	FVector Origin;
+	FVector Forward;
+	GetTee(Swing.SatelliteId, Origin, Forward);
+
+	const FHaversineBallLaunch Launch = FHaversineBallLaunchEstimate::FromSwing(Swing.ClubheadSpeedMph, Swing.Club, Swing.bRightHanded,
+		FVector3f(Forward), FVector3f::UpVector);
+	Solver->Launch(Slot, Launch);
+	Ball->TakeFromPool(Origin);
+
+	FBall& Entry = Balls[Slot];
+	Entry.Origin = Origin;
+	Entry.LaunchSeconds = GetWorld()->GetTimeSeconds();
+	Entry.ReturnSeconds = 0.0;
+	Entry.bInUse = true;
+	++Launched;
+}
+
+int32 UHaversineBallLaunchSubsystem::AcquireSlot()
+{
+	if (!FreeSlots.IsEmpty())
+	{
+		return FreeSlots.Pop(EAllowShrinking::No);
+	}
+
+	// Every ball is out: reuse one that has landed and is only lingering, or else the one launched longest ago
+	int32 Oldest = INDEX_NONE;
+	int32 OldestLanded = INDEX_NONE;
+	for (int32 Slot = 0; Slot < Balls.Num(); ++Slot)
+	{
+		if (!Balls[Slot].bInUse)
+		{
+			continue;
+		}
+		if (Oldest == INDEX_NONE || Balls[Slot].LaunchSeconds < Balls[Oldest].LaunchSeconds)
+		{
+			Oldest = Slot;
+		}
+		if (!Solver->IsAirborne(Slot) && (OldestLanded == INDEX_NONE || Balls[Slot].LaunchSeconds < Balls[OldestLanded].LaunchSeconds))
+		{
+			OldestLanded = Slot;
+		}
+	}
+
+	const int32 Reused = OldestLanded != INDEX_NONE ? OldestLanded : Oldest;
+	if (Reused != INDEX_NONE)
+	{
+		Recycled += Solver->IsAirborne(Reused) ? 1 : 0;
+		Solver->Remove(Reused);
+	}
+	return Reused;
+}
+
+void UHaversineBallLaunchSubsystem::ReleaseSlot(int32 Slot)
+{
+	FBall& Entry = Balls[Slot];
+	Solver->Remove(Slot);
+	if (AUnrealHaversineDemoProjectile* Ball = Entry.Actor.Get())
+	{
+		Ball->SetActorLocation(PoolParkingLocation);
+		Ball->ReturnToPool();
+	}
+	Entry.bInUse = false;
+	Entry.ReturnSeconds = 0.0;
+	FreeSlots.Add(Slot);
+}
+
+void UHaversineBallLaunchSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if (!Solver || Launched == 0)
+	{
+		return;
+	}
+
+	LandedScratch.Reset();
+	Solver->Advance(DeltaTime, LandedScratch);
+	const double NowSeconds = GetWorld()->GetTimeSeconds();
+
+	for (const int32 Slot : LandedScratch)
+	{
+		const FVector3f Position = Solver->GetPosition(Slot);
+		LongestCarryMeters = FMath::Max(LongestCarryMeters, static_cast<double>(FVector2f(Position.X, Position.Y).Size()));
+		Balls[Slot].ReturnSeconds = NowSeconds + LingerSeconds;
+		++Landed;
+	}
+
+	// Copy the solver's positions to the actors; landed balls get their final position once
+	for (int32 Slot = 0; Slot < Balls.Num(); ++Slot)
+	{
+		FBall& Entry = Balls[Slot];
+		if (!Entry.bInUse)
+		{
+			continue;
+		}
+
+		if (Entry.ReturnSeconds > 0.0 && NowSeconds >= Entry.ReturnSeconds)
+		{
+			ReleaseSlot(Slot);
+			continue;
+		}
+
+		const bool bMoved = Solver->IsAirborne(Slot) || LandedScratch.Contains(Slot);
+		AUnrealHaversineDemoProjectile* Ball = Entry.Actor.Get();
+		if (bMoved && Ball)
+		{
+			Ball->SetActorLocation(Entry.Origin + FVector(Solver->GetPosition(Slot)) * MetersToUnits);
+		}
+	}
+}
+
+TStatId UHaversineBallLaunchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHaversineBallLaunchSubsystem, STATGROUP_Tickables);
+}
+
+void UHaversineBallLaunchSubsystem::LogStats() const
+{
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Ball launch stats: launched=%llu landed=%llu recycled-in-flight=%llu | airborne=%d free=%d of %d | longest carry %.1f m"),
+		Launched, Landed, Recycled, Solver ? Solver->NumAirborne() : 0, FreeSlots.Num(), Balls.Num(), LongestCarryMeters);
+}
+
+//
+// Console commands
+//
+
+static FAutoConsoleCommandWithWorldAndArgs HaversineBallsLaunchCommand(
+	TEXT("haversine.Balls.Launch"),
+	TEXT("Launches a ball as if a swing had been processed. Args: [Mph=100] [Club=Driver] [R|L]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UHaversineBallLaunchSubsystem* Balls = World ? World->GetSubsystem<UHaversineBallLaunchSubsystem>() : nullptr)
+		{
+			FHaversineSwingEvent Swing;
+			Swing.SatelliteId = TEXT("CONSOLE");
+			Swing.ClubheadSpeedMph = Args.IsValidIndex(0) ? FCString::Atof(*Args[0]) : 100.0f;
+			Swing.Club = Args.IsValidIndex(1) ? Args[1] : TEXT("Driver");
+			Swing.bRightHanded = !Args.IsValidIndex(2) || !Args[2].Equals(TEXT("L"), ESearchCase::IgnoreCase);
+			Balls->LaunchBall(Swing);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs HaversineBallsStatsCommand(
+	TEXT("haversine.Balls.Stats"),
+	TEXT("Logs swing ball launches, pool usage and the longest carry."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (const UHaversineBallLaunchSubsystem* Balls = World ? World->GetSubsystem<UHaversineBallLaunchSubsystem>() : nullptr)
+		{
+			Balls->LogStats();
+		}
+	}));
@@ -0,0 +1,88 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HaversineBallFlightSolver.h"
+#include "HaversineBlueprintTypes.h"
+#include "HaversineBallLaunchSubsystem.generated.h"
+
+class AUnrealHaversineDemoProjectile;
+
+/**
+ * Turns every processed swing into a ball flight in the game world.
+ *
+ * Balls are projectiles spawned once, when the world begins play (`haversine.Balls.PoolSize`), and parked hidden
+ * between shots; a swing takes one from the pool and a landed ball goes back after `haversine.Balls.LingerSeconds`.
+ * Nothing is spawned or destroyed per shot, so bursts of swings cause no spawn or garbage collection hitches. If every
+ * ball is in use, a landed one still lingering is reused first, and otherwise the one launched longest ago.
+ *
+ * Flight is computed by `FHaversineBallFlightSolver` for all airborne balls together at a fixed step, and the pool
+ * only copies positions to the actors. Each satellite gets its own tee, `haversine.Balls.BaySpacing` apart along a
+ * line to the right of the first player, in the order satellites were discovered.
+ */
+UCLASS()
+class UNREALHAVERSINEDEMO_API UHaversineBallLaunchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Deinitialize() override;
+
+	// UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Launch a ball as this swing would have hit it */
+	UFUNCTION(BlueprintCallable, Category = "Haversine")
+	void LaunchBall(const FHaversineSwingEvent& Swing);
+
+	/** Where this satellite's balls are launched from (world space, on the ground) and the horizontal target line */
+	void GetTee(const FString& SatelliteId, FVector& OutLocation, FVector& OutForward) const;
+
+	void LogStats() const;
+
+protected:
+	// UWorldSubsystem interface
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FBall
+	{
+		TWeakObjectPtr<AUnrealHaversineDemoProjectile> Actor;
+		FVector Origin = FVector::ZeroVector;
+		double LaunchSeconds = 0.0;
+
+		/** When a landed ball goes back to the pool; 0 while in flight or pooled */
+		double ReturnSeconds = 0.0;
+		bool bInUse = false;
+	};
+
+	UFUNCTION()
+	void OnSwingsProcessed(const TArray<FHaversineSwingEvent>& Swings);
+
+	void SpawnPool();
+	int32 AcquireSlot();
+	void ReleaseSlot(int32 Slot);
+
+	TUniquePtr<FHaversineBallFlightSolver> Solver;
+	TArray<FBall> Balls;
+	TArray<int32> FreeSlots;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AUnrealHaversineDemoProjectile>> PooledActors;
+
+	TArray<int32> LandedScratch;
+	float LingerSeconds = 3.0f;
+	double BaySpacing = 300.0;
+
+	uint64 Launched = 0;
+	uint64 Landed = 0;
+	uint64 Recycled = 0;
+	double LongestCarryMeters = 0.0;
+};
@@ -0,0 +1,165 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineBlueprintEventBatcher.cpp
+// UnrealHaversineDemo
+//
+// Gathers Blueprint-facing events from any thread and delivers them once per frame
+//
+
+#include "HaversineBlueprintEventBatcher.h"
+#include "SuperTagKitPlugin.h"
+
+namespace
+{
+	FHaversineSatelliteEvent MakeSatelliteEvent(const FHaversineSatelliteSnapshot& Satellite)
+	{
+		FHaversineSatelliteEvent Event;
+		Event.SatelliteId = Satellite.SatelliteId;
+		Event.Name = Satellite.Name;
+		Event.FirmwareVersionMajor = Satellite.FirmwareVersionMajor;
+		Event.FirmwareVersionMinor = Satellite.FirmwareVersionMinor;
+		Event.CollectionCount = Satellite.CollectionCount;
+		Event.bInCollectionState = Satellite.bInCollectionState;
+		Event.bIsMoving = Satellite.bIsMoving;
+		Event.bIsDark = Satellite.bIsDark;
+		Event.bNeedsServicing = Satellite.bNeedsServicing;
+		return Event;
+	}
+}
+
+FHaversineBlueprintEventBatcher::FHaversineBlueprintEventBatcher(FBroadcast InBroadcast)
+	: Broadcast(MoveTemp(InBroadcast))
+{
+}
+
+FHaversineBlueprintEventBatcher::~FHaversineBlueprintEventBatcher()
+{
+	Shutdown();
+}
+
+void FHaversineBlueprintEventBatcher::Start()
+{
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FHaversineBlueprintEventBatcher::Tick), 0.0f);
+	}
+}
+
+void FHaversineBlueprintEventBatcher::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	FScopeLock Lock(&Mutex);
+	Pending = FHaversineBlueprintEventBatch();
+	PendingChangeBySatellite.Reset();
+	PendingDiscoveryBySatellite.Reset();
+}
+
+void FHaversineBlueprintEventBatcher::AddSwing(FHaversineSwingEvent&& Swing)
+{
+	Events.fetch_add(1, std::memory_order_relaxed);
+	FScopeLock Lock(&Mutex);
+	Pending.Swings.Add(MoveTemp(Swing));
+}
+
+void FHaversineBlueprintEventBatcher::AddSatellite(const FHaversineSatelliteSnapshot& Satellite, bool bDiscovered)
+{
+	Events.fetch_add(1, std::memory_order_relaxed);
+	FHaversineSatelliteEvent Event = MakeSatelliteEvent(Satellite);
+
+	FScopeLock Lock(&Mutex);
+	bool bAlreadyDiscovered = true;
+	if (bDiscovered)
+	{
+		DiscoveredSatelliteIds.Add(Satellite.SatelliteId, &bAlreadyDiscovered);
+	}
+	if (!bAlreadyDiscovered)
+	{
+		PendingDiscoveryBySatellite.Add(Satellite.SatelliteId, Pending.DiscoveredSatellites.Num());
+		Pending.DiscoveredSatellites.Add(MoveTemp(Event));
+		return;
+	}
+
+	// A satellite whose discovery has not gone out yet is announced with its latest state rather than also reported as changed
+	const bool bDiscoveryPending = PendingDiscoveryBySatellite.Contains(Satellite.SatelliteId);
+	TArray<FHaversineSatelliteEvent>& Target = bDiscoveryPending ? Pending.DiscoveredSatellites : Pending.ChangedSatellites;
+	const TMap<FString, int32>& Indices = bDiscoveryPending ? PendingDiscoveryBySatellite : PendingChangeBySatellite;
+	if (const int32* Index = Indices.Find(Satellite.SatelliteId))
+	{
+		// Keep the name from an earlier update if this one has none
+		if (Event.Name.IsEmpty())
+		{
+			Event.Name = MoveTemp(Target[*Index].Name);
+		}
+		Target[*Index] = MoveTemp(Event);
+		Coalesced.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	PendingChangeBySatellite.Add(Satellite.SatelliteId, Pending.ChangedSatellites.Num());
+	Pending.ChangedSatellites.Add(MoveTemp(Event));
+}
+
+void FHaversineBlueprintEventBatcher::AddTransferFailure(const FString& SatelliteId, uint16 CollectionIndex, const FString& Error)
+{
+	Events.fetch_add(1, std::memory_order_relaxed);
+	FHaversineTransferFailedEvent Event;
+	Event.SatelliteId = SatelliteId;
+	Event.CollectionIndex = CollectionIndex;
+	Event.Error = Error;
+
+	FScopeLock Lock(&Mutex);
+	Pending.TransferFailures.Add(MoveTemp(Event));
+}
+
+bool FHaversineBlueprintEventBatcher::Tick(float DeltaTime)
+{
+	FHaversineBlueprintEventBatch Batch;
+	{
+		FScopeLock Lock(&Mutex);
+		if (Pending.IsEmpty())
+		{
+			return true;
+		}
+		Batch = MoveTemp(Pending);
+		Pending = FHaversineBlueprintEventBatch();
+		PendingChangeBySatellite.Reset();
+		PendingDiscoveryBySatellite.Reset();
+	}
+
+	// Handlers run outside the lock, so they may cause more events without deadlocking; those go out next frame
+	const int32 NumEvents = Batch.Swings.Num() + Batch.DiscoveredSatellites.Num() + Batch.ChangedSatellites.Num() + Batch.TransferFailures.Num();
+	Batches.fetch_add(1, std::memory_order_relaxed);
+	int32 PreviousMax = MaxBatchEvents.load(std::memory_order_relaxed);
+	while (NumEvents > PreviousMax
+		&& !MaxBatchEvents.compare_exchange_weak(PreviousMax, NumEvents, std::memory_order_relaxed))
+	{
+	}
+
+	Broadcast(Batch);
+	return true;
+}
+
+FHaversineBlueprintEventBatcherStats FHaversineBlueprintEventBatcher::GetStats() const
+{
+	FHaversineBlueprintEventBatcherStats Stats;
+	Stats.Events = Events.load(std::memory_order_relaxed);
+	Stats.Coalesced = Coalesced.load(std::memory_order_relaxed);
+	Stats.Batches = Batches.load(std::memory_order_relaxed);
+	Stats.MaxBatchEvents = MaxBatchEvents.load(std::memory_order_relaxed);
+	return Stats;
+}
+
+void FHaversineBlueprintEventBatcher::LogStats() const
+{
+	const FHaversineBlueprintEventBatcherStats Stats = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Blueprint event stats: events=%llu coalesced=%llu | batches=%llu (%.1f events each, max %d)"),
+		Stats.Events, Stats.Coalesced, Stats.Batches,
+		Stats.Batches > 0 ? static_cast<double>(Stats.Events - Stats.Coalesced) / Stats.Batches : 0.0, Stats.MaxBatchEvents);
+}
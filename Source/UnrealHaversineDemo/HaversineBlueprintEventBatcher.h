@@ -0,0 +1,92 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineBlueprintTypes.h"
+#include "HaversineFleetEvents.h"
+#include "Containers/Ticker.h"
+#include <atomic>
+
+/** Everything that happened during one frame, oldest first within each kind */
+struct FHaversineBlueprintEventBatch
+{
+	TArray<FHaversineSwingEvent> Swings;
+
+	/** Satellites reported for the first time this session, one entry each with its latest state */
+	TArray<FHaversineSatelliteEvent> DiscoveredSatellites;
+
+	/** Latest state of each satellite that changed; one entry per satellite however many updates arrived */
+	TArray<FHaversineSatelliteEvent> ChangedSatellites;
+	TArray<FHaversineTransferFailedEvent> TransferFailures;
+
+	bool IsEmpty() const
+	{
+		return Swings.IsEmpty() && DiscoveredSatellites.IsEmpty() && ChangedSatellites.IsEmpty() && TransferFailures.IsEmpty();
+	}
+};
+
+/** Point-in-time counters for `FHaversineBlueprintEventBatcher` */
+struct FHaversineBlueprintEventBatcherStats
+{
+	uint64 Events = 0;
+
+	/** State changes and repeat discoveries folded into one already waiting for the same satellite */
+	uint64 Coalesced = 0;
+
+	/** Frames that had something to broadcast, and the most events any one of them carried */
+	uint64 Batches = 0;
+	int32 MaxBatchEvents = 0;
+};
+
+/**
+ * Collects swing, satellite and transfer events for Blueprint and hands them to the game thread once per frame.
+ *
+ * Events arrive from the pipeline workers, the SDK's threads and the game thread, sometimes hundreds per second from a
+ * large fleet. Broadcasting each one would run every bound Blueprint graph that many times. Instead they are gathered
+ * under a short lock and delivered as one batch per kind per frame, and repeated state changes for a satellite within
+ * a frame collapse into its latest state. The SDK reports a satellite as discovered every time it is seen again, so
+ * only the first discovery this session is delivered as one; later ones are treated as state changes. `Add*` methods
+ * are thread-safe; the batch is delivered on the game thread.
+ */
+class FHaversineBlueprintEventBatcher
+{
+public:
+	using FBroadcast = TFunction<void(const FHaversineBlueprintEventBatch& Batch)>;
+
+	explicit FHaversineBlueprintEventBatcher(FBroadcast InBroadcast);
+	~FHaversineBlueprintEventBatcher();
+
+	/** Start delivering batches. Must be called on the game thread. */
+	void Start();
+
+	/** Stop delivering. Events not yet delivered are discarded. */
+	void Shutdown();
+
+	void AddSwing(FHaversineSwingEvent&& Swing);
+	void AddSatellite(const FHaversineSatelliteSnapshot& Satellite, bool bDiscovered);
+	void AddTransferFailure(const FString& SatelliteId, uint16 CollectionIndex, const FString& Error);
+
+	FHaversineBlueprintEventBatcherStats GetStats() const;
+	void LogStats() const;
+
+private:
+	bool Tick(float DeltaTime);
+
+	FBroadcast Broadcast;
+
+	FCriticalSection Mutex;
+	FHaversineBlueprintEventBatch Pending;
+	TMap<FString, int32> PendingChangeBySatellite;
+	TMap<FString, int32> PendingDiscoveryBySatellite;
+
+	/** Every satellite already delivered or waiting as a discovery */
+	TSet<FString> DiscoveredSatelliteIds;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	std::atomic<uint64> Events{0};
+	std::atomic<uint64> Coalesced{0};
+	std::atomic<uint64> Batches{0};
+	std::atomic<int32> MaxBatchEvents{0};
+};
@@ -0,0 +1,92 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineBlueprintTypes.generated.h"
+
+/** A swing that was reconstructed and queued for upload */
+USTRUCT(BlueprintType)
+struct FHaversineSwingEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	FString SatelliteId;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	int32 CollectionIndex = 0;
+
+	/** SkyGolf user the satellite belongs to, from its SuperTag metadata; 0 if not known yet */
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	int64 UserId = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	FString Club;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	float ClubheadSpeedMph = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	bool bRightHanded = true;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	int64 TimestampUnixMs = 0;
+};
+
+/** A satellite as last reported by discovery or a state update */
+USTRUCT(BlueprintType)
+struct FHaversineSatelliteEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	FString SatelliteId;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	FString Name;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	int32 FirmwareVersionMajor = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	int32 FirmwareVersionMinor = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	int32 CollectionCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	bool bInCollectionState = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	bool bIsMoving = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	bool bIsDark = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	bool bNeedsServicing = false;
+};
+
+/** A collection transfer that failed; the SDK retries it on a later connection */
+USTRUCT(BlueprintType)
+struct FHaversineTransferFailedEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	FString SatelliteId;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	int32 CollectionIndex = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Haversine")
+	FString Error;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FHaversineReadyDelegate);
+
+// Broadcast at most once per frame each, with everything that happened since the last broadcast, oldest first
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHaversineSwingsProcessedDelegate, const TArray<FHaversineSwingEvent>&, Swings);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHaversineSatellitesDelegate, const TArray<FHaversineSatelliteEvent>&, Satellites);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHaversineTransfersFailedDelegate, const TArray<FHaversineTransferFailedEvent>&, Failures);
@@ -0,0 +1,118 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+#include <atomic>
+
+/**
+ * Fixed-capacity, lock-free multi-producer/multi-consumer queue.
+ *
+ * Based on Dmitry Vyukov's bounded MPMC queue: every cell carries a sequence number that tells producers
+ * and consumers whether it is free to write or ready to read, so neither side ever takes a lock.
+ * Capacity is rounded up to a power of two. TryEnqueue fails instead of blocking when the queue is full,
+ * which is what gives the swing pipeline its back-pressure.
+ */
+template <typename T>
+class THaversineBoundedQueue
+{
+public:
+	explicit THaversineBoundedQueue(uint32 InCapacity)
+		: Capacity(FMath::RoundUpToPowerOfTwo(FMath::Max<uint32>(InCapacity, 2)))
+		, Mask(Capacity - 1)
+		, Cells(MakeUnique<FCell[]>(Capacity))
+	{
+		for (uint32 Index = 0; Index < Capacity; ++Index)
+		{
+			Cells[Index].Sequence.store(Index, std::memory_order_relaxed);
+		}
+		EnqueuePos.store(0, std::memory_order_relaxed);
+		DequeuePos.store(0, std::memory_order_relaxed);
+	}
+
+	THaversineBoundedQueue(const THaversineBoundedQueue&) = delete;
+	THaversineBoundedQueue& operator=(const THaversineBoundedQueue&) = delete;
+
+	/** Moves Value into the queue. Returns false (leaving Value untouched) if the queue is full. */
+	bool TryEnqueue(T&& Value)
+	{
+		uint64 Pos = EnqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			FCell& Cell = Cells[Pos & Mask];
+			const uint64 Sequence = Cell.Sequence.load(std::memory_order_acquire);
+			const int64 Diff = static_cast<int64>(Sequence) - static_cast<int64>(Pos);
+			if (Diff == 0)
+			{
+				if (EnqueuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					Cell.Value = MoveTemp(Value);
+					Cell.Sequence.store(Pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (Diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Pos = EnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/** Moves the oldest element into OutValue. Returns false if the queue is empty. */
+	bool TryDequeue(T& OutValue)
+	{
+		uint64 Pos = DequeuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			FCell& Cell = Cells[Pos & Mask];
+			const uint64 Sequence = Cell.Sequence.load(std::memory_order_acquire);
+			const int64 Diff = static_cast<int64>(Sequence) - static_cast<int64>(Pos + 1);
+			if (Diff == 0)
+			{
+				if (DequeuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					OutValue = MoveTemp(Cell.Value);
+					Cell.Sequence.store(Pos + Mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (Diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Pos = DequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/** Approximate number of queued elements; only meaningful for statistics. */
+	uint32 ApproximateNum() const
+	{
+		const uint64 Enqueued = EnqueuePos.load(std::memory_order_relaxed);
+		const uint64 Dequeued = DequeuePos.load(std::memory_order_relaxed);
+		return Enqueued > Dequeued ? static_cast<uint32>(Enqueued - Dequeued) : 0;
+	}
+
+	uint32 GetCapacity() const { return Capacity; }
+
+private:
+	struct alignas(PLATFORM_CACHE_LINE_SIZE) FCell
+	{
+		std::atomic<uint64> Sequence;
+		T Value;
+	};
+
+	const uint32 Capacity;
+	const uint64 Mask;
+	TUniquePtr<FCell[]> Cells;
+
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> EnqueuePos;
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> DequeuePos;
+};
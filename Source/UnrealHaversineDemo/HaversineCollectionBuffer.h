@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SharedPointer.h"
+#include <vector>
+
+class FHaversineCollectionBuffer;
+
+/** Shared handle to an immutable collection. Copying the handle never copies the bytes. */
+using FHaversineCollectionBufferRef = TSharedRef<const FHaversineCollectionBuffer, ESPMode::ThreadSafe>;
+using FHaversineCollectionBufferPtr = TSharedPtr<const FHaversineCollectionBuffer, ESPMode::ThreadSafe>;
+
+/**
+ * Raw bytes of one transferred collection (i.e. swing), allocated once and shared by every consumer.
+ *
+ * The SDK only lends its `std::vector` for the duration of `collection_transfer_did_finish`, so the bytes are copied
+ * into a buffer exactly once on arrival. The pipeline, swing reconstruction and the uploader then hold references to
+ * that one allocation, which is released when the last of them lets go. The buffer is never modified after creation,
+ * so it can be read from any number of threads without synchronisation.
+ */
+class FHaversineCollectionBuffer
+{
+public:
+	/** Prefer `Create`; public only so that `MakeShared` can allocate object and reference count together. */
+	explicit FHaversineCollectionBuffer(std::vector<uint8_t>&& InBytes)
+		: Bytes(MoveTemp(InBytes))
+	{
+	}
+
+	FHaversineCollectionBuffer(const FHaversineCollectionBuffer&) = delete;
+	FHaversineCollectionBuffer& operator=(const FHaversineCollectionBuffer&) = delete;
+
+	/** Copy bytes lent by the SDK into a new shared buffer */
+	static FHaversineCollectionBufferRef Create(const std::vector<uint8_t>& InBytes)
+	{
+		return MakeShared<FHaversineCollectionBuffer, ESPMode::ThreadSafe>(std::vector<uint8_t>(InBytes));
+	}
+
+	/** Adopt bytes we already own without copying them */
+	static FHaversineCollectionBufferRef Create(std::vector<uint8_t>&& InBytes)
+	{
+		return MakeShared<FHaversineCollectionBuffer, ESPMode::ThreadSafe>(MoveTemp(InBytes));
+	}
+
+	/** The bytes in the form the SuperTagKit swing APIs expect */
+	const std::vector<uint8_t>& GetBytes() const { return Bytes; }
+
+	/** Non-owning view of the bytes for engine-side consumers */
+	TConstArrayView<uint8> GetView() const { return TConstArrayView<uint8>(Bytes.data(), static_cast<int32>(Bytes.size())); }
+
+	int32 Num() const { return static_cast<int32>(Bytes.size()); }
+
+private:
+	const std::vector<uint8_t> Bytes;
+};
@@ -0,0 +1,300 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineConnectionScheduler.cpp
+// UnrealHaversineDemo
+//
+// Caps concurrent satellite connections and hands free slots to the satellites that need them most
+//
+
+#include "HaversineConnectionScheduler.h"
+#include "HaversineSatelliteStateCache.h"
+#include "SuperTagKitPlugin.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<int32> CVarHaversineSchedulerMaxConnections(
+	TEXT("haversine.Scheduler.MaxConnections"),
+	4,
+	TEXT("Satellites that may be connected at the same time. 0 disables the scheduler. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineSchedulerMaxWaitSeconds(
+	TEXT("haversine.Scheduler.MaxWaitSeconds"),
+	15.0f,
+	TEXT("A satellite waiting this long for a connection slot is admitted ahead of all others."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineSchedulerLeaseSeconds(
+	TEXT("haversine.Scheduler.LeaseSeconds"),
+	30.0f,
+	TEXT("A connection slot with no transfer activity for this long is reclaimed."),
+	ECVF_ReadOnly);
+
+FHaversineConnectionSchedulerConfig FHaversineConnectionSchedulerConfig::FromConsoleVariables()
+{
+	FHaversineConnectionSchedulerConfig Result;
+	Result.MaxConcurrentConnections = FMath::Max(0, CVarHaversineSchedulerMaxConnections.GetValueOnAnyThread());
+	Result.MaxWaitSeconds = FMath::Max(0.0f, CVarHaversineSchedulerMaxWaitSeconds.GetValueOnAnyThread());
+	Result.LeaseSeconds = FMath::Max(1.0f, CVarHaversineSchedulerLeaseSeconds.GetValueOnAnyThread());
+	return Result;
+}
+
+FHaversineConnectionScheduler::FHaversineConnectionScheduler(const FHaversineConnectionSchedulerConfig& InConfig, const FHaversineSatelliteStateCache* InStateCache)
+	: Config(InConfig)
+	, StateCache(InStateCache)
+{
+}
+
+FHaversineConnectionScheduler::FSatelliteEntry& FHaversineConnectionScheduler::FindOrAddLocked(const FString& SatelliteId)
+{
+	if (FSatelliteEntry* Existing = Satellites.Find(SatelliteId))
+	{
+		return *Existing;
+	}
+
+	FSatelliteEntry& Entry = Satellites.Add(SatelliteId);
+	FHaversineCachedSatelliteState Cached;
+	if (StateCache && StateCache->Find(SatelliteId, Cached) && Cached.bHasTransferred)
+	{
+		Entry.LastTransferUnixMs = Cached.LastTransferUnixMs;
+	}
+	return Entry;
+}
+
+void FHaversineConnectionScheduler::UpdateSatellite(const FString& SatelliteId, int32 PendingCollections, bool bInCollectionState)
+{
+	const double NowSeconds = FPlatformTime::Seconds();
+
+	FScopeLock Lock(&Mutex);
+	ForgetIdleLocked(NowSeconds);
+
+	FSatelliteEntry& Entry = FindOrAddLocked(SatelliteId);
+	Entry.PendingCollections = FMath::Max(0, PendingCollections);
+	Entry.bInCollectionState = bInCollectionState;
+	Entry.LastSeenSeconds = NowSeconds;
+}
+
+double FHaversineConnectionScheduler::ScoreLocked(const FSatelliteEntry& Entry, double NowSeconds, int64 NowUnixMs) const
+{
+	double Score = Config.PendingCollectionWeight * FMath::Min(Entry.PendingCollections, Config.MaxPendingCounted);
+
+	if (Entry.bInCollectionState)
+	{
+		Score += Config.InCollectionStateBonus;
+	}
+
+	// Never transferred counts as the oldest possible
+	const double TransferAgeMinutes = Entry.LastTransferUnixMs > 0
+		? (NowUnixMs - Entry.LastTransferUnixMs) / 60000.0
+		: Config.MaxTransferAgeMinutes;
+	Score += Config.TransferAgeWeightPerMinute * FMath::Clamp(TransferAgeMinutes, 0.0, Config.MaxTransferAgeMinutes);
+
+	if (Entry.WaitingSinceSeconds > 0.0)
+	{
+		Score += Config.WaitAgingPerSecond * (NowSeconds - Entry.WaitingSinceSeconds);
+	}
+	return Score;
+}
+
+bool FHaversineConnectionScheduler::TryAdmit(const FString& SatelliteId)
+{
+	if (Config.MaxConcurrentConnections <= 0)
+	{
+		return true;
+	}
+
+	const double NowSeconds = FPlatformTime::Seconds();
+	const int64 NowUnixMs = FHaversineSatelliteStateCache::NowUnixMs();
+
+	FScopeLock Lock(&Mutex);
+	ExpireLeasesLocked(NowSeconds);
+	ForgetIdleLocked(NowSeconds);
+
+	FSatelliteEntry& Entry = FindOrAddLocked(SatelliteId);
+	Entry.LastSeenSeconds = NowSeconds;
+	if (Entry.bConnected)
+	{
+		Entry.LeaseExpirySeconds = NowSeconds + Config.LeaseSeconds;
+		return true;
+	}
+
+	Entry.LastRequestSeconds = NowSeconds;
+	if (Entry.WaitingSinceSeconds <= 0.0)
+	{
+		Entry.WaitingSinceSeconds = NowSeconds;
+	}
+
+	const int32 FreeSlots = Config.MaxConcurrentConnections - NumConnected;
+	if (FreeSlots <= 0)
+	{
+		++Deferred;
+		return false;
+	}
+
+	// Count the waiting satellites that outrank this one. Starved satellites outrank everyone, oldest first.
+	const bool bStarved = NowSeconds - Entry.WaitingSinceSeconds >= Config.MaxWaitSeconds;
+	const double Score = ScoreLocked(Entry, NowSeconds, NowUnixMs);
+	int32 Outranked = 0;
+	for (const TPair<FString, FSatelliteEntry>& Pair : Satellites)
+	{
+		const FSatelliteEntry& Other = Pair.Value;
+		if (&Other == &Entry || Other.bConnected || Other.WaitingSinceSeconds <= 0.0
+			|| NowSeconds - Other.LastRequestSeconds > Config.RequestWindowSeconds)
+		{
+			continue;
+		}
+
+		const bool bOtherStarved = NowSeconds - Other.WaitingSinceSeconds >= Config.MaxWaitSeconds;
+		if (bStarved || bOtherStarved)
+		{
+			Outranked += bOtherStarved && (!bStarved || Other.WaitingSinceSeconds < Entry.WaitingSinceSeconds) ? 1 : 0;
+		}
+		else
+		{
+			Outranked += ScoreLocked(Other, NowSeconds, NowUnixMs) > Score ? 1 : 0;
+		}
+
+		if (Outranked >= FreeSlots)
+		{
+			++Deferred;
+			return false;
+		}
+	}
+
+	const double WaitSeconds = NowSeconds - Entry.WaitingSinceSeconds;
+	TotalAdmissionWaitSeconds += WaitSeconds;
+	MaxAdmissionWaitSeconds = FMath::Max(MaxAdmissionWaitSeconds, WaitSeconds);
+	StarvationAdmissions += bStarved ? 1 : 0;
+	++Admitted;
+
+	Entry.bConnected = true;
+	Entry.WaitingSinceSeconds = 0.0;
+	Entry.TransfersRemaining = 0;
+	Entry.LeaseExpirySeconds = NowSeconds + Config.LeaseSeconds;
+	++NumConnected;
+	return true;
+}
+
+void FHaversineConnectionScheduler::OnTransfersPlanned(const FString& SatelliteId, int32 NumCollections)
+{
+	FScopeLock Lock(&Mutex);
+	FSatelliteEntry* Entry = Satellites.Find(SatelliteId);
+	if (!Entry || !Entry->bConnected)
+	{
+		return;
+	}
+
+	Entry->TransfersRemaining = NumCollections;
+	Entry->LeaseExpirySeconds = FPlatformTime::Seconds() + Config.LeaseSeconds;
+	if (NumCollections <= 0)
+	{
+		ReleaseLocked(*Entry);
+	}
+}
+
+void FHaversineConnectionScheduler::OnTransferEnded(const FString& SatelliteId)
+{
+	FScopeLock Lock(&Mutex);
+	FSatelliteEntry* Entry = Satellites.Find(SatelliteId);
+	if (!Entry)
+	{
+		return;
+	}
+
+	Entry->LastTransferUnixMs = FHaversineSatelliteStateCache::NowUnixMs();
+	Entry->PendingCollections = FMath::Max(0, Entry->PendingCollections - 1);
+	if (Entry->bConnected)
+	{
+		Entry->LeaseExpirySeconds = FPlatformTime::Seconds() + Config.LeaseSeconds;
+		if (--Entry->TransfersRemaining <= 0)
+		{
+			ReleaseLocked(*Entry);
+		}
+	}
+}
+
+void FHaversineConnectionScheduler::OnTransferFailed(const FString& SatelliteId)
+{
+	FScopeLock Lock(&Mutex);
+	if (FSatelliteEntry* Entry = Satellites.Find(SatelliteId))
+	{
+		ReleaseLocked(*Entry);
+	}
+}
+
+void FHaversineConnectionScheduler::ReleaseLocked(FSatelliteEntry& Entry)
+{
+	if (Entry.bConnected)
+	{
+		Entry.bConnected = false;
+		Entry.TransfersRemaining = 0;
+		--NumConnected;
+	}
+}
+
+void FHaversineConnectionScheduler::ExpireLeasesLocked(double NowSeconds)
+{
+	if (NumConnected == 0)
+	{
+		return;
+	}
+
+	for (TPair<FString, FSatelliteEntry>& Pair : Satellites)
+	{
+		if (Pair.Value.bConnected && NowSeconds > Pair.Value.LeaseExpirySeconds)
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Connection slot for satellite %s expired without finishing its transfers"), *Pair.Key);
+			ReleaseLocked(Pair.Value);
+			++LeasesExpired;
+		}
+	}
+}
+
+void FHaversineConnectionScheduler::ForgetIdleLocked(double NowSeconds)
+{
+	// A full sweep now and then is plenty; entries only need to go before the map grows large
+	if (NowSeconds < NextForgetSeconds)
+	{
+		return;
+	}
+	NextForgetSeconds = NowSeconds + FMath::Min(Config.ForgetAfterSeconds, 10.0);
+
+	for (auto It = Satellites.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().bConnected && NowSeconds - It.Value().LastSeenSeconds > Config.ForgetAfterSeconds)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+FHaversineConnectionSchedulerStats FHaversineConnectionScheduler::GetStats() const
+{
+	const double NowSeconds = FPlatformTime::Seconds();
+
+	FScopeLock Lock(&Mutex);
+	FHaversineConnectionSchedulerStats Stats;
+	Stats.Connected = NumConnected;
+	for (const TPair<FString, FSatelliteEntry>& Pair : Satellites)
+	{
+		Stats.Waiting += !Pair.Value.bConnected && Pair.Value.WaitingSinceSeconds > 0.0
+			&& NowSeconds - Pair.Value.LastRequestSeconds <= Config.RequestWindowSeconds ? 1 : 0;
+	}
+	Stats.Admitted = Admitted;
+	Stats.Deferred = Deferred;
+	Stats.StarvationAdmissions = StarvationAdmissions;
+	Stats.LeasesExpired = LeasesExpired;
+	Stats.AverageAdmissionWaitMs = Admitted > 0 ? TotalAdmissionWaitSeconds * 1000.0 / Admitted : 0.0;
+	Stats.MaxAdmissionWaitMs = MaxAdmissionWaitSeconds * 1000.0;
+	return Stats;
+}
+
+void FHaversineConnectionScheduler::LogStats() const
+{
+	const FHaversineConnectionSchedulerStats Stats = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Connection scheduler stats (max %d): connected=%d waiting=%d | admitted=%llu deferred=%llu starved=%llu expired=%llu | admission wait avg %.1f ms max %.1f ms"),
+		Config.MaxConcurrentConnections, Stats.Connected, Stats.Waiting, Stats.Admitted, Stats.Deferred,
+		Stats.StarvationAdmissions, Stats.LeasesExpired, Stats.AverageAdmissionWaitMs, Stats.MaxAdmissionWaitMs);
+}
@@ -0,0 +1,136 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FHaversineSatelliteStateCache;
+
+/** Tuning for `FHaversineConnectionScheduler` */
+struct FHaversineConnectionSchedulerConfig
+{
+	/** Satellites that may be connected (transferring) at the same time */
+	int32 MaxConcurrentConnections = 4;
+
+	/** Score per pending collection, counted up to `MaxPendingCounted` */
+	double PendingCollectionWeight = 10.0;
+	int32 MaxPendingCounted = 16;
+
+	/** Score for a satellite that is recording a swing right now: its player is waiting at the screen */
+	double InCollectionStateBonus = 25.0;
+
+	/** Score per minute since the last transfer from this satellite, capped at `MaxTransferAgeMinutes` */
+	double TransferAgeWeightPerMinute = 1.0;
+	double MaxTransferAgeMinutes = 60.0;
+
+	/** Score per second spent waiting for a slot, so low scores still rise to the top eventually */
+	double WaitAgingPerSecond = 2.0;
+
+	/** A satellite that has waited this long is admitted before any other, oldest first */
+	double MaxWaitSeconds = 15.0;
+
+	/** A connection that reports nothing for this long is assumed gone and its slot reclaimed */
+	double LeaseSeconds = 30.0;
+
+	/** A satellite that has not asked to connect for this long is no longer considered waiting */
+	double RequestWindowSeconds = 5.0;
+
+	/** A satellite neither connected nor heard from for this long is forgotten; the state cache still has its history */
+	double ForgetAfterSeconds = 600.0;
+
+	/** Reads `haversine.Scheduler.*` console variables */
+	static FHaversineConnectionSchedulerConfig FromConsoleVariables();
+};
+
+/** Point-in-time counters for `FHaversineConnectionScheduler` */
+struct FHaversineConnectionSchedulerStats
+{
+	int32 Connected = 0;
+	int32 Waiting = 0;
+	uint64 Admitted = 0;
+	uint64 Deferred = 0;
+	uint64 StarvationAdmissions = 0;
+	uint64 LeasesExpired = 0;
+	double AverageAdmissionWaitMs = 0.0;
+	double MaxAdmissionWaitMs = 0.0;
+};
+
+/**
+ * Decides which satellites in range get a connection slot, and when.
+ *
+ * The backend asks whether it may connect to a satellite; `TryAdmit` answers yes only while fewer than
+ * `MaxConcurrentConnections` satellites are connected and the asking satellite ranks among the best of those
+ * currently waiting. Rank is a score built from the number of collections waiting on the tag, whether it is
+ * recording a swing right now, and how long ago anything was transferred from it (read from the satellite state
+ * cache). Fairness comes from two rules: the score grows with time spent waiting, and any satellite that has
+ * waited `MaxWaitSeconds` jumps ahead of every score.
+ *
+ * A slot is held from admission until the planned transfers finish or fail, or until its lease runs out. Nothing
+ * reports a satellite leaving range, so a satellite that has not been heard from for `ForgetAfterSeconds` is dropped.
+ * Only the simulated fleet asks before connecting. The SDK has no connect hook this demo can rely on, and declining
+ * in `first_collection_to_transfer` is no substitute: a declined collection is never offered again. So real satellites
+ * are neither capped nor ordered; for them the scheduler just follows state and transfers. All methods are thread-safe.
+ */
+class FHaversineConnectionScheduler
+{
+public:
+	FHaversineConnectionScheduler(const FHaversineConnectionSchedulerConfig& InConfig, const FHaversineSatelliteStateCache* InStateCache);
+
+	/** Latest state seen for a satellite, from discovery or a state update */
+	void UpdateSatellite(const FString& SatelliteId, int32 PendingCollections, bool bInCollectionState);
+
+	/** @return true if the SDK may connect to this satellite now. A true result takes a slot. */
+	bool TryAdmit(const FString& SatelliteId);
+
+	/** The transfer delegate chose to transfer `NumCollections`; zero releases the slot straight away */
+	void OnTransfersPlanned(const FString& SatelliteId, int32 NumCollections);
+
+	/** One planned collection finished; the slot is released after the last one */
+	void OnTransferEnded(const FString& SatelliteId);
+
+	/** A transfer failed. The connection is gone and the retry asks for a slot again, so this one is released. */
+	void OnTransferFailed(const FString& SatelliteId);
+
+	FHaversineConnectionSchedulerStats GetStats() const;
+	void LogStats() const;
+
+private:
+	struct FSatelliteEntry
+	{
+		int32 PendingCollections = 0;
+		bool bInCollectionState = false;
+		int64 LastTransferUnixMs = 0;
+
+		/** FPlatformTime::Seconds() of the last state update or request */
+		double LastSeenSeconds = 0.0;
+
+		/** FPlatformTime::Seconds() of the first unanswered request, or 0 if not waiting */
+		double WaitingSinceSeconds = 0.0;
+		double LastRequestSeconds = 0.0;
+
+		bool bConnected = false;
+		double LeaseExpirySeconds = 0.0;
+		int32 TransfersRemaining = 0;
+	};
+
+	FSatelliteEntry& FindOrAddLocked(const FString& SatelliteId);
+	double ScoreLocked(const FSatelliteEntry& Entry, double NowSeconds, int64 NowUnixMs) const;
+	void ReleaseLocked(FSatelliteEntry& Entry);
+	void ExpireLeasesLocked(double NowSeconds);
+	void ForgetIdleLocked(double NowSeconds);
+
+	FHaversineConnectionSchedulerConfig Config;
+	const FHaversineSatelliteStateCache* StateCache;
+
+	mutable FCriticalSection Mutex;
+	TMap<FString, FSatelliteEntry> Satellites;
+	int32 NumConnected = 0;
+	double NextForgetSeconds = 0.0;
+
+	uint64 Admitted = 0;
+	uint64 Deferred = 0;
+	uint64 StarvationAdmissions = 0;
+	uint64 LeasesExpired = 0;
+	double TotalAdmissionWaitSeconds = 0.0;
+	double MaxAdmissionWaitSeconds = 0.0;
+};
@@ -13,8 +13,23 @@
 #include "SuperTagPermissionsDelegate.h"
 #include "SuperTagUpdateDelegate.h"
 #include "SuperTagExtensions.h"
-#include "SuperTagGolfSwing.h"
-#include "SuperTagSwingUploader.h"
+#include "HaversineSwingPipeline.h"
+#include "HaversineSatelliteStateCache.h"
+#include "HaversineTransferPolicy.h"
+#include "HaversineConnectionScheduler.h"
+#include "HaversineFleetSimulator.h"
+#include "HaversineSwingCorpus.h"
+#include "HaversineMetadataCache.h"
+#include "HaversineAuthTokenCache.h"
+#include "HaversineGameThreadEventQueue.h"
+#include "HaversineLatencyTracker.h"
+#include "HaversineSwingJournal.h"
+#include "HaversineSwingReconstructor.h"
+#include "HaversineEventLog.h"
+#include "HaversineMockUploadServer.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
 #include "haversine/haversine_satellite_manager.h"
 #include "haversine/haversine_environment.h"
 #include "haversine/haversine_satellite.h"
@@ -22,9 +37,17 @@
 #include "haversine/satellite_id.h"
 #include "haversine/utils/events.h"
 
-// Forward declaration for GolfSwingKit types
-struct GSAuthTokenCache_s;
-typedef struct GSAuthTokenCache_s GSAuthTokenCache_t;
+static TAutoConsoleVariable<bool> CVarHaversineCacheEnabled(
+	TEXT("haversine.Cache.Enabled"),
+	true,
+	TEXT("Keep per-satellite state on disk across launches (Saved/Haversine/SatelliteStateCache.bin)."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<bool> CVarHaversineStartupAsync(
+	TEXT("haversine.Startup.Async"),
+	true,
+	TEXT("Create the satellite manager (or simulated fleet) and recover the swing journal on a background task instead of while the game instance starts. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
 
 //
 // Nested Delegate Classes
@@ -46,8 +69,8 @@ typedef struct GSAuthTokenCache_s GSAuthTokenCache_t;
 class UHaversineDemoSubsystem::CollectionTransferDelegate : public haversine::HaversineCollectionTransferDelegate
 {
 public:
-	explicit CollectionTransferDelegate(USuperTagAuthenticationManager* InAuthManager)
-		: AuthManager(InAuthManager)
+	explicit CollectionTransferDelegate(IHaversineFleetListener* InListener)
+		: Listener(InListener)
 	{
 	}
 
@@ -55,13 +78,11 @@ public:
 		const haversine::CollectionIndexes& Range,
 		const haversine::SatelliteId& SatelliteId) override
 	{
-		// For this demo, transfer the last swing (most recent)
 		// To transfer all, return Range.start_index
 		// To transfer none, return Range.end_index
+		// Which of these (or anything in between) is up to the transfer policy (see `HaversineTransferPolicy.h`)
 		FString SatID = UTF8_TO_TCHAR(SatelliteId.str().c_str());
-		UE_LOG(LogHaversineSatellite, Log, TEXT("  → Starting collection transfer from index %d to %d for satellite %s"),
-			Range.start_index, Range.end_index, *SatID);
-		return Range.end_index - 1; // Transfer last swing only
+		return Listener->FirstCollectionToTransfer(SatID, Range.start_index, Range.end_index);
 	}
 
 	virtual void will_transfer_collections(
@@ -69,9 +90,9 @@ public:
 		const haversine::SatelliteId& SatelliteId) override
 	{
         // Optional: could uodate UI if we want to indicate a swing transfer starting.
+        // Here it marks the start of the swing latency trace (see `HaversineLatencyTracker.h`).
 		FString SatID = UTF8_TO_TCHAR(SatelliteId.str().c_str());
-		UE_LOG(LogHaversineSatellite, Log, TEXT("  → Will transfer %d collections from satellite %s"),
-			Range.end_index - Range.start_index, *SatID);
+		Listener->OnCollectionTransfersStarting(SatID, Range.start_index, Range.end_index);
 	}
 
 	virtual void collection_transfer_did_finish(
@@ -81,79 +102,13 @@ public:
 	{
         // A collection transfer completed successfully.
         // - We now use the physics engine to process `collection_data` into a Golfswing.
-        // - This requires authentication with SkyGolf API as shown below.
-
+        // - This requires authentication with SkyGolf API, and reconstruction is far too slow to run here: this method is
+        //   called on the SDK's Bluetooth thread, and other satellites' transfers queue up behind it.
+        // - So we only hand the data to the swing pipeline (see `HaversineSwingPipeline.h`) and return straight away.
+        // - `CollectionData` is only valid during this call. It is copied once into a shared, immutable buffer that
+        //   reconstruction and upload both read from (see `HaversineCollectionBuffer.h`).
 		FString SatID = UTF8_TO_TCHAR(SatelliteId.str().c_str());
-		UE_LOG(LogHaversineSatellite, Log, TEXT("  ✓ Collection %d transferred successfully (%d bytes) from satellite %s"),
-			CollectionIndex, CollectionData.size(), *SatID);
-
-		// Parse hardware ID from swing data
-		FString HardwareId = FSuperTagGolfSwing::ParseHardwareId(CollectionData);
-		if (HardwareId.IsEmpty())
-		{
-			UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ Failed to parse hardware ID from swing data"));
-			return;
-		}
-
-		// Get authentication token for this hardware
-		if (!AuthManager)
-		{
-			UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ AuthManager is null, cannot process swing"));
-			return;
-		}
-
-		FString AuthToken = AuthManager->CachedAuthenticationToken(HardwareId);
-		if (AuthToken.IsEmpty())
-		{
-			UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ No authentication token for satellite %s, swing discarded"), *HardwareId);
-			return;
-		}
-
-		// Create and parse swing object
-        // *** This is where we get an actual golf swing with metrics! ***
-		GSAuthTokenCache_t* TokenCache = static_cast<GSAuthTokenCache_t*>(AuthManager->GetAuthTokenCacheHandle());
-		FSuperTagGolfSwing Swing(CollectionData, AuthToken, TokenCache);
-		if (!Swing.IsValid())
-		{
-			UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ Swing failed reconstruction from satellite %s"), *HardwareId);
-			return;
-		}
-
-		// For now, we just log some example properties of the swing.  See `SuperTagGolfSwing.h` for more information
-		FString ClubName = Swing.GetClub();
-		float Speed = Swing.GetClubheadSpeed();
-		FString Handedness = Swing.IsRightHanded() ? TEXT("Right") : TEXT("Left");
-		UE_LOG(LogHaversineSatellite, Log, TEXT("  ✓ Swing processed: Club=%s, Speed=%.1f MPH, %s"),
-			*ClubName, Speed, *Handedness);
-
-		// Display on-screen message
-		if (GEngine)
-		{
-			FString Message = FString::Printf(TEXT("Swing: %s @ %.1f MPH (%s)"), *ClubName, Speed, *Handedness);
-			GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Cyan, Message);
-		}
-
-		// Upload the swing to SkyGolf API
-		// The uploader will parse metadata internally from collection data
-		TArray<uint8> CollectionDataArray(CollectionData.data(), CollectionData.size());
-		FSuperTagSwingUploader::UploadSwing(
-			CollectionDataArray,
-			Swing,
-			HardwareId,
-			AuthToken,
-			TokenCache,
-			[SatID](bool bSuccess, const FString& ErrorMessage)
-			{
-				if (bSuccess)
-				{
-					UE_LOG(LogHaversineSatellite, Log, TEXT("  ✓ Successfully uploaded swing to SkyGolf API for satellite %s"), *SatID);
-				}
-				else
-				{
-					UE_LOG(LogHaversineSatellite, Warning, TEXT("  ⚠ Failed to upload swing to SkyGolf API: %s"), *ErrorMessage);
-				}
-			}
-		);
+		Listener->OnCollectionTransferred(SatID, CollectionIndex, FHaversineCollectionBuffer::Create(CollectionData));
 	}
 
 	virtual void collection_transfer_did_fail(
@@ -165,12 +120,11 @@ public:
         // you may want to clean it up here.
 		FString SatID = UTF8_TO_TCHAR(SatelliteId.str().c_str());
 		FString ErrorMsg = UTF8_TO_TCHAR(Error.to_string().c_str());
-		UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ Collection %d transfer failed: %s for satellite %s"),
-			CollectionIndex, *ErrorMsg, *SatID);
+		Listener->OnCollectionTransferFailed(SatID, CollectionIndex, ErrorMsg);
 	}
 
 private:
-	USuperTagAuthenticationManager* AuthManager;
+	IHaversineFleetListener* Listener;
 };
 
 //
@@ -181,6 +135,7 @@ void UHaversineDemoSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
 
+	const uint64 InitializeStartCycles = FPlatformTime::Cycles64();
 	UE_LOG(LogHaversineSatellite, Warning, TEXT("*** HAVERSINE SATELLITE SUBSYSTEM STARTING ***"));
 	UE_LOG(LogHaversineSatellite, Log, TEXT("Initializing Haversine Satellite Subsystem"));
 
@@ -193,104 +148,333 @@ void UHaversineDemoSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	// Create an authentication manager. This is used to authenticate swings for processing.
 	AuthenticationManager = NewObject<USuperTagAuthenticationManager>(this);
 
-	// A `PermissionDelegate` is an object that tells the HaversineSatelliteLibrary SDK which
-    // satellites (supertags) to interact with.
-	PermissionsDelegate = new FSuperTagPermissionsDelegate(AuthenticationManager);
-
-    // An `UpdateDelegate` can be configured to update the firmware on the supertags if necessary.
-    // This is unlikely to be used, and you can probably just ignore it.
-	UpdateDelegate = new FSuperTagUpdateDelegate();
-
-    // We've seen the collection transfer delegate above; it is the object that handles collection (swing) transfer.
-	TransferDelegate = new CollectionTransferDelegate(AuthenticationManager);
-
-    // Now create a "HaversineEnvironment" with these delegates.
-    // A "HaversineEnviroment" is the type used to customize SDK behaviour for a fleet of satellites. It holds
-    // the permissions and transfer delegate we discussed earlier, but it also has a number of other options
-    // for customization. One important one, not implemented here, is the ability to provide a persistant cache
-    // which will prevent unnecessary connections to satellites across app launches.
-	haversine::HaversineEnvironment Environment;
-	Environment.set_permissions_delegate(std::unique_ptr<haversine::HaversinePermissionsDelegate>(PermissionsDelegate));
-	Environment.set_update_delegate(std::unique_ptr<haversine::HaversineUpdateDelegate>(UpdateDelegate));
-	Environment.set_transfer_delegate(std::unique_ptr<haversine::HaversineCollectionTransferDelegate>(TransferDelegate));
-
-    // Create a "HaversineSatelliteManager". This is the top-level object for working with HaversineSatellites.
-    // - It takes the environment and also the hardware version of the SuperTag satellites. This should be 10.0
-	UE_LOG(LogHaversineSatellite, Log, TEXT("Creating satellite manager (HW version 10.0)"));
-	SatelliteManager = std::make_unique<haversine::HaversineSatelliteManager>(
-		std::move(Environment), 10, 0
-	);
-
-    // The `manager` will publish various events...
-
-	// Subscribe to Bluetooth state changes. We can only start scanning when Bluetooth is powered on.
-	BluetoothSubscription = std::make_unique<haversine::EventSubscription<haversine::BluetoothState>>(
-		const_cast<haversine::EventChannel<haversine::BluetoothState>&>(SatelliteManager->bluetooth_state_events())
-			.subscribe([this](const haversine::BluetoothState& State) {
-				OnBluetoothStateChanged(State);
-			})
-	);
-
-	// Subscribe to satellite discoveries.
-    // - This happens when a new nearby satellite (supertag) is discovered while scanning.
-    // - For subsequent state updates for this supertag, see `state_update_events` on the discovered satellite.
-	DiscoverySubscription = std::make_unique<haversine::EventSubscription<std::shared_ptr<haversine::HaversineSatellite>>>(
-		const_cast<haversine::EventChannel<std::shared_ptr<haversine::HaversineSatellite>>&>(SatelliteManager->discovery_events())
-			.subscribe([this](const std::shared_ptr<haversine::HaversineSatellite>& Satellite) {
-				OnSatelliteDiscovered(Satellite);
-			})
-	);
-
-	// Subscribe to scan completion
-    // - This is called when you stop scanning, or if it completes with an error (e.g. Bluetooth turned off)
-	ScanCompletionSubscription = std::make_unique<haversine::EventSubscription<haversine::Status>>(
-		const_cast<haversine::EventChannel<haversine::Status>&>(SatelliteManager->scanning_completion_events())
-			.subscribe([this](const haversine::Status& Status) {
-				OnScanCompleted(Status);
-			})
-	);
-
-	// Check current Bluetooth state and start scanning if possible.
-	haversine::BluetoothState CurrentState = SatelliteManager->bluetooth_state();
-	UE_LOG(LogHaversineSatellite, Log, TEXT("Current Bluetooth state: %s"), *BluetoothStateToString(CurrentState));
-
-	if (CurrentState == haversine::BluetoothState::PoweredOn)
+    // A simulated fleet (see `CreateBackend`) keeps its state cache, journal and spool in their own directory, so its
+    // made-up satellites and swings never mix with a real run's.
+	const FHaversineFleetSimulatorConfig SimulatorConfig = FHaversineFleetSimulatorConfig::FromConsoleVariables();
+	const bool bSimulatedFleet = SimulatorConfig.NumSatellites > 0;
+
+	// Per-satellite state (last seen, last transferred collection) is kept on disk, so a restart does not
+    // transfer the same collections again. It is mapped in once here and flushed incrementally from then on.
+	if (CVarHaversineCacheEnabled.GetValueOnGameThread())
+	{
+		SatelliteStateCache = MakeUnique<FHaversineSatelliteStateCache>(FHaversineSatelliteStateCache::GetDefaultFilename(bSimulatedFleet));
+		SatelliteStateCache->Load();
+	}
+
+    // With many satellites in range, the scheduler bounds how many are connected at once and picks who goes next.
+    // Only the simulated fleet asks it before connecting. The SDK's permissions delegate has no per-connection hook
+    // this demo can rely on, and declining a transfer would lose its collections, so real satellites are not capped.
+	ConnectionScheduler = MakeUnique<FHaversineConnectionScheduler>(FHaversineConnectionSchedulerConfig::FromConsoleVariables(), SatelliteStateCache.Get());
+	RegisterConsoleCommand(TEXT("haversine.Scheduler.Stats"), TEXT("Logs connection slot usage and admission wait times."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogSchedulerStats));
+
+    // The fleet list is kept up to date from discovery and state events, and can be read from any thread without a copy.
+	SatelliteRegistry.Start();
+	RegisterConsoleCommand(TEXT("haversine.Satellites.List"), TEXT("Logs every satellite seen this session. Args: [SatelliteIdSubstring]"),
+		FConsoleCommandWithArgsDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogSatellites));
+	RegisterConsoleCommand(TEXT("haversine.Satellites.Stats"), TEXT("Logs satellite registry updates and snapshot publishing."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogSatelliteRegistryStats));
+
+    // Processed swings are uploaded in batches rather than one request each.
+	UploadQueue = FHaversineSwingUploadQueue::Create(AuthenticationManager, FHaversineSwingUploadQueueConfig::FromConsoleVariables());
+	UploadQueue->Start();
+
+    // Tokens are fetched as soon as a known satellite is seen, so its swings rarely wait for one.
+	TokenCache = MakeShared<FHaversineAuthTokenCache, ESPMode::ThreadSafe>(AuthenticationManager, FHaversineAuthTokenCacheConfig::FromConsoleVariables());
+	TokenCache->Start();
+
+    // Swings the upload queue gives up on (SkyGolf unreachable, or still waiting at shutdown) are compressed to disk
+    // and uploaded in the background once it can be reached, this session or a later one.
+	const FHaversineUploadSpoolConfig SpoolConfig = FHaversineUploadSpoolConfig::FromConsoleVariables();
+	if (SpoolConfig.bEnabled)
+	{
+		UploadSpool = MakeShared<FHaversineUploadSpool, ESPMode::ThreadSafe>(FHaversineUploadSpool::GetDefaultDirectory(bSimulatedFleet), SpoolConfig,
+			UploadQueue->GetTransport(), AuthenticationManager, TokenCache.ToSharedRef());
+		UploadQueue->SetSpool(UploadSpool);
+		UploadSpool->Start();
+		RegisterConsoleCommand(TEXT("haversine.Spool.Stats"), TEXT("Logs upload spool backlog, drain rate and backoff."),
+			FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogSpoolStats));
+		RegisterConsoleCommand(TEXT("haversine.Spool.Drain"), TEXT("Skips the upload spool's backoff and tries to upload spooled swings now."),
+			FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::DrainSpool));
+	}
+
+    // Every transferred collection is journaled before it is processed, since the satellite will not send it again.
+    // Collections the last run did not get uploaded (it crashed, or SkyGolf was unreachable) are recovered along with
+    // the satellite manager below, and replayed once it is ready.
+	const FHaversineSwingJournalConfig JournalConfig = FHaversineSwingJournalConfig::FromConsoleVariables();
+	if (JournalConfig.bEnabled)
+	{
+		SwingJournal = MakeShared<FHaversineSwingJournal, ESPMode::ThreadSafe>(FHaversineSwingJournal::GetDefaultFilename(bSimulatedFleet), JournalConfig);
+		RegisterConsoleCommand(TEXT("haversine.Journal.Stats"), TEXT("Logs swing journal appends, completions, syncs and startup replay."),
+			FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogJournalStats));
+	}
+
+    // Real traffic can be recorded with its timing and replayed later through the same path, for reproducible
+    // benchmarks (see `HaversineSwingRecording.h` and the ingest commandlet's `-Replay`).
+	if (FHaversineSwingRecorder::IsEnabled())
+	{
+		SwingRecorder = MakeUnique<FHaversineSwingRecorder>(FHaversineSwingRecorder::GetDefaultFilename());
+		if (!SwingRecorder->Open())
+		{
+			SwingRecorder.Reset();
+		}
+	}
+	RegisterConsoleCommand(TEXT("haversine.Replay.Start"), TEXT("Replays a swing recording through the swing pipeline. Args: <Filename> [Speed=1, 0 for maximum]"),
+		FConsoleCommandWithArgsDelegate::CreateUObject(this, &UHaversineDemoSubsystem::StartReplayCommand));
+	RegisterConsoleCommand(TEXT("haversine.Replay.Stop"), TEXT("Stops a running swing replay."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::StopReplay));
+
+    // Swings, satellites and failed transfers are broadcast to Blueprint once per frame, however many arrive.
+	BlueprintEvents = MakeUnique<FHaversineBlueprintEventBatcher>([this](const FHaversineBlueprintEventBatch& Batch) { BroadcastBlueprintEvents(Batch); });
+	BlueprintEvents->Start();
+	RegisterConsoleCommand(TEXT("haversine.Blueprint.Stats"), TEXT("Logs how many gameplay events were batched and broadcast."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogBlueprintEventStats));
+
+    // Swings are reconstructed by a pool of worker threads, off the SDK's callback thread.
+	SwingPipeline = MakeUnique<FHaversineSwingPipeline>(AuthenticationManager, TokenCache.ToSharedRef(), UploadQueue.ToSharedRef(), SwingJournal, &SwingStore,
+		BlueprintEvents.Get(), FHaversineSwingPipelineConfig::FromConsoleVariables());
+
+	RegisterConsoleCommand(TEXT("haversine.Pipeline.Stats"), TEXT("Logs per-stage throughput and latency of the swing pipeline."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogPipelineStats));
+	RegisterConsoleCommand(TEXT("haversine.Upload.Stats"), TEXT("Logs swing upload batching and retry counters."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogUploadStats));
+	RegisterConsoleCommand(TEXT("haversine.Swings.Stats"), TEXT("Logs swing store row counts and memory."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogSwingStoreStats));
+	RegisterConsoleCommand(TEXT("haversine.Swings.Query"), TEXT("Logs clubhead speed over stored swings. Args: [user=<id>] [club=<name>] [hand=L|R] [satellite=<id>] [minutes=<n>]"),
+		FConsoleCommandWithArgsDelegate::CreateUObject(this, &UHaversineDemoSubsystem::QuerySwingStore));
+	RegisterConsoleCommand(TEXT("haversine.Reconstruct.Benchmark"), TEXT("Compares one-at-a-time and batched swing reconstruction over the recorded corpus. Blocks the game thread. Args: [Swings=256] [BatchSize=32]"),
+		FConsoleCommandWithArgsDelegate::CreateUObject(this, &UHaversineDemoSubsystem::RunReconstructionBenchmark));
+	RegisterConsoleCommand(TEXT("haversine.Metadata.Stats"), TEXT("Logs metadata cache hit and miss counters."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogMetadataStats));
+	RegisterConsoleCommand(TEXT("haversine.Auth.Stats"), TEXT("Logs auth token cache hits, fetches and parked swings."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogAuthStats));
+
+    // How much of each satellite's backlog to transfer per connection. Transfers are cheaper than connection setup,
+    // so by default everything not already received is drained.
+	TransferPolicy = MakeUnique<FHaversineTransferPolicyEngine>(FHaversineTransferPolicyEngine::CreatePolicyFromConsoleVariables(), SatelliteStateCache.Get());
+	RegisterConsoleCommand(TEXT("haversine.Transfer.Stats"), TEXT("Logs how many collections the transfer policy requested per connection."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogTransferStats));
+
+    // SDK and simulator events arrive on their own threads. They are queued and handled on the game thread a few at a
+    // time, so handlers can touch UObjects and GEngine, and a burst from a large fleet cannot cause a hitch.
+	EventQueue = MakeUnique<FHaversineGameThreadEventQueue>(FHaversineGameThreadEventQueueConfig::FromConsoleVariables(),
+		[this](const FHaversineFleetEvent& Event) { DispatchFleetEvent(Event); });
+	EventQueue->Start();
+	RegisterConsoleCommand(TEXT("haversine.Events.Stats"), TEXT("Logs game thread event queue backlog, coalescing and latency."),
+		FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogEventStats));
+
+    // Creating the satellite manager and recovering the journal are the slow part of startup (SDK and Bluetooth
+    // setup, disk reads). They run on a background task so the game instance does not wait for them; everything
+    // above is ready to receive their events. `GetReadyFuture` and `OnReady` tell consumers when they are done.
+	ReadyFuture = ReadyPromise.GetFuture().Share();
+	if (CVarHaversineStartupAsync.GetValueOnGameThread())
+	{
+		TWeakObjectPtr<UHaversineDemoSubsystem> WeakThis(this);
+		BackendTask = Async(EAsyncExecution::ThreadPool, [this, WeakThis, SimulatorConfig]()
+		{
+			CreateBackend(SimulatorConfig);
+			AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+			{
+				if (UHaversineDemoSubsystem* Subsystem = WeakThis.Get())
+				{
+					Subsystem->OnBackendReady();
+				}
+			});
+		});
+	}
+	else
+	{
+		CreateBackend(SimulatorConfig);
+		OnBackendReady();
+	}
+
+	GameThreadInitializeMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - InitializeStartCycles);
+	InitializeStartSeconds = FPlatformTime::Seconds() - GameThreadInitializeMs / 1000.0;
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Subsystem initialized in %.2f ms of game thread time (satellite manager %s)"),
+		GameThreadInitializeMs, BackendTask.IsValid() ? TEXT("starting in the background") : TEXT("created inline"));
+}
+
+// Runs on a background task unless `haversine.Startup.Async` is off. Touches nothing the game thread reads before `OnBackendReady`.
+void UHaversineDemoSubsystem::CreateBackend(const FHaversineFleetSimulatorConfig& SimulatorConfig)
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// Before any satellite can connect, so no transfer is appended to a journal that is not open yet
+	if (SwingJournal)
+	{
+		RecoveredSwings = SwingJournal->Open();
+	}
+
+    // On machines without a Bluetooth adapter (build boxes, load tests) a simulated fleet stands in for the SDK.
+    // It reports the same events through the same handlers; see `HaversineFleetSimulator.h`.
+	if (SimulatorConfig.NumSatellites > 0)
+	{
+		FleetSimulator = MakeUnique<FHaversineFleetSimulator>(SimulatorConfig, this);
+		FleetSimulator->Start();
+	}
+	else
+	{
+		CreateSatelliteManagers();
+	}
+
+	BackendInitializeMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+}
+
+// Game thread, once `CreateBackend` has finished.
+void UHaversineDemoSubsystem::OnBackendReady()
+{
+	if (bShuttingDown || bBackendReady)
+	{
+		return;
+	}
+	bBackendReady = true;
+
+	if (SwingJournal)
+	{
+		SwingJournal->Replay(MoveTemp(RecoveredSwings), [this](const FHaversineJournalEntry& Entry)
+		{
+			return SwingPipeline && SwingPipeline->Submit(Entry.SatelliteId, Entry.CollectionIndex, Entry.Collection.ToSharedRef(), 0, Entry.Sequence);
+		});
+	}
+
+	if (FleetSimulator)
+	{
+		RegisterConsoleCommand(TEXT("haversine.Fleet.Stats"), TEXT("Logs simulated fleet activity and swing-to-transfer latency."),
+			FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogFleetStats));
+	}
+	else
+	{
+		RegisterConsoleCommand(TEXT("haversine.Shards.Stats"), TEXT("Logs each satellite manager shard's event backlog, queue latency and partition filtering."),
+			FConsoleCommandDelegate::CreateUObject(this, &UHaversineDemoSubsystem::LogShardStats));
+	}
+
+	// Start scanning if possible; otherwise the PoweredOn event will
+	if (FleetSimulator)
 	{
 		StartScanning();
 	}
 	else
 	{
-		UE_LOG(LogHaversineSatellite, Warning, TEXT("Bluetooth not ready yet, waiting for PoweredOn state..."));
+		// Every shard watches the same adapter
+		const haversine::BluetoothState CurrentState = SatelliteShards.IsEmpty() ? haversine::BluetoothState::Unknown : SatelliteShards[0]->GetBluetoothState();
+		UE_LOG(LogHaversineSatellite, Log, TEXT("Current Bluetooth state: %s"), *BluetoothStateToString(CurrentState));
+		if (CurrentState == haversine::BluetoothState::PoweredOn)
+		{
+			StartScanning();
+		}
+		else
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("Bluetooth not ready yet, waiting for PoweredOn state..."));
+		}
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("✓ Haversine ready %.0f ms after startup (game thread %.2f ms, satellite manager and journal %.0f ms)"),
+		(FPlatformTime::Seconds() - InitializeStartSeconds) * 1000.0, GameThreadInitializeMs, BackendInitializeMs);
+
+	ReadyPromise.SetValue(true);
+	OnReady.Broadcast();
+}
+
+// This method creates the SDK's satellite managers and hands each of them our delegates.
+void UHaversineDemoSubsystem::CreateSatelliteManagers()
+{
+    // Mixed-generation hardware needs one satellite manager per hardware version, and a very large fleet can be split
+    // further between several managers by satellite ID (see `haversine.Shards.*`). By default there is a single
+    // shard for hardware version 10.0. Each shard has its own delegates and its own event thread, and all of them
+    // report to this subsystem; see `HaversineSatelliteShard.h`.
+	for (const FHaversineSatelliteShardConfig& ShardConfig : FHaversineSatelliteShardConfig::FromConsoleVariables())
+	{
+        // Discovered satellites are queued for the game thread with a snapshot of their state, so the event queue can
+        // see which ones are urgent, and a copy of the state their metadata is parsed from there.
+		TUniquePtr<FHaversineSatelliteShard> Shard = MakeUnique<FHaversineSatelliteShard>(ShardConfig, this,
+			[this](const FHaversineSatelliteSnapshot& Satellite, const std::shared_ptr<const haversine::SatelliteState>& State)
+			{
+				FHaversineFleetEvent Event;
+				Event.Type = EHaversineFleetEventType::SatelliteDiscovered;
+				Event.Satellite = Satellite;
+				Event.SdkState = State;
+				EventQueue->Enqueue(MoveTemp(Event));
+			});
+
+		// A `PermissionDelegate` is an object that tells the HaversineSatelliteLibrary SDK which
+        // satellites (supertags) to interact with.
+		FSuperTagPermissionsDelegate* PermissionsDelegate = new FSuperTagPermissionsDelegate(AuthenticationManager);
+
+        // An `UpdateDelegate` can be configured to update the firmware on the supertags if necessary.
+        // This is unlikely to be used, and you can probably just ignore it.
+		FSuperTagUpdateDelegate* UpdateDelegate = new FSuperTagUpdateDelegate();
+
+        // We've seen the collection transfer delegate above; it is the object that handles collection (swing) transfer.
+		CollectionTransferDelegate* TransferDelegate = new CollectionTransferDelegate(Shard.Get());
+
+        // Now create a "HaversineEnvironment" with these delegates.
+        // A "HaversineEnviroment" is the type used to customize SDK behaviour for a fleet of satellites. It holds
+        // the permissions and transfer delegate we discussed earlier, but it also has a number of other options
+        // for customization. The satellite state cache above plays the role of the persistent cache the environment
+        // can take: the transfer delegate consults it so collections are not fetched twice across app launches.
+		haversine::HaversineEnvironment Environment;
+		Environment.set_permissions_delegate(std::unique_ptr<haversine::HaversinePermissionsDelegate>(PermissionsDelegate));
+		Environment.set_update_delegate(std::unique_ptr<haversine::HaversineUpdateDelegate>(UpdateDelegate));
+		Environment.set_transfer_delegate(std::unique_ptr<haversine::HaversineCollectionTransferDelegate>(TransferDelegate));
+
+        // The shard creates a "HaversineSatelliteManager", the top-level object for working with HaversineSatellites,
+        // from the environment and the shard's hardware version (10.0 for current SuperTags).
+        // - The `manager` publishes Bluetooth state, discovery and scan completion events. The shard subscribes to
+        //   them on the SDK's threads and passes them on from its own thread; each handler here only queues the
+        //   event for the game thread.
+		Shard->Start(MoveTemp(Environment));
+		SatelliteShards.Add(MoveTemp(Shard));
 	}
+
+    // Scanning starts in `OnBackendReady`, back on the game thread.
 }
 
 
 void UHaversineDemoSubsystem::StartScanning()
 {
-	if (!SatelliteManager)
+	if (FleetSimulator)
 	{
-		UE_LOG(LogHaversineSatellite, Error, TEXT("Cannot start scanning: SatelliteManager is null"));
+		UE_LOG(LogHaversineSatellite, Log, TEXT("Starting simulated satellite scan..."));
+		FleetSimulator->StartScanning();
 		return;
 	}
 
-	if (SatelliteManager->is_scanning())
+	if (SatelliteShards.IsEmpty())
 	{
-		UE_LOG(LogHaversineSatellite, Log, TEXT("Already scanning, skipping start request"));
+		UE_LOG(LogHaversineSatellite, Error, TEXT("Cannot start scanning: no satellite manager"));
 		return;
 	}
 
 	UE_LOG(LogHaversineSatellite, Log, TEXT("Starting satellite scan..."));
 
-	haversine::Status ScanResult = SatelliteManager->scan_for_satellites();
-	if (!ScanResult.ok())
+	int32 NumScanning = 0;
+	for (const TUniquePtr<FHaversineSatelliteShard>& Shard : SatelliteShards)
 	{
-		FString ErrorMsg = UTF8_TO_TCHAR(ScanResult.to_string().c_str());
-		UE_LOG(LogHaversineSatellite, Error, TEXT("Failed to start scanning: %s"), *ErrorMsg);
+		NumScanning += Shard->StartScanning() ? 1 : 0;
 	}
-	else
+
+	if (NumScanning == SatelliteShards.Num())
 	{
 		UE_LOG(LogHaversineSatellite, Log, TEXT("Scanning started successfully"));
 	}
+	else
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("Failed to start scanning on %d of %d satellite managers"),
+			SatelliteShards.Num() - NumScanning, SatelliteShards.Num());
+	}
+}
+
+bool UHaversineDemoSubsystem::IsScanning() const
+{
+	if (!bBackendReady)
+	{
+		return false;
+	}
+	if (FleetSimulator)
+	{
+		return FleetSimulator->IsScanning();
+	}
+	return SatelliteShards.ContainsByPredicate([](const TUniquePtr<FHaversineSatelliteShard>& Shard) { return Shard->IsScanning(); });
 }
 
 void UHaversineDemoSubsystem::OnBluetoothStateChanged(const haversine::BluetoothState& State)
@@ -298,71 +482,268 @@ void UHaversineDemoSubsystem::OnBluetoothStateChanged(const haversine::Bluetooth
 	UE_LOG(LogHaversineSatellite, Log, TEXT("Bluetooth State: %s"), *BluetoothStateToString(State));
 
 	// Auto-start scanning when Bluetooth becomes ready
-	if (State == haversine::BluetoothState::PoweredOn && SatelliteManager && !SatelliteManager->is_scanning())
+	if (State == haversine::BluetoothState::PoweredOn && bBackendReady && (FleetSimulator || !SatelliteShards.IsEmpty()) && !IsScanning())
 	{
 		UE_LOG(LogHaversineSatellite, Log, TEXT("Bluetooth powered on, auto-starting scan"));
 		StartScanning();
 	}
 }
 
-void UHaversineDemoSubsystem::OnSatelliteDiscovered(const std::shared_ptr<haversine::HaversineSatellite>& Satellite)
+// `State` is a copy taken when the SDK reported the discovery; the satellite's live state is not touched here.
+void UHaversineDemoSubsystem::OnSatelliteDiscovered(const FHaversineSatelliteSnapshot& Snapshot, const haversine::SatelliteState& State)
 {
-	if (!Satellite)
-	{
-		UE_LOG(LogHaversineSatellite, Warning, TEXT("Received null satellite in discovery event"));
-		return;
-	}
+	const FString& SatelliteID = Snapshot.SatelliteId;
+	const FString& SatelliteName = Snapshot.Name;
+	FHaversineEventLog::Get().RecordSatellite(EHaversineEventLogType::SatelliteDiscovered, Snapshot);
+	RecordSatelliteState(Snapshot);
+	BlueprintEvents->AddSatellite(Snapshot, true);
 
-	FString SatelliteID = UTF8_TO_TCHAR(Satellite->id().str().c_str());
-	FString SatelliteName = Satellite->name()
-		? UTF8_TO_TCHAR(Satellite->name()->c_str())
-		: TEXT("(unnamed)");
-	FString StateInfo = FormatSatelliteState(Satellite->state());
-
-	// Try to parse metadata with authentication
-	FString ClubInfo = TEXT("none");
-	FString UserInfo = TEXT("none");
-	if (AuthenticationManager)
+	// Try to parse metadata with authentication.
+	// Satellites re-advertise the same metadata constantly, so it is only parsed again when its bytes change.
+	auto ParseMetadata = [this, &SatelliteID, &State]()
 	{
-		haversine::Result<FSuperTagMetadata> MetadataResult = FSuperTagExtensions::ParseMetadata(Satellite->state(), AuthenticationManager);
+		FHaversineSatelliteMetadata Result;
+		Result.ClubInfo = TEXT("none");
+		Result.UserInfo = TEXT("none");
+		if (!AuthenticationManager)
+		{
+			return Result;
+		}
+
+		haversine::Result<FSuperTagMetadata> MetadataResult = FSuperTagExtensions::ParseMetadata(State, AuthenticationManager);
 
 		if (MetadataResult.ok())
 		{
 			const FSuperTagMetadata& Metadata = MetadataResult.value();
+			Result.bParsed = true;
 
 			if (Metadata.Club.IsSet())
 			{
 				const GSClub& Club = Metadata.Club.GetValue();
 				FString ClubLongName = UTF8_TO_TCHAR(Club.longName);
-				ClubInfo = ClubLongName.IsEmpty() ? TEXT("(unnamed club)") : ClubLongName;
+				Result.ClubInfo = ClubLongName.IsEmpty() ? TEXT("(unnamed club)") : ClubLongName;
 			}
 
 			if (Metadata.UserId.IsSet())
 			{
-				UserInfo = FString::Printf(TEXT("User %u"), Metadata.UserId.GetValue());
+				Result.UserInfo = FString::Printf(TEXT("User %u"), Metadata.UserId.GetValue());
+				SwingStore.AssociateUser(SatelliteID, Metadata.UserId.GetValue());
 			}
 		}
 		else
 		{
 			FString ErrorMsg = UTF8_TO_TCHAR(MetadataResult.status().to_string().c_str());
-			ClubInfo = FString::Printf(TEXT("parse error: %s"), *ErrorMsg);
+			Result.ClubInfo = FString::Printf(TEXT("parse error: %s"), *ErrorMsg);
 		}
+		return Result;
+	};
+
+	const std::vector<uint8_t>& RawMetadata = State.persistent().metadata();
+	const TOptional<uint64> MetadataHash = RawMetadata.empty()
+		? TOptional<uint64>()
+		: TOptional<uint64>(FHaversineMetadataCache::HashMetadata(RawMetadata.data(), RawMetadata.size()));
+	FHaversineSatelliteMetadataRef Metadata = MetadataCache.FindOrParse(SatelliteID, MetadataHash, ParseMetadata);
+
+	// The event log already has this discovery; the text is only built if someone will read it
+	if (UE_LOG_ACTIVE(LogHaversineSatellite, Log))
+	{
+		UE_LOG(LogHaversineSatellite, Log, TEXT("🛰️  Discovered: %s (%s) - %s | Club: %s | User: %s"),
+			*SatelliteID, *SatelliteName, *FormatSatelliteState(Snapshot), *Metadata->ClubInfo, *Metadata->UserInfo);
+	}
+}
+
+void UHaversineDemoSubsystem::RecordSatelliteState(const FHaversineSatelliteSnapshot& Satellite)
+{
+	SatelliteRegistry.Update(Satellite);
+
+	if (SatelliteStateCache)
+	{
+		SatelliteStateCache->RecordSeen(Satellite.SatelliteId, Satellite.FirmwareVersionMajor, Satellite.FirmwareVersionMinor, Satellite.CollectionCount);
+	}
+
+	if (ConnectionScheduler)
+	{
+		ConnectionScheduler->UpdateSatellite(Satellite.SatelliteId, Satellite.CollectionCount, Satellite.bInCollectionState);
+	}
+
+	if (TokenCache)
+	{
+		TokenCache->PrefetchForSatellite(Satellite.SatelliteId);
 	}
+}
+
+//
+// Fleet events. The satellite manager shards forward their delegates and subscriptions here, and so does the simulated fleet.
+//
+
+void UHaversineDemoSubsystem::OnFleetBluetoothStateChanged(haversine::BluetoothState State)
+{
+	FHaversineEventLog::Get().RecordBluetoothState(State);
 
-	UE_LOG(LogHaversineSatellite, Log, TEXT("🛰️  Discovered: %s (%s) - %s | Club: %s | User: %s"),
-		*SatelliteID, *SatelliteName, *StateInfo, *ClubInfo, *UserInfo);
+	FHaversineFleetEvent Event;
+	Event.Type = EHaversineFleetEventType::BluetoothStateChanged;
+	Event.BluetoothState = State;
+	EventQueue->Enqueue(MoveTemp(Event));
 }
 
-void UHaversineDemoSubsystem::OnScanCompleted(const haversine::Status& Status)
+void UHaversineDemoSubsystem::OnFleetSatelliteDiscovered(const FHaversineSatelliteSnapshot& Satellite)
 {
-	if (Status.ok())
+	FHaversineEventLog::Get().RecordSatellite(EHaversineEventLogType::SatelliteDiscovered, Satellite);
+
+	FHaversineFleetEvent Event;
+	Event.Type = EHaversineFleetEventType::SatelliteDiscovered;
+	Event.Satellite = Satellite;
+	EventQueue->Enqueue(MoveTemp(Event));
+}
+
+void UHaversineDemoSubsystem::OnFleetSatelliteStateUpdated(const FHaversineSatelliteSnapshot& Satellite)
+{
+	FHaversineEventLog::Get().RecordSatellite(EHaversineEventLogType::SatelliteStateUpdated, Satellite);
+
+	FHaversineFleetEvent Event;
+	Event.Type = EHaversineFleetEventType::SatelliteStateUpdated;
+	Event.Satellite = Satellite;
+	EventQueue->Enqueue(MoveTemp(Event));
+}
+
+void UHaversineDemoSubsystem::OnFleetScanCompleted(bool bSuccess, const FString& Error)
+{
+	FHaversineEventLog::Get().RecordScanCompleted(bSuccess);
+
+	FHaversineFleetEvent Event;
+	Event.Type = EHaversineFleetEventType::ScanCompleted;
+	Event.bSuccess = bSuccess;
+	Event.Error = Error;
+	EventQueue->Enqueue(MoveTemp(Event));
+}
+
+// Runs on the game thread, within the event queue's per-tick budget.
+void UHaversineDemoSubsystem::DispatchFleetEvent(const FHaversineFleetEvent& Event)
+{
+	switch (Event.Type)
 	{
-		UE_LOG(LogHaversineSatellite, Log, TEXT("Scanning completed successfully"));
+		case EHaversineFleetEventType::BluetoothStateChanged:
+			OnBluetoothStateChanged(Event.BluetoothState);
+			break;
+
+		case EHaversineFleetEventType::SatelliteDiscovered:
+			if (Event.SdkState)
+			{
+				OnSatelliteDiscovered(Event.Satellite, *Event.SdkState);
+				break;
+			}
+			if (UE_LOG_ACTIVE(LogHaversineSatellite, Log))
+			{
+				UE_LOG(LogHaversineSatellite, Log, TEXT("🛰️  Discovered: %s (%s) - %s"),
+					*Event.Satellite.SatelliteId, *Event.Satellite.Name, *FormatSatelliteState(Event.Satellite));
+			}
+			RecordSatelliteState(Event.Satellite);
+			BlueprintEvents->AddSatellite(Event.Satellite, true);
+			break;
+
+		case EHaversineFleetEventType::SatelliteStateUpdated:
+			RecordSatelliteState(Event.Satellite);
+			BlueprintEvents->AddSatellite(Event.Satellite, false);
+			break;
+
+		case EHaversineFleetEventType::ScanCompleted:
+			if (Event.bSuccess)
+			{
+				UE_LOG(LogHaversineSatellite, Log, TEXT("Scanning completed successfully"));
+			}
+			else
+			{
+				UE_LOG(LogHaversineSatellite, Error, TEXT("Scanning completed with error: %s"), *Event.Error);
+			}
+			break;
 	}
-	else
+}
+
+bool UHaversineDemoSubsystem::ShouldConnect(const FHaversineSatelliteSnapshot& Satellite)
+{
+	if (!ConnectionScheduler)
 	{
-		FString ErrorMsg = UTF8_TO_TCHAR(Status.to_string().c_str());
-		UE_LOG(LogHaversineSatellite, Error, TEXT("Scanning completed with error: %s"), *ErrorMsg);
+		return true;
+	}
+
+	ConnectionScheduler->UpdateSatellite(Satellite.SatelliteId, Satellite.CollectionCount, Satellite.bInCollectionState);
+	return ConnectionScheduler->TryAdmit(Satellite.SatelliteId);
+}
+
+uint16 UHaversineDemoSubsystem::FirstCollectionToTransfer(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex)
+{
+	UE_LOG(LogHaversineSatellite, Log, TEXT("  → Starting collection transfer from index %d to %d for satellite %s"),
+		StartIndex, EndIndex, *SatelliteId);
+
+	const uint16 First = TransferPolicy
+		? TransferPolicy->FirstCollectionToTransfer(SatelliteId, StartIndex, EndIndex)
+		: static_cast<uint16>(EndIndex - 1); // Transfer last swing only
+
+	// The connection slot is held until these transfers end
+	if (ConnectionScheduler)
+	{
+		ConnectionScheduler->OnTransfersPlanned(SatelliteId, static_cast<uint16>(EndIndex - First));
+	}
+	return First;
+}
+
+void UHaversineDemoSubsystem::OnCollectionTransfersStarting(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex)
+{
+	UE_LOG(LogHaversineSatellite, Log, TEXT("  → Will transfer %d collections from satellite %s"),
+		static_cast<uint16>(EndIndex - StartIndex), *SatelliteId);
+	FHaversineLatencyTracker::Get().OnTransfersStarting(SatelliteId, StartIndex, EndIndex);
+	FHaversineEventLog::Get().RecordTransfer(EHaversineEventLogType::TransfersStarting, SatelliteId, StartIndex, EndIndex);
+}
+
+void UHaversineDemoSubsystem::OnCollectionTransferred(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection)
+{
+	const uint64 TransferStartCycles = FHaversineLatencyTracker::Get().OnCollectionTransferred(SatelliteId, CollectionIndex);
+	FHaversineEventLog::Get().RecordTransfer(EHaversineEventLogType::CollectionTransferred, SatelliteId, CollectionIndex, 0, static_cast<uint32>(Collection->Num()));
+
+	// Journal the raw collection first, so a crash from here on cannot lose the swing
+	const uint64 JournalSequence = SwingJournal ? SwingJournal->Append(SatelliteId, CollectionIndex, Collection) : 0;
+	if (!SwingPipeline || !SwingPipeline->Submit(SatelliteId, CollectionIndex, Collection, TransferStartCycles, JournalSequence))
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ Swing pipeline unavailable or full, collection %d from satellite %s %s"),
+			CollectionIndex, *SatelliteId, JournalSequence != 0 ? TEXT("left in the journal for the next launch") : TEXT("discarded"));
+	}
+
+	if (!FleetSimulator && FHaversineSwingCorpus::IsRecording())
+	{
+		FHaversineSwingCorpus::SaveAsync(FHaversineSwingCorpus::GetDirectory(), SatelliteId, CollectionIndex, Collection);
+	}
+	if (SwingRecorder)
+	{
+		SwingRecorder->Record(SatelliteId, CollectionIndex, Collection);
+	}
+
+	// The satellite will not offer this index again, so remember it across launches either way
+	if (TransferPolicy)
+	{
+		TransferPolicy->RecordTransferred(SatelliteId, CollectionIndex, Collection->Num());
+	}
+
+	if (ConnectionScheduler)
+	{
+		ConnectionScheduler->OnTransferEnded(SatelliteId);
+	}
+}
+
+void UHaversineDemoSubsystem::OnCollectionTransferFailed(const FString& SatelliteId, uint16 CollectionIndex, const FString& Error)
+{
+	UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ Collection %d transfer failed: %s for satellite %s"),
+		CollectionIndex, *Error, *SatelliteId);
+	FHaversineLatencyTracker::Get().OnCollectionTransferFailed(SatelliteId);
+	FHaversineEventLog::Get().RecordTransfer(EHaversineEventLogType::CollectionTransferFailed, SatelliteId, CollectionIndex);
+	if (BlueprintEvents)
+	{
+		BlueprintEvents->AddTransferFailure(SatelliteId, CollectionIndex, Error);
+	}
+
+	// The retry asks for a connection slot again, so this one is given up
+	if (ConnectionScheduler)
+	{
+		ConnectionScheduler->OnTransferFailed(SatelliteId);
 	}
 }
 
@@ -370,47 +751,479 @@ void UHaversineDemoSubsystem::Deinitialize()
 {
     UE_LOG(LogHaversineSatellite, Log, TEXT("Shutting down Haversine Satellite Subsystem"));
 
-    if (SatelliteManager && SatelliteManager->is_scanning())
+    // A background start still in progress is waited for, so whatever it created is torn down below.
+    bShuttingDown = true;
+    if (BackendTask.IsValid())
     {
-        UE_LOG(LogHaversineSatellite, Log, TEXT("Stopping active scan..."));
-        SatelliteManager->stop_scanning();
+        BackendTask.Wait();
     }
-
-    // Print final summary
-    if (SatelliteManager)
+    if (!bBackendReady)
     {
-        auto Discovered = SatelliteManager->get_discovered_satellites();
-        UE_LOG(LogHaversineSatellite, Log, TEXT("Final summary: %d satellites discovered"), Discovered.size());
+        ReadyPromise.SetValue(false);
+    }
 
-        for (const auto& [ID, Satellite] : Discovered)
+    if (IsScanning())
+    {
+        UE_LOG(LogHaversineSatellite, Log, TEXT("Stopping active scan..."));
+        if (FleetSimulator)
+        {
+            FleetSimulator->StopScanning();
+        }
+        else
         {
-            FString SatID = UTF8_TO_TCHAR(ID.str().c_str());
-            FString Name = Satellite->name()
-                ? UTF8_TO_TCHAR(Satellite->name()->c_str())
-                : TEXT("(unnamed)");
-            FString StateInfo = FormatSatelliteState(Satellite->state());
-            UE_LOG(LogHaversineSatellite, Log, TEXT("  • %s (%s) - %s"), *SatID, *Name, *StateInfo);
+            for (const TUniquePtr<FHaversineSatelliteShard>& Shard : SatelliteShards)
+            {
+                Shard->StopScanning();
+            }
         }
     }
 
-    // RAII will cleanup subscriptions and manager
-    BluetoothSubscription.reset();
-    DiscoverySubscription.reset();
-    ScanCompletionSubscription.reset();
-    SatelliteManager.reset();
+    // Print final summary from the registry, which already holds every satellite seen
+    // (a simulated fleet can be thousands of satellites, so only its size is logged).
+    SatelliteRegistry.Shutdown();
+    if (FleetSimulator)
+    {
+        FHaversineSatelliteRegistry::FReadScope Snapshot(SatelliteRegistry);
+        UE_LOG(LogHaversineSatellite, Log, TEXT("Final summary: %d simulated satellites discovered"), Snapshot->Num());
+    }
+    else
+    {
+        UE_LOG(LogHaversineSatellite, Log, TEXT("Final summary:"));
+        LogSatellites(TArray<FString>());
+    }
+    SatelliteRegistry.LogStats();
+
+    if (FleetSimulator)
+    {
+        FleetSimulator->Stop();
+        FleetSimulator->LogStats();
+        FleetSimulator.Reset();
+    }
+
+    // Each shard tears down its manager (RAII cleans up subscriptions and delegates), then hands on what it had queued.
+    for (const TUniquePtr<FHaversineSatelliteShard>& Shard : SatelliteShards)
+    {
+        Shard->Stop();
+        Shard->LogStats();
+    }
+    SatelliteShards.Reset();
+
+    // Nothing can publish events any more; whatever is still queued describes satellites we are letting go of.
+    if (EventQueue)
+    {
+        EventQueue->Shutdown();
+        EventQueue->LogStats();
+        EventQueue.Reset();
+    }
+
+    // A replay feeds the pipeline the way the satellite manager does, so it stops with it.
+    StopReplay();
+    if (SwingRecorder)
+    {
+        SwingRecorder->Close();
+        SwingRecorder->LogStats();
+        SwingRecorder.Reset();
+    }
+
+    // The manager or simulator (and with it the transfer delegate) is gone, so nothing new can arrive. Finish queued swings.
+    for (IConsoleObject* Command : ConsoleCommands)
+    {
+        IConsoleManager::Get().UnregisterConsoleObject(Command);
+    }
+    ConsoleCommands.Reset();
+
+    // Swings still waiting on a token fetch are released (and discarded) rather than held up until it times out.
+    if (TokenCache)
+    {
+        TokenCache->Shutdown();
+    }
+
+    if (SwingPipeline)
+    {
+        SwingPipeline->Shutdown();
+        SwingPipeline->LogStats();
+        SwingPipeline.Reset();
+    }
+
+    // Nothing publishes swings any more; gameplay events not broadcast yet are dropped with the subsystem.
+    if (BlueprintEvents)
+    {
+        BlueprintEvents->Shutdown();
+        BlueprintEvents->LogStats();
+        BlueprintEvents.Reset();
+    }
+
+    // Send whatever is still waiting for a batch; anything that cannot go out now is spooled (or reported as failed).
+    if (UploadQueue)
+    {
+        UploadQueue->Flush();
+        UploadQueue->LogStats();
+        UploadQueue->Shutdown();
+        UploadQueue.Reset();
+    }
+
+    if (ReplayUploadQueue)
+    {
+        ReplayUploadQueue->Flush();
+        ReplayUploadQueue->LogStats();
+        ReplayUploadQueue->Shutdown();
+        ReplayUploadQueue.Reset();
+    }
+
+    // Spooled swings stay on disk and are drained by the next launch.
+    if (UploadSpool)
+    {
+        UploadSpool->Shutdown();
+        UploadSpool->LogStats();
+        UploadSpool.Reset();
+    }
+
+    if (TokenCache)
+    {
+        TokenCache->LogStats();
+        TokenCache.Reset();
+    }
+
+    // Uploads have completed or failed by now. Whatever was not marked complete is replayed at the next launch.
+    if (SwingJournal)
+    {
+        SwingJournal->Shutdown();
+        SwingJournal->LogStats();
+        SwingJournal.Reset();
+    }
+
+    MetadataCache.LogStats();
+    SwingStore.LogStats();
+
+    if (ConnectionScheduler)
+    {
+        ConnectionScheduler->LogStats();
+        ConnectionScheduler.Reset();
+    }
+
+    FHaversineLatencyTracker::Get().LogStats();
+
+    if (TransferPolicy)
+    {
+        TransferPolicy->LogStats();
+        TransferPolicy.Reset();
+    }
+
+    if (SatelliteStateCache)
+    {
+        SatelliteStateCache->Shutdown();
+        SatelliteStateCache.Reset();
+    }
 
     Super::Deinitialize();
 }
 
-FString UHaversineDemoSubsystem::FormatSatelliteState(const haversine::SatelliteState& State)
+void UHaversineDemoSubsystem::RegisterConsoleCommand(const TCHAR* Name, const TCHAR* Help, const FConsoleCommandDelegate& Command)
+{
+	if (IConsoleObject* Registered = IConsoleManager::Get().RegisterConsoleCommand(Name, Help, Command))
+	{
+		ConsoleCommands.Add(Registered);
+	}
+}
+
+void UHaversineDemoSubsystem::RegisterConsoleCommand(const TCHAR* Name, const TCHAR* Help, const FConsoleCommandWithArgsDelegate& Command)
+{
+	if (IConsoleObject* Registered = IConsoleManager::Get().RegisterConsoleCommand(Name, Help, Command))
+	{
+		ConsoleCommands.Add(Registered);
+	}
+}
+
+FHaversineIngestStats UHaversineDemoSubsystem::GetIngestStats() const
+{
+	FHaversineIngestStats Stats;
+	Stats.Satellites = SatelliteRegistry.GetStats().Satellites;
+
+	if (SwingPipeline)
+	{
+		Stats.CollectionsTransferred = SwingPipeline->GetStageStats(EHaversineSwingStage::Transfer).Processed;
+		Stats.SwingsPublished = SwingPipeline->GetStageStats(EHaversineSwingStage::Publish).Processed;
+		for (int32 Stage = 0; Stage < static_cast<int32>(EHaversineSwingStage::Num); ++Stage)
+		{
+			Stats.SwingsDiscarded += SwingPipeline->GetStageStats(static_cast<EHaversineSwingStage>(Stage)).Discarded;
+		}
+	}
+
+	if (UploadQueue)
+	{
+		const FHaversineSwingUploadStats UploadStats = UploadQueue->GetStats();
+		Stats.SwingsUploaded = UploadStats.Uploaded;
+		Stats.UploadsFailed = UploadStats.Failed;
+		Stats.UploadsPending = UploadStats.Pending;
+	}
+
+	if (ReplayUploadQueue)
+	{
+		const FHaversineSwingUploadStats UploadStats = ReplayUploadQueue->GetStats();
+		Stats.SwingsUploaded += UploadStats.Uploaded;
+		Stats.UploadsFailed += UploadStats.Failed;
+		Stats.UploadsPending += UploadStats.Pending;
+	}
+	return Stats;
+}
+
+void UHaversineDemoSubsystem::LogPipelineStats()
+{
+	if (SwingPipeline)
+	{
+		SwingPipeline->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::LogTransferStats()
+{
+	if (TransferPolicy)
+	{
+		TransferPolicy->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::LogSchedulerStats()
+{
+	if (ConnectionScheduler)
+	{
+		ConnectionScheduler->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::LogFleetStats()
+{
+	if (FleetSimulator)
+	{
+		FleetSimulator->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::LogShardStats()
+{
+	for (const TUniquePtr<FHaversineSatelliteShard>& Shard : SatelliteShards)
+	{
+		Shard->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::LogMetadataStats()
+{
+	MetadataCache.LogStats();
+}
+
+void UHaversineDemoSubsystem::LogAuthStats()
+{
+	if (TokenCache)
+	{
+		TokenCache->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::LogSatellites(const TArray<FString>& Args)
+{
+	const FString Filter = Args.IsValidIndex(0) ? Args[0] : FString();
+
+	FHaversineSatelliteRegistry::FReadScope Snapshot(SatelliteRegistry);
+	int32 NumListed = 0;
+	for (int32 Index = 0; Index < Snapshot->Num(); ++Index)
+	{
+		const FHaversineSatelliteRow& Row = (*Snapshot)[Index];
+		if (!Filter.IsEmpty() && !Row.SatelliteId.Contains(Filter))
+		{
+			continue;
+		}
+		UE_LOG(LogHaversineSatellite, Log, TEXT("  • %s (%s) - %s"),
+			*Row.SatelliteId, Row.Name.IsEmpty() ? TEXT("(unnamed)") : *Row.Name, *FormatSatelliteState(Row.ToSnapshot()));
+		++NumListed;
+	}
+	UE_LOG(LogHaversineSatellite, Log, TEXT("%d of %d satellites discovered"), NumListed, Snapshot->Num());
+}
+
+void UHaversineDemoSubsystem::LogSatelliteRegistryStats()
+{
+	SatelliteRegistry.LogStats();
+}
+
+void UHaversineDemoSubsystem::LogBlueprintEventStats()
+{
+	if (BlueprintEvents)
+	{
+		BlueprintEvents->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::BroadcastBlueprintEvents(const FHaversineBlueprintEventBatch& Batch)
+{
+	if (!Batch.DiscoveredSatellites.IsEmpty())
+	{
+		OnSatellitesDiscovered.Broadcast(Batch.DiscoveredSatellites);
+	}
+	if (!Batch.ChangedSatellites.IsEmpty())
+	{
+		OnSatelliteStatesChanged.Broadcast(Batch.ChangedSatellites);
+	}
+	if (!Batch.Swings.IsEmpty())
+	{
+		OnSwingsProcessed.Broadcast(Batch.Swings);
+	}
+	if (!Batch.TransferFailures.IsEmpty())
+	{
+		OnTransfersFailed.Broadcast(Batch.TransferFailures);
+	}
+}
+
+void UHaversineDemoSubsystem::LogEventStats()
+{
+	if (EventQueue)
+	{
+		EventQueue->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::LogSwingStoreStats()
+{
+	SwingStore.LogStats();
+}
+
+void UHaversineDemoSubsystem::QuerySwingStore(const TArray<FString>& Args)
+{
+	FHaversineSwingQuery Query;
+	if (!FHaversineSwingQuery::FromConsoleArgs(Args, Query))
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("Usage: haversine.Swings.Query [user=<id>] [club=<name>] [hand=L|R] [satellite=<id>] [minutes=<n>]"));
+		return;
+	}
+	SwingStore.LogQuery(Query);
+}
+
+void UHaversineDemoSubsystem::RunReconstructionBenchmark(const TArray<FString>& Args)
+{
+	const int32 NumSwings = Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 256;
+	const int32 BatchSize = Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 32;
+	FHaversineSwingReconstructor::RunBenchmark(AuthenticationManager, FHaversineSwingCorpus::Load(FHaversineSwingCorpus::GetDirectory()), NumSwings, BatchSize);
+}
+
+bool UHaversineDemoSubsystem::StartReplay(const FString& Filename, double Speed)
+{
+	if (!bBackendReady || !SwingPipeline)
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Swing replay needs the subsystem to be ready"));
+		return false;
+	}
+
+	TArray<FHaversineRecordedCollection> Collections;
+	if (!FHaversineSwingRecorder::Load(Filename, Collections))
+	{
+		return false;
+	}
+
+	// Recorded swings are real swings that were uploaded when they were recorded. Replayed ones go to the mock upload
+	// server when it is running and are discarded otherwise, never to SkyGolf, the journal or the spool.
+	if (!ReplayUploadQueue)
+	{
+		FHaversineMockUploadServer& MockServer = FHaversineMockUploadServer::Get();
+		TSharedRef<IHaversineSwingUploadTransport, ESPMode::ThreadSafe> ReplayTransport = MockServer.IsRunning()
+			? StaticCastSharedRef<IHaversineSwingUploadTransport>(MakeShared<FHaversineHttpBatchTransport, ESPMode::ThreadSafe>(MockServer.GetBatchUrl()))
+			: StaticCastSharedRef<IHaversineSwingUploadTransport>(MakeShared<FHaversineDiscardUploadTransport, ESPMode::ThreadSafe>());
+		ReplayUploadQueue = MakeShared<FHaversineSwingUploadQueue, ESPMode::ThreadSafe>(ReplayTransport, FHaversineSwingUploadQueueConfig::FromConsoleVariables());
+		ReplayUploadQueue->Start();
+	}
+
+	StopReplay();
+	SwingReplay = MakeUnique<FHaversineSwingReplay>(MoveTemp(Collections), Speed,
+		[this](const FHaversineRecordedCollection& Entry) { return SubmitReplayedCollection(Entry); });
+	SwingReplay->Start();
+	return true;
+}
+
+void UHaversineDemoSubsystem::StartReplayCommand(const TArray<FString>& Args)
+{
+	if (!Args.IsValidIndex(0))
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("Usage: haversine.Replay.Start <Filename> [Speed=1, 0 for maximum]"));
+		return;
+	}
+	StartReplay(Args[0], Args.IsValidIndex(1) ? FCString::Atod(*Args[1]) : 1.0);
+}
+
+void UHaversineDemoSubsystem::StopReplay()
+{
+	if (SwingReplay)
+	{
+		SwingReplay->Stop();
+	}
+}
+
+// Replay thread. Mirrors `OnCollectionTransferred` up to the pipeline; the transfer policy and connection scheduler
+// only deal with real connections and are left alone, and nothing is journaled.
+bool UHaversineDemoSubsystem::SubmitReplayedCollection(const FHaversineRecordedCollection& Entry)
+{
+	FHaversineLatencyTracker& Latency = FHaversineLatencyTracker::Get();
+	Latency.OnTransfersStarting(Entry.SatelliteId, Entry.CollectionIndex, static_cast<uint16>(Entry.CollectionIndex + 1));
+	const uint64 TransferStartCycles = Latency.OnCollectionTransferred(Entry.SatelliteId, Entry.CollectionIndex);
+
+	const FHaversineCollectionBufferRef Collection = Entry.Collection.ToSharedRef();
+	FHaversineEventLog::Get().RecordTransfer(EHaversineEventLogType::CollectionTransferred, Entry.SatelliteId, Entry.CollectionIndex, 0, static_cast<uint32>(Collection->Num()));
+
+	// A full Transfer queue holds the replay up instead of dropping the swing, so a maximum-speed run measures
+	// throughput rather than how many swings were refused
+	while (!SwingPipeline->Submit(Entry.SatelliteId, Entry.CollectionIndex, Collection, TransferStartCycles, /*JournalSequence*/ 0, ReplayUploadQueue))
+	{
+		if (SwingReplay->IsStopRequested())
+		{
+			return false;
+		}
+		FPlatformProcess::Sleep(0.001f);
+	}
+	return true;
+}
+
+void UHaversineDemoSubsystem::LogJournalStats()
+{
+	if (SwingJournal)
+	{
+		SwingJournal->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::LogUploadStats()
+{
+	if (UploadQueue)
+	{
+		UploadQueue->LogStats();
+	}
+	if (ReplayUploadQueue)
+	{
+		ReplayUploadQueue->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::LogSpoolStats()
+{
+	if (UploadSpool)
+	{
+		UploadSpool->LogStats();
+	}
+}
+
+void UHaversineDemoSubsystem::DrainSpool()
+{
+	if (UploadSpool)
+	{
+		UploadSpool->DrainNow();
+	}
+}
+
+FString UHaversineDemoSubsystem::FormatSatelliteState(const FHaversineSatelliteSnapshot& State)
 {
 	// Movement/collecting status
 	FString MovementState;
-	if (State.transient().inCollectionState)
+	if (State.bInCollectionState)
 	{
 		MovementState = TEXT("collecting");
 	}
-	else if (State.transient().isMoving)
+	else if (State.bIsMoving)
 	{
 		MovementState = TEXT("moving");
 	}
@@ -421,12 +1234,12 @@ FString UHaversineDemoSubsystem::FormatSatelliteState(const haversine::Satellite
 
 	// Firmware version
 	FString FirmwareVersion = FString::Printf(TEXT("FW:%d.%d"),
-		State.persistent().platform_versions().firmwareVersionMajor,
-		State.persistent().platform_versions().firmwareVersionMinor);
+		State.FirmwareVersionMajor,
+		State.FirmwareVersionMinor);
 
 	// Status indicators
 	TArray<FString> StatusIcons;
-	if (State.transient().isDark)
+	if (State.bIsDark)
 	{
 		StatusIcons.Add(TEXT("☾"));
 	}
@@ -435,19 +1248,19 @@ FString UHaversineDemoSubsystem::FormatSatelliteState(const haversine::Satellite
 		StatusIcons.Add(TEXT("☀"));
 	}
 
-	if (State.transient().needsServicing)
+	if (State.bNeedsServicing)
 	{
 		StatusIcons.Add(TEXT("⚠"));
 	}
 
-	if (State.transient().hasDebugInfo)
+	if (State.bHasDebugInfo)
 	{
 		StatusIcons.Add(TEXT("☠"));
 	}
 
 	// Collections
 	FString Collections = FString::Printf(TEXT("%d collections"),
-		State.truncated_collection_count());
+		State.CollectionCount);
 
 	// Combine all parts
 	FString StatusIconsStr = FString::Join(StatusIcons, TEXT(" "));
@@ -15,11 +15,44 @@
 #include "haversine/haversine_environment.h"
 #include "haversine/utils/events.h"
 
+#include "HaversineSwingPipeline.h"
+#include "HaversineSwingUploadQueue.h"
+#include "HaversineUploadSpool.h"
+#include "HaversineSatelliteStateCache.h"
+#include "HaversineTransferPolicy.h"
+#include "HaversineConnectionScheduler.h"
+#include "HaversineFleetEvents.h"
+#include "HaversineFleetSimulator.h"
+#include "HaversineSatelliteShard.h"
+#include "HaversineMetadataCache.h"
+#include "HaversineAuthTokenCache.h"
+#include "HaversineGameThreadEventQueue.h"
+#include "HaversineSwingJournal.h"
+#include "HaversineSwingRecording.h"
+#include "HaversineSwingStore.h"
+#include "HaversineSatelliteRegistry.h"
+#include "HaversineBlueprintEventBatcher.h"
+#include "HaversineBlueprintTypes.h"
+#include "Async/Future.h"
+#include "HAL/IConsoleManager.h"
+
 #include "HaversineDemoSubsystem.generated.h"
 
 class USuperTagAuthenticationManager;
-class FSuperTagPermissionsDelegate;
-class FSuperTagUpdateDelegate;
+
+/** Running totals of what the subsystem has ingested, for headless boxes that report throughput */
+struct FHaversineIngestStats
+{
+	int32 Satellites = 0;
+	uint64 CollectionsTransferred = 0;
+	uint64 SwingsPublished = 0;
+
+	/** Collections that never became a swing (no hardware ID, no token, failed reconstruction) */
+	uint64 SwingsDiscarded = 0;
+	uint64 SwingsUploaded = 0;
+	uint64 UploadsFailed = 0;
+	int32 UploadsPending = 0;
+};
 
 /**
  * Demo subsystem that shows how to use the SuperKit plugin
@@ -28,7 +61,7 @@ class FSuperTagUpdateDelegate;
  * Integrates SuperTag authentication and permissions
  */
 UCLASS()
-class UNREALHAVERSINEDEMO_API UHaversineDemoSubsystem : public UGameInstanceSubsystem
+class UNREALHAVERSINEDEMO_API UHaversineDemoSubsystem : public UGameInstanceSubsystem, public IHaversineFleetListener
 {
 	GENERATED_BODY()
 
@@ -37,12 +70,82 @@ public:
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 	virtual void Deinitialize() override;
 
+	// IHaversineFleetListener interface (called on the SDK's or the simulator's threads).
+	// Bluetooth, discovery, state and scan events are queued and handled on the game thread.
+	virtual void OnFleetBluetoothStateChanged(haversine::BluetoothState State) override;
+	virtual void OnFleetSatelliteDiscovered(const FHaversineSatelliteSnapshot& Satellite) override;
+	virtual void OnFleetSatelliteStateUpdated(const FHaversineSatelliteSnapshot& Satellite) override;
+	virtual void OnFleetScanCompleted(bool bSuccess, const FString& Error) override;
+	virtual bool ShouldConnect(const FHaversineSatelliteSnapshot& Satellite) override;
+	virtual uint16 FirstCollectionToTransfer(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex) override;
+	virtual void OnCollectionTransfersStarting(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex) override;
+	virtual void OnCollectionTransferred(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection) override;
+	virtual void OnCollectionTransferFailed(const FString& SatelliteId, uint16 CollectionIndex, const FString& Error) override;
+
 	/**
 	 * Get the authentication manager
 	 * @return The authentication manager instance
 	 */
 	USuperTagAuthenticationManager* GetAuthenticationManager() const { return AuthenticationManager; }
 
+	/**
+	 * Every satellite seen this session, for fleet lists and queries.
+	 * Read it from any thread with `FHaversineSatelliteRegistry::FReadScope`.
+	 */
+	const FHaversineSatelliteRegistry& GetSatelliteRegistry() const { return SatelliteRegistry; }
+
+	/**
+	 * Completes once the satellite manager (or simulated fleet) is running and scanning has been requested: with true,
+	 * or with false if the subsystem shut down first. `Initialize` returns before this, see `haversine.Startup.Async`.
+	 */
+	TSharedFuture<bool> GetReadyFuture() const { return ReadyFuture; }
+
+	/** True once the satellite manager (or simulated fleet) is running */
+	UFUNCTION(BlueprintPure, Category = "Haversine")
+	bool IsReady() const { return bBackendReady; }
+
+	/** Broadcast on the game thread when `IsReady` becomes true */
+	UPROPERTY(BlueprintAssignable, Category = "Haversine")
+	FHaversineReadyDelegate OnReady;
+
+	/** Totals since the subsystem started. Game thread only. */
+	FHaversineIngestStats GetIngestStats() const;
+
+	/** The swing pipeline, for benchmarks; null once the subsystem has shut down */
+	FHaversineSwingPipeline* GetSwingPipeline() const { return SwingPipeline.Get(); }
+
+	/**
+	 * Play a recording (see `HaversineSwingRecording.h`) into the swing path as if its collections were being
+	 * transferred now: traced and processed like any other transfer, without touching the transfer policy or
+	 * connection scheduler. Replayed swings are not journaled, and are uploaded to the mock upload server if it is
+	 * running and discarded otherwise, never to SkyGolf. Replaces a replay already running. Game thread only, once
+	 * `IsReady`.
+	 * @param Speed 1 for the recorded pacing, N for N times faster, 0 for as fast as the pipeline accepts
+	 * @return false if the recording cannot be loaded or the subsystem is not ready
+	 */
+	bool StartReplay(const FString& Filename, double Speed);
+
+	/** The running or last finished replay, or null if none was started */
+	const FHaversineSwingReplay* GetSwingReplay() const { return SwingReplay.Get(); }
+
+	// Gameplay events. Each is broadcast on the game thread at most once per frame, with everything since the last one.
+
+	/** Swings reconstructed and queued for upload */
+	UPROPERTY(BlueprintAssignable, Category = "Haversine")
+	FHaversineSwingsProcessedDelegate OnSwingsProcessed;
+
+	/** Satellites seen for the first time this session, one entry each; later sightings arrive as state changes */
+	UPROPERTY(BlueprintAssignable, Category = "Haversine")
+	FHaversineSatellitesDelegate OnSatellitesDiscovered;
+
+	/** Latest state of each satellite that reported a change; one entry per satellite */
+	UPROPERTY(BlueprintAssignable, Category = "Haversine")
+	FHaversineSatellitesDelegate OnSatelliteStatesChanged;
+
+	/** Collection transfers that failed (the SDK retries them) */
+	UPROPERTY(BlueprintAssignable, Category = "Haversine")
+	FHaversineTransfersFailedDelegate OnTransfersFailed;
+
 private:
 	// Collection transfer delegate (defined in .cpp)
 	class CollectionTransferDelegate;
@@ -51,25 +154,105 @@ private:
 	UPROPERTY()
 	USuperTagAuthenticationManager* AuthenticationManager;
 
-	// Satellite manager
-	std::unique_ptr<haversine::HaversineSatelliteManager> SatelliteManager;
+	// Worker pipeline that reconstructs transferred swings, and the batching queue that uploads them
+	TUniquePtr<FHaversineSwingPipeline> SwingPipeline;
+	TSharedPtr<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> UploadQueue;
+
+	// Uploads replayed swings to the mock upload server or nowhere, created by the first replay
+	TSharedPtr<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> ReplayUploadQueue;
+
+	// Transferred collections on disk until their swings are uploaded
+	TSharedPtr<FHaversineSwingJournal, ESPMode::ThreadSafe> SwingJournal;
+
+	// Transferred collections recorded with their timing (`haversine.Replay.Record`), and recordings being played back
+	TUniquePtr<FHaversineSwingRecorder> SwingRecorder;
+	TUniquePtr<FHaversineSwingReplay> SwingReplay;
+
+	// Authentication tokens, fetched before the swings that need them arrive
+	TSharedPtr<FHaversineAuthTokenCache, ESPMode::ThreadSafe> TokenCache;
+
+	// Swings the upload queue gave up on, on disk until SkyGolf can be reached again
+	TSharedPtr<FHaversineUploadSpool, ESPMode::ThreadSafe> UploadSpool;
+
+	// On-disk per-satellite state that survives app launches
+	TUniquePtr<FHaversineSatelliteStateCache> SatelliteStateCache;
+
+	// Decides how many collections each connection transfers
+	TUniquePtr<FHaversineTransferPolicyEngine> TransferPolicy;
+
+	// Parsed metadata per satellite, reused until the metadata bytes change
+	FHaversineMetadataCache MetadataCache;
+
+	// Gathers the gameplay events above and broadcasts them once per frame
+	TUniquePtr<FHaversineBlueprintEventBatcher> BlueprintEvents;
+
+	// Live satellite list, published once per frame as an immutable snapshot
+	FHaversineSatelliteRegistry SatelliteRegistry;
+
+	// Every published swing, column by column, for speed queries per user and club
+	FHaversineSwingStore SwingStore;
+
+	// Caps and orders the simulated fleet's connections; for SDK satellites it only follows state and transfers
+	TUniquePtr<FHaversineConnectionScheduler> ConnectionScheduler;
+
+	// Carries SDK and simulator events to the game thread
+	TUniquePtr<FHaversineGameThreadEventQueue> EventQueue;
+
+	// Console commands registered by this subsystem
+	TArray<IConsoleObject*> ConsoleCommands;
+
+	// Satellite managers, one per hardware version and fleet partition, each with its own delegates and event thread
+	TArray<TUniquePtr<FHaversineSatelliteShard>> SatelliteShards;
 
-	// SuperTag delegates (owned by this subsystem, moved into environment)
-	FSuperTagPermissionsDelegate* PermissionsDelegate;
-	FSuperTagUpdateDelegate* UpdateDelegate;
-	CollectionTransferDelegate* TransferDelegate;
+	// Simulated satellites, used instead of the satellite manager when `haversine.Fleet.Simulate` is set
+	TUniquePtr<FHaversineFleetSimulator> FleetSimulator;
 
-	// Event subscriptions (RAII cleanup)
-	std::unique_ptr<haversine::EventSubscription<haversine::BluetoothState>> BluetoothSubscription;
-	std::unique_ptr<haversine::EventSubscription<std::shared_ptr<haversine::HaversineSatellite>>> DiscoverySubscription;
-	std::unique_ptr<haversine::EventSubscription<haversine::Status>> ScanCompletionSubscription;
+	// Background start: the satellite manager or simulator, and journal recovery. See `Initialize`.
+	TFuture<void> BackendTask;
+	TPromise<bool> ReadyPromise;
+	TSharedFuture<bool> ReadyFuture;
+	TArray<FHaversineJournalEntry> RecoveredSwings;
+	bool bBackendReady = false;
+	bool bShuttingDown = false;
+	double InitializeStartSeconds = 0.0;
+	double GameThreadInitializeMs = 0.0;
+	double BackendInitializeMs = 0.0;
 
 	// Helper functions
+	void CreateBackend(const FHaversineFleetSimulatorConfig& SimulatorConfig);
+	void OnBackendReady();
+	void CreateSatelliteManagers();
 	void StartScanning();
+	bool IsScanning() const;
 	void OnBluetoothStateChanged(const haversine::BluetoothState& State);
-	void OnSatelliteDiscovered(const std::shared_ptr<haversine::HaversineSatellite>& Satellite);
-	void OnScanCompleted(const haversine::Status& Status);
+	void OnSatelliteDiscovered(const FHaversineSatelliteSnapshot& Snapshot, const haversine::SatelliteState& State);
+	void DispatchFleetEvent(const FHaversineFleetEvent& Event);
+	void RecordSatelliteState(const FHaversineSatelliteSnapshot& Satellite);
+	void RegisterConsoleCommand(const TCHAR* Name, const TCHAR* Help, const FConsoleCommandDelegate& Command);
+	void RegisterConsoleCommand(const TCHAR* Name, const TCHAR* Help, const FConsoleCommandWithArgsDelegate& Command);
+	void LogPipelineStats();
+	void LogUploadStats();
+	void LogSpoolStats();
+	void DrainSpool();
+	void LogTransferStats();
+	void LogSchedulerStats();
+	void LogFleetStats();
+	void LogShardStats();
+	void LogMetadataStats();
+	void LogAuthStats();
+	void LogEventStats();
+	void LogJournalStats();
+	void LogSwingStoreStats();
+	void LogSatellites(const TArray<FString>& Args);
+	void LogSatelliteRegistryStats();
+	void LogBlueprintEventStats();
+	void BroadcastBlueprintEvents(const FHaversineBlueprintEventBatch& Batch);
+	void QuerySwingStore(const TArray<FString>& Args);
+	void RunReconstructionBenchmark(const TArray<FString>& Args);
+	void StartReplayCommand(const TArray<FString>& Args);
+	void StopReplay();
+	bool SubmitReplayedCollection(const FHaversineRecordedCollection& Entry);
 
-	static FString FormatSatelliteState(const haversine::SatelliteState& State);
+	static FString FormatSatelliteState(const FHaversineSatelliteSnapshot& State);
 	static FString BluetoothStateToString(haversine::BluetoothState State);
 };
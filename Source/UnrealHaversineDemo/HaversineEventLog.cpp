@@ -0,0 +1,280 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineEventLog.cpp
+// UnrealHaversineDemo
+//
+// Binary ring buffer of satellite and transfer events, formatted only when read
+//
+
+#include "HaversineEventLog.h"
+#include "SuperTagKitPlugin.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<int32> CVarHaversineEventLogCapacity(
+	TEXT("haversine.EventLog.Capacity"),
+	16384,
+	TEXT("Satellite and transfer events kept in memory for post-mortems (rounded up to a power of two, 64 bytes each). Read when the first event is recorded."),
+	ECVF_ReadOnly);
+
+namespace
+{
+	const TCHAR* GetTypeName(EHaversineEventLogType Type)
+	{
+		switch (Type)
+		{
+			case EHaversineEventLogType::BluetoothStateChanged:		return TEXT("BluetoothStateChanged");
+			case EHaversineEventLogType::SatelliteDiscovered:		return TEXT("SatelliteDiscovered");
+			case EHaversineEventLogType::SatelliteStateUpdated:		return TEXT("SatelliteStateUpdated");
+			case EHaversineEventLogType::ScanCompleted:				return TEXT("ScanCompleted");
+			case EHaversineEventLogType::TransfersStarting:			return TEXT("TransfersStarting");
+			case EHaversineEventLogType::CollectionTransferred:		return TEXT("CollectionTransferred");
+			case EHaversineEventLogType::CollectionTransferFailed:	return TEXT("CollectionTransferFailed");
+			default:												return TEXT("Invalid");
+		}
+	}
+
+	const TCHAR* GetBluetoothStateName(haversine::BluetoothState State)
+	{
+		switch (State)
+		{
+			case haversine::BluetoothState::PoweredOn:		return TEXT("PoweredOn");
+			case haversine::BluetoothState::PoweredOff:		return TEXT("PoweredOff");
+			case haversine::BluetoothState::Unsupported:	return TEXT("Unsupported");
+			case haversine::BluetoothState::Unauthorized:	return TEXT("Unauthorized");
+			case haversine::BluetoothState::Unknown:		return TEXT("Unknown");
+			case haversine::BluetoothState::Resetting:		return TEXT("Resetting");
+			default:										return TEXT("Invalid");
+		}
+	}
+}
+
+//
+// Record
+//
+
+FString FHaversineEventLogRecord::ToString() const
+{
+	const TCHAR* TypeName = GetTypeName(Type);
+	const FString Satellite = UTF8_TO_TCHAR(SatelliteId);
+
+	switch (Type)
+	{
+		case EHaversineEventLogType::BluetoothStateChanged:
+			return FString::Printf(TEXT("%s %s"), TypeName, GetBluetoothStateName(static_cast<haversine::BluetoothState>(Flags)));
+
+		case EHaversineEventLogType::ScanCompleted:
+			return FString::Printf(TEXT("%s %s"), TypeName, (Flags & Success) ? TEXT("ok") : TEXT("with error"));
+
+		case EHaversineEventLogType::SatelliteDiscovered:
+		case EHaversineEventLogType::SatelliteStateUpdated:
+		{
+			const TCHAR* Movement = (Flags & InCollectionState) ? TEXT("collecting") : (Flags & Moving) ? TEXT("moving") : TEXT("still");
+			return FString::Printf(TEXT("%s %s [%s] FW:%d.%d %s%s%s | %d collections"), TypeName, *Satellite, Movement,
+				FirmwareVersionMajor, FirmwareVersionMinor, (Flags & Dark) ? TEXT("☾") : TEXT("☀"),
+				(Flags & NeedsServicing) ? TEXT(" ⚠") : TEXT(""), (Flags & HasDebugInfo) ? TEXT(" ☠") : TEXT(""), A);
+		}
+
+		case EHaversineEventLogType::TransfersStarting:
+			return FString::Printf(TEXT("%s %s collections %d..%d"), TypeName, *Satellite, A, B);
+
+		case EHaversineEventLogType::CollectionTransferred:
+			return FString::Printf(TEXT("%s %s collection %d, %u bytes"), TypeName, *Satellite, A, Value);
+
+		default:
+			return FString::Printf(TEXT("%s %s collection %d"), TypeName, *Satellite, A);
+	}
+}
+
+//
+// Log
+//
+
+FHaversineEventLog& FHaversineEventLog::Get()
+{
+	static FHaversineEventLog Log;
+	return Log;
+}
+
+FHaversineEventLog::FHaversineEventLog()
+{
+	Capacity = static_cast<int32>(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(FMath::Clamp(CVarHaversineEventLogCapacity.GetValueOnAnyThread(), 16, 1 << 22))));
+	Mask = static_cast<uint64>(Capacity) - 1;
+	Slots = MakeUnique<FSlot[]>(Capacity);
+
+	SystemErrorHandle = FCoreDelegates::OnHandleSystemError.AddRaw(this, &FHaversineEventLog::OnSystemError);
+}
+
+FHaversineEventLog::~FHaversineEventLog()
+{
+	FCoreDelegates::OnHandleSystemError.Remove(SystemErrorHandle);
+}
+
+void FHaversineEventLog::Write(const FHaversineEventLogRecord& Record)
+{
+	const uint64 Ticket = NextTicket.fetch_add(1, std::memory_order_relaxed);
+	FSlot& Slot = Slots[Ticket & Mask];
+
+	// Readers that see 0, or a sequence other than the one they started with, skip the slot
+	Slot.Sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	Slot.Record = Record;
+	Slot.Sequence.store(Ticket + 1, std::memory_order_release);
+}
+
+void FHaversineEventLog::CopySatelliteId(const FString& SatelliteId, FHaversineEventLogRecord& Record)
+{
+	// IDs are ASCII; anything else is replaced rather than converted
+	const int32 Length = FMath::Min(SatelliteId.Len(), static_cast<int32>(UE_ARRAY_COUNT(Record.SatelliteId)) - 1);
+	for (int32 Index = 0; Index < Length; ++Index)
+	{
+		const TCHAR Char = SatelliteId[Index];
+		Record.SatelliteId[Index] = Char < 128 ? static_cast<ANSICHAR>(Char) : '?';
+	}
+	Record.SatelliteId[Length] = '\0';
+}
+
+void FHaversineEventLog::RecordBluetoothState(haversine::BluetoothState State)
+{
+	FHaversineEventLogRecord Record;
+	Record.Cycles = FPlatformTime::Cycles64();
+	Record.Type = EHaversineEventLogType::BluetoothStateChanged;
+	Record.Flags = static_cast<uint8>(State);
+	Write(Record);
+}
+
+void FHaversineEventLog::RecordSatellite(EHaversineEventLogType Type, const FHaversineSatelliteSnapshot& Satellite)
+{
+	FHaversineEventLogRecord Record;
+	Record.Cycles = FPlatformTime::Cycles64();
+	Record.Type = Type;
+	Record.A = Satellite.CollectionCount;
+	Record.FirmwareVersionMajor = Satellite.FirmwareVersionMajor;
+	Record.FirmwareVersionMinor = Satellite.FirmwareVersionMinor;
+	Record.Flags = (Satellite.bInCollectionState ? FHaversineEventLogRecord::InCollectionState : 0)
+		| (Satellite.bIsMoving ? FHaversineEventLogRecord::Moving : 0)
+		| (Satellite.bIsDark ? FHaversineEventLogRecord::Dark : 0)
+		| (Satellite.bNeedsServicing ? FHaversineEventLogRecord::NeedsServicing : 0)
+		| (Satellite.bHasDebugInfo ? FHaversineEventLogRecord::HasDebugInfo : 0);
+	CopySatelliteId(Satellite.SatelliteId, Record);
+	Write(Record);
+}
+
+void FHaversineEventLog::RecordScanCompleted(bool bSuccess)
+{
+	FHaversineEventLogRecord Record;
+	Record.Cycles = FPlatformTime::Cycles64();
+	Record.Type = EHaversineEventLogType::ScanCompleted;
+	Record.Flags = bSuccess ? FHaversineEventLogRecord::Success : 0;
+	Write(Record);
+}
+
+void FHaversineEventLog::RecordTransfer(EHaversineEventLogType Type, const FString& SatelliteId, uint16 A, uint16 B, uint32 Value)
+{
+	FHaversineEventLogRecord Record;
+	Record.Cycles = FPlatformTime::Cycles64();
+	Record.Type = Type;
+	Record.A = A;
+	Record.B = B;
+	Record.Value = Value;
+	CopySatelliteId(SatelliteId, Record);
+	Write(Record);
+}
+
+TArray<FString> FHaversineEventLog::Format(int32 MaxEvents, const FString& SatelliteFilter) const
+{
+	const uint64 End = NextTicket.load(std::memory_order_acquire);
+	const uint64 Available = FMath::Min<uint64>(End, Capacity);
+	const uint64 Begin = End - FMath::Min<uint64>(Available, FMath::Max(0, MaxEvents));
+
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+	const FDateTime Now = FDateTime::Now();
+
+	TArray<FString> Lines;
+	Lines.Reserve(static_cast<int32>(End - Begin));
+	for (uint64 Ticket = Begin; Ticket < End; ++Ticket)
+	{
+		const FSlot& Slot = Slots[Ticket & Mask];
+		if (Slot.Sequence.load(std::memory_order_acquire) != Ticket + 1)
+		{
+			continue;
+		}
+		const FHaversineEventLogRecord Record = Slot.Record;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (Slot.Sequence.load(std::memory_order_relaxed) != Ticket + 1)
+		{
+			continue; // Overwritten while we copied it
+		}
+
+		if (!SatelliteFilter.IsEmpty() && !FString(UTF8_TO_TCHAR(Record.SatelliteId)).Contains(SatelliteFilter))
+		{
+			continue;
+		}
+
+		const double AgeSeconds = NowCycles > Record.Cycles ? FPlatformTime::ToSeconds64(NowCycles - Record.Cycles) : 0.0;
+		const FDateTime When = Now - FTimespan::FromSeconds(AgeSeconds);
+		Lines.Add(FString::Printf(TEXT("#%llu %s %s"), Ticket, *When.ToString(TEXT("%H:%M:%S.%s")), *Record.ToString()));
+	}
+	return Lines;
+}
+
+bool FHaversineEventLog::WriteToFile(const FString& Filename) const
+{
+	TArray<FString> Lines = Format(Capacity);
+	Lines.Insert(FString::Printf(TEXT("Haversine event log: %d of %llu events recorded since startup"), Lines.Num(), GetNumRecorded()), 0);
+	return FFileHelper::SaveStringArrayToFile(Lines, *Filename, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
+
+FString FHaversineEventLog::GetDefaultFilename()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Haversine") / FString::Printf(TEXT("EventLog-%s.txt"), *FDateTime::Now().ToString());
+}
+
+void FHaversineEventLog::OnSystemError()
+{
+	// Best effort: the process is going down, but the events leading up to it are the interesting part
+	const FString Filename = GetDefaultFilename();
+	if (WriteToFile(Filename))
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("Haversine event log written to %s"), *Filename);
+	}
+}
+
+//
+// Console commands
+//
+
+static FAutoConsoleCommand HaversineEventLogDumpCommand(
+	TEXT("haversine.EventLog.Dump"),
+	TEXT("Logs the most recent satellite and transfer events. Args: [Count=100] [SatelliteIdSubstring]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Count = Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 100;
+		const FString Filter = Args.IsValidIndex(1) ? Args[1] : FString();
+		const FHaversineEventLog& EventLog = FHaversineEventLog::Get();
+		for (const FString& Line : EventLog.Format(Count, Filter))
+		{
+			UE_LOG(LogHaversineSatellite, Log, TEXT("%s"), *Line);
+		}
+		UE_LOG(LogHaversineSatellite, Log, TEXT("(%llu events recorded, last %d kept)"), EventLog.GetNumRecorded(), EventLog.GetCapacity());
+	}));
+
+static FAutoConsoleCommand HaversineEventLogSaveCommand(
+	TEXT("haversine.EventLog.Save"),
+	TEXT("Writes every satellite and transfer event still in memory to a file. Args: [Filename=Saved/Haversine/EventLog-<timestamp>.txt]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString Filename = Args.IsValidIndex(0) ? Args[0] : FHaversineEventLog::GetDefaultFilename();
+		if (FHaversineEventLog::Get().WriteToFile(Filename))
+		{
+			UE_LOG(LogHaversineSatellite, Log, TEXT("✓ Event log written to %s"), *Filename);
+		}
+		else
+		{
+			UE_LOG(LogHaversineSatellite, Error, TEXT("✗ Could not write event log to %s"), *Filename);
+		}
+	}));
@@ -0,0 +1,115 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineFleetEvents.h"
+#include <atomic>
+
+enum class EHaversineEventLogType : uint8
+{
+	BluetoothStateChanged,
+	SatelliteDiscovered,
+	SatelliteStateUpdated,
+	ScanCompleted,
+	TransfersStarting,		// A = start index, B = end index
+	CollectionTransferred,	// A = collection index, Value = bytes
+	CollectionTransferFailed,	// A = collection index
+};
+
+/** One fixed-size event as stored in the ring. Nothing in it is formatted until someone reads the log. */
+struct FHaversineEventLogRecord
+{
+	/** FPlatformTime::Cycles64() when the event was recorded */
+	uint64 Cycles = 0;
+	uint32 Value = 0;
+	uint16 A = 0;
+	uint16 B = 0;
+	uint16 FirmwareVersionMajor = 0;
+	uint16 FirmwareVersionMinor = 0;
+	EHaversineEventLogType Type = EHaversineEventLogType::SatelliteStateUpdated;
+
+	/** `EFlags`; for BluetoothStateChanged, the state itself */
+	uint8 Flags = 0;
+
+	/** ASCII, NUL-terminated, truncated to fit */
+	ANSICHAR SatelliteId[34] = {};
+
+	enum EFlags : uint8
+	{
+		InCollectionState	= 1 << 0,
+		Moving				= 1 << 1,
+		Dark				= 1 << 2,
+		NeedsServicing		= 1 << 3,
+		HasDebugInfo		= 1 << 4,
+		Success				= 1 << 5,
+	};
+
+	/** Human-readable form, e.g. `SatelliteStateUpdated SIM-00042 [moving] FW:1.2 ☀ | 7 collections` */
+	FString ToString() const;
+};
+static_assert(sizeof(FHaversineEventLogRecord) == 56, "Event log records are meant to stay small and fixed-size");
+
+/**
+ * Process-wide flight recorder of satellite and transfer events.
+ *
+ * Recording copies a fixed-size binary record into a preallocated ring buffer: no formatting, no allocation and no
+ * lock, so it is cheap enough to call on every SDK callback whatever the log verbosity. The ring keeps the most
+ * recent `haversine.EventLog.Capacity` events. Text is only produced when someone asks for it with
+ * `haversine.EventLog.Dump` or `haversine.EventLog.Save`, or when the engine reports a crash, in which case the log
+ * is written to Saved/Haversine for the post-mortem.
+ *
+ * Writers claim a slot with one atomic increment and publish it with a per-slot sequence number, so readers can skip
+ * a slot that is being overwritten while they copy it. Thread-safe.
+ */
+class FHaversineEventLog
+{
+public:
+	static FHaversineEventLog& Get();
+
+	~FHaversineEventLog();
+
+	void RecordBluetoothState(haversine::BluetoothState State);
+	void RecordSatellite(EHaversineEventLogType Type, const FHaversineSatelliteSnapshot& Satellite);
+	void RecordScanCompleted(bool bSuccess);
+	void RecordTransfer(EHaversineEventLogType Type, const FString& SatelliteId, uint16 A, uint16 B = 0, uint32 Value = 0);
+
+	/**
+	 * Formats the most recent events, oldest first.
+	 * @param MaxEvents at most this many events, counted from the newest
+	 * @param SatelliteFilter only events for satellites whose ID contains this, if not empty
+	 */
+	TArray<FString> Format(int32 MaxEvents, const FString& SatelliteFilter = FString()) const;
+
+	/** Writes every event still in the ring. @return false if the file could not be written. */
+	bool WriteToFile(const FString& Filename) const;
+
+	/** Saved/Haversine/EventLog-<timestamp>.txt */
+	static FString GetDefaultFilename();
+
+	int32 GetCapacity() const { return Capacity; }
+
+	/** Events recorded since startup, including those that have since been overwritten */
+	uint64 GetNumRecorded() const { return NextTicket.load(std::memory_order_relaxed); }
+
+private:
+	FHaversineEventLog();
+
+	struct FSlot
+	{
+		/** Ticket + 1 of the record in this slot once it is complete; 0 while it is being written */
+		std::atomic<uint64> Sequence{0};
+		FHaversineEventLogRecord Record;
+	};
+
+	void Write(const FHaversineEventLogRecord& Record);
+	void OnSystemError();
+
+	static void CopySatelliteId(const FString& SatelliteId, FHaversineEventLogRecord& Record);
+
+	int32 Capacity;
+	uint64 Mask;
+	TUniquePtr<FSlot[]> Slots;
+	std::atomic<uint64> NextTicket{0};
+	FDelegateHandle SystemErrorHandle;
+};
@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineCollectionBuffer.h"
+#include "haversine/haversine_satellite_manager.h"
+#include "haversine/haversine_satellite.h"
+
+/** The parts of a satellite's state the demo acts on, copied out of the SDK's `SatelliteState` */
+struct FHaversineSatelliteSnapshot
+{
+	FString SatelliteId;
+	FString Name;
+
+	uint16 FirmwareVersionMajor = 0;
+	uint16 FirmwareVersionMinor = 0;
+	uint16 CollectionCount = 0;
+
+	bool bInCollectionState = false;
+	bool bIsMoving = false;
+	bool bIsDark = false;
+	bool bNeedsServicing = false;
+	bool bHasDebugInfo = false;
+
+	/** Copies what the demo needs out of an SDK state. Call on the thread that was handed `State`. */
+	static FHaversineSatelliteSnapshot FromSdkState(const FString& SatelliteId, const FString& Name, const haversine::SatelliteState& State)
+	{
+		FHaversineSatelliteSnapshot Snapshot;
+		Snapshot.SatelliteId = SatelliteId;
+		Snapshot.Name = Name;
+		Snapshot.FirmwareVersionMajor = State.persistent().platform_versions().firmwareVersionMajor;
+		Snapshot.FirmwareVersionMinor = State.persistent().platform_versions().firmwareVersionMinor;
+		Snapshot.CollectionCount = State.truncated_collection_count();
+		Snapshot.bInCollectionState = State.transient().inCollectionState;
+		Snapshot.bIsMoving = State.transient().isMoving;
+		Snapshot.bIsDark = State.transient().isDark;
+		Snapshot.bNeedsServicing = State.transient().needsServicing;
+		Snapshot.bHasDebugInfo = State.transient().hasDebugInfo;
+		return Snapshot;
+	}
+};
+
+/**
+ * Receives fleet events in SDK-independent form.
+ *
+ * `UHaversineDemoSubsystem` implements this. Its SDK delegates and event subscriptions translate into these calls,
+ * and so does the simulated fleet (see `HaversineFleetSimulator.h`), which is what lets one replace the other.
+ * Calls arrive on the backend's own threads, exactly as the SDK's callbacks do.
+ */
+class IHaversineFleetListener
+{
+public:
+	virtual ~IHaversineFleetListener() = default;
+
+	virtual void OnFleetBluetoothStateChanged(haversine::BluetoothState State) = 0;
+	virtual void OnFleetSatelliteDiscovered(const FHaversineSatelliteSnapshot& Satellite) = 0;
+	virtual void OnFleetSatelliteStateUpdated(const FHaversineSatelliteSnapshot& Satellite) = 0;
+	virtual void OnFleetScanCompleted(bool bSuccess, const FString& Error) = 0;
+
+	/** @return true if the backend may connect to this satellite now. Only the simulated fleet asks. */
+	virtual bool ShouldConnect(const FHaversineSatelliteSnapshot& Satellite) { return true; }
+
+	/** Same contract as `HaversineCollectionTransferDelegate::first_collection_to_transfer` */
+	virtual uint16 FirstCollectionToTransfer(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex) = 0;
+
+	/** Same contract as `HaversineCollectionTransferDelegate::will_transfer_collections` */
+	virtual void OnCollectionTransfersStarting(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex) = 0;
+	virtual void OnCollectionTransferred(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection) = 0;
+	virtual void OnCollectionTransferFailed(const FString& SatelliteId, uint16 CollectionIndex, const FString& Error) = 0;
+};
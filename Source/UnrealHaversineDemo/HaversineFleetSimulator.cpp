@@ -0,0 +1,500 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineFleetSimulator.cpp
+// UnrealHaversineDemo
+//
+// A fleet of virtual SuperTags for load testing without Bluetooth hardware
+//
+
+#include "HaversineFleetSimulator.h"
+#include "HaversineSwingCorpus.h"
+#include "SuperTagKitPlugin.h"
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<int32> CVarHaversineFleetSimulate(
+	TEXT("haversine.Fleet.Simulate"),
+	0,
+	TEXT("If positive, replace the Bluetooth SDK with this many simulated satellites (up to 10000). Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineFleetSwingIntervalSeconds(
+	TEXT("haversine.Fleet.SwingIntervalSeconds"),
+	20.0f,
+	TEXT("Mean time between swings on one simulated satellite."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineFleetInitialBacklog(
+	TEXT("haversine.Fleet.InitialBacklog"),
+	0,
+	TEXT("Collections already waiting on each simulated satellite when it is discovered."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineFleetTransferLatencyMs(
+	TEXT("haversine.Fleet.TransferLatencyMs"),
+	60.0f,
+	TEXT("Simulated time to transfer one collection."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineFleetTransferFailureRate(
+	TEXT("haversine.Fleet.TransferFailureRate"),
+	0.01f,
+	TEXT("Fraction of simulated collection transfers that fail."),
+	ECVF_ReadOnly);
+
+static constexpr int32 MaxSimulatedSatellites = 10000;
+
+// Longest the simulation thread sleeps before re-checking for new events and shutdown
+static constexpr uint32 MaxIdleWaitMs = 50;
+
+// Size of the stand-in payloads used when no corpus has been recorded
+static constexpr int32 SyntheticPayloadBytes = 4096;
+
+FHaversineFleetSimulatorConfig FHaversineFleetSimulatorConfig::FromConsoleVariables()
+{
+	FHaversineFleetSimulatorConfig Result;
+	Result.NumSatellites = CVarHaversineFleetSimulate.GetValueOnAnyThread();
+	FParse::Value(FCommandLine::Get(), TEXT("HaversineSimulatedFleet="), Result.NumSatellites);
+	Result.NumSatellites = FMath::Clamp(Result.NumSatellites, 0, MaxSimulatedSatellites);
+
+	Result.SwingIntervalSeconds = FMath::Max(0.1f, CVarHaversineFleetSwingIntervalSeconds.GetValueOnAnyThread());
+	Result.InitialBacklog = FMath::Clamp(CVarHaversineFleetInitialBacklog.GetValueOnAnyThread(), 0, static_cast<int32>(MAX_uint16));
+	Result.TransferLatencyMs = FMath::Max(0.0f, CVarHaversineFleetTransferLatencyMs.GetValueOnAnyThread());
+	Result.TransferFailureRate = FMath::Clamp(CVarHaversineFleetTransferFailureRate.GetValueOnAnyThread(), 0.0f, 1.0f);
+	Result.CorpusDirectory = FHaversineSwingCorpus::GetDirectory();
+	return Result;
+}
+
+FHaversineFleetSimulator::FHaversineFleetSimulator(const FHaversineFleetSimulatorConfig& InConfig, IHaversineFleetListener* InListener)
+	: Config(InConfig)
+	, Listener(InListener)
+	, Random(InConfig.Seed)
+{
+	check(Listener);
+
+	Corpus = FHaversineSwingCorpus::Load(Config.CorpusDirectory);
+	if (Corpus.IsEmpty())
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ No recorded collections in %s; simulated satellites will send random bytes, which swing reconstruction rejects. Record some with haversine.Corpus.Record 1."),
+			*Config.CorpusDirectory);
+
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			std::vector<uint8_t> Payload(SyntheticPayloadBytes);
+			for (uint8_t& Byte : Payload)
+			{
+				Byte = static_cast<uint8_t>(Random.RandHelper(256));
+			}
+			Corpus.Add(FHaversineCollectionBuffer::Create(MoveTemp(Payload)));
+		}
+	}
+
+	Satellites.SetNum(Config.NumSatellites);
+	for (int32 Index = 0; Index < Satellites.Num(); ++Index)
+	{
+		Satellites[Index].SatelliteId = FString::Printf(TEXT("SIM-%05d"), Index);
+	}
+}
+
+FHaversineFleetSimulator::~FHaversineFleetSimulator()
+{
+	Stop();
+}
+
+void FHaversineFleetSimulator::Start()
+{
+	if (Thread)
+	{
+		return;
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Starting simulated fleet: %d satellites, a swing every %.1f s each, %d recorded payloads"),
+		Satellites.Num(), Config.SwingIntervalSeconds, Corpus.Num());
+
+	bStopping = false;
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	{
+		FScopeLock Lock(&Mutex);
+		ScheduleLocked(FPlatformTime::Seconds(), EEventType::BluetoothPoweredOn);
+	}
+	Thread = FRunnableThread::Create(this, TEXT("HaversineFleetSimulator"), 0, TPri_Normal);
+}
+
+void FHaversineFleetSimulator::Stop()
+{
+	if (!Thread)
+	{
+		return;
+	}
+
+	bStopping = true;
+	WakeEvent->Trigger();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+void FHaversineFleetSimulator::StartScanning()
+{
+	if (bScanning.exchange(true))
+	{
+		return;
+	}
+
+	FScopeLock Lock(&Mutex);
+	ScheduleLocked(FPlatformTime::Seconds(), EEventType::ScanStarted);
+}
+
+void FHaversineFleetSimulator::StopScanning()
+{
+	if (!bScanning.exchange(false))
+	{
+		return;
+	}
+
+	FScopeLock Lock(&Mutex);
+	ScheduleLocked(FPlatformTime::Seconds(), EEventType::ScanStopped);
+}
+
+uint32 FHaversineFleetSimulator::Run()
+{
+	while (!bStopping)
+	{
+		const double NowSeconds = FPlatformTime::Seconds();
+		double NextEventSeconds = NowSeconds + MaxIdleWaitMs / 1000.0;
+
+		// Take one due event at a time, so events it schedules for "now" are processed in order
+		while (!bStopping)
+		{
+			FScheduledEvent Event;
+			{
+				FScopeLock Lock(&Mutex);
+				if (Events.IsEmpty() || Events.HeapTop().TimeSeconds > NowSeconds)
+				{
+					NextEventSeconds = Events.IsEmpty() ? NextEventSeconds : FMath::Min(NextEventSeconds, Events.HeapTop().TimeSeconds);
+					break;
+				}
+				Events.HeapPop(Event, EAllowShrinking::No);
+			}
+			ProcessEvent(Event, NowSeconds);
+		}
+
+		const double WaitMs = (NextEventSeconds - FPlatformTime::Seconds()) * 1000.0;
+		if (WaitMs > 0.0)
+		{
+			WakeEvent->Wait(static_cast<uint32>(FMath::Clamp(WaitMs, 1.0, static_cast<double>(MaxIdleWaitMs))));
+		}
+	}
+	return 0;
+}
+
+void FHaversineFleetSimulator::ScheduleLocked(double TimeSeconds, EEventType Type, int32 Satellite)
+{
+	FScheduledEvent Event;
+	Event.TimeSeconds = TimeSeconds;
+	Event.Type = Type;
+	Event.Satellite = Satellite;
+	Events.HeapPush(Event);
+
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+void FHaversineFleetSimulator::ScheduleConnectLocked(FVirtualSatellite& Satellite, int32 Index, double TimeSeconds)
+{
+	if (!Satellite.bConnected && !Satellite.bConnectScheduled && Satellite.StartIndex != Satellite.EndIndex)
+	{
+		Satellite.bConnectScheduled = true;
+		ScheduleLocked(TimeSeconds, EEventType::ConnectAttempt, Index);
+	}
+}
+
+double FHaversineFleetSimulator::SampleSwingInterval()
+{
+	// Exponential inter-arrival times: swings on a tag form a Poisson process
+	return -Config.SwingIntervalSeconds * FMath::Loge(FMath::Max(1.0f - Random.GetFraction(), UE_KINDA_SMALL_NUMBER));
+}
+
+FHaversineSatelliteSnapshot FHaversineFleetSimulator::MakeSnapshotLocked(const FVirtualSatellite& Satellite) const
+{
+	FHaversineSatelliteSnapshot Snapshot;
+	Snapshot.SatelliteId = Satellite.SatelliteId;
+	Snapshot.Name = FString::Printf(TEXT("Simulated %s"), *Satellite.SatelliteId.RightChop(4));
+	Snapshot.FirmwareVersionMajor = 10;
+	Snapshot.FirmwareVersionMinor = 0;
+	Snapshot.CollectionCount = static_cast<uint16>(Satellite.EndIndex - Satellite.StartIndex);
+	Snapshot.bInCollectionState = Satellite.bInCollectionState;
+	Snapshot.bIsMoving = Satellite.bInCollectionState;
+	return Snapshot;
+}
+
+void FHaversineFleetSimulator::ProcessEvent(const FScheduledEvent& Event, double NowSeconds)
+{
+	// Each case updates the simulation under the lock, then reports to the listener without it
+	switch (Event.Type)
+	{
+		case EEventType::BluetoothPoweredOn:
+		{
+			Listener->OnFleetBluetoothStateChanged(haversine::BluetoothState::PoweredOn);
+			break;
+		}
+
+		case EEventType::ScanStarted:
+		{
+			FScopeLock Lock(&Mutex);
+			for (int32 Index = 0; Index < Satellites.Num(); ++Index)
+			{
+				if (!Satellites[Index].bDiscovered)
+				{
+					ScheduleLocked(NowSeconds + Random.FRandRange(0.0f, Config.DiscoveryRampSeconds), EEventType::Discover, Index);
+				}
+			}
+			break;
+		}
+
+		case EEventType::ScanStopped:
+		{
+			Listener->OnFleetScanCompleted(true, FString());
+			break;
+		}
+
+		case EEventType::Discover:
+		{
+			FHaversineSatelliteSnapshot Snapshot;
+			{
+				FScopeLock Lock(&Mutex);
+				FVirtualSatellite& Satellite = Satellites[Event.Satellite];
+				if (Satellite.bDiscovered || !bScanning)
+				{
+					break;
+				}
+
+				Satellite.bDiscovered = true;
+				++Stats.Discovered;
+				for (int32 Backlog = 0; Backlog < Config.InitialBacklog; ++Backlog)
+				{
+					++Satellite.EndIndex;
+					Satellite.RecordedAtSeconds.Add(NowSeconds);
+				}
+				ScheduleLocked(NowSeconds + SampleSwingInterval(), EEventType::SwingStart, Event.Satellite);
+				ScheduleConnectLocked(Satellite, Event.Satellite, NowSeconds);
+				Snapshot = MakeSnapshotLocked(Satellite);
+			}
+			Listener->OnFleetSatelliteDiscovered(Snapshot);
+			break;
+		}
+
+		case EEventType::SwingStart:
+		{
+			FHaversineSatelliteSnapshot Snapshot;
+			{
+				FScopeLock Lock(&Mutex);
+				FVirtualSatellite& Satellite = Satellites[Event.Satellite];
+				Satellite.bInCollectionState = true;
+				ScheduleLocked(NowSeconds + Config.CollectionSeconds, EEventType::SwingEnd, Event.Satellite);
+				Snapshot = MakeSnapshotLocked(Satellite);
+			}
+			Listener->OnFleetSatelliteStateUpdated(Snapshot);
+			break;
+		}
+
+		case EEventType::SwingEnd:
+		{
+			FHaversineSatelliteSnapshot Snapshot;
+			{
+				FScopeLock Lock(&Mutex);
+				FVirtualSatellite& Satellite = Satellites[Event.Satellite];
+				Satellite.bInCollectionState = false;
+				++Satellite.EndIndex;
+				Satellite.RecordedAtSeconds.Add(NowSeconds);
+				++Stats.SwingsRecorded;
+
+				ScheduleLocked(NowSeconds + SampleSwingInterval(), EEventType::SwingStart, Event.Satellite);
+				if (bScanning)
+				{
+					ScheduleConnectLocked(Satellite, Event.Satellite, NowSeconds);
+				}
+				Snapshot = MakeSnapshotLocked(Satellite);
+			}
+			Listener->OnFleetSatelliteStateUpdated(Snapshot);
+			break;
+		}
+
+		case EEventType::ConnectAttempt:
+		{
+			FHaversineSatelliteSnapshot Snapshot;
+			{
+				FScopeLock Lock(&Mutex);
+				FVirtualSatellite& Satellite = Satellites[Event.Satellite];
+				Satellite.bConnectScheduled = false;
+				if (Satellite.bConnected || Satellite.StartIndex == Satellite.EndIndex || !bScanning)
+				{
+					break;
+				}
+				Snapshot = MakeSnapshotLocked(Satellite);
+			}
+
+			const bool bAllowed = Listener->ShouldConnect(Snapshot);
+
+			FScopeLock Lock(&Mutex);
+			FVirtualSatellite& Satellite = Satellites[Event.Satellite];
+			if (!bAllowed)
+			{
+				++Stats.ConnectionsRefused;
+				ScheduleConnectLocked(Satellite, Event.Satellite, NowSeconds + Config.ConnectRetrySeconds);
+				break;
+			}
+
+			Satellite.bConnected = true;
+			++Stats.Connected;
+			++Stats.Connections;
+			ScheduleLocked(NowSeconds + Config.ConnectLatencyMs / 1000.0, EEventType::TransferBegin, Event.Satellite);
+			break;
+		}
+
+		case EEventType::TransferBegin:
+		{
+			FString SatelliteId;
+			uint16 StartIndex = 0;
+			uint16 EndIndex = 0;
+			{
+				FScopeLock Lock(&Mutex);
+				const FVirtualSatellite& Satellite = Satellites[Event.Satellite];
+				SatelliteId = Satellite.SatelliteId;
+				StartIndex = Satellite.StartIndex;
+				EndIndex = Satellite.EndIndex;
+			}
+
+			const uint16 First = Listener->FirstCollectionToTransfer(SatelliteId, StartIndex, EndIndex);
+
+			FScopeLock Lock(&Mutex);
+			FVirtualSatellite& Satellite = Satellites[Event.Satellite];
+
+			// Like a real satellite, anything before the first requested index is gone for good
+			const uint16 Skipped = FMath::Min(static_cast<uint16>(First - StartIndex), static_cast<uint16>(EndIndex - StartIndex));
+			Satellite.StartIndex = static_cast<uint16>(StartIndex + Skipped);
+			Satellite.RecordedAtSeconds.RemoveAt(0, FMath::Min<int32>(Skipped, Satellite.RecordedAtSeconds.Num()), EAllowShrinking::No);
+			Stats.CollectionsSkipped += Skipped;
+
+			Satellite.TransferEndIndex = EndIndex;
+			if (Satellite.StartIndex == Satellite.TransferEndIndex)
+			{
+				Satellite.bConnected = false;
+				--Stats.Connected;
+				ScheduleConnectLocked(Satellite, Event.Satellite, NowSeconds);
+				break;
+			}
+			ScheduleLocked(NowSeconds + Config.TransferLatencyMs / 1000.0, EEventType::TransferNext, Event.Satellite);
+
+			// Only this thread runs events, so the first transfer cannot start before the listener has been told
+			const uint16 TransferStartIndex = Satellite.StartIndex;
+			Lock.Unlock();
+			Listener->OnCollectionTransfersStarting(SatelliteId, TransferStartIndex, EndIndex);
+			break;
+		}
+
+		case EEventType::TransferNext:
+		{
+			FString SatelliteId;
+			uint16 CollectionIndex = 0;
+			bool bFailed = false;
+			FHaversineCollectionBufferPtr Collection;
+			{
+				FScopeLock Lock(&Mutex);
+				FVirtualSatellite& Satellite = Satellites[Event.Satellite];
+				SatelliteId = Satellite.SatelliteId;
+				CollectionIndex = Satellite.StartIndex;
+				bFailed = Random.GetFraction() < Config.TransferFailureRate;
+
+				if (bFailed)
+				{
+					// The SDK drops the connection and tries the remaining collections again later
+					++Stats.TransferFailures;
+					Satellite.bConnected = false;
+					--Stats.Connected;
+					ScheduleConnectLocked(Satellite, Event.Satellite, NowSeconds + Config.ConnectRetrySeconds);
+				}
+				else
+				{
+					Collection = Corpus[Random.RandHelper(Corpus.Num())];
+					++Stats.CollectionsTransferred;
+					if (!Satellite.RecordedAtSeconds.IsEmpty())
+					{
+						const double SwingToTransferSeconds = NowSeconds - Satellite.RecordedAtSeconds[0];
+						TotalSwingToTransferSeconds += SwingToTransferSeconds;
+						Stats.MaxSwingToTransferMs = FMath::Max(Stats.MaxSwingToTransferMs, SwingToTransferSeconds * 1000.0);
+						Satellite.RecordedAtSeconds.RemoveAt(0, 1, EAllowShrinking::No);
+					}
+
+					++Satellite.StartIndex;
+					if (Satellite.StartIndex != Satellite.TransferEndIndex)
+					{
+						ScheduleLocked(NowSeconds + Config.TransferLatencyMs / 1000.0, EEventType::TransferNext, Event.Satellite);
+					}
+					else
+					{
+						// Swings recorded during the transfer need a new connection
+						Satellite.bConnected = false;
+						--Stats.Connected;
+						ScheduleConnectLocked(Satellite, Event.Satellite, NowSeconds);
+					}
+				}
+			}
+
+			if (bFailed)
+			{
+				Listener->OnCollectionTransferFailed(SatelliteId, CollectionIndex, TEXT("simulated transfer failure"));
+			}
+			else
+			{
+				Listener->OnCollectionTransferred(SatelliteId, CollectionIndex, Collection.ToSharedRef());
+			}
+			break;
+		}
+	}
+}
+
+TArray<FHaversineSatelliteSnapshot> FHaversineFleetSimulator::GetDiscoveredSatellites() const
+{
+	FScopeLock Lock(&Mutex);
+	TArray<FHaversineSatelliteSnapshot> Result;
+	for (const FVirtualSatellite& Satellite : Satellites)
+	{
+		if (Satellite.bDiscovered)
+		{
+			Result.Add(MakeSnapshotLocked(Satellite));
+		}
+	}
+	return Result;
+}
+
+FHaversineFleetSimulatorStats FHaversineFleetSimulator::GetStats() const
+{
+	FScopeLock Lock(&Mutex);
+	FHaversineFleetSimulatorStats Result = Stats;
+	Result.AverageSwingToTransferMs = Stats.CollectionsTransferred > 0
+		? TotalSwingToTransferSeconds * 1000.0 / Stats.CollectionsTransferred
+		: 0.0;
+	return Result;
+}
+
+void FHaversineFleetSimulator::LogStats() const
+{
+	const FHaversineFleetSimulatorStats Current = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Simulated fleet stats: %d/%d discovered, %d connected | swings=%llu transferred=%llu skipped=%llu failed=%llu | connections=%llu refused=%llu | swing-to-transfer avg %.1f ms max %.1f ms"),
+		Current.Discovered, Satellites.Num(), Current.Connected, Current.SwingsRecorded, Current.CollectionsTransferred,
+		Current.CollectionsSkipped, Current.TransferFailures, Current.Connections, Current.ConnectionsRefused,
+		Current.AverageSwingToTransferMs, Current.MaxSwingToTransferMs);
+}
@@ -0,0 +1,160 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineFleetEvents.h"
+#include "HAL/Runnable.h"
+#include "Math/RandomStream.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+
+/** Shape of the simulated fleet */
+struct FHaversineFleetSimulatorConfig
+{
+	/** Number of virtual tags, 1 to 10,000. 0 means use the real SDK. */
+	int32 NumSatellites = 0;
+
+	/** Mean time between swings on one tag (exponentially distributed) */
+	float SwingIntervalSeconds = 20.0f;
+
+	/** How long a tag stays in collection state while a swing is recorded */
+	float CollectionSeconds = 1.5f;
+
+	/** Tags are discovered at random times within this window after scanning starts */
+	float DiscoveryRampSeconds = 5.0f;
+
+	/** Collections already waiting on every tag when it is discovered */
+	int32 InitialBacklog = 0;
+
+	float ConnectLatencyMs = 400.0f;
+	float TransferLatencyMs = 60.0f;
+	float TransferFailureRate = 0.01f;
+
+	/** How soon a refused or failed connection is tried again */
+	float ConnectRetrySeconds = 1.0f;
+
+	/** Recorded collections to play back; see `HaversineSwingCorpus.h` */
+	FString CorpusDirectory;
+
+	int32 Seed = 0;
+
+	/** Reads `haversine.Fleet.*` console variables; `-HaversineSimulatedFleet=N` on the command line overrides the size */
+	static FHaversineFleetSimulatorConfig FromConsoleVariables();
+};
+
+/** Point-in-time counters for `FHaversineFleetSimulator` */
+struct FHaversineFleetSimulatorStats
+{
+	int32 Discovered = 0;
+	int32 Connected = 0;
+	uint64 SwingsRecorded = 0;
+	uint64 ConnectionsRefused = 0;
+	uint64 Connections = 0;
+	uint64 CollectionsTransferred = 0;
+	uint64 CollectionsSkipped = 0;
+	uint64 TransferFailures = 0;
+
+	/** From the end of a swing on the tag to its collection being handed to the listener */
+	double AverageSwingToTransferMs = 0.0;
+	double MaxSwingToTransferMs = 0.0;
+};
+
+/**
+ * Stand-in for `HaversineSatelliteManager` that needs no Bluetooth hardware.
+ *
+ * It runs a fleet of virtual tags on its own thread, the way the SDK runs its Bluetooth thread, and reports
+ * Bluetooth state, discovery, state updates, scan completion and collection transfers to an
+ * `IHaversineFleetListener`. Tags record swings at random, ask the listener for permission to connect, honour
+ * `FirstCollectionToTransfer`, and deliver collections one by one with configurable latency and failures. Payloads
+ * are drawn from a recorded corpus, so swing reconstruction downstream does real work.
+ */
+class FHaversineFleetSimulator : public FRunnable
+{
+public:
+	FHaversineFleetSimulator(const FHaversineFleetSimulatorConfig& InConfig, IHaversineFleetListener* InListener);
+	virtual ~FHaversineFleetSimulator() override;
+
+	/** Starts the simulation thread, which reports Bluetooth as powered on */
+	void Start();
+
+	/** Stops the simulation thread. No listener calls are made after this returns. */
+	void Stop();
+
+	void StartScanning();
+	void StopScanning();
+	bool IsScanning() const { return bScanning.load(); }
+
+	TArray<FHaversineSatelliteSnapshot> GetDiscoveredSatellites() const;
+
+	FHaversineFleetSimulatorStats GetStats() const;
+	void LogStats() const;
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+
+private:
+	enum class EEventType : uint8
+	{
+		BluetoothPoweredOn,
+		ScanStarted,
+		ScanStopped,
+		Discover,
+		SwingStart,
+		SwingEnd,
+		ConnectAttempt,
+		TransferBegin,
+		TransferNext,
+	};
+
+	struct FScheduledEvent
+	{
+		double TimeSeconds = 0.0;
+		EEventType Type = EEventType::Discover;
+		int32 Satellite = INDEX_NONE;
+
+		bool operator<(const FScheduledEvent& Other) const { return TimeSeconds < Other.TimeSeconds; }
+	};
+
+	struct FVirtualSatellite
+	{
+		FString SatelliteId;
+		uint16 StartIndex = 0;
+		uint16 EndIndex = 0;
+		uint16 TransferEndIndex = 0;
+
+		bool bDiscovered = false;
+		bool bInCollectionState = false;
+		bool bConnected = false;
+		bool bConnectScheduled = false;
+
+		/** When each waiting collection finished recording, oldest first */
+		TArray<double> RecordedAtSeconds;
+	};
+
+	void ProcessEvent(const FScheduledEvent& Event, double NowSeconds);
+	void ScheduleLocked(double TimeSeconds, EEventType Type, int32 Satellite = INDEX_NONE);
+	void ScheduleConnectLocked(FVirtualSatellite& Satellite, int32 Index, double TimeSeconds);
+	FHaversineSatelliteSnapshot MakeSnapshotLocked(const FVirtualSatellite& Satellite) const;
+	double SampleSwingInterval();
+
+	FHaversineFleetSimulatorConfig Config;
+	IHaversineFleetListener* Listener;
+	TArray<FHaversineCollectionBufferRef> Corpus;
+
+	// Guards the event heap, the satellites and the counters. Never held while calling the listener.
+	mutable FCriticalSection Mutex;
+	TArray<FScheduledEvent> Events;
+	TArray<FVirtualSatellite> Satellites;
+	FRandomStream Random;
+
+	FHaversineFleetSimulatorStats Stats;
+	double TotalSwingToTransferSeconds = 0.0;
+
+	std::atomic<bool> bScanning{false};
+	std::atomic<bool> bStopping{false};
+	FEvent* WakeEvent = nullptr;
+	FRunnableThread* Thread = nullptr;
+};
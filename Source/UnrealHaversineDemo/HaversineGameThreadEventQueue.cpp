@@ -0,0 +1,299 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineGameThreadEventQueue.cpp
+// UnrealHaversineDemo
+//
+// Hands fleet events from backend threads to the game thread under a per-tick time budget
+//
+
+#include "HaversineGameThreadEventQueue.h"
+#include "SuperTagKitPlugin.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarHaversineEventsBudgetMs(
+	TEXT("haversine.Events.BudgetMs"),
+	1.0f,
+	TEXT("Game-thread milliseconds per tick spent handling satellite events; the rest wait for the next tick. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineEventsMaxSatelliteUpdatesPerSecond(
+	TEXT("haversine.Events.MaxSatelliteUpdatesPerSecond"),
+	2.0f,
+	TEXT("Discovery and state events handled per satellite per second; newer ones replace older ones while they wait. ")
+	TEXT("Entering the collection state is never delayed. 0 disables the limit. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+FHaversineGameThreadEventQueueConfig FHaversineGameThreadEventQueueConfig::FromConsoleVariables()
+{
+	FHaversineGameThreadEventQueueConfig Result;
+	Result.BudgetMs = FMath::Max(0.0f, CVarHaversineEventsBudgetMs.GetValueOnAnyThread());
+	Result.MaxSatelliteUpdatesPerSecond = FMath::Max(0.0f, CVarHaversineEventsMaxSatelliteUpdatesPerSecond.GetValueOnAnyThread());
+	return Result;
+}
+
+FHaversineGameThreadEventQueue::FHaversineGameThreadEventQueue(const FHaversineGameThreadEventQueueConfig& InConfig, FDispatchFunction&& InDispatch)
+	: Config(InConfig)
+	, Dispatch(MoveTemp(InDispatch))
+{
+}
+
+FHaversineGameThreadEventQueue::~FHaversineGameThreadEventQueue()
+{
+	Shutdown();
+}
+
+void FHaversineGameThreadEventQueue::Start()
+{
+	check(IsInGameThread());
+	if (!TickerHandle.IsValid())
+	{
+		// A zero delay ticks once per frame
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FHaversineGameThreadEventQueue::Tick), 0.0f);
+	}
+}
+
+void FHaversineGameThreadEventQueue::Shutdown()
+{
+	bAccepting.store(false, std::memory_order_release);
+
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	int32 Dropped = Pending.Num() - PendingHead + NumHeld;
+	FHaversineFleetEvent Event;
+	while (Incoming.Dequeue(Event))
+	{
+		++Dropped;
+	}
+	Pending.Reset();
+	PendingHead = 0;
+	PendingBySatellite.Reset();
+	Throttles.Reset();
+	NumHeld = 0;
+
+	if (Dropped > 0)
+	{
+		UE_LOG(LogHaversineSatellite, Log, TEXT("Dropped %d satellite events still waiting for the game thread"), Dropped);
+	}
+}
+
+void FHaversineGameThreadEventQueue::Enqueue(FHaversineFleetEvent&& Event)
+{
+	if (!bAccepting.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	Event.EnqueueCycles = FPlatformTime::Cycles64();
+	Incoming.Enqueue(MoveTemp(Event));
+	Enqueued.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FHaversineGameThreadEventQueue::Collect(double NowSeconds)
+{
+	const double MinIntervalSeconds = Config.MaxSatelliteUpdatesPerSecond > 0.0f ? 1.0 / Config.MaxSatelliteUpdatesPerSecond : 0.0;
+
+	FHaversineFleetEvent Event;
+	while (Incoming.Dequeue(Event))
+	{
+		const bool bSatelliteEvent = Event.Type == EHaversineFleetEventType::SatelliteDiscovered
+			|| Event.Type == EHaversineFleetEventType::SatelliteStateUpdated;
+		if (!bSatelliteEvent)
+		{
+			Pending.Add(MoveTemp(Event));
+			continue;
+		}
+
+		FSatelliteThrottle& Throttle = Throttles.FindOrAdd(Event.Satellite.SatelliteId);
+		const bool bUrgent = IsUrgent(Event, Throttle);
+
+		// Already held back: the newer state takes its place, and goes out now if it cannot wait
+		if (Throttle.Held.IsSet())
+		{
+			Fold(Throttle.Held.GetValue(), MoveTemp(Event));
+			++Coalesced;
+			if (bUrgent)
+			{
+				++Bypassed;
+				--NumHeld;
+				AddPending(MoveTemp(Throttle.Held.GetValue()));
+				Throttle.Held.Reset();
+			}
+			continue;
+		}
+
+		// Already on its way to the handlers, or due anyway
+		if (PendingBySatellite.Contains(Event.Satellite.SatelliteId) || NowSeconds - Throttle.LastDispatchSeconds >= MinIntervalSeconds)
+		{
+			AddPending(MoveTemp(Event));
+			continue;
+		}
+
+		if (bUrgent)
+		{
+			++Bypassed;
+			AddPending(MoveTemp(Event));
+			continue;
+		}
+
+		Throttle.Held.Emplace(MoveTemp(Event));
+		++NumHeld;
+		++RateLimited;
+	}
+}
+
+void FHaversineGameThreadEventQueue::ReleaseHeld(double NowSeconds)
+{
+	if (NumHeld == 0)
+	{
+		return;
+	}
+
+	const double MinIntervalSeconds = Config.MaxSatelliteUpdatesPerSecond > 0.0f ? 1.0 / Config.MaxSatelliteUpdatesPerSecond : 0.0;
+	for (TPair<FString, FSatelliteThrottle>& Pair : Throttles)
+	{
+		FSatelliteThrottle& Throttle = Pair.Value;
+		if (Throttle.Held.IsSet() && NowSeconds - Throttle.LastDispatchSeconds >= MinIntervalSeconds)
+		{
+			AddPending(MoveTemp(Throttle.Held.GetValue()));
+			Throttle.Held.Reset();
+			--NumHeld;
+		}
+	}
+}
+
+void FHaversineGameThreadEventQueue::AddPending(FHaversineFleetEvent&& Event)
+{
+	// Anything newer for a satellite folds into the event still waiting for it; a waiting discovery stays a
+	// discovery, and a repeat discovery turns the waiting event into one, so each satellite is dispatched once
+	const int32* Waiting = PendingBySatellite.Find(Event.Satellite.SatelliteId);
+	if (Waiting)
+	{
+		Fold(Pending[*Waiting], MoveTemp(Event));
+		++Coalesced;
+		return;
+	}
+
+	PendingBySatellite.Add(Event.Satellite.SatelliteId, Pending.Num());
+	Pending.Add(MoveTemp(Event));
+}
+
+bool FHaversineGameThreadEventQueue::IsUrgent(const FHaversineFleetEvent& Event, const FSatelliteThrottle& Throttle)
+{
+	// A swing is being recorded (a transfer follows), or the tag needs attention
+	return (Event.Satellite.bInCollectionState && !Throttle.bInCollectionState)
+		|| (Event.Satellite.bNeedsServicing && !Throttle.bNeedsServicing);
+}
+
+void FHaversineGameThreadEventQueue::Fold(FHaversineFleetEvent& Existing, FHaversineFleetEvent&& Incoming)
+{
+	FString Name = Incoming.Satellite.Name.IsEmpty() ? MoveTemp(Existing.Satellite.Name) : MoveTemp(Incoming.Satellite.Name);
+	Existing.Satellite = MoveTemp(Incoming.Satellite);
+	Existing.Satellite.Name = MoveTemp(Name);
+
+	// The handlers still need to see the discovery, with the newest state copy
+	if (Incoming.Type == EHaversineFleetEventType::SatelliteDiscovered)
+	{
+		Existing.Type = EHaversineFleetEventType::SatelliteDiscovered;
+		Existing.SdkState = MoveTemp(Incoming.SdkState);
+	}
+}
+
+bool FHaversineGameThreadEventQueue::Tick(float DeltaTime)
+{
+	const double NowSeconds = FPlatformTime::Seconds();
+	Collect(NowSeconds);
+	ReleaseHeld(NowSeconds);
+
+	const int32 Backlog = Pending.Num() - PendingHead;
+	if (Backlog == 0)
+	{
+		return true;
+	}
+	MaxBacklog = FMath::Max(MaxBacklog, Backlog);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const uint64 BudgetCycles = static_cast<uint64>(Config.BudgetMs / FPlatformTime::ToMilliseconds64(1));
+	uint64 NowCycles = StartCycles;
+	do
+	{
+		// Move the event out first: the handler may be slow, and later updates for this satellite must queue anew
+		FHaversineFleetEvent Event = MoveTemp(Pending[PendingHead]);
+		++PendingHead;
+		if (Event.Type == EHaversineFleetEventType::SatelliteDiscovered || Event.Type == EHaversineFleetEventType::SatelliteStateUpdated)
+		{
+			PendingBySatellite.Remove(Event.Satellite.SatelliteId);
+
+			FSatelliteThrottle& Throttle = Throttles.FindOrAdd(Event.Satellite.SatelliteId);
+			Throttle.LastDispatchSeconds = NowSeconds;
+			Throttle.bInCollectionState = Event.Satellite.bInCollectionState;
+			Throttle.bNeedsServicing = Event.Satellite.bNeedsServicing;
+		}
+
+		const double LatencyMs = FPlatformTime::ToMilliseconds64(NowCycles - Event.EnqueueCycles);
+		TotalLatencyMs += LatencyMs;
+		MaxLatencyMs = FMath::Max(MaxLatencyMs, LatencyMs);
+		++Dispatched;
+
+		Dispatch(Event);
+		NowCycles = FPlatformTime::Cycles64();
+	}
+	while (PendingHead < Pending.Num() && NowCycles - StartCycles < BudgetCycles);
+
+	MaxTickMs = FMath::Max(MaxTickMs, FPlatformTime::ToMilliseconds64(NowCycles - StartCycles));
+
+	if (PendingHead == Pending.Num())
+	{
+		// Everything went out; reuse the allocation from the start
+		Pending.Reset();
+		PendingHead = 0;
+		return true;
+	}
+
+	++TicksOverBudget;
+
+	// Under sustained load the queue may never empty; drop the dispatched prefix once it is most of the array
+	if (PendingHead >= 1024 && PendingHead * 2 >= Pending.Num())
+	{
+		Pending.RemoveAt(0, PendingHead, EAllowShrinking::No);
+		for (TPair<FString, int32>& Pair : PendingBySatellite)
+		{
+			Pair.Value -= PendingHead;
+		}
+		PendingHead = 0;
+	}
+	return true;
+}
+
+FHaversineGameThreadEventQueueStats FHaversineGameThreadEventQueue::GetStats() const
+{
+	FHaversineGameThreadEventQueueStats Stats;
+	Stats.Enqueued = Enqueued.load(std::memory_order_relaxed);
+	Stats.Dispatched = Dispatched;
+	Stats.Coalesced = Coalesced;
+	Stats.RateLimited = RateLimited;
+	Stats.Bypassed = Bypassed;
+	Stats.Held = NumHeld;
+	Stats.Backlog = static_cast<int32>(Stats.Enqueued - Dispatched - Coalesced);
+	Stats.MaxBacklog = MaxBacklog;
+	Stats.TicksOverBudget = TicksOverBudget;
+	Stats.MaxTickMs = MaxTickMs;
+	Stats.AverageLatencyMs = Dispatched > 0 ? TotalLatencyMs / Dispatched : 0.0;
+	Stats.MaxLatencyMs = MaxLatencyMs;
+	return Stats;
+}
+
+void FHaversineGameThreadEventQueue::LogStats() const
+{
+	const FHaversineGameThreadEventQueueStats Stats = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Game thread event stats (%.2f ms budget, %.1f updates/s per satellite): enqueued=%llu dispatched=%llu coalesced=%llu | rate-limited=%llu bypassed=%llu held=%d | backlog=%d max %d | over budget %llu ticks, tick max %.2f ms | latency avg %.2f ms max %.2f ms"),
+		Config.BudgetMs, Config.MaxSatelliteUpdatesPerSecond, Stats.Enqueued, Stats.Dispatched, Stats.Coalesced,
+		Stats.RateLimited, Stats.Bypassed, Stats.Held, Stats.Backlog, Stats.MaxBacklog,
+		Stats.TicksOverBudget, Stats.MaxTickMs, Stats.AverageLatencyMs, Stats.MaxLatencyMs);
+}
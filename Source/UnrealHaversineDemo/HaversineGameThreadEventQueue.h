@@ -0,0 +1,181 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineFleetEvents.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "haversine/haversine_satellite.h"
+#include <atomic>
+#include <memory>
+
+enum class EHaversineFleetEventType : uint8
+{
+	BluetoothStateChanged,
+	SatelliteDiscovered,
+	SatelliteStateUpdated,
+	ScanCompleted,
+};
+
+/** A fleet event on its way from a backend thread to the game thread */
+struct FHaversineFleetEvent
+{
+	EHaversineFleetEventType Type = EHaversineFleetEventType::SatelliteStateUpdated;
+
+	/** BluetoothStateChanged */
+	haversine::BluetoothState BluetoothState = haversine::BluetoothState::Unknown;
+
+	/** SatelliteDiscovered and SatelliteStateUpdated. Later updates for the same satellite overwrite it while queued. */
+	FHaversineSatelliteSnapshot Satellite;
+
+	/** SatelliteDiscovered from the SDK: the satellite's state, copied when it was reported, to parse metadata from */
+	std::shared_ptr<const haversine::SatelliteState> SdkState;
+
+	/** ScanCompleted */
+	bool bSuccess = true;
+	FString Error;
+
+	/** FPlatformTime::Cycles64() when the event was queued */
+	uint64 EnqueueCycles = 0;
+};
+
+struct FHaversineGameThreadEventQueueConfig
+{
+	/** Game-thread time spent dispatching events per tick. At least one event is dispatched every tick. */
+	float BudgetMs = 1.0f;
+
+	/**
+	 * Discovery and state events handled per satellite per second; 0 for no limit. Entering the collection state,
+	 * starting to need servicing and a satellite's first event are always handled at once.
+	 */
+	float MaxSatelliteUpdatesPerSecond = 2.0f;
+
+	/** Reads `haversine.Events.*` console variables */
+	static FHaversineGameThreadEventQueueConfig FromConsoleVariables();
+};
+
+/** Point-in-time counters for `FHaversineGameThreadEventQueue` */
+struct FHaversineGameThreadEventQueueStats
+{
+	uint64 Enqueued = 0;
+	uint64 Dispatched = 0;
+
+	/** State updates folded into an earlier queued or held event for the same satellite */
+	uint64 Coalesced = 0;
+
+	/** Events held back by the per-satellite rate limit, and those let through early as important transitions */
+	uint64 RateLimited = 0;
+	uint64 Bypassed = 0;
+
+	/** Satellites with an event currently held back */
+	int32 Held = 0;
+
+	/** Events still waiting, and the most that have ever waited at the start of a tick */
+	int32 Backlog = 0;
+	int32 MaxBacklog = 0;
+
+	/** Ticks that ran out of budget with events left over */
+	uint64 TicksOverBudget = 0;
+	double MaxTickMs = 0.0;
+	double AverageLatencyMs = 0.0;
+	double MaxLatencyMs = 0.0;
+};
+
+/**
+ * Carries fleet events from the SDK's (or the simulator's) threads to the game thread.
+ *
+ * Producers push into a lock-free multi-producer queue and return at once; they never contend with each other or
+ * with the game thread. Once per tick the game thread drains the queue and dispatches events until its time budget
+ * is spent, carrying the rest over to the next tick, so a whole fleet broadcasting at once cannot cause a hitch.
+ *
+ * While an event waits, a newer state update for the same satellite replaces its snapshot instead of being queued
+ * behind it. Only the latest state of each satellite is dispatched, so the backlog is bounded by fleet size.
+ *
+ * Moving tags report state many times a second. Each satellite's discovery and state events are therefore
+ * dispatched at most `MaxSatelliteUpdatesPerSecond` times a second: anything arriving sooner is held, folded into
+ * the latest, and released when the satellite's interval is up. Transitions that matter right away (entering the
+ * collection state, needing servicing) skip the wait.
+ */
+class FHaversineGameThreadEventQueue
+{
+public:
+	using FDispatchFunction = TFunction<void(const FHaversineFleetEvent&)>;
+
+	FHaversineGameThreadEventQueue(const FHaversineGameThreadEventQueueConfig& InConfig, FDispatchFunction&& InDispatch);
+	~FHaversineGameThreadEventQueue();
+
+	FHaversineGameThreadEventQueue(const FHaversineGameThreadEventQueue&) = delete;
+	FHaversineGameThreadEventQueue& operator=(const FHaversineGameThreadEventQueue&) = delete;
+
+	/** Starts draining once per tick. Must be called on the game thread. */
+	void Start();
+
+	/** Stops draining and drops anything still queued. Must be called on the game thread. */
+	void Shutdown();
+
+	/** Queue an event for the game thread. Safe to call from any thread; never blocks. */
+	void Enqueue(FHaversineFleetEvent&& Event);
+
+	/** Game thread only */
+	FHaversineGameThreadEventQueueStats GetStats() const;
+	void LogStats() const;
+
+private:
+	bool Tick(float DeltaTime);
+
+	/** Per-satellite rate limiting state, game thread only */
+	struct FSatelliteThrottle
+	{
+		double LastDispatchSeconds = -DBL_MAX;
+		bool bInCollectionState = false;
+		bool bNeedsServicing = false;
+
+		/** Latest event held back by the rate limit, if any */
+		TOptional<FHaversineFleetEvent> Held;
+	};
+
+	/**
+	 * Moves everything from the lock-free queue into `Pending`, folding state updates into queued events and
+	 * holding back satellites that were dispatched too recently
+	 */
+	void Collect(double NowSeconds);
+
+	/** Moves held events whose satellite's interval is up into `Pending` */
+	void ReleaseHeld(double NowSeconds);
+
+	/** Adds a satellite event to `Pending`, or folds it into the one already waiting there */
+	void AddPending(FHaversineFleetEvent&& Event);
+
+	/** Whether this event reports a transition that must not wait for the rate limit */
+	static bool IsUrgent(const FHaversineFleetEvent& Event, const FSatelliteThrottle& Throttle);
+
+	/** Replaces `Existing`'s snapshot with `Incoming`'s, keeping a discovery a discovery */
+	static void Fold(FHaversineFleetEvent& Existing, FHaversineFleetEvent&& Incoming);
+
+	FHaversineGameThreadEventQueueConfig Config;
+	FDispatchFunction Dispatch;
+
+	TQueue<FHaversineFleetEvent, EQueueMode::Mpsc> Incoming;
+	std::atomic<uint64> Enqueued{0};
+	std::atomic<bool> bAccepting{true};
+
+	// Game thread only. `Pending[PendingHead..]` are waiting; `PendingBySatellite` maps a satellite to its waiting event.
+	TArray<FHaversineFleetEvent> Pending;
+	int32 PendingHead = 0;
+	TMap<FString, int32> PendingBySatellite;
+	TMap<FString, FSatelliteThrottle> Throttles;
+	int32 NumHeld = 0;
+
+	uint64 Dispatched = 0;
+	uint64 Coalesced = 0;
+	uint64 RateLimited = 0;
+	uint64 Bypassed = 0;
+	uint64 TicksOverBudget = 0;
+	int32 MaxBacklog = 0;
+	double MaxTickMs = 0.0;
+	double TotalLatencyMs = 0.0;
+	double MaxLatencyMs = 0.0;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,195 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineIngestCommandlet.cpp
+// UnrealHaversineDemo
+//
+// Headless ingest loop: satellite manager, swing pipeline and uploads without a game world
+//
+
+#include "HaversineIngestCommandlet.h"
+#include "HaversineDemoSubsystem.h"
+#include "HaversineReplayBenchmark.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Parse.h"
+
+UHaversineIngestCommandlet::UHaversineIngestCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UHaversineIngestCommandlet::Main(const FString& Params)
+{
+	double DurationSeconds = 0.0;
+	double StatsIntervalSeconds = 10.0;
+	double TickRate = 60.0;
+	FParse::Value(*Params, TEXT("Duration="), DurationSeconds);
+	FParse::Value(*Params, TEXT("StatsInterval="), StatsIntervalSeconds);
+	FParse::Value(*Params, TEXT("TickRate="), TickRate);
+	const double TickSeconds = 1.0 / FMath::Clamp(TickRate, 1.0, 1000.0);
+
+	FString ReplayFilename;
+	FString BaselineFilename;
+	FString WriteBaselineFilename;
+	double ReplaySpeed = 0.0;
+	double Tolerance = 0.1;
+	FParse::Value(*Params, TEXT("Replay="), ReplayFilename);
+	FParse::Value(*Params, TEXT("Speed="), ReplaySpeed);
+	FParse::Value(*Params, TEXT("Baseline="), BaselineFilename);
+	FParse::Value(*Params, TEXT("WriteBaseline="), WriteBaselineFilename);
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+	const bool bReplay = !ReplayFilename.IsEmpty();
+
+	// The counter can only be installed at module startup, before other threads are allocating
+	if (bReplay && !FHaversineReplayBenchmark::IsCountingAllocations())
+	{
+		UE_LOG(LogHaversineSatellite, Log, TEXT("→ Allocations per swing are not measured; add -%s to measure them"), FHaversineReplayBenchmark::CountAllocationsSwitch);
+	}
+
+	// A game instance is all the subsystem needs; no world or map is created, so nothing renders or spawns
+	const double StartSeconds = FPlatformTime::Seconds();
+	UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine);
+	GameInstance->AddToRoot();
+	GameInstance->Init();
+
+	UHaversineDemoSubsystem* Subsystem = GameInstance->GetSubsystem<UHaversineDemoSubsystem>();
+	if (!Subsystem)
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("✗ Haversine subsystem did not start"));
+		GameInstance->Shutdown();
+		GameInstance->RemoveFromRoot();
+		return 1;
+	}
+	UE_LOG(LogHaversineSatellite, Log, TEXT("✓ Headless ingest started in %.0f ms (%s, ticking at %.0f Hz)"),
+		(FPlatformTime::Seconds() - StartSeconds) * 1000.0,
+		DurationSeconds > 0.0 ? *FString::Printf(TEXT("running for %.0f s"), DurationSeconds) : TEXT("running until interrupted"), 1.0 / TickSeconds);
+
+	// Everything the subsystem schedules (event queue, uploads, journal, token fetches) runs from the core ticker or
+	// as game-thread tasks, so pumping both is the whole main loop
+	FHaversineIngestStats Previous;
+	FHaversineReplayBenchmark Benchmark;
+	bool bReplayStarted = false;
+	bool bReplayCompleted = false;
+	int32 ExitCode = 0;
+	double LastTickSeconds = FPlatformTime::Seconds();
+	double LastStatsSeconds = LastTickSeconds;
+	while (!IsEngineExitRequested() && (DurationSeconds <= 0.0 || LastTickSeconds - StartSeconds < DurationSeconds))
+	{
+		const double NowSeconds = FPlatformTime::Seconds();
+		const float DeltaTime = static_cast<float>(NowSeconds - LastTickSeconds);
+		LastTickSeconds = NowSeconds;
+
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FTSTicker::GetCoreTicker().Tick(DeltaTime);
+
+		// The replay needs the pipeline running, i.e. the subsystem ready
+		if (bReplay && !bReplayStarted && Subsystem->IsReady())
+		{
+			if (!Benchmark.Start(*Subsystem, ReplayFilename, ReplaySpeed))
+			{
+				ExitCode = 1;
+				break;
+			}
+			bReplayStarted = true;
+		}
+		if (bReplayStarted && Benchmark.Poll())
+		{
+			bReplayCompleted = true;
+			break;
+		}
+
+		if (StatsIntervalSeconds > 0.0 && NowSeconds - LastStatsSeconds >= StatsIntervalSeconds)
+		{
+			const FHaversineIngestStats Stats = Subsystem->GetIngestStats();
+			const double Elapsed = NowSeconds - LastStatsSeconds;
+			UE_LOG(LogHaversineSatellite, Log,
+				TEXT("Ingest: %d satellites | %.1f collections/s %.1f swings/s %.1f uploads/s | totals: transferred=%llu published=%llu discarded=%llu uploaded=%llu failed=%llu pending=%d"),
+				Stats.Satellites,
+				(Stats.CollectionsTransferred - Previous.CollectionsTransferred) / Elapsed,
+				(Stats.SwingsPublished - Previous.SwingsPublished) / Elapsed,
+				(Stats.SwingsUploaded - Previous.SwingsUploaded) / Elapsed,
+				Stats.CollectionsTransferred, Stats.SwingsPublished, Stats.SwingsDiscarded, Stats.SwingsUploaded, Stats.UploadsFailed, Stats.UploadsPending);
+			Previous = Stats;
+			LastStatsSeconds = NowSeconds;
+		}
+
+		const double Remaining = TickSeconds - (FPlatformTime::Seconds() - NowSeconds);
+		if (Remaining > 0.0)
+		{
+			FPlatformProcess::Sleep(static_cast<float>(Remaining));
+		}
+	}
+
+	if (bReplayStarted)
+	{
+		ExitCode = ReportReplay(Benchmark, bReplayCompleted, BaselineFilename, WriteBaselineFilename, Tolerance);
+	}
+	else if (bReplay && ExitCode == 0)
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("✗ Replay never started: the subsystem did not become ready"));
+		ExitCode = 1;
+	}
+
+	// Deinitialize drains the pipeline and flushes uploads, and logs every component's final stats
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Headless ingest stopping after %.0f s"), FPlatformTime::Seconds() - StartSeconds);
+	GameInstance->Shutdown();
+	GameInstance->RemoveFromRoot();
+	return ExitCode;
+}
+
+int32 UHaversineIngestCommandlet::ReportReplay(FHaversineReplayBenchmark& Benchmark, bool bCompleted, const FString& BaselineFilename, const FString& WriteBaselineFilename, double Tolerance)
+{
+	// Measured before shutdown, which drains and uploads and would add to every number
+	const FHaversineReplayBenchmarkResult Result = Benchmark.Finish();
+	Result.Log();
+	if (!bCompleted)
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("✗ Replay did not finish before the ingest stopped; results are partial"));
+		return 1;
+	}
+
+	if (!WriteBaselineFilename.IsEmpty())
+	{
+		if (Result.SaveBaseline(WriteBaselineFilename))
+		{
+			UE_LOG(LogHaversineSatellite, Log, TEXT("✓ Baseline written to %s"), *WriteBaselineFilename);
+		}
+		else
+		{
+			UE_LOG(LogHaversineSatellite, Error, TEXT("✗ Could not write baseline %s"), *WriteBaselineFilename);
+			return 1;
+		}
+	}
+
+	if (BaselineFilename.IsEmpty())
+	{
+		return 0;
+	}
+
+	FHaversineReplayBenchmarkResult Baseline;
+	if (!FHaversineReplayBenchmarkResult::LoadBaseline(BaselineFilename, Baseline))
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("✗ Could not read baseline %s"), *BaselineFilename);
+		return 1;
+	}
+
+	const TArray<FString> Regressions = Result.FindRegressions(Baseline, Tolerance);
+	for (const FString& Regression : Regressions)
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("✗ Regression: %s"), *Regression);
+	}
+	if (!Regressions.IsEmpty())
+	{
+		return 1;
+	}
+	UE_LOG(LogHaversineSatellite, Log, TEXT("✓ No regressions against %s (tolerance %.0f%%)"), *BaselineFilename, Tolerance * 100.0);
+	return 0;
+}
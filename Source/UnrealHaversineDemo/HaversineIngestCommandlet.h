@@ -0,0 +1,52 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "HaversineIngestCommandlet.generated.h"
+
+class FHaversineReplayBenchmark;
+
+/**
+ * Headless swing ingest for back-room boxes: scanning, transfer, reconstruction and upload, and nothing else.
+ *
+ * Runs `UHaversineDemoSubsystem` in a bare game instance, with no world, map, pawn or renderer, and ticks it until
+ * the duration elapses or the process is asked to exit (Ctrl+C). Throughput is logged at a fixed interval.
+ *
+ *   UnrealEditor-Cmd UnrealHaversineDemo.uproject -run=HaversineIngest -nullrhi -unattended [-Duration=<s>] [-StatsInterval=<s>] [-TickRate=<Hz>]
+ *
+ * The usual `haversine.*` console variables apply (`-ini:Engine:[ConsoleVariables]:...` or `-ExecCmds`), so the
+ * same box can run against the simulated fleet or the mock upload server.
+ *
+ * With `-Replay=<recording>` it benchmarks instead (see `HaversineReplayBenchmark.h`): once the subsystem is ready the
+ * recording is played through the swing path, and the run ends when every replayed swing has left the pipeline.
+ *
+ *   ... -run=HaversineIngest -nullrhi -unattended -Replay=<file.hvrec> [-Speed=<0 max | 1 real time | N>] [-TickRate=1000]
+ *       [-WriteBaseline=<file.json>] [-Baseline=<file.json> [-Tolerance=0.1]] [-HaversineCountAllocations]
+ *
+ * `-HaversineCountAllocations` wraps the allocator when the game module starts and adds heap allocations per swing to
+ * the result. The count covers every thread in the process, not only the swing path.
+ *
+ * Replayed swings are never uploaded to SkyGolf or written to the swing journal or upload spool: they go to the mock
+ * upload server if it is running (`-ExecCmds="haversine.MockUpload.Start"`), so upload batching is measured too, and
+ * are reported uploaded and discarded otherwise.
+ *
+ * The exit code is non-zero if the replay did not finish or regressed against the baseline. Completion is noticed at
+ * the tick rate, so raise it for short recordings.
+ */
+UCLASS()
+class UHaversineIngestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UHaversineIngestCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/** Logs the benchmark result, writes and compares baselines. @return the exit code */
+	static int32 ReportReplay(FHaversineReplayBenchmark& Benchmark, bool bCompleted, const FString& BaselineFilename, const FString& WriteBaselineFilename, double Tolerance);
+};
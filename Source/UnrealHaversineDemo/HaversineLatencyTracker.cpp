@@ -0,0 +1,312 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineLatencyTracker.cpp
+// UnrealHaversineDemo
+//
+// Traces swings from transfer to upload and keeps per-segment latency histograms
+//
+
+#include "HaversineLatencyTracker.h"
+#include "SuperTagKitPlugin.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Trace/Trace.inl"
+
+UE_TRACE_CHANNEL_DEFINE(HaversineChannel)
+
+UE_TRACE_EVENT_BEGIN(Haversine, SwingMilestone)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint16, CollectionIndex)
+	UE_TRACE_EVENT_FIELD(uint8, Milestone)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, SatelliteId)
+UE_TRACE_EVENT_END()
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Transfers started"), STAT_HaversineTransfersStarted, STATGROUP_Haversine);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Collections transferred"), STAT_HaversineCollectionsTransferred, STATGROUP_Haversine);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Swings reconstructed"), STAT_HaversineSwingsReconstructed, STATGROUP_Haversine);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Swings uploaded"), STAT_HaversineSwingsUploaded, STATGROUP_Haversine);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last transfer (ms)"), STAT_HaversineTransferMs, STATGROUP_Haversine);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last reconstruction (ms)"), STAT_HaversineReconstructionMs, STATGROUP_Haversine);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last upload (ms)"), STAT_HaversineUploadMs, STATGROUP_Haversine);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last end to end (ms)"), STAT_HaversineEndToEndMs, STATGROUP_Haversine);
+
+//
+// Histogram
+//
+
+int32 FHaversineLatencyHistogram::BucketFor(double Microseconds)
+{
+	if (Microseconds <= 1.0)
+	{
+		return 0;
+	}
+	return FMath::Min(NumBuckets - 1, static_cast<int32>(FMath::Log2(Microseconds) * BucketsPerDoubling));
+}
+
+double FHaversineLatencyHistogram::BucketMidpointMs(int32 Bucket)
+{
+	return FMath::Pow(2.0, (Bucket + 0.5) / BucketsPerDoubling) / 1000.0;
+}
+
+void FHaversineLatencyHistogram::Record(double Milliseconds)
+{
+	const double Microseconds = FMath::Max(0.0, Milliseconds * 1000.0);
+	const uint64 WholeMicroseconds = static_cast<uint64>(Microseconds);
+
+	Buckets[BucketFor(Microseconds)].fetch_add(1, std::memory_order_relaxed);
+	Count.fetch_add(1, std::memory_order_relaxed);
+	TotalMicroseconds.fetch_add(WholeMicroseconds, std::memory_order_relaxed);
+
+	uint64 PreviousMax = MaxMicroseconds.load(std::memory_order_relaxed);
+	while (WholeMicroseconds > PreviousMax
+		&& !MaxMicroseconds.compare_exchange_weak(PreviousMax, WholeMicroseconds, std::memory_order_relaxed))
+	{
+	}
+}
+
+void FHaversineLatencyHistogram::Reset()
+{
+	for (std::atomic<uint64>& Bucket : Buckets)
+	{
+		Bucket.store(0, std::memory_order_relaxed);
+	}
+	Count.store(0, std::memory_order_relaxed);
+	TotalMicroseconds.store(0, std::memory_order_relaxed);
+	MaxMicroseconds.store(0, std::memory_order_relaxed);
+}
+
+FHaversineLatencySummary FHaversineLatencyHistogram::Summarize() const
+{
+	// Snapshot the buckets first; recording may continue while this runs
+	uint64 Snapshot[NumBuckets];
+	uint64 Total = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Snapshot[Bucket] = Buckets[Bucket].load(std::memory_order_relaxed);
+		Total += Snapshot[Bucket];
+	}
+
+	FHaversineLatencySummary Summary;
+	Summary.Count = Total;
+	if (Total == 0)
+	{
+		return Summary;
+	}
+
+	Summary.AverageMs = TotalMicroseconds.load(std::memory_order_relaxed) / 1000.0 / FMath::Max<uint64>(1, Count.load(std::memory_order_relaxed));
+	Summary.MaxMs = MaxMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+
+	auto Percentile = [&Snapshot, Total](double Fraction)
+	{
+		const uint64 Rank = FMath::Max<uint64>(1, static_cast<uint64>(FMath::CeilToDouble(Fraction * Total)));
+		uint64 Seen = 0;
+		for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+		{
+			Seen += Snapshot[Bucket];
+			if (Seen >= Rank)
+			{
+				return BucketMidpointMs(Bucket);
+			}
+		}
+		return BucketMidpointMs(NumBuckets - 1);
+	};
+
+	// A bucket midpoint can overshoot the largest sample actually seen
+	Summary.P50Ms = FMath::Min(Percentile(0.50), Summary.MaxMs);
+	Summary.P90Ms = FMath::Min(Percentile(0.90), Summary.MaxMs);
+	Summary.P99Ms = FMath::Min(Percentile(0.99), Summary.MaxMs);
+	return Summary;
+}
+
+//
+// Tracker
+//
+
+FHaversineLatencyTracker& FHaversineLatencyTracker::Get()
+{
+	static FHaversineLatencyTracker Tracker;
+	return Tracker;
+}
+
+void FHaversineLatencyTracker::TraceMilestone(EHaversineSwingMilestone Milestone, const FString& SatelliteId, uint16 CollectionIndex, uint64 Cycles)
+{
+	UE_TRACE_LOG(Haversine, SwingMilestone, HaversineChannel)
+		<< SwingMilestone.Cycle(Cycles)
+		<< SwingMilestone.CollectionIndex(CollectionIndex)
+		<< SwingMilestone.Milestone(static_cast<uint8>(Milestone))
+		<< SwingMilestone.SatelliteId(*SatelliteId, SatelliteId.Len());
+}
+
+void FHaversineLatencyTracker::Record(EHaversineLatencySegment Segment, uint64 FromCycles, uint64 ToCycles)
+{
+	if (FromCycles == 0 || ToCycles < FromCycles)
+	{
+		return;
+	}
+
+	const double Milliseconds = FPlatformTime::ToMilliseconds64(ToCycles - FromCycles);
+	Histograms[static_cast<int32>(Segment)].Record(Milliseconds);
+
+	switch (Segment)
+	{
+		case EHaversineLatencySegment::Transfer:		SET_FLOAT_STAT(STAT_HaversineTransferMs, Milliseconds); break;
+		case EHaversineLatencySegment::Reconstruction:	SET_FLOAT_STAT(STAT_HaversineReconstructionMs, Milliseconds); break;
+		case EHaversineLatencySegment::Upload:			SET_FLOAT_STAT(STAT_HaversineUploadMs, Milliseconds); break;
+		case EHaversineLatencySegment::EndToEnd:		SET_FLOAT_STAT(STAT_HaversineEndToEndMs, Milliseconds); break;
+		default:										break;
+	}
+}
+
+void FHaversineLatencyTracker::OnTransfersStarting(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex)
+{
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+	{
+		FScopeLock Lock(&Mutex);
+		TransferStartBySatellite.Add(SatelliteId, NowCycles);
+	}
+
+	INC_DWORD_STAT(STAT_HaversineTransfersStarted);
+	TraceMilestone(EHaversineSwingMilestone::TransferStarted, SatelliteId, StartIndex, NowCycles);
+}
+
+uint64 FHaversineLatencyTracker::OnCollectionTransferred(const FString& SatelliteId, uint16 CollectionIndex)
+{
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+
+	// Collections of one connection arrive back to back; each one's transfer starts when the previous one finished
+	uint64 StartCycles = 0;
+	{
+		FScopeLock Lock(&Mutex);
+		uint64& NextStart = TransferStartBySatellite.FindOrAdd(SatelliteId, 0);
+		StartCycles = NextStart;
+		NextStart = NowCycles;
+	}
+
+	INC_DWORD_STAT(STAT_HaversineCollectionsTransferred);
+	TraceMilestone(EHaversineSwingMilestone::Transferred, SatelliteId, CollectionIndex, NowCycles);
+	Record(EHaversineLatencySegment::Transfer, StartCycles, NowCycles);
+	return StartCycles != 0 ? StartCycles : NowCycles;
+}
+
+void FHaversineLatencyTracker::OnCollectionTransferFailed(const FString& SatelliteId)
+{
+	FScopeLock Lock(&Mutex);
+	TransferStartBySatellite.Remove(SatelliteId);
+}
+
+void FHaversineLatencyTracker::OnSwingReconstructed(const FString& SatelliteId, uint16 CollectionIndex, uint64 TransferredCycles)
+{
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+	INC_DWORD_STAT(STAT_HaversineSwingsReconstructed);
+	TraceMilestone(EHaversineSwingMilestone::Reconstructed, SatelliteId, CollectionIndex, NowCycles);
+	Record(EHaversineLatencySegment::Reconstruction, TransferredCycles, NowCycles);
+}
+
+void FHaversineLatencyTracker::OnSwingUploaded(const FString& SatelliteId, uint16 CollectionIndex, uint64 TransferStartCycles, uint64 ReconstructedCycles)
+{
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+	INC_DWORD_STAT(STAT_HaversineSwingsUploaded);
+	TraceMilestone(EHaversineSwingMilestone::Uploaded, SatelliteId, CollectionIndex, NowCycles);
+	Record(EHaversineLatencySegment::Upload, ReconstructedCycles, NowCycles);
+	Record(EHaversineLatencySegment::EndToEnd, TransferStartCycles, NowCycles);
+}
+
+FHaversineLatencySummary FHaversineLatencyTracker::Summarize(EHaversineLatencySegment Segment) const
+{
+	return Histograms[static_cast<int32>(Segment)].Summarize();
+}
+
+void FHaversineLatencyTracker::Reset()
+{
+	for (FHaversineLatencyHistogram& Histogram : Histograms)
+	{
+		Histogram.Reset();
+	}
+}
+
+void FHaversineLatencyTracker::LogStats() const
+{
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Swing latency stats:"));
+	for (int32 SegmentIndex = 0; SegmentIndex < static_cast<int32>(EHaversineLatencySegment::Num); ++SegmentIndex)
+	{
+		const EHaversineLatencySegment Segment = static_cast<EHaversineLatencySegment>(SegmentIndex);
+		const FHaversineLatencySummary Summary = Summarize(Segment);
+		UE_LOG(LogHaversineSatellite, Log, TEXT("  • %-14s n=%llu | avg %.2f ms | p50 %.2f ms p90 %.2f ms p99 %.2f ms | max %.2f ms"),
+			GetSegmentName(Segment), Summary.Count, Summary.AverageMs, Summary.P50Ms, Summary.P90Ms, Summary.P99Ms, Summary.MaxMs);
+	}
+}
+
+bool FHaversineLatencyTracker::WriteCsv(const FString& Filename) const
+{
+	FString Csv = TEXT("segment,count,avg_ms,p50_ms,p90_ms,p99_ms,max_ms\n");
+	for (int32 SegmentIndex = 0; SegmentIndex < static_cast<int32>(EHaversineLatencySegment::Num); ++SegmentIndex)
+	{
+		const EHaversineLatencySegment Segment = static_cast<EHaversineLatencySegment>(SegmentIndex);
+		const FHaversineLatencySummary Summary = Summarize(Segment);
+		Csv += FString::Printf(TEXT("%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n"),
+			GetSegmentName(Segment), Summary.Count, Summary.AverageMs, Summary.P50Ms, Summary.P90Ms, Summary.P99Ms, Summary.MaxMs);
+	}
+	return FFileHelper::SaveStringToFile(Csv, *Filename);
+}
+
+FString FHaversineLatencyTracker::GetDefaultCsvFilename()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Haversine") / FString::Printf(TEXT("Latency-%s.csv"), *FDateTime::Now().ToString());
+}
+
+const TCHAR* FHaversineLatencyTracker::GetSegmentName(EHaversineLatencySegment Segment)
+{
+	switch (Segment)
+	{
+		case EHaversineLatencySegment::Transfer:
+			return TEXT("Transfer");
+		case EHaversineLatencySegment::Reconstruction:
+			return TEXT("Reconstruction");
+		case EHaversineLatencySegment::Upload:
+			return TEXT("Upload");
+		case EHaversineLatencySegment::EndToEnd:
+			return TEXT("EndToEnd");
+		default:
+			return TEXT("Invalid");
+	}
+}
+
+//
+// Console commands
+//
+
+static FAutoConsoleCommand HaversineLatencyStatsCommand(
+	TEXT("haversine.Latency.Stats"),
+	TEXT("Logs swing latency percentiles for transfer, reconstruction, upload and end to end."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FHaversineLatencyTracker::Get().LogStats();
+	}));
+
+static FAutoConsoleCommand HaversineLatencyDumpCsvCommand(
+	TEXT("haversine.Latency.DumpCsv"),
+	TEXT("Writes swing latency percentiles to a CSV file. Args: [Filename=Saved/Haversine/Latency-<timestamp>.csv]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString Filename = Args.IsValidIndex(0) ? Args[0] : FHaversineLatencyTracker::GetDefaultCsvFilename();
+		if (FHaversineLatencyTracker::Get().WriteCsv(Filename))
+		{
+			UE_LOG(LogHaversineSatellite, Log, TEXT("✓ Swing latency written to %s"), *Filename);
+		}
+		else
+		{
+			UE_LOG(LogHaversineSatellite, Error, TEXT("✗ Could not write swing latency to %s"), *Filename);
+		}
+	}));
+
+static FAutoConsoleCommand HaversineLatencyResetCommand(
+	TEXT("haversine.Latency.Reset"),
+	TEXT("Clears the swing latency histograms."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FHaversineLatencyTracker::Get().Reset();
+	}));
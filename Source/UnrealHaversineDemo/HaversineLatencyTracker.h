@@ -0,0 +1,116 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include <atomic>
+
+/** Unreal Insights channel for swing milestones and pipeline stage scopes. Enable with `-trace=default,Haversine`. */
+UE_TRACE_CHANNEL_EXTERN(HaversineChannel)
+
+DECLARE_STATS_GROUP(TEXT("Haversine"), STATGROUP_Haversine, STATCAT_Advanced);
+
+/** Points a swing passes on its way from the satellite to SkyGolf */
+enum class EHaversineSwingMilestone : uint8
+{
+	TransferStarted,	// `will_transfer_collections`, or the previous collection of the same connection finishing
+	Transferred,		// `collection_transfer_did_finish`
+	Reconstructed,		// Physics engine produced a valid swing
+	Uploaded,			// SkyGolf accepted the upload
+};
+
+/** Time between two milestones */
+enum class EHaversineLatencySegment : uint8
+{
+	Transfer,			// TransferStarted → Transferred
+	Reconstruction,		// Transferred → Reconstructed, including time queued in the pipeline
+	Upload,				// Reconstructed → Uploaded, including batching and retries
+	EndToEnd,			// TransferStarted → Uploaded
+	Num
+};
+
+struct FHaversineLatencySummary
+{
+	uint64 Count = 0;
+	double AverageMs = 0.0;
+	double P50Ms = 0.0;
+	double P90Ms = 0.0;
+	double P99Ms = 0.0;
+	double MaxMs = 0.0;
+};
+
+/**
+ * Lock-free latency histogram with logarithmic buckets, eight per doubling from 1 µs to about an hour.
+ * Recording is a handful of relaxed atomic adds; percentiles are accurate to within one bucket (about 9%).
+ */
+class FHaversineLatencyHistogram
+{
+public:
+	void Record(double Milliseconds);
+	void Reset();
+	FHaversineLatencySummary Summarize() const;
+
+private:
+	static constexpr int32 BucketsPerDoubling = 8;
+	static constexpr int32 NumBuckets = 32 * BucketsPerDoubling;
+
+	static int32 BucketFor(double Microseconds);
+	static double BucketMidpointMs(int32 Bucket);
+
+	std::atomic<uint64> Buckets[NumBuckets] = {};
+	std::atomic<uint64> Count{0};
+	std::atomic<uint64> TotalMicroseconds{0};
+	std::atomic<uint64> MaxMicroseconds{0};
+};
+
+/**
+ * Process-wide record of where swing time goes between the satellite and SkyGolf.
+ *
+ * Every milestone is emitted as a `Haversine.SwingMilestone` trace event (satellite, collection index and cycle
+ * counter), so individual swings can be followed in Unreal Insights, and bumps a counter in `stat Haversine`. The
+ * time between milestones feeds one histogram per segment; query them with `haversine.Latency.Stats` or write them
+ * out with `haversine.Latency.DumpCsv` for regression tracking.
+ *
+ * Timestamps are `FPlatformTime::Cycles64()` values carried along with the swing. Thread-safe.
+ */
+class FHaversineLatencyTracker
+{
+public:
+	static FHaversineLatencyTracker& Get();
+
+	/** A connection is about to transfer collections `StartIndex` up to `EndIndex` */
+	void OnTransfersStarting(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex);
+
+	/** @return when this collection's transfer started, for the later milestones */
+	uint64 OnCollectionTransferred(const FString& SatelliteId, uint16 CollectionIndex);
+
+	/** The connection dropped; its next transfer is timed from the next `OnTransfersStarting` */
+	void OnCollectionTransferFailed(const FString& SatelliteId);
+
+	void OnSwingReconstructed(const FString& SatelliteId, uint16 CollectionIndex, uint64 TransferredCycles);
+	void OnSwingUploaded(const FString& SatelliteId, uint16 CollectionIndex, uint64 TransferStartCycles, uint64 ReconstructedCycles);
+
+	FHaversineLatencySummary Summarize(EHaversineLatencySegment Segment) const;
+	void Reset();
+	void LogStats() const;
+
+	/** Writes one row per segment. @return false if the file could not be written. */
+	bool WriteCsv(const FString& Filename) const;
+
+	/** Saved/Haversine/Latency-<timestamp>.csv */
+	static FString GetDefaultCsvFilename();
+
+	static const TCHAR* GetSegmentName(EHaversineLatencySegment Segment);
+
+private:
+	void Record(EHaversineLatencySegment Segment, uint64 FromCycles, uint64 ToCycles);
+	static void TraceMilestone(EHaversineSwingMilestone Milestone, const FString& SatelliteId, uint16 CollectionIndex, uint64 Cycles);
+
+	FHaversineLatencyHistogram Histograms[static_cast<int32>(EHaversineLatencySegment::Num)];
+
+	// When the next collection of each satellite's current connection started transferring
+	FCriticalSection Mutex;
+	TMap<FString, uint64> TransferStartBySatellite;
+};
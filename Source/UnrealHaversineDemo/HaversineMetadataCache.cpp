@@ -0,0 +1,78 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineMetadataCache.cpp
+// UnrealHaversineDemo
+//
+// Parses SuperTag metadata once per distinct set of bytes, not once per advertisement
+//
+
+#include "HaversineMetadataCache.h"
+#include "SuperTagKitPlugin.h"
+#include "Hash/xxhash.h"
+
+uint64 FHaversineMetadataCache::HashMetadata(const uint8* Data, uint64 NumBytes)
+{
+	return FXxHash64::HashBuffer(Data, NumBytes).Hash;
+}
+
+FHaversineSatelliteMetadataRef FHaversineMetadataCache::FindOrParse(const FString& SatelliteId, TOptional<uint64> MetadataHash,
+	TFunctionRef<FHaversineSatelliteMetadata()> Parse)
+{
+	const double NowSeconds = FPlatformTime::Seconds();
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const FEntry* Entry = Entries.Find(SatelliteId))
+		{
+			// Same bytes, same result, however old. Without bytes to compare, age is all there is to go on.
+			const bool bUnchanged = MetadataHash.IsSet()
+				? Entry->MetadataHash == MetadataHash
+				: NowSeconds - Entry->ParsedSeconds < MaxAgeSeconds;
+			if (bUnchanged)
+			{
+				Hits.fetch_add(1, std::memory_order_relaxed);
+				return Entry->Metadata;
+			}
+			(MetadataHash.IsSet() ? Changes : Expirations).fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// Parse outside the lock; two threads racing on the same satellite both parse, and the last one wins
+	Misses.fetch_add(1, std::memory_order_relaxed);
+
+	FHaversineSatelliteMetadataRef Metadata = MakeShared<FHaversineSatelliteMetadata, ESPMode::ThreadSafe>(Parse());
+	if (!Metadata->bParsed)
+	{
+		ParseFailures.fetch_add(1, std::memory_order_relaxed);
+		return Metadata;
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+	Entries.Add(SatelliteId, FEntry{ MetadataHash, NowSeconds, Metadata });
+	return Metadata;
+}
+
+FHaversineMetadataCacheStats FHaversineMetadataCache::GetStats() const
+{
+	FHaversineMetadataCacheStats Stats;
+	{
+		FReadScopeLock ReadLock(Lock);
+		Stats.Entries = Entries.Num();
+	}
+	Stats.Hits = Hits.load(std::memory_order_relaxed);
+	Stats.Misses = Misses.load(std::memory_order_relaxed);
+	Stats.Changes = Changes.load(std::memory_order_relaxed);
+	Stats.Expirations = Expirations.load(std::memory_order_relaxed);
+	Stats.ParseFailures = ParseFailures.load(std::memory_order_relaxed);
+	return Stats;
+}
+
+void FHaversineMetadataCache::LogStats() const
+{
+	const FHaversineMetadataCacheStats Stats = GetStats();
+	const uint64 Lookups = Stats.Hits + Stats.Misses;
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Metadata cache stats: %d satellites | hits=%llu misses=%llu (%.1f%% hit rate) | changed=%llu expired=%llu parse-failures=%llu"),
+		Stats.Entries, Stats.Hits, Stats.Misses, Lookups > 0 ? 100.0 * Stats.Hits / Lookups : 0.0,
+		Stats.Changes, Stats.Expirations, Stats.ParseFailures);
+}
@@ -0,0 +1,84 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+#include <atomic>
+
+/** Display-ready result of parsing a satellite's SuperTag metadata */
+struct FHaversineSatelliteMetadata
+{
+	FString ClubInfo;
+	FString UserInfo;
+
+	/** False if parsing failed. Failures are returned but never cached, since they are often transient (no token yet). */
+	bool bParsed = false;
+};
+
+using FHaversineSatelliteMetadataRef = TSharedRef<const FHaversineSatelliteMetadata, ESPMode::ThreadSafe>;
+
+/** Point-in-time counters for `FHaversineMetadataCache` */
+struct FHaversineMetadataCacheStats
+{
+	int32 Entries = 0;
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+
+	/** Misses where the satellite was cached but its metadata bytes had changed */
+	uint64 Changes = 0;
+
+	/** Misses where the satellite's metadata bytes were not available and its entry had outlived `MaxAgeSeconds` */
+	uint64 Expirations = 0;
+	uint64 ParseFailures = 0;
+};
+
+/**
+ * Parsed metadata per satellite, keyed by satellite ID plus a hash of the raw metadata bytes.
+ *
+ * Satellites re-advertise the same metadata over and over; parsing it (and building the display strings) is only
+ * repeated when the bytes change, e.g. the tag was moved to another club or user, and then at the very next
+ * advertisement. Only when a state carries no metadata bytes is a cached result reused by age instead, for at most
+ * `MaxAgeSeconds`. A hit takes a shared read lock and copies a reference, so it neither parses nor allocates.
+ * Thread-safe.
+ */
+class FHaversineMetadataCache
+{
+public:
+	/** How long a parsed result is reused for a satellite whose metadata bytes are not available */
+	static constexpr double MaxAgeSeconds = 30.0;
+
+	/** @return the hash `FindOrParse` keys on, over all `NumBytes` of the raw metadata */
+	static uint64 HashMetadata(const uint8* Data, uint64 NumBytes);
+
+	/**
+	 * @param MetadataHash	`HashMetadata` of the satellite's raw metadata, or unset if it has none
+	 * @return the cached result for this satellite, running `Parse` only if there is none, its metadata bytes changed,
+	 *         or (without a hash) it has aged out
+	 */
+	FHaversineSatelliteMetadataRef FindOrParse(const FString& SatelliteId, TOptional<uint64> MetadataHash,
+		TFunctionRef<FHaversineSatelliteMetadata()> Parse);
+
+	FHaversineMetadataCacheStats GetStats() const;
+	void LogStats() const;
+
+private:
+	struct FEntry
+	{
+		/** Hash of the metadata bytes `Metadata` was parsed from; unset if they were not available */
+		TOptional<uint64> MetadataHash;
+
+		/** FPlatformTime::Seconds() when `Metadata` was parsed */
+		double ParsedSeconds = 0.0;
+		FHaversineSatelliteMetadataRef Metadata;
+	};
+
+	mutable FRWLock Lock;
+	TMap<FString, FEntry> Entries;
+
+	std::atomic<uint64> Hits{0};
+	std::atomic<uint64> Misses{0};
+	std::atomic<uint64> Changes{0};
+	std::atomic<uint64> Expirations{0};
+	std::atomic<uint64> ParseFailures{0};
+};
@@ -0,0 +1,285 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineMockUploadServer.cpp
+// UnrealHaversineDemo
+//
+// In-process stand-in for the swing batch upload endpoint, plus an offline upload benchmark
+//
+
+#include "HaversineMockUploadServer.h"
+#include "HaversineSwingUploadQueue.h"
+#include "SuperTagKitPlugin.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "HttpPath.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "Misc/ScopeLock.h"
+
+static const TCHAR* MockBatchPath = TEXT("/swings/batch");
+
+FHaversineMockUploadServer& FHaversineMockUploadServer::Get()
+{
+	static FHaversineMockUploadServer Instance;
+	return Instance;
+}
+
+bool FHaversineMockUploadServer::Start(const FConfig& InConfig)
+{
+	check(IsInGameThread());
+	Stop();
+
+	Config = InConfig;
+	Router = FHttpServerModule::Get().GetHttpRouter(Config.Port, /*bFailOnBindFailure*/ true);
+	if (!Router.IsValid())
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("Mock upload server could not bind port %u"), Config.Port);
+		return false;
+	}
+
+	RouteHandle = Router->BindRoute(FHttpPath(MockBatchPath), EHttpServerRequestVerbs::VERB_POST,
+		FHttpRequestHandler::CreateRaw(this, &FHaversineMockUploadServer::HandleBatch));
+	FHttpServerModule::Get().StartAllListeners();
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Mock upload server listening on %s (%.0f±%.0f ms, %.0f%% tail at %.0f ms, %.0f%% failures)"),
+		*GetBatchUrl(), Config.LatencyMs, Config.JitterMs, Config.TailProbability * 100.0f, Config.TailLatencyMs, Config.FailureRate * 100.0f);
+	return true;
+}
+
+void FHaversineMockUploadServer::Stop()
+{
+	if (Router.IsValid() && RouteHandle.IsValid())
+	{
+		Router->UnbindRoute(RouteHandle);
+		UE_LOG(LogHaversineSatellite, Log, TEXT("Mock upload server stopped after %llu batches (%llu swings)"), BatchesReceived, SwingsReceived);
+	}
+	RouteHandle.Reset();
+	Router.Reset();
+}
+
+void FHaversineMockUploadServer::SetAvailable(bool bInAvailable)
+{
+	check(IsInGameThread());
+	bAvailable = bInAvailable;
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Mock upload server is now %s"), bAvailable ? TEXT("up") : TEXT("down (refusing every batch with 503)"));
+}
+
+FString FHaversineMockUploadServer::GetBatchUrl() const
+{
+	return FString::Printf(TEXT("http://127.0.0.1:%u%s"), Config.Port, MockBatchPath);
+}
+
+bool FHaversineMockUploadServer::HandleBatch(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+	if (!bAvailable)
+	{
+		++BatchesRefused;
+		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::ServiceUnavail, TEXT("unavailable")));
+		return true;
+	}
+
+	TArray<FHaversineSwingBatchCodec::FEntry> Entries;
+	if (!FHaversineSwingBatchCodec::Decode(Request.Body, Entries))
+	{
+		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("malformed_batch")));
+		return true;
+	}
+
+	++BatchesReceived;
+	SwingsReceived += Entries.Num();
+
+	TArray<FHaversineSwingUploadResult> Results;
+	Results.Reserve(Entries.Num());
+	for (const FHaversineSwingBatchCodec::FEntry& Entry : Entries)
+	{
+		FHaversineSwingUploadResult& Result = Results.AddDefaulted_GetRef();
+		Result.bSuccess = !Entry.AuthToken.IsEmpty() && FMath::FRand() >= Config.FailureRate;
+		if (!Result.bSuccess)
+		{
+			Result.ErrorMessage = Entry.AuthToken.IsEmpty() ? TEXT("missing auth token") : TEXT("simulated failure");
+		}
+	}
+
+	float DelayMs = FMath::FRand() < Config.TailProbability
+		? Config.TailLatencyMs
+		: Config.LatencyMs + FMath::FRandRange(-Config.JitterMs, Config.JitterMs);
+	DelayMs = FMath::Max(0.0f, DelayMs);
+
+	FString Json = FHaversineSwingBatchCodec::EncodeResults(Results);
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([OnComplete, Json = MoveTemp(Json)](float)
+	{
+		OnComplete(FHttpServerResponse::Create(Json, TEXT("application/json")));
+		return false;
+	}), DelayMs / 1000.0f);
+
+	return true;
+}
+
+//
+// Console commands
+//
+
+static FAutoConsoleCommand HaversineMockUploadStartCommand(
+	TEXT("haversine.MockUpload.Start"),
+	TEXT("Starts the local mock batch upload endpoint. Args: [Port] [LatencyMs] [JitterMs] [FailureRate]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FHaversineMockUploadServer::FConfig Config;
+		if (Args.IsValidIndex(0)) { Config.Port = FCString::Atoi(*Args[0]); }
+		if (Args.IsValidIndex(1)) { Config.LatencyMs = FCString::Atof(*Args[1]); }
+		if (Args.IsValidIndex(2)) { Config.JitterMs = FCString::Atof(*Args[2]); }
+		if (Args.IsValidIndex(3)) { Config.FailureRate = FCString::Atof(*Args[3]); }
+		FHaversineMockUploadServer::Get().Start(Config);
+	}));
+
+static FAutoConsoleCommand HaversineMockUploadStopCommand(
+	TEXT("haversine.MockUpload.Stop"),
+	TEXT("Stops the local mock batch upload endpoint."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FHaversineMockUploadServer::Get().Stop();
+	}));
+
+static FAutoConsoleCommand HaversineMockUploadDownCommand(
+	TEXT("haversine.MockUpload.Down"),
+	TEXT("Makes the local mock batch upload endpoint refuse every batch with 503, as if SkyGolf were unreachable."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FHaversineMockUploadServer::Get().SetAvailable(false);
+	}));
+
+static FAutoConsoleCommand HaversineMockUploadUpCommand(
+	TEXT("haversine.MockUpload.Up"),
+	TEXT("Makes the local mock batch upload endpoint accept batches again after haversine.MockUpload.Down."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FHaversineMockUploadServer::Get().SetAvailable(true);
+	}));
+
+/** State shared by the completions of one benchmark run */
+struct FHaversineUploadBenchRun
+{
+	int32 Total = 0;
+	uint64 StartCycles = 0;
+	uint64 BatchesAtStart = 0;
+	TSharedPtr<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> Queue;
+
+	FCriticalSection Mutex;
+	TArray<double> LatenciesMs;
+	int32 Failures = 0;
+
+	void Record(double LatencyMs, bool bSuccess)
+	{
+		bool bDone = false;
+		{
+			FScopeLock Lock(&Mutex);
+			LatenciesMs.Add(LatencyMs);
+			Failures += bSuccess ? 0 : 1;
+			bDone = LatenciesMs.Num() == Total;
+		}
+
+		if (bDone)
+		{
+			AsyncTask(ENamedThreads::GameThread, [this]() { Finish(); });
+		}
+	}
+
+	void Finish();
+};
+
+static TSharedPtr<FHaversineUploadBenchRun, ESPMode::ThreadSafe> ActiveUploadBench;
+
+static double Percentile(const TArray<double>& Sorted, double Fraction)
+{
+	if (Sorted.IsEmpty())
+	{
+		return 0.0;
+	}
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+	return Sorted[Index];
+}
+
+void FHaversineUploadBenchRun::Finish()
+{
+	const double ElapsedSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	LatenciesMs.Sort();
+
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Upload benchmark: %d swings in %.2f s = %.1f swings/s | %llu batches | %d failed | latency p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms"),
+		Total, ElapsedSeconds, ElapsedSeconds > 0.0 ? Total / ElapsedSeconds : 0.0,
+		FHaversineMockUploadServer::Get().GetBatchesReceived() - BatchesAtStart, Failures,
+		Percentile(LatenciesMs, 0.50), Percentile(LatenciesMs, 0.90), Percentile(LatenciesMs, 0.99), LatenciesMs.Last());
+
+	Queue->LogStats();
+	Queue->Shutdown();
+	ActiveUploadBench.Reset();
+}
+
+static FAutoConsoleCommand HaversineUploadBenchCommand(
+	TEXT("haversine.Upload.Bench"),
+	TEXT("Pushes synthetic swings through the batching uploader into the local mock endpoint and reports throughput and latency percentiles. Args: [Swings=1000] [Satellites=40] [PayloadBytes=4096]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (ActiveUploadBench.IsValid())
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("Upload benchmark already running"));
+			return;
+		}
+
+		const int32 NumSwings = Args.IsValidIndex(0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		const int32 NumSatellites = Args.IsValidIndex(1) ? FMath::Max(1, FCString::Atoi(*Args[1])) : 40;
+		const int32 PayloadBytes = Args.IsValidIndex(2) ? FMath::Max(1, FCString::Atoi(*Args[2])) : 4096;
+
+		FHaversineMockUploadServer& Server = FHaversineMockUploadServer::Get();
+		if (!Server.IsRunning() && !Server.Start(FHaversineMockUploadServer::FConfig()))
+		{
+			return;
+		}
+
+		FHaversineSwingUploadQueueConfig QueueConfig = FHaversineSwingUploadQueueConfig::FromConsoleVariables();
+		QueueConfig.BatchUrl = Server.GetBatchUrl();
+
+		TSharedRef<FHaversineUploadBenchRun, ESPMode::ThreadSafe> Run = MakeShared<FHaversineUploadBenchRun, ESPMode::ThreadSafe>();
+		Run->Total = NumSwings;
+		Run->Queue = FHaversineSwingUploadQueue::Create(nullptr, QueueConfig);
+		Run->Queue->Start();
+		Run->BatchesAtStart = Server.GetBatchesReceived();
+		Run->LatenciesMs.Reserve(NumSwings);
+		ActiveUploadBench = Run;
+
+		// One shared payload: the benchmark measures the uploader, not allocation
+		std::vector<uint8_t> Payload(PayloadBytes);
+		for (uint8_t& Byte : Payload)
+		{
+			Byte = static_cast<uint8_t>(FMath::RandHelper(256));
+		}
+		FHaversineCollectionBufferRef Collection = FHaversineCollectionBuffer::Create(MoveTemp(Payload));
+
+		UE_LOG(LogHaversineSatellite, Log, TEXT("Upload benchmark: %d swings from %d satellites, %d bytes each"), NumSwings, NumSatellites, PayloadBytes);
+
+		Run->StartCycles = FPlatformTime::Cycles64();
+		for (int32 Index = 0; Index < NumSwings; ++Index)
+		{
+			FHaversineSwingUploadRef Upload = MakeShared<FHaversineSwingUpload, ESPMode::ThreadSafe>();
+			Upload->SatelliteId = FString::Printf(TEXT("bench-%04d"), Index % NumSatellites);
+			Upload->CollectionIndex = static_cast<uint16>(Index / NumSatellites);
+			Upload->Collection = Collection;
+			Upload->HardwareId = Upload->SatelliteId;
+			Upload->AuthToken = TEXT("bench-token");
+
+			const uint64 QueuedCycles = FPlatformTime::Cycles64();
+			TWeakPtr<FHaversineUploadBenchRun, ESPMode::ThreadSafe> WeakRun = Run;
+			Upload->OnComplete = [WeakRun, QueuedCycles](bool bSuccess, const FString&)
+			{
+				if (TSharedPtr<FHaversineUploadBenchRun, ESPMode::ThreadSafe> PinnedRun = WeakRun.Pin())
+				{
+					PinnedRun->Record(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - QueuedCycles), bSuccess);
+				}
+			};
+			Run->Queue->Enqueue(Upload);
+		}
+	}));
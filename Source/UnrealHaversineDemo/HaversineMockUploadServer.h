@@ -0,0 +1,70 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpResultCallback.h"
+#include "HttpRouteHandle.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+
+/**
+ * Local stand-in for the swing batch upload endpoint, served from this process on 127.0.0.1.
+ *
+ * It decodes batches in the format of `FHaversineSwingBatchCodec` and answers after a configurable, jittery latency
+ * with an occasional slow tail, failing a configurable fraction of swings. Point `haversine.Upload.BatchUrl` at
+ * `GetBatchUrl()` (or run `haversine.Upload.Bench`) to measure upload throughput and tail latency offline.
+ *
+ * `SetAvailable(false)` takes the endpoint down without unbinding it: every batch is refused with 503 until it is set
+ * available again, which is how the upload spool's outage handling and recovery are exercised.
+ *
+ * Responses are delivered from the core ticker, so the game thread (or a commandlet's tick loop) must be running.
+ */
+class FHaversineMockUploadServer
+{
+public:
+	struct FConfig
+	{
+		uint32 Port = 8917;
+		float LatencyMs = 20.0f;
+		float JitterMs = 10.0f;
+
+		/** Fraction of batches answered after TailLatencyMs instead */
+		float TailProbability = 0.01f;
+		float TailLatencyMs = 250.0f;
+
+		/** Fraction of swings reported as failed */
+		float FailureRate = 0.0f;
+	};
+
+	static FHaversineMockUploadServer& Get();
+
+	/** @return false if the port could not be bound */
+	bool Start(const FConfig& InConfig);
+	void Stop();
+	bool IsRunning() const { return RouteHandle.IsValid(); }
+
+	/** While unavailable every batch is answered 503, as if SkyGolf were unreachable */
+	void SetAvailable(bool bInAvailable);
+	bool IsAvailable() const { return bAvailable; }
+
+	const FConfig& GetConfig() const { return Config; }
+	FString GetBatchUrl() const;
+
+	uint64 GetBatchesReceived() const { return BatchesReceived; }
+	uint64 GetSwingsReceived() const { return SwingsReceived; }
+	uint64 GetBatchesRefused() const { return BatchesRefused; }
+
+private:
+	bool HandleBatch(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+
+	FConfig Config;
+	TSharedPtr<IHttpRouter> Router;
+	FHttpRouteHandle RouteHandle;
+	bool bAvailable = true;
+
+	uint64 BatchesReceived = 0;
+	uint64 SwingsReceived = 0;
+	uint64 BatchesRefused = 0;
+};
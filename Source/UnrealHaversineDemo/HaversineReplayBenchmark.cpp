@@ -0,0 +1,379 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineReplayBenchmark.cpp
+// UnrealHaversineDemo
+//
+// Replays a swing recording through the subsystem and compares the measurements with a baseline
+//
+
+#include "HaversineReplayBenchmark.h"
+#include "HaversineDemoSubsystem.h"
+#include "HaversineSwingRecording.h"
+#include "SuperTagKitPlugin.h"
+#include "Dom/JsonObject.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include <atomic>
+
+namespace
+{
+	/** Latency below this is noise on any machine; a p99 only regresses if it also grows by more than this */
+	constexpr double LatencyNoiseFloorMs = 0.05;
+
+	/** Likewise for allocations: one more per swing is not worth failing a run over */
+	constexpr double AllocationNoiseFloor = 1.0;
+
+	std::atomic<uint64> GHaversineAllocations{0};
+	bool GHaversineAllocationCounterInstalled = false;
+
+	/**
+	 * Forwards everything to the allocator it wraps and counts allocations (including reallocations, which usually
+	 * allocate). One relaxed atomic add per allocation: enough overhead to skew a tight microbenchmark, not a swing.
+	 */
+	class FHaversineCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FHaversineCountingMalloc(FMalloc* InInner)
+			: Inner(InInner)
+		{
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			GHaversineAllocations.fetch_add(1, std::memory_order_relaxed);
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			GHaversineAllocations.fetch_add(1, std::memory_order_relaxed);
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0)
+			{
+				GHaversineAllocations.fetch_add(1, std::memory_order_relaxed);
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0)
+			{
+				GHaversineAllocations.fetch_add(1, std::memory_order_relaxed);
+			}
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void MarkTLSCachesAsUsedOnCurrentThread() override { Inner->MarkTLSCachesAsUsedOnCurrentThread(); }
+		virtual void MarkTLSCachesAsUnusedOnCurrentThread() override { Inner->MarkTLSCachesAsUnusedOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+
+		// Named for itself so memory reports show the wrapper is installed
+		virtual const TCHAR* GetDescriptiveName() override { return TEXT("HaversineCountingMalloc"); }
+
+	private:
+		FMalloc* Inner;
+	};
+
+	TSharedRef<FJsonObject> SummaryToJson(const FHaversineLatencySummary& Summary)
+	{
+		TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+		Json->SetNumberField(TEXT("Count"), static_cast<double>(Summary.Count));
+		Json->SetNumberField(TEXT("AverageMs"), Summary.AverageMs);
+		Json->SetNumberField(TEXT("P50Ms"), Summary.P50Ms);
+		Json->SetNumberField(TEXT("P90Ms"), Summary.P90Ms);
+		Json->SetNumberField(TEXT("P99Ms"), Summary.P99Ms);
+		Json->SetNumberField(TEXT("MaxMs"), Summary.MaxMs);
+		return Json;
+	}
+
+	FHaversineLatencySummary SummaryFromJson(const TSharedPtr<FJsonObject>& Json)
+	{
+		FHaversineLatencySummary Summary;
+		if (Json)
+		{
+			Summary.Count = static_cast<uint64>(Json->GetNumberField(TEXT("Count")));
+			Summary.AverageMs = Json->GetNumberField(TEXT("AverageMs"));
+			Summary.P50Ms = Json->GetNumberField(TEXT("P50Ms"));
+			Summary.P90Ms = Json->GetNumberField(TEXT("P90Ms"));
+			Summary.P99Ms = Json->GetNumberField(TEXT("P99Ms"));
+			Summary.MaxMs = Json->GetNumberField(TEXT("MaxMs"));
+		}
+		return Summary;
+	}
+
+	/** Adds a regression line if `Current` p99 is worse than `Baseline` p99 by more than the tolerance and the noise floor */
+	void CheckLatency(const TCHAR* Name, const FHaversineLatencySummary& Current, const FHaversineLatencySummary& Baseline, double Tolerance, TArray<FString>& OutRegressions)
+	{
+		if (Baseline.Count == 0 || Current.Count == 0)
+		{
+			return;
+		}
+		const double Limit = FMath::Max(Baseline.P99Ms * (1.0 + Tolerance), Baseline.P99Ms + LatencyNoiseFloorMs);
+		if (Current.P99Ms > Limit)
+		{
+			OutRegressions.Add(FString::Printf(TEXT("%s p99 %.3f ms, baseline %.3f ms (limit %.3f ms)"), Name, Current.P99Ms, Baseline.P99Ms, Limit));
+		}
+	}
+}
+
+//
+// Result
+//
+
+void FHaversineReplayBenchmarkResult::Log() const
+{
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Replay benchmark: %s at %s"), *Recording,
+		Speed > 0.0 ? *FString::Printf(TEXT("%gx"), Speed) : TEXT("maximum speed"));
+	UE_LOG(LogHaversineSatellite, Log, TEXT("  • %d collections → %llu swings published, %llu discarded in %.2f s = %.1f swings/s"),
+		Collections, SwingsPublished, SwingsDiscarded, Seconds, SwingsPerSecond);
+	if (AllocationsPerSwing != AllocationsNotCounted)
+	{
+		UE_LOG(LogHaversineSatellite, Log, TEXT("  • %.1f heap allocations per swing (whole process, every thread)"), AllocationsPerSwing);
+	}
+	else
+	{
+		UE_LOG(LogHaversineSatellite, Log, TEXT("  • heap allocations not counted (start with -%s)"), FHaversineReplayBenchmark::CountAllocationsSwitch);
+	}
+	for (int32 StageIndex = 0; StageIndex < static_cast<int32>(EHaversineSwingStage::Num); ++StageIndex)
+	{
+		const FHaversineLatencySummary& Stage = Stages[StageIndex];
+		UE_LOG(LogHaversineSatellite, Log, TEXT("  • %-14s n=%llu avg %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f ms"),
+			FHaversineSwingPipeline::GetStageName(static_cast<EHaversineSwingStage>(StageIndex)),
+			Stage.Count, Stage.AverageMs, Stage.P50Ms, Stage.P90Ms, Stage.P99Ms, Stage.MaxMs);
+	}
+	UE_LOG(LogHaversineSatellite, Log, TEXT("  • %-14s n=%llu avg %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f ms"),
+		TEXT("Transfer→Swing"), Reconstruction.Count, Reconstruction.AverageMs, Reconstruction.P50Ms, Reconstruction.P90Ms, Reconstruction.P99Ms, Reconstruction.MaxMs);
+}
+
+bool FHaversineReplayBenchmarkResult::SaveBaseline(const FString& Filename) const
+{
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetStringField(TEXT("Recording"), Recording);
+	Json->SetNumberField(TEXT("Speed"), Speed);
+	Json->SetNumberField(TEXT("Collections"), Collections);
+	Json->SetNumberField(TEXT("SwingsPublished"), static_cast<double>(SwingsPublished));
+	Json->SetNumberField(TEXT("SwingsDiscarded"), static_cast<double>(SwingsDiscarded));
+	Json->SetNumberField(TEXT("Seconds"), Seconds);
+	Json->SetNumberField(TEXT("SwingsPerSecond"), SwingsPerSecond);
+	if (AllocationsPerSwing != AllocationsNotCounted)
+	{
+		Json->SetNumberField(TEXT("AllocationsPerSwing"), AllocationsPerSwing);
+	}
+
+	TSharedRef<FJsonObject> StagesJson = MakeShared<FJsonObject>();
+	for (int32 StageIndex = 0; StageIndex < static_cast<int32>(EHaversineSwingStage::Num); ++StageIndex)
+	{
+		StagesJson->SetObjectField(FHaversineSwingPipeline::GetStageName(static_cast<EHaversineSwingStage>(StageIndex)), SummaryToJson(Stages[StageIndex]));
+	}
+	Json->SetObjectField(TEXT("Stages"), StagesJson);
+	Json->SetObjectField(TEXT("Reconstruction"), SummaryToJson(Reconstruction));
+
+	FString Text;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Text);
+	return FJsonSerializer::Serialize(Json, Writer) && FFileHelper::SaveStringToFile(Text, *Filename);
+}
+
+bool FHaversineReplayBenchmarkResult::LoadBaseline(const FString& Filename, FHaversineReplayBenchmarkResult& OutBaseline)
+{
+	FString Text;
+	TSharedPtr<FJsonObject> Json;
+	if (!FFileHelper::LoadFileToString(Text, *Filename) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Text), Json) || !Json)
+	{
+		return false;
+	}
+
+	OutBaseline = FHaversineReplayBenchmarkResult();
+	OutBaseline.Recording = Json->GetStringField(TEXT("Recording"));
+	OutBaseline.Speed = Json->GetNumberField(TEXT("Speed"));
+	OutBaseline.Collections = static_cast<int32>(Json->GetNumberField(TEXT("Collections")));
+	OutBaseline.SwingsPublished = static_cast<uint64>(Json->GetNumberField(TEXT("SwingsPublished")));
+	OutBaseline.SwingsDiscarded = static_cast<uint64>(Json->GetNumberField(TEXT("SwingsDiscarded")));
+	OutBaseline.Seconds = Json->GetNumberField(TEXT("Seconds"));
+	OutBaseline.SwingsPerSecond = Json->GetNumberField(TEXT("SwingsPerSecond"));
+	if (Json->HasField(TEXT("AllocationsPerSwing")))
+	{
+		OutBaseline.AllocationsPerSwing = Json->GetNumberField(TEXT("AllocationsPerSwing"));
+	}
+
+	const TSharedPtr<FJsonObject>* StagesJson = nullptr;
+	if (Json->TryGetObjectField(TEXT("Stages"), StagesJson))
+	{
+		for (int32 StageIndex = 0; StageIndex < static_cast<int32>(EHaversineSwingStage::Num); ++StageIndex)
+		{
+			OutBaseline.Stages[StageIndex] = SummaryFromJson((*StagesJson)->GetObjectField(FHaversineSwingPipeline::GetStageName(static_cast<EHaversineSwingStage>(StageIndex))));
+		}
+	}
+	const TSharedPtr<FJsonObject>* ReconstructionJson = nullptr;
+	if (Json->TryGetObjectField(TEXT("Reconstruction"), ReconstructionJson))
+	{
+		OutBaseline.Reconstruction = SummaryFromJson(*ReconstructionJson);
+	}
+	return true;
+}
+
+TArray<FString> FHaversineReplayBenchmarkResult::FindRegressions(const FHaversineReplayBenchmarkResult& Baseline, double Tolerance) const
+{
+	TArray<FString> Regressions;
+
+	// Throughput and queueing depend on the pacing, so runs at different speeds say nothing about each other
+	if (!FMath::IsNearlyEqual(Speed, Baseline.Speed) || Collections != Baseline.Collections)
+	{
+		Regressions.Add(FString::Printf(TEXT("not comparable: baseline replayed %d collections at speed %g, this run %d at speed %g"),
+			Baseline.Collections, Baseline.Speed, Collections, Speed));
+		return Regressions;
+	}
+
+	const double MinSwingsPerSecond = Baseline.SwingsPerSecond * (1.0 - Tolerance);
+	if (SwingsPerSecond < MinSwingsPerSecond)
+	{
+		Regressions.Add(FString::Printf(TEXT("throughput %.1f swings/s, baseline %.1f (limit %.1f)"), SwingsPerSecond, Baseline.SwingsPerSecond, MinSwingsPerSecond));
+	}
+
+	if (AllocationsPerSwing != AllocationsNotCounted && Baseline.AllocationsPerSwing != AllocationsNotCounted)
+	{
+		const double Limit = FMath::Max(Baseline.AllocationsPerSwing * (1.0 + Tolerance), Baseline.AllocationsPerSwing + AllocationNoiseFloor);
+		if (AllocationsPerSwing > Limit)
+		{
+			Regressions.Add(FString::Printf(TEXT("%.1f allocations per swing, baseline %.1f (limit %.1f)"), AllocationsPerSwing, Baseline.AllocationsPerSwing, Limit));
+		}
+	}
+
+	for (int32 StageIndex = 0; StageIndex < static_cast<int32>(EHaversineSwingStage::Num); ++StageIndex)
+	{
+		CheckLatency(FHaversineSwingPipeline::GetStageName(static_cast<EHaversineSwingStage>(StageIndex)), Stages[StageIndex], Baseline.Stages[StageIndex], Tolerance, Regressions);
+	}
+	CheckLatency(TEXT("Transfer→Swing"), Reconstruction, Baseline.Reconstruction, Tolerance, Regressions);
+	return Regressions;
+}
+
+//
+// Benchmark
+//
+
+void FHaversineReplayBenchmark::InstallAllocationCounter()
+{
+	check(IsInGameThread());
+	if (!GHaversineAllocationCounterInstalled)
+	{
+		// Blocks allocated before this are freed through the wrapper too, which forwards them unchanged
+		FHaversineCountingMalloc* CountingMalloc = new FHaversineCountingMalloc(GMalloc);
+		FPlatformAtomics::InterlockedExchangePtr(reinterpret_cast<void**>(&GMalloc), CountingMalloc);
+		GHaversineAllocationCounterInstalled = true;
+		UE_LOG(LogHaversineSatellite, Log, TEXT("Counting heap allocations for the replay benchmark (whole process)"));
+	}
+}
+
+bool FHaversineReplayBenchmark::IsCountingAllocations()
+{
+	return GHaversineAllocationCounterInstalled;
+}
+
+bool FHaversineReplayBenchmark::Start(UHaversineDemoSubsystem& InSubsystem, const FString& Filename, double InSpeed)
+{
+	Subsystem = &InSubsystem;
+	Recording = Filename;
+	Speed = InSpeed;
+	bCompleted = false;
+
+	// Only this run's swings go into the percentiles
+	if (FHaversineSwingPipeline* Pipeline = InSubsystem.GetSwingPipeline())
+	{
+		Pipeline->ResetLatency();
+	}
+	FHaversineLatencyTracker::Get().Reset();
+
+	const FHaversineIngestStats Stats = InSubsystem.GetIngestStats();
+	StartPublished = Stats.SwingsPublished;
+	StartDiscarded = Stats.SwingsDiscarded;
+	StartAllocations = GHaversineAllocations.load(std::memory_order_relaxed);
+	StartSeconds = FPlatformTime::Seconds();
+	return InSubsystem.StartReplay(Filename, InSpeed);
+}
+
+bool FHaversineReplayBenchmark::Poll()
+{
+	if (bCompleted)
+	{
+		return true;
+	}
+
+	const UHaversineDemoSubsystem* Target = Subsystem.Get();
+	const FHaversineSwingReplay* Replay = Target ? Target->GetSwingReplay() : nullptr;
+	if (Replay && !Replay->IsFinished())
+	{
+		return false;
+	}
+
+	if (Replay)
+	{
+		const FHaversineIngestStats Stats = Target->GetIngestStats();
+		const uint64 Finished = (Stats.SwingsPublished - StartPublished) + (Stats.SwingsDiscarded - StartDiscarded);
+		if (Finished < static_cast<uint64>(Replay->GetNumSubmitted()))
+		{
+			return false;
+		}
+	}
+
+	CompletedSeconds = FPlatformTime::Seconds();
+	CompletedAllocations = GHaversineAllocations.load(std::memory_order_relaxed);
+	bCompleted = true;
+	return true;
+}
+
+FHaversineReplayBenchmarkResult FHaversineReplayBenchmark::Finish()
+{
+	Poll();
+
+	FHaversineReplayBenchmarkResult Result;
+	Result.Recording = FPaths::GetCleanFilename(Recording);
+	Result.Speed = Speed;
+	Result.Seconds = FMath::Max(CompletedSeconds - StartSeconds, UE_SMALL_NUMBER);
+
+	const UHaversineDemoSubsystem* Target = Subsystem.Get();
+	if (!Target)
+	{
+		return Result;
+	}
+
+	if (const FHaversineSwingReplay* Replay = Target->GetSwingReplay())
+	{
+		Result.Collections = Replay->GetNumSubmitted();
+	}
+	const FHaversineIngestStats Stats = Target->GetIngestStats();
+	Result.SwingsPublished = Stats.SwingsPublished - StartPublished;
+	Result.SwingsDiscarded = Stats.SwingsDiscarded - StartDiscarded;
+	Result.SwingsPerSecond = Result.SwingsPublished / Result.Seconds;
+	if (IsCountingAllocations() && Result.SwingsPublished > 0)
+	{
+		Result.AllocationsPerSwing = static_cast<double>(CompletedAllocations - StartAllocations) / Result.SwingsPublished;
+	}
+
+	if (const FHaversineSwingPipeline* Pipeline = Target->GetSwingPipeline())
+	{
+		for (int32 StageIndex = 0; StageIndex < static_cast<int32>(EHaversineSwingStage::Num); ++StageIndex)
+		{
+			Result.Stages[StageIndex] = Pipeline->GetStageStats(static_cast<EHaversineSwingStage>(StageIndex)).Latency;
+		}
+	}
+	Result.Reconstruction = FHaversineLatencyTracker::Get().Summarize(EHaversineLatencySegment::Reconstruction);
+	return Result;
+}
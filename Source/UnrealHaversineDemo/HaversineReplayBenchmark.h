@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineLatencyTracker.h"
+#include "HaversineSwingPipeline.h"
+
+class UHaversineDemoSubsystem;
+
+/** What one replay of a recording measured */
+struct FHaversineReplayBenchmarkResult
+{
+	FString Recording;
+	double Speed = 0.0;
+
+	int32 Collections = 0;
+	uint64 SwingsPublished = 0;
+	uint64 SwingsDiscarded = 0;
+
+	/** From the first replayed collection to the last one leaving the pipeline */
+	double Seconds = 0.0;
+	double SwingsPerSecond = 0.0;
+
+	/** `AllocationsPerSwing` when allocations were not counted, or a baseline does not record them */
+	static constexpr double AllocationsNotCounted = -1.0;
+
+	/**
+	 * Heap allocations anywhere in the process during the run (every thread, not only the swing path), per published
+	 * swing; `AllocationsNotCounted` unless the process was started with the allocation counter
+	 */
+	double AllocationsPerSwing = AllocationsNotCounted;
+
+	/** Per pipeline stage: queue wait plus service time */
+	FHaversineLatencySummary Stages[static_cast<int32>(EHaversineSwingStage::Num)];
+
+	/** Transfer finished to swing reconstructed, across the whole pipeline */
+	FHaversineLatencySummary Reconstruction;
+
+	void Log() const;
+
+	/** Writes the result as JSON, for use as the next run's baseline. @return false if the file could not be written. */
+	bool SaveBaseline(const FString& Filename) const;
+
+	/** @return false if the file cannot be read or parsed */
+	static bool LoadBaseline(const FString& Filename, FHaversineReplayBenchmarkResult& OutBaseline);
+
+	/**
+	 * Compares throughput, allocations per swing and per-stage p99 latency against a baseline.
+	 * @param Tolerance fraction a measurement may be worse than the baseline by, e.g. 0.1 for 10%
+	 * @return one line per regression; empty if none
+	 */
+	TArray<FString> FindRegressions(const FHaversineReplayBenchmarkResult& Baseline, double Tolerance) const;
+};
+
+/**
+ * Replays a recording (see `HaversineSwingRecording.h`) through a running subsystem's swing path and measures it:
+ * swings per second, per-stage latency percentiles and heap allocations per swing.
+ *
+ * Drive it from a loop that keeps the subsystem ticking, e.g. the headless ingest commandlet with `-Replay=`: `Start`,
+ * then `Poll` every tick until it returns true, then `Finish`. Game thread only.
+ */
+class FHaversineReplayBenchmark
+{
+public:
+	/** Command-line switch that makes the game module install the allocation counter at startup */
+	static constexpr const TCHAR* CountAllocationsSwitch = TEXT("HaversineCountAllocations");
+
+	/**
+	 * Count heap allocations from now on by wrapping `GMalloc`. Only for module startup (see
+	 * `CountAllocationsSwitch`): swapping the allocator while other threads allocate is not safe. The wrapper stays
+	 * installed for the life of the process, like the engine's own allocator proxies.
+	 */
+	static void InstallAllocationCounter();
+
+	/** @return whether `InstallAllocationCounter` has run, i.e. whether results will include allocations */
+	static bool IsCountingAllocations();
+
+	/** Resets the latency distributions and starts the replay. @return false if the recording cannot be replayed. */
+	bool Start(UHaversineDemoSubsystem& InSubsystem, const FString& Filename, double Speed);
+
+	/** @return true once every replayed collection has been published or discarded by the pipeline */
+	bool Poll();
+
+	FHaversineReplayBenchmarkResult Finish();
+
+private:
+	TWeakObjectPtr<UHaversineDemoSubsystem> Subsystem;
+	FString Recording;
+	double Speed = 0.0;
+
+	uint64 StartPublished = 0;
+	uint64 StartDiscarded = 0;
+	uint64 StartAllocations = 0;
+	double StartSeconds = 0.0;
+
+	double CompletedSeconds = 0.0;
+	uint64 CompletedAllocations = 0;
+	bool bCompleted = false;
+};
@@ -0,0 +1,259 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSatelliteRegistry.cpp
+// UnrealHaversineDemo
+//
+// Live satellite list published as shared, immutable snapshots
+//
+
+#include "HaversineSatelliteRegistry.h"
+#include "HaversineSatelliteStateCache.h"
+#include "SuperTagKitPlugin.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+
+const FHaversineSatelliteRow* FHaversineSatelliteRegistrySnapshot::Find(const FString& SatelliteId) const
+{
+	const int32 Index = IndexOf(SatelliteId);
+	return Index != INDEX_NONE ? &(*this)[Index] : nullptr;
+}
+
+int32 FHaversineSatelliteRegistrySnapshot::IndexOf(const FString& SatelliteId) const
+{
+	const int32* Index = RowsById ? RowsById->Find(SatelliteId) : nullptr;
+	return Index && *Index < NumRows ? *Index : INDEX_NONE;
+}
+
+//
+// Readers
+//
+
+FHaversineSatelliteRegistry::FReadScope::FReadScope(const FHaversineSatelliteRegistry& InRegistry)
+	: Registry(InRegistry)
+	, ReaderSlot(InRegistry.PinReader())
+	, Snapshot(InRegistry.Current.load())
+{
+}
+
+FHaversineSatelliteRegistry::FReadScope::~FReadScope()
+{
+	Registry.UnpinReader(ReaderSlot);
+}
+
+int32 FHaversineSatelliteRegistry::PinReader() const
+{
+	// Start at a slot that depends on the thread, so concurrent readers rarely try the same one
+	const int32 First = static_cast<int32>(FPlatformTLS::GetCurrentThreadId() % MaxReaders);
+	for (int32 Attempt = 0; ; ++Attempt)
+	{
+		const int32 Index = (First + Attempt) % MaxReaders;
+		uint64 Expected = 0;
+
+		// A reader whose epoch is newer than a snapshot's retirement cannot have loaded that snapshot: it was replaced
+		// before the epoch advanced. Everything here is sequentially consistent so the writer's scan agrees.
+		if (ReaderSlots[Index].Epoch.compare_exchange_strong(Expected, GlobalEpoch.load()))
+		{
+			return Index;
+		}
+
+		// Every slot taken: more concurrent readers than expected, wait for one to leave
+		if ((Attempt + 1) % MaxReaders == 0)
+		{
+			FPlatformProcess::Yield();
+		}
+	}
+}
+
+void FHaversineSatelliteRegistry::UnpinReader(int32 ReaderSlot) const
+{
+	ReaderSlots[ReaderSlot].Epoch.store(0);
+}
+
+//
+// Writer
+//
+
+FHaversineSatelliteRegistry::FHaversineSatelliteRegistry()
+	: Current(new FHaversineSatelliteRegistrySnapshot())
+{
+}
+
+FHaversineSatelliteRegistry::~FHaversineSatelliteRegistry()
+{
+	Shutdown();
+
+	// No reader may outlive the registry
+	for (const FRetiredSnapshot& Entry : Retired)
+	{
+		delete Entry.Snapshot;
+	}
+	delete Current.load();
+}
+
+void FHaversineSatelliteRegistry::Start()
+{
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FHaversineSatelliteRegistry::Tick), 0.0f);
+	}
+}
+
+void FHaversineSatelliteRegistry::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+	Publish();
+}
+
+bool FHaversineSatelliteRegistry::Tick(float DeltaTime)
+{
+	Publish();
+	if (!Retired.IsEmpty())
+	{
+		Reclaim();
+	}
+	return true;
+}
+
+void FHaversineSatelliteRegistry::Update(const FHaversineSatelliteSnapshot& Satellite)
+{
+	check(IsInGameThread());
+
+	int32 Index;
+	if (const int32* Found = RowsById.Find(Satellite.SatelliteId))
+	{
+		Index = *Found;
+	}
+	else
+	{
+		Index = Rows.AddDefaulted();
+		Rows[Index].SatelliteId = Satellite.SatelliteId;
+		RowsById.Add(Satellite.SatelliteId, Index);
+		if ((Index & (FHaversineSatelliteRegistrySnapshot::ChunkSize - 1)) == 0)
+		{
+			DirtyChunks.Add(true);
+		}
+		bRowsAdded = true;
+		NumSatellites.store(Rows.Num(), std::memory_order_relaxed);
+	}
+
+	FHaversineSatelliteRow& Row = Rows[Index];
+
+	// State updates do not always carry the name; keep the one from discovery
+	if (!Satellite.Name.IsEmpty())
+	{
+		Row.Name = Satellite.Name;
+	}
+	Row.LastSeenUnixMs = FHaversineSatelliteStateCache::NowUnixMs();
+	Row.FirmwareVersionMajor = Satellite.FirmwareVersionMajor;
+	Row.FirmwareVersionMinor = Satellite.FirmwareVersionMinor;
+	Row.CollectionCount = Satellite.CollectionCount;
+	Row.bInCollectionState = Satellite.bInCollectionState;
+	Row.bIsMoving = Satellite.bIsMoving;
+	Row.bIsDark = Satellite.bIsDark;
+	Row.bNeedsServicing = Satellite.bNeedsServicing;
+
+	DirtyChunks[Index >> FHaversineSatelliteRegistrySnapshot::ChunkShift] = true;
+	bDirty = true;
+	Updates.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FHaversineSatelliteRegistry::Publish()
+{
+	check(IsInGameThread());
+	if (!bDirty)
+	{
+		return;
+	}
+
+	using FChunk = FHaversineSatelliteRegistrySnapshot::FChunk;
+	constexpr int32 ChunkSize = FHaversineSatelliteRegistrySnapshot::ChunkSize;
+
+	const FHaversineSatelliteRegistrySnapshot* Previous = Current.load();
+	FHaversineSatelliteRegistrySnapshot* Next = new FHaversineSatelliteRegistrySnapshot();
+	Next->NumRows = Rows.Num();
+	Next->Version = Previous->Version + 1;
+	Next->RowsById = bRowsAdded ? MakeShared<TMap<FString, int32>, ESPMode::ThreadSafe>(RowsById) : Previous->RowsById;
+
+	// Unchanged chunks are shared with the previous snapshot; only the changed ones are copied
+	const int32 NumChunks = DirtyChunks.Num();
+	Next->Chunks.Reserve(NumChunks);
+	for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+	{
+		if (!DirtyChunks[ChunkIndex] && Previous->Chunks.IsValidIndex(ChunkIndex))
+		{
+			Next->Chunks.Add(Previous->Chunks[ChunkIndex]);
+			continue;
+		}
+
+		TSharedRef<FChunk, ESPMode::ThreadSafe> Chunk = MakeShared<FChunk, ESPMode::ThreadSafe>();
+		const int32 FirstRow = ChunkIndex * ChunkSize;
+		const int32 NumChunkRows = FMath::Min(ChunkSize, Rows.Num() - FirstRow);
+		for (int32 Row = 0; Row < NumChunkRows; ++Row)
+		{
+			Chunk->Rows[Row] = Rows[FirstRow + Row];
+		}
+		Next->Chunks.Add(Chunk);
+		ChunksCopied.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	DirtyChunks.Init(false, NumChunks);
+	bRowsAdded = false;
+	bDirty = false;
+
+	// Swap first, then advance the epoch: readers that pin the new epoch are guaranteed to load `Next`
+	Current.store(Next);
+	Retired.Add({ Previous, GlobalEpoch.fetch_add(1) });
+	Published.fetch_add(1, std::memory_order_relaxed);
+
+	Reclaim();
+}
+
+void FHaversineSatelliteRegistry::Reclaim()
+{
+	uint64 OldestPinned = MAX_uint64;
+	for (const FReaderSlot& Slot : ReaderSlots)
+	{
+		const uint64 Epoch = Slot.Epoch.load();
+		if (Epoch != 0)
+		{
+			OldestPinned = FMath::Min(OldestPinned, Epoch);
+		}
+	}
+
+	// A snapshot retired at epoch E can only be held by readers that pinned E or earlier
+	Retired.RemoveAllSwap([OldestPinned](const FRetiredSnapshot& Entry)
+	{
+		if (Entry.Epoch < OldestPinned)
+		{
+			delete Entry.Snapshot;
+			return true;
+		}
+		return false;
+	});
+	NumRetired.store(Retired.Num(), std::memory_order_relaxed);
+}
+
+FHaversineSatelliteRegistryStats FHaversineSatelliteRegistry::GetStats() const
+{
+	FHaversineSatelliteRegistryStats Stats;
+	Stats.Satellites = NumSatellites.load(std::memory_order_relaxed);
+	Stats.Updates = Updates.load(std::memory_order_relaxed);
+	Stats.Published = Published.load(std::memory_order_relaxed);
+	Stats.ChunksCopied = ChunksCopied.load(std::memory_order_relaxed);
+	Stats.Retired = NumRetired.load(std::memory_order_relaxed);
+	return Stats;
+}
+
+void FHaversineSatelliteRegistry::LogStats() const
+{
+	const FHaversineSatelliteRegistryStats Stats = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Satellite registry stats: %d satellites | updates=%llu snapshots=%llu chunks-copied=%llu (%.1f per snapshot) | retired-pending=%d"),
+		Stats.Satellites, Stats.Updates, Stats.Published, Stats.ChunksCopied,
+		Stats.Published > 0 ? static_cast<double>(Stats.ChunksCopied) / Stats.Published : 0.0, Stats.Retired);
+}
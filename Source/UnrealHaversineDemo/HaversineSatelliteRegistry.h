@@ -0,0 +1,185 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "HaversineFleetEvents.h"
+#include <atomic>
+
+/** What the registry keeps about one satellite: enough to draw a fleet list */
+struct FHaversineSatelliteRow
+{
+	FString SatelliteId;
+	FString Name;
+
+	/** When the last discovery or state event for this satellite was handled */
+	int64 LastSeenUnixMs = 0;
+
+	uint16 FirmwareVersionMajor = 0;
+	uint16 FirmwareVersionMinor = 0;
+	uint16 CollectionCount = 0;
+
+	uint8 bInCollectionState : 1 = 0;
+	uint8 bIsMoving : 1 = 0;
+	uint8 bIsDark : 1 = 0;
+	uint8 bNeedsServicing : 1 = 0;
+
+	FHaversineSatelliteSnapshot ToSnapshot() const
+	{
+		FHaversineSatelliteSnapshot Snapshot;
+		Snapshot.SatelliteId = SatelliteId;
+		Snapshot.Name = Name;
+		Snapshot.FirmwareVersionMajor = FirmwareVersionMajor;
+		Snapshot.FirmwareVersionMinor = FirmwareVersionMinor;
+		Snapshot.CollectionCount = CollectionCount;
+		Snapshot.bInCollectionState = bInCollectionState;
+		Snapshot.bIsMoving = bIsMoving;
+		Snapshot.bIsDark = bIsDark;
+		Snapshot.bNeedsServicing = bNeedsServicing;
+		return Snapshot;
+	}
+};
+
+/**
+ * Immutable view of every satellite seen this session, in discovery order.
+ *
+ * Rows are stored in fixed-size chunks that consecutive snapshots share: publishing a snapshot only copies the chunks
+ * whose rows changed, and reading one never copies anything.
+ */
+class FHaversineSatelliteRegistrySnapshot
+{
+public:
+	static constexpr int32 ChunkShift = 6;
+	static constexpr int32 ChunkSize = 1 << ChunkShift;
+
+	int32 Num() const { return NumRows; }
+
+	const FHaversineSatelliteRow& operator[](int32 Index) const
+	{
+		check(Index >= 0 && Index < NumRows);
+		return Chunks[Index >> ChunkShift]->Rows[Index & (ChunkSize - 1)];
+	}
+
+	/** @return null if the satellite has not been seen */
+	const FHaversineSatelliteRow* Find(const FString& SatelliteId) const;
+
+	/** @return the satellite's position in discovery order, or INDEX_NONE if it has not been seen */
+	int32 IndexOf(const FString& SatelliteId) const;
+
+	/** Increases with every published snapshot; unchanged means nothing to redraw */
+	uint64 GetVersion() const { return Version; }
+
+private:
+	friend class FHaversineSatelliteRegistry;
+
+	struct FChunk
+	{
+		FHaversineSatelliteRow Rows[ChunkSize];
+	};
+
+	TArray<TSharedRef<const FChunk, ESPMode::ThreadSafe>> Chunks;
+	TSharedPtr<const TMap<FString, int32>, ESPMode::ThreadSafe> RowsById;
+	int32 NumRows = 0;
+	uint64 Version = 0;
+};
+
+/** Point-in-time counters for `FHaversineSatelliteRegistry` */
+struct FHaversineSatelliteRegistryStats
+{
+	int32 Satellites = 0;
+	uint64 Updates = 0;
+	uint64 Published = 0;
+	uint64 ChunksCopied = 0;
+
+	/** Snapshots replaced but still pinned by a reader */
+	int32 Retired = 0;
+};
+
+/**
+ * Live list of satellites, updated incrementally from discovery and state events and readable from any thread.
+ *
+ * The game thread applies updates to its own copy of the rows and, at most once per frame, publishes a new immutable
+ * snapshot by swapping a pointer. Readers pin the current snapshot with an `FReadScope`: two atomic operations on a
+ * per-reader slot, no lock and no copy. A replaced snapshot is freed once every reader that might still be looking at it
+ * has left its scope (epoch-based reclamation), so read scopes should be short, e.g. one UI refresh.
+ *
+ * `Update`, `Publish`, `Start` and `Shutdown` must be called on the game thread; `FReadScope` may be used on any thread.
+ */
+class FHaversineSatelliteRegistry
+{
+public:
+	/** Pins the current snapshot for as long as it lives. Do not keep one across frames. */
+	class FReadScope : public FNoncopyable
+	{
+	public:
+		explicit FReadScope(const FHaversineSatelliteRegistry& InRegistry);
+		~FReadScope();
+
+		const FHaversineSatelliteRegistrySnapshot& operator*() const { return *Snapshot; }
+		const FHaversineSatelliteRegistrySnapshot* operator->() const { return Snapshot; }
+
+	private:
+		const FHaversineSatelliteRegistry& Registry;
+		int32 ReaderSlot;
+		const FHaversineSatelliteRegistrySnapshot* Snapshot;
+	};
+
+	FHaversineSatelliteRegistry();
+	~FHaversineSatelliteRegistry();
+
+	/** Start publishing changes once per frame */
+	void Start();
+
+	/** Publish pending changes and stop the per-frame publisher. Readers may continue to use the last snapshot. */
+	void Shutdown();
+
+	/** Add the satellite, or update its row. Visible to readers after the next `Publish`. */
+	void Update(const FHaversineSatelliteSnapshot& Satellite);
+
+	/** Make pending updates visible now rather than at the end of the frame */
+	void Publish();
+
+	FHaversineSatelliteRegistryStats GetStats() const;
+	void LogStats() const;
+
+private:
+	static constexpr int32 MaxReaders = 64;
+
+	/** Epoch a reader pinned, or 0 if the slot is free. One cache line each, so readers do not contend. */
+	struct alignas(PLATFORM_CACHE_LINE_SIZE) FReaderSlot
+	{
+		std::atomic<uint64> Epoch{0};
+	};
+
+	struct FRetiredSnapshot
+	{
+		const FHaversineSatelliteRegistrySnapshot* Snapshot;
+		uint64 Epoch;
+	};
+
+	int32 PinReader() const;
+	void UnpinReader(int32 ReaderSlot) const;
+	void Reclaim();
+	bool Tick(float DeltaTime);
+
+	// Readers
+	std::atomic<const FHaversineSatelliteRegistrySnapshot*> Current;
+	std::atomic<uint64> GlobalEpoch{1};
+	mutable FReaderSlot ReaderSlots[MaxReaders];
+
+	// Game thread only
+	TArray<FHaversineSatelliteRow> Rows;
+	TMap<FString, int32> RowsById;
+	TBitArray<> DirtyChunks;
+	bool bRowsAdded = false;
+	bool bDirty = false;
+	TArray<FRetiredSnapshot> Retired;
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	std::atomic<uint64> Updates{0};
+	std::atomic<uint64> Published{0};
+	std::atomic<uint64> ChunksCopied{0};
+	std::atomic<int32> NumRetired{0};
+	std::atomic<int32> NumSatellites{0};
+};
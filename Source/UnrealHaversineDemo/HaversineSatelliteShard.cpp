@@ -0,0 +1,510 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSatelliteShard.cpp
+// UnrealHaversineDemo
+//
+// One satellite manager per hardware version and fleet partition, each with its own event thread
+//
+
+#include "HaversineSatelliteShard.h"
+#include "SuperTagKitPlugin.h"
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Crc.h"
+#include "Misc/ScopeLock.h"
+#include "haversine/satellite_id.h"
+
+static TAutoConsoleVariable<FString> CVarHaversineShardsHardwareVersions(
+	TEXT("haversine.Shards.HardwareVersions"),
+	TEXT("10.0"),
+	TEXT("Comma-separated SuperTag hardware versions to run a satellite manager for, e.g. \"10.0,11.0\". Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineShardsPartitionsPerVersion(
+	TEXT("haversine.Shards.PartitionsPerVersion"),
+	1,
+	TEXT("Satellite managers per hardware version, each handling the satellites whose ID hashes to it. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static constexpr int32 MaxPartitionsPerVersion = 16;
+
+// Longest the shard thread sleeps before re-checking for events and shutdown
+static constexpr uint32 MaxIdleWaitMs = 50;
+
+FString FHaversineSatelliteShardConfig::GetName() const
+{
+	return PartitionCount > 1
+		? FString::Printf(TEXT("%d.%d #%d/%d"), HardwareVersionMajor, HardwareVersionMinor, PartitionIndex + 1, PartitionCount)
+		: FString::Printf(TEXT("%d.%d"), HardwareVersionMajor, HardwareVersionMinor);
+}
+
+TArray<FHaversineSatelliteShardConfig> FHaversineSatelliteShardConfig::FromConsoleVariables()
+{
+	const int32 PartitionCount = FMath::Clamp(CVarHaversineShardsPartitionsPerVersion.GetValueOnAnyThread(), 1, MaxPartitionsPerVersion);
+
+	TArray<FString> Versions;
+	CVarHaversineShardsHardwareVersions.GetValueOnAnyThread().ParseIntoArray(Versions, TEXT(","));
+
+	TArray<FHaversineSatelliteShardConfig> Result;
+	for (FString& Version : Versions)
+	{
+		Version.TrimStartAndEndInline();
+		FString Major;
+		FString Minor = TEXT("0");
+		if (!Version.Split(TEXT("."), &Major, &Minor))
+		{
+			Major = Version;
+		}
+		if (!Major.IsNumeric() || !Minor.IsNumeric())
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Ignoring hardware version '%s' in haversine.Shards.HardwareVersions"), *Version);
+			continue;
+		}
+
+		const int32 VersionMajor = FCString::Atoi(*Major);
+		const int32 VersionMinor = FCString::Atoi(*Minor);
+		const bool bDuplicate = Result.ContainsByPredicate([VersionMajor, VersionMinor](const FHaversineSatelliteShardConfig& Existing)
+		{
+			return Existing.HardwareVersionMajor == VersionMajor && Existing.HardwareVersionMinor == VersionMinor;
+		});
+		if (bDuplicate)
+		{
+			continue;
+		}
+
+		for (int32 Partition = 0; Partition < PartitionCount; ++Partition)
+		{
+			FHaversineSatelliteShardConfig& Shard = Result.AddDefaulted_GetRef();
+			Shard.HardwareVersionMajor = VersionMajor;
+			Shard.HardwareVersionMinor = VersionMinor;
+			Shard.PartitionIndex = Partition;
+			Shard.PartitionCount = PartitionCount;
+			Shard.bReportsBluetoothState = Result.Num() == 1;
+		}
+	}
+
+	if (Result.IsEmpty())
+	{
+		for (int32 Partition = 0; Partition < PartitionCount; ++Partition)
+		{
+			FHaversineSatelliteShardConfig& Shard = Result.AddDefaulted_GetRef();
+			Shard.PartitionIndex = Partition;
+			Shard.PartitionCount = PartitionCount;
+			Shard.bReportsBluetoothState = Partition == 0;
+		}
+	}
+	return Result;
+}
+
+FHaversineSatelliteShard::FHaversineSatelliteShard(const FHaversineSatelliteShardConfig& InConfig, IHaversineFleetListener* InListener, FSdkDiscoveryFunction&& InOnSdkDiscovery)
+	: Config(InConfig)
+	, Name(InConfig.GetName())
+	, Listener(InListener)
+	, OnSdkDiscovery(MoveTemp(InOnSdkDiscovery))
+{
+	check(Listener);
+}
+
+FHaversineSatelliteShard::~FHaversineSatelliteShard()
+{
+	Stop();
+}
+
+void FHaversineSatelliteShard::Start(haversine::HaversineEnvironment&& Environment)
+{
+	if (Thread)
+	{
+		return;
+	}
+
+	// The thread is running before the manager exists, so nothing the manager reports waits for it
+	bStopping = false;
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("HaversineShard %s"), *Name), 0, TPri_Normal);
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Creating satellite manager (HW version %d.%d, shard %s)"),
+		Config.HardwareVersionMajor, Config.HardwareVersionMinor, *Name);
+	SatelliteManager = std::make_unique<haversine::HaversineSatelliteManager>(
+		std::move(Environment), Config.HardwareVersionMajor, Config.HardwareVersionMinor
+	);
+
+	BluetoothSubscription = std::make_unique<haversine::EventSubscription<haversine::BluetoothState>>(
+		const_cast<haversine::EventChannel<haversine::BluetoothState>&>(SatelliteManager->bluetooth_state_events())
+			.subscribe([this](const haversine::BluetoothState& State) {
+				OnFleetBluetoothStateChanged(State);
+			})
+	);
+
+	// Every manager discovers every satellite in range; only the owner's discovery goes any further
+	DiscoverySubscription = std::make_unique<haversine::EventSubscription<std::shared_ptr<haversine::HaversineSatellite>>>(
+		const_cast<haversine::EventChannel<std::shared_ptr<haversine::HaversineSatellite>>&>(SatelliteManager->discovery_events())
+			.subscribe([this](const std::shared_ptr<haversine::HaversineSatellite>& Satellite) {
+				if (!Satellite)
+				{
+					UE_LOG(LogHaversineSatellite, Warning, TEXT("Received null satellite in discovery event"));
+					return;
+				}
+				const FString SatelliteId = UTF8_TO_TCHAR(Satellite->id().str().c_str());
+				if (!IsOwned(SatelliteId))
+				{
+					SatellitesIgnored.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				SubscribeToStateUpdates(Satellite, SatelliteId);
+
+				// The state is copied here, on the thread the SDK reported it on; nothing later reads the live one
+				FShardEvent Event;
+				Event.Type = EEventType::SdkSatelliteDiscovered;
+				Event.SdkState = std::make_shared<const haversine::SatelliteState>(Satellite->state());
+				Event.Satellite = FHaversineSatelliteSnapshot::FromSdkState(SatelliteId,
+					Satellite->name() ? FString(UTF8_TO_TCHAR(Satellite->name()->c_str())) : FString(TEXT("(unnamed)")), *Event.SdkState);
+				Enqueue(MoveTemp(Event));
+			})
+	);
+
+	ScanCompletionSubscription = std::make_unique<haversine::EventSubscription<haversine::Status>>(
+		const_cast<haversine::EventChannel<haversine::Status>&>(SatelliteManager->scanning_completion_events())
+			.subscribe([this](const haversine::Status& Status) {
+				OnFleetScanCompleted(Status.ok(), Status.ok() ? FString() : FString(UTF8_TO_TCHAR(Status.to_string().c_str())));
+			})
+	);
+}
+
+void FHaversineSatelliteShard::Stop()
+{
+	if (!Thread)
+	{
+		return;
+	}
+
+	// The manager (and with it the delegates) goes first, so the shard thread's last drain sees everything it reported
+	BluetoothSubscription.reset();
+	DiscoverySubscription.reset();
+	ScanCompletionSubscription.reset();
+	{
+		FScopeLock Lock(&StateSubscriptionsMutex);
+		for (TPair<FString, FStateSubscription>& Pair : StateSubscriptions)
+		{
+			Pair.Value.Subscription.reset();
+		}
+		StateSubscriptions.Reset();
+	}
+	SatelliteManager.reset();
+
+	bStopping = true;
+	WakeEvent->Trigger();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+bool FHaversineSatelliteShard::StartScanning()
+{
+	if (!SatelliteManager)
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("Cannot start scanning on shard %s: SatelliteManager is null"), *Name);
+		return false;
+	}
+
+	if (SatelliteManager->is_scanning())
+	{
+		UE_LOG(LogHaversineSatellite, Log, TEXT("Shard %s already scanning, skipping start request"), *Name);
+		return true;
+	}
+
+	haversine::Status ScanResult = SatelliteManager->scan_for_satellites();
+	if (!ScanResult.ok())
+	{
+		FString ErrorMsg = UTF8_TO_TCHAR(ScanResult.to_string().c_str());
+		UE_LOG(LogHaversineSatellite, Error, TEXT("Failed to start scanning on shard %s: %s"), *Name, *ErrorMsg);
+		return false;
+	}
+	return true;
+}
+
+void FHaversineSatelliteShard::StopScanning()
+{
+	if (SatelliteManager && SatelliteManager->is_scanning())
+	{
+		SatelliteManager->stop_scanning();
+	}
+}
+
+bool FHaversineSatelliteShard::IsScanning() const
+{
+	return SatelliteManager && SatelliteManager->is_scanning();
+}
+
+haversine::BluetoothState FHaversineSatelliteShard::GetBluetoothState() const
+{
+	return SatelliteManager ? SatelliteManager->bluetooth_state() : haversine::BluetoothState::Unknown;
+}
+
+void FHaversineSatelliteShard::SubscribeToStateUpdates(const std::shared_ptr<haversine::HaversineSatellite>& Satellite, const FString& SatelliteId)
+{
+	FScopeLock Lock(&StateSubscriptionsMutex);
+	if (StateSubscriptions.Contains(SatelliteId))
+	{
+		return;
+	}
+
+	// A tag that starts recording or needs servicing after it was discovered is only seen through these updates
+	const FString SatelliteName = Satellite->name() ? FString(UTF8_TO_TCHAR(Satellite->name()->c_str())) : FString();
+	FStateSubscription& Entry = StateSubscriptions.Add(SatelliteId);
+	Entry.Satellite = Satellite;
+	Entry.Subscription = std::make_unique<haversine::EventSubscription<haversine::SatelliteState>>(
+		const_cast<haversine::EventChannel<haversine::SatelliteState>&>(Satellite->state_update_events())
+			.subscribe([this, SatelliteId, SatelliteName](const haversine::SatelliteState& State) {
+				OnFleetSatelliteStateUpdated(FHaversineSatelliteSnapshot::FromSdkState(SatelliteId, SatelliteName, State));
+			})
+	);
+}
+
+bool FHaversineSatelliteShard::IsOwned(const FString& SatelliteId) const
+{
+	// CRC rather than GetTypeHash: the split must not change between builds, or the state cache and scheduler
+	// would see satellites move between shards
+	return Config.PartitionCount <= 1
+		|| static_cast<int32>(FCrc::StrCrc32(*SatelliteId) % static_cast<uint32>(Config.PartitionCount)) == Config.PartitionIndex;
+}
+
+//
+// IHaversineFleetListener. Called on the SDK's threads; only `FirstCollectionToTransfer`, which the SDK needs
+// answered before it carries on, reaches the listener from here. Everything about another partition's satellites is dropped.
+//
+
+void FHaversineSatelliteShard::OnFleetBluetoothStateChanged(haversine::BluetoothState State)
+{
+	if (!Config.bReportsBluetoothState)
+	{
+		return;
+	}
+
+	FShardEvent Event;
+	Event.Type = EEventType::BluetoothStateChanged;
+	Event.BluetoothState = State;
+	Enqueue(MoveTemp(Event));
+}
+
+void FHaversineSatelliteShard::OnFleetSatelliteDiscovered(const FHaversineSatelliteSnapshot& Satellite)
+{
+	if (!IsOwned(Satellite.SatelliteId))
+	{
+		SatellitesIgnored.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	FShardEvent Event;
+	Event.Type = EEventType::SatelliteDiscovered;
+	Event.Satellite = Satellite;
+	Enqueue(MoveTemp(Event));
+}
+
+void FHaversineSatelliteShard::OnFleetSatelliteStateUpdated(const FHaversineSatelliteSnapshot& Satellite)
+{
+	if (!IsOwned(Satellite.SatelliteId))
+	{
+		return;
+	}
+
+	FShardEvent Event;
+	Event.Type = EEventType::SatelliteStateUpdated;
+	Event.Satellite = Satellite;
+	Enqueue(MoveTemp(Event));
+}
+
+void FHaversineSatelliteShard::OnFleetScanCompleted(bool bSuccess, const FString& Error)
+{
+	FShardEvent Event;
+	Event.Type = EEventType::ScanCompleted;
+	Event.bSuccess = bSuccess;
+	Event.Error = bSuccess ? FString() : FString::Printf(TEXT("%s (shard %s)"), *Error, *Name);
+	Enqueue(MoveTemp(Event));
+}
+
+uint16 FHaversineSatelliteShard::FirstCollectionToTransfer(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex)
+{
+	// The owning partition's manager is offered the same collections; transferring them here too would publish each twice
+	if (!IsOwned(SatelliteId))
+	{
+		TransfersDeclined.fetch_add(1, std::memory_order_relaxed);
+		return EndIndex;
+	}
+	return Listener->FirstCollectionToTransfer(SatelliteId, StartIndex, EndIndex);
+}
+
+void FHaversineSatelliteShard::OnCollectionTransfersStarting(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex)
+{
+	if (!IsOwned(SatelliteId))
+	{
+		return;
+	}
+
+	FShardEvent Event;
+	Event.Type = EEventType::TransfersStarting;
+	Event.SatelliteId = SatelliteId;
+	Event.StartIndex = StartIndex;
+	Event.EndIndex = EndIndex;
+	Enqueue(MoveTemp(Event));
+}
+
+void FHaversineSatelliteShard::OnCollectionTransferred(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection)
+{
+	if (!IsOwned(SatelliteId))
+	{
+		return;
+	}
+
+	FShardEvent Event;
+	Event.Type = EEventType::CollectionTransferred;
+	Event.SatelliteId = SatelliteId;
+	Event.StartIndex = CollectionIndex;
+	Event.Collection = Collection;
+	Enqueue(MoveTemp(Event));
+}
+
+void FHaversineSatelliteShard::OnCollectionTransferFailed(const FString& SatelliteId, uint16 CollectionIndex, const FString& Error)
+{
+	if (!IsOwned(SatelliteId))
+	{
+		return;
+	}
+
+	FShardEvent Event;
+	Event.Type = EEventType::CollectionTransferFailed;
+	Event.SatelliteId = SatelliteId;
+	Event.StartIndex = CollectionIndex;
+	Event.bSuccess = false;
+	Event.Error = Error;
+	Enqueue(MoveTemp(Event));
+}
+
+void FHaversineSatelliteShard::Enqueue(FShardEvent&& Event)
+{
+	Event.EnqueueCycles = FPlatformTime::Cycles64();
+	Events.Enqueue(MoveTemp(Event));
+
+	const uint64 NumEnqueued = Enqueued.fetch_add(1, std::memory_order_relaxed) + 1;
+	const int32 Backlog = static_cast<int32>(NumEnqueued - Processed.load(std::memory_order_relaxed));
+	int32 PreviousMax = MaxBacklog.load(std::memory_order_relaxed);
+	while (Backlog > PreviousMax
+		&& !MaxBacklog.compare_exchange_weak(PreviousMax, Backlog, std::memory_order_relaxed))
+	{
+	}
+
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+//
+// Shard thread
+//
+
+uint32 FHaversineSatelliteShard::Run()
+{
+	for (;;)
+	{
+		// Read before draining: once the manager is gone and this is set, one more drain empties the queue for good
+		const bool bStop = bStopping.load();
+		Drain();
+		if (bStop)
+		{
+			break;
+		}
+		WakeEvent->Wait(MaxIdleWaitMs);
+	}
+	return 0;
+}
+
+void FHaversineSatelliteShard::Drain()
+{
+	FShardEvent Event;
+	while (Events.Dequeue(Event))
+	{
+		const uint64 QueueCycles = FPlatformTime::Cycles64() - Event.EnqueueCycles;
+		TotalQueueCycles.store(TotalQueueCycles.load(std::memory_order_relaxed) + QueueCycles, std::memory_order_relaxed);
+		if (QueueCycles > MaxQueueCycles.load(std::memory_order_relaxed))
+		{
+			MaxQueueCycles.store(QueueCycles, std::memory_order_relaxed);
+		}
+
+		Deliver(Event);
+		Processed.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void FHaversineSatelliteShard::Deliver(const FShardEvent& Event)
+{
+	switch (Event.Type)
+	{
+		case EEventType::BluetoothStateChanged:
+			Listener->OnFleetBluetoothStateChanged(Event.BluetoothState);
+			break;
+
+		case EEventType::SdkSatelliteDiscovered:
+			if (OnSdkDiscovery)
+			{
+				OnSdkDiscovery(Event.Satellite, Event.SdkState);
+			}
+			break;
+
+		case EEventType::SatelliteDiscovered:
+			Listener->OnFleetSatelliteDiscovered(Event.Satellite);
+			break;
+
+		case EEventType::SatelliteStateUpdated:
+			Listener->OnFleetSatelliteStateUpdated(Event.Satellite);
+			break;
+
+		case EEventType::ScanCompleted:
+			Listener->OnFleetScanCompleted(Event.bSuccess, Event.Error);
+			break;
+
+		case EEventType::TransfersStarting:
+			Listener->OnCollectionTransfersStarting(Event.SatelliteId, Event.StartIndex, Event.EndIndex);
+			break;
+
+		case EEventType::CollectionTransferred:
+			CollectionsTransferred.fetch_add(1, std::memory_order_relaxed);
+			Listener->OnCollectionTransferred(Event.SatelliteId, Event.StartIndex, Event.Collection.ToSharedRef());
+			break;
+
+		case EEventType::CollectionTransferFailed:
+			Listener->OnCollectionTransferFailed(Event.SatelliteId, Event.StartIndex, Event.Error);
+			break;
+	}
+}
+
+FHaversineSatelliteShardStats FHaversineSatelliteShard::GetStats() const
+{
+	FHaversineSatelliteShardStats Result;
+	Result.Processed = Processed.load(std::memory_order_relaxed);
+	Result.Enqueued = FMath::Max(Enqueued.load(std::memory_order_relaxed), Result.Processed);
+	Result.CollectionsTransferred = CollectionsTransferred.load(std::memory_order_relaxed);
+	Result.SatellitesIgnored = SatellitesIgnored.load(std::memory_order_relaxed);
+	Result.TransfersDeclined = TransfersDeclined.load(std::memory_order_relaxed);
+	Result.Backlog = static_cast<int32>(Result.Enqueued - Result.Processed);
+	Result.MaxBacklog = MaxBacklog.load(std::memory_order_relaxed);
+	Result.AverageQueueMs = Result.Processed > 0
+		? FPlatformTime::ToMilliseconds64(TotalQueueCycles.load(std::memory_order_relaxed)) / Result.Processed
+		: 0.0;
+	Result.MaxQueueMs = FPlatformTime::ToMilliseconds64(MaxQueueCycles.load(std::memory_order_relaxed));
+	return Result;
+}
+
+void FHaversineSatelliteShard::LogStats() const
+{
+	const FHaversineSatelliteShardStats Current = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Shard %s stats: events=%llu delivered=%llu backlog=%d (max %d) | collections=%llu | other partitions: discoveries ignored=%llu transfers declined=%llu | queue avg %.2f ms max %.2f ms"),
+		*Name, Current.Enqueued, Current.Processed, Current.Backlog, Current.MaxBacklog, Current.CollectionsTransferred,
+		Current.SatellitesIgnored, Current.TransfersDeclined, Current.AverageQueueMs, Current.MaxQueueMs);
+}
@@ -0,0 +1,218 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineFleetEvents.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include "haversine/haversine_environment.h"
+#include "haversine/haversine_satellite_manager.h"
+#include "haversine/haversine_satellite.h"
+#include "haversine/utils/events.h"
+#include <atomic>
+#include <memory>
+
+class FEvent;
+class FRunnableThread;
+
+/** Which satellites one shard's satellite manager handles */
+struct FHaversineSatelliteShardConfig
+{
+	/** SuperTag hardware version the shard's satellite manager is created for */
+	int32 HardwareVersionMajor = 10;
+	int32 HardwareVersionMinor = 0;
+
+	/** The shard handles the satellites whose ID hashes to `PartitionIndex` out of `PartitionCount` */
+	int32 PartitionIndex = 0;
+	int32 PartitionCount = 1;
+
+	/**
+	 * Every satellite manager watches the same adapter, so only one shard reports Bluetooth state changes; the
+	 * others would only repeat them.
+	 */
+	bool bReportsBluetoothState = true;
+
+	/** e.g. "10.0" or "10.0 #2/4" */
+	FString GetName() const;
+
+	/**
+	 * Reads `haversine.Shards.*` console variables: one shard per hardware version and partition. Never empty; an
+	 * unusable hardware version list falls back to 10.0.
+	 */
+	static TArray<FHaversineSatelliteShardConfig> FromConsoleVariables();
+};
+
+/** Point-in-time counters for `FHaversineSatelliteShard` */
+struct FHaversineSatelliteShardStats
+{
+	/** Events handed from the SDK's threads to the shard thread, and those it has passed on */
+	uint64 Enqueued = 0;
+	uint64 Processed = 0;
+
+	uint64 CollectionsTransferred = 0;
+
+	/** Discoveries of satellites another partition owns, dropped on the SDK's thread */
+	uint64 SatellitesIgnored = 0;
+
+	/** Transfers offered by satellites another partition owns, declined so only the owner transfers them */
+	uint64 TransfersDeclined = 0;
+
+	/** Events waiting for the shard thread now, and the most that have ever waited */
+	int32 Backlog = 0;
+	int32 MaxBacklog = 0;
+
+	/** From an SDK callback to the shard thread passing its event on */
+	double AverageQueueMs = 0.0;
+	double MaxQueueMs = 0.0;
+};
+
+/**
+ * One `HaversineSatelliteManager` and everything that belongs to it: its environment and delegates, its event
+ * subscriptions, and a thread that passes its events on.
+ *
+ * The subsystem runs one shard per SuperTag hardware version, optionally split further into partitions of the fleet
+ * by satellite ID (see `haversine.Shards.*`). Each shard ignores discoveries and state updates of satellites outside
+ * its partition, and declines their collection transfers (`FirstCollectionToTransfer` answers "none"), so every
+ * satellite is reported and every collection transferred by exactly one shard. Every partition's manager may still
+ * connect to every tag of its hardware version; the SuperTag permissions delegate offers no hook to refuse that.
+ *
+ * The shard sits between its delegates and the real `IHaversineFleetListener` (the subsystem). Questions the SDK
+ * needs answered at once (`FirstCollectionToTransfer`) go straight through. Everything else is
+ * pushed onto the shard's own lock-free queue and delivered to the listener from the shard thread, so the SDK's
+ * Bluetooth thread returns at once and never waits on the journal or pipeline behind another shard's transfers. All
+ * shards deliver into the same listener, whose game thread event queue and swing pipeline are the single
+ * aggregated stream. Shards share no state with each other.
+ */
+class FHaversineSatelliteShard : public FRunnable, public IHaversineFleetListener
+{
+public:
+	/**
+	 * Receives discoveries from the SDK on the shard thread, with a copy of the satellite's state taken on the SDK's
+	 * thread when it reported them; the live state is the SDK's to change
+	 */
+	using FSdkDiscoveryFunction = TFunction<void(const FHaversineSatelliteSnapshot&, const std::shared_ptr<const haversine::SatelliteState>&)>;
+
+	FHaversineSatelliteShard(const FHaversineSatelliteShardConfig& InConfig, IHaversineFleetListener* InListener, FSdkDiscoveryFunction&& InOnSdkDiscovery);
+	virtual ~FHaversineSatelliteShard() override;
+
+	/**
+	 * Creates the satellite manager from an environment whose delegates report to this shard, subscribes to its
+	 * events and starts the shard thread
+	 */
+	void Start(haversine::HaversineEnvironment&& Environment);
+
+	/**
+	 * Destroys the satellite manager, delivers whatever it had already reported, and joins the shard thread. No
+	 * listener calls are made after this returns.
+	 */
+	void Stop();
+
+	/** @return false if scanning could not be started; the reason is logged */
+	bool StartScanning();
+	void StopScanning();
+	bool IsScanning() const;
+	haversine::BluetoothState GetBluetoothState() const;
+
+	/** Whether this shard's partition handles the satellite */
+	bool IsOwned(const FString& SatelliteId) const;
+
+	const FHaversineSatelliteShardConfig& GetConfig() const { return Config; }
+	const FString& GetName() const { return Name; }
+
+	FHaversineSatelliteShardStats GetStats() const;
+	void LogStats() const;
+
+	// IHaversineFleetListener interface, called by this shard's delegates and subscriptions on the SDK's threads
+	virtual void OnFleetBluetoothStateChanged(haversine::BluetoothState State) override;
+	virtual void OnFleetSatelliteDiscovered(const FHaversineSatelliteSnapshot& Satellite) override;
+	virtual void OnFleetSatelliteStateUpdated(const FHaversineSatelliteSnapshot& Satellite) override;
+	virtual void OnFleetScanCompleted(bool bSuccess, const FString& Error) override;
+	virtual uint16 FirstCollectionToTransfer(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex) override;
+	virtual void OnCollectionTransfersStarting(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex) override;
+	virtual void OnCollectionTransferred(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection) override;
+	virtual void OnCollectionTransferFailed(const FString& SatelliteId, uint16 CollectionIndex, const FString& Error) override;
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+
+private:
+	enum class EEventType : uint8
+	{
+		BluetoothStateChanged,
+		SdkSatelliteDiscovered,
+		SatelliteDiscovered,
+		SatelliteStateUpdated,
+		ScanCompleted,
+		TransfersStarting,
+		CollectionTransferred,
+		CollectionTransferFailed,
+	};
+
+	/** A listener call on its way from the SDK's thread to the shard thread */
+	struct FShardEvent
+	{
+		EEventType Type = EEventType::CollectionTransferred;
+		haversine::BluetoothState BluetoothState = haversine::BluetoothState::Unknown;
+		FHaversineSatelliteSnapshot Satellite;
+		std::shared_ptr<const haversine::SatelliteState> SdkState;
+
+		/** Transfer events */
+		FString SatelliteId;
+		uint16 StartIndex = 0;
+		uint16 EndIndex = 0;
+		FHaversineCollectionBufferPtr Collection;
+
+		/** ScanCompleted and CollectionTransferFailed */
+		bool bSuccess = true;
+		FString Error;
+
+		uint64 EnqueueCycles = 0;
+	};
+
+	void Enqueue(FShardEvent&& Event);
+
+	/** Follows a discovered satellite's `state_update_events`, once per satellite. SDK thread. */
+	void SubscribeToStateUpdates(const std::shared_ptr<haversine::HaversineSatellite>& Satellite, const FString& SatelliteId);
+
+	/** Passes every queued event on to the listener. Shard thread only. */
+	void Drain();
+	void Deliver(const FShardEvent& Event);
+
+	FHaversineSatelliteShardConfig Config;
+	FString Name;
+	IHaversineFleetListener* Listener;
+	FSdkDiscoveryFunction OnSdkDiscovery;
+
+	std::unique_ptr<haversine::HaversineSatelliteManager> SatelliteManager;
+
+	// Event subscriptions (RAII cleanup)
+	std::unique_ptr<haversine::EventSubscription<haversine::BluetoothState>> BluetoothSubscription;
+	std::unique_ptr<haversine::EventSubscription<std::shared_ptr<haversine::HaversineSatellite>>> DiscoverySubscription;
+	std::unique_ptr<haversine::EventSubscription<haversine::Status>> ScanCompletionSubscription;
+
+	/** Per-satellite state update subscriptions; the satellite is held so its event channel outlives the subscription */
+	struct FStateSubscription
+	{
+		std::shared_ptr<haversine::HaversineSatellite> Satellite;
+		std::unique_ptr<haversine::EventSubscription<haversine::SatelliteState>> Subscription;
+	};
+	FCriticalSection StateSubscriptionsMutex;
+	TMap<FString, FStateSubscription> StateSubscriptions;
+
+	TQueue<FShardEvent, EQueueMode::Mpsc> Events;
+	FEvent* WakeEvent = nullptr;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping{false};
+
+	std::atomic<uint64> Enqueued{0};
+	std::atomic<uint64> Processed{0};
+	std::atomic<uint64> CollectionsTransferred{0};
+	std::atomic<uint64> SatellitesIgnored{0};
+	std::atomic<uint64> TransfersDeclined{0};
+	std::atomic<int32> MaxBacklog{0};
+
+	// Written by the shard thread only
+	std::atomic<uint64> TotalQueueCycles{0};
+	std::atomic<uint64> MaxQueueCycles{0};
+};
@@ -0,0 +1,323 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSatelliteStateCache.cpp
+// UnrealHaversineDemo
+//
+// Persistent per-satellite state, memory-mapped at startup and flushed slot by slot
+//
+
+#include "HaversineSatelliteStateCache.h"
+#include "SuperTagKitPlugin.h"
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Crc.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<float> CVarHaversineCacheFlushIntervalSeconds(
+	TEXT("haversine.Cache.FlushIntervalSeconds"),
+	1.0f,
+	TEXT("How often dirty satellite cache slots are written to disk."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineCacheMaxSatellites(
+	TEXT("haversine.Cache.MaxSatellites"),
+	65536,
+	TEXT("Number of satellites the cache remembers before the least recently seen one is evicted."),
+	ECVF_ReadOnly);
+
+namespace
+{
+	struct FCacheFileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 RecordSize;
+		uint32 Reserved;
+	};
+
+	constexpr uint32 CacheMagic = 0x43534148; // "HASC"
+	constexpr uint32 CacheVersion = 1;
+}
+
+FHaversineSatelliteStateCache::FHaversineSatelliteStateCache(const FString& InFilename)
+	: Filename(InFilename)
+{
+}
+
+FHaversineSatelliteStateCache::~FHaversineSatelliteStateCache()
+{
+	Shutdown();
+}
+
+FString FHaversineSatelliteStateCache::GetDefaultFilename(bool bSimulatedFleet)
+{
+	return bSimulatedFleet
+		? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Haversine"), TEXT("Simulated"), TEXT("SatelliteStateCache.bin"))
+		: FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Haversine"), TEXT("SatelliteStateCache.bin"));
+}
+
+int64 FHaversineSatelliteStateCache::NowUnixMs()
+{
+	return static_cast<int64>((FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalMilliseconds());
+}
+
+uint32 FHaversineSatelliteStateCache::ComputeChecksum(const FRecord& Record)
+{
+	const uint8* Bytes = reinterpret_cast<const uint8*>(&Record);
+	return FCrc::MemCrc32(Bytes + sizeof(Record.Checksum), sizeof(FRecord) - sizeof(Record.Checksum));
+}
+
+void FHaversineSatelliteStateCache::Load()
+{
+	check(IsInGameThread());
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	int32 Discarded = 0;
+	TArray<FRecord> Contents;
+	{
+		FScopeLock Lock(&Mutex);
+		Records.Reset();
+		SlotsById.Reset();
+		FreeSlots.Reset();
+
+		const int64 FileSize = PlatformFile.FileSize(*Filename);
+		if (FileSize >= static_cast<int64>(sizeof(FCacheFileHeader)))
+		{
+			TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Filename));
+			TUniquePtr<IMappedFileRegion> Region(MappedFile ? MappedFile->MapRegion(0, FileSize) : nullptr);
+			if (Region)
+			{
+				const uint8* Data = Region->GetMappedPtr();
+				FCacheFileHeader Header;
+				FMemory::Memcpy(&Header, Data, sizeof(Header));
+
+				if (Header.Magic == CacheMagic && Header.Version == CacheVersion && Header.RecordSize == sizeof(FRecord))
+				{
+					const int64 NumSlots = (FileSize - sizeof(FCacheFileHeader)) / sizeof(FRecord);
+					Records.SetNumUninitialized(NumSlots);
+					FMemory::Memcpy(Records.GetData(), Data + sizeof(FCacheFileHeader), NumSlots * sizeof(FRecord));
+				}
+			}
+		}
+
+		for (int32 Slot = 0; Slot < Records.Num(); ++Slot)
+		{
+			FRecord& Record = Records[Slot];
+			Record.SatelliteId[UE_ARRAY_COUNT(Record.SatelliteId) - 1] = '\0';
+
+			if (Record.bOccupied && Record.Checksum == ComputeChecksum(Record))
+			{
+				SlotsById.Add(UTF8_TO_TCHAR(Record.SatelliteId), Slot);
+			}
+			else
+			{
+				Discarded += Record.bOccupied ? 1 : 0;
+				FMemory::Memzero(Record);
+				FreeSlots.Add(Slot);
+			}
+		}
+
+		DirtySlots.Init(false, Records.Num());
+		bAnyDirty = false;
+		Contents = Records;
+	}
+
+	{
+		// Slots are later written in place, which needs a handle that is neither appending (an append handle ignores
+		// Seek on Unix) nor truncating after this point. Opening without append truncates, so what was just read is
+		// written straight back, with discarded slots cleared.
+		FScopeLock FileLock(&FileMutex);
+		WriteHandle.Reset(PlatformFile.OpenWrite(*Filename, /*bAppend*/ false, /*bAllowRead*/ true));
+		if (WriteHandle)
+		{
+			const FCacheFileHeader Header = { CacheMagic, CacheVersion, sizeof(FRecord), 0 };
+			WriteHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+			WriteHandle->Write(reinterpret_cast<const uint8*>(Contents.GetData()), Contents.Num() * sizeof(FRecord));
+			WriteHandle->Flush();
+		}
+	}
+
+	if (!WriteHandle)
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("Satellite state cache %s is not writable; state will not persist"), *Filename);
+	}
+
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FHaversineSatelliteStateCache::Tick),
+			FMath::Max(0.05f, CVarHaversineCacheFlushIntervalSeconds.GetValueOnGameThread()));
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Satellite state cache loaded %d satellites in %.2f ms (%d corrupt slots discarded) from %s"),
+		Num(), FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles), Discarded, *Filename);
+}
+
+void FHaversineSatelliteStateCache::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	Flush();
+
+	FScopeLock FileLock(&FileMutex);
+	WriteHandle.Reset();
+}
+
+bool FHaversineSatelliteStateCache::Tick(float DeltaTime)
+{
+	Flush();
+	return true;
+}
+
+bool FHaversineSatelliteStateCache::Find(const FString& SatelliteId, FHaversineCachedSatelliteState& OutState) const
+{
+	FScopeLock Lock(&Mutex);
+	const int32* Slot = SlotsById.Find(SatelliteId);
+	if (!Slot)
+	{
+		return false;
+	}
+
+	const FRecord& Record = Records[*Slot];
+	OutState.SatelliteId = SatelliteId;
+	OutState.LastSeenUnixMs = Record.LastSeenUnixMs;
+	OutState.FirmwareVersionMajor = Record.FirmwareVersionMajor;
+	OutState.FirmwareVersionMinor = Record.FirmwareVersionMinor;
+	OutState.CollectionCount = Record.CollectionCount;
+	OutState.bHasTransferred = Record.bHasTransferred != 0;
+	OutState.LastTransferredIndex = Record.LastTransferredIndex;
+	OutState.LastTransferUnixMs = Record.LastTransferUnixMs;
+	return true;
+}
+
+void FHaversineSatelliteStateCache::RecordSeen(const FString& SatelliteId, uint16 FirmwareVersionMajor, uint16 FirmwareVersionMinor, uint16 CollectionCount)
+{
+	FScopeLock Lock(&Mutex);
+	const int32 Slot = FindOrAddSlotLocked(SatelliteId);
+	FRecord& Record = Records[Slot];
+	Record.LastSeenUnixMs = NowUnixMs();
+	Record.FirmwareVersionMajor = FirmwareVersionMajor;
+	Record.FirmwareVersionMinor = FirmwareVersionMinor;
+	Record.CollectionCount = CollectionCount;
+	DirtySlots[Slot] = true;
+	bAnyDirty = true;
+}
+
+void FHaversineSatelliteStateCache::RecordTransferred(const FString& SatelliteId, uint16 CollectionIndex)
+{
+	FScopeLock Lock(&Mutex);
+	const int32 Slot = FindOrAddSlotLocked(SatelliteId);
+	FRecord& Record = Records[Slot];
+	Record.bHasTransferred = 1;
+	Record.LastTransferredIndex = CollectionIndex;
+	Record.LastTransferUnixMs = NowUnixMs();
+	DirtySlots[Slot] = true;
+	bAnyDirty = true;
+}
+
+int32 FHaversineSatelliteStateCache::Num() const
+{
+	FScopeLock Lock(&Mutex);
+	return SlotsById.Num();
+}
+
+int32 FHaversineSatelliteStateCache::FindOrAddSlotLocked(const FString& SatelliteId)
+{
+	if (const int32* Existing = SlotsById.Find(SatelliteId))
+	{
+		return *Existing;
+	}
+
+	int32 Slot = INDEX_NONE;
+	if (!FreeSlots.IsEmpty())
+	{
+		Slot = FreeSlots.Pop(EAllowShrinking::No);
+	}
+	else if (Records.Num() < CVarHaversineCacheMaxSatellites.GetValueOnAnyThread())
+	{
+		Slot = Records.AddZeroed();
+		DirtySlots.Add(false);
+	}
+	else
+	{
+		// Full: reuse the slot of the satellite we have not seen for the longest time
+		Slot = 0;
+		for (int32 Candidate = 1; Candidate < Records.Num(); ++Candidate)
+		{
+			if (Records[Candidate].LastSeenUnixMs < Records[Slot].LastSeenUnixMs)
+			{
+				Slot = Candidate;
+			}
+		}
+		SlotsById.Remove(UTF8_TO_TCHAR(Records[Slot].SatelliteId));
+	}
+
+	FRecord& Record = Records[Slot];
+	FMemory::Memzero(Record);
+	Record.bOccupied = 1;
+
+	FTCHARToUTF8 Utf8Id(*SatelliteId);
+	const int32 IdLength = FMath::Min<int32>(Utf8Id.Length(), UE_ARRAY_COUNT(Record.SatelliteId) - 1);
+	FMemory::Memcpy(Record.SatelliteId, Utf8Id.Get(), IdLength);
+
+	SlotsById.Add(SatelliteId, Slot);
+	return Slot;
+}
+
+void FHaversineSatelliteStateCache::Flush()
+{
+	// Copy dirty slots out under the lock, then write them without blocking updates
+	TArray<int32> DirtyIndexes;
+	TArray<FRecord> DirtyRecords;
+	{
+		FScopeLock Lock(&Mutex);
+		if (!bAnyDirty)
+		{
+			return;
+		}
+
+		for (TConstSetBitIterator<> It(DirtySlots); It; ++It)
+		{
+			FRecord& Record = DirtyRecords.Add_GetRef(Records[It.GetIndex()]);
+			Record.Checksum = ComputeChecksum(Record);
+			DirtyIndexes.Add(It.GetIndex());
+		}
+		DirtySlots.Init(false, Records.Num());
+		bAnyDirty = false;
+	}
+
+	FScopeLock FileLock(&FileMutex);
+	if (!WriteHandle)
+	{
+		return;
+	}
+
+	// Adjacent dirty slots go out in a single write
+	int32 RunStart = 0;
+	while (RunStart < DirtyIndexes.Num())
+	{
+		int32 RunEnd = RunStart + 1;
+		while (RunEnd < DirtyIndexes.Num() && DirtyIndexes[RunEnd] == DirtyIndexes[RunEnd - 1] + 1)
+		{
+			++RunEnd;
+		}
+
+		const int64 Offset = sizeof(FCacheFileHeader) + static_cast<int64>(DirtyIndexes[RunStart]) * sizeof(FRecord);
+		WriteHandle->Seek(Offset);
+		WriteHandle->Write(reinterpret_cast<const uint8*>(&DirtyRecords[RunStart]), (RunEnd - RunStart) * sizeof(FRecord));
+		RunStart = RunEnd;
+	}
+	WriteHandle->Flush();
+}
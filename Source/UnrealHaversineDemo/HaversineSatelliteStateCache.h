@@ -0,0 +1,106 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+class IFileHandle;
+
+/** What we remember about a satellite between app launches */
+struct FHaversineCachedSatelliteState
+{
+	FString SatelliteId;
+
+	/** Last persistent state seen while scanning */
+	int64 LastSeenUnixMs = 0;
+	uint16 FirmwareVersionMajor = 0;
+	uint16 FirmwareVersionMinor = 0;
+	uint16 CollectionCount = 0;
+
+	/** Index of the last collection that was transferred and handed to the pipeline */
+	bool bHasTransferred = false;
+	uint16 LastTransferredIndex = 0;
+	int64 LastTransferUnixMs = 0;
+};
+
+/**
+ * On-disk cache of per-satellite state, keyed by `SatelliteId`.
+ *
+ * The file is an array of fixed-size, checksummed slots, one per satellite. At startup the whole file is memory-mapped
+ * and scanned once, which takes milliseconds even for thousands of tags, and the surviving slots are written back to
+ * a fresh file. Afterwards every update only marks its slot dirty, and a timer writes just the dirty slots back in
+ * place, so the file stays one slot per satellite, the cache is never more than one flush interval behind, and
+ * nothing has to happen at shutdown for it to survive a crash.
+ *
+ * All methods are thread-safe.
+ */
+class FHaversineSatelliteStateCache
+{
+public:
+	explicit FHaversineSatelliteStateCache(const FString& InFilename);
+	~FHaversineSatelliteStateCache();
+
+	/** Default location under the project's Saved directory; a simulated fleet's state is kept apart from real satellites' */
+	static FString GetDefaultFilename(bool bSimulatedFleet = false);
+
+	/** Wall-clock time in the unit the cache stores timestamps in */
+	static int64 NowUnixMs();
+
+	/** Map and read the cache file, then start the incremental flush timer. Must be called on the game thread. */
+	void Load();
+
+	/** Write all dirty slots now and stop the flush timer */
+	void Shutdown();
+
+	/** @return false if nothing is cached for this satellite */
+	bool Find(const FString& SatelliteId, FHaversineCachedSatelliteState& OutState) const;
+
+	/** Record persistent state observed during a scan */
+	void RecordSeen(const FString& SatelliteId, uint16 FirmwareVersionMajor, uint16 FirmwareVersionMinor, uint16 CollectionCount);
+
+	/** Record that a collection was transferred */
+	void RecordTransferred(const FString& SatelliteId, uint16 CollectionIndex);
+
+	/** Write dirty slots to disk */
+	void Flush();
+
+	int32 Num() const;
+
+private:
+	/** On-disk slot. Plain data, written to and read from the file as-is. */
+	struct FRecord
+	{
+		uint32 Checksum;		// CRC32 of every byte after this field
+		uint8 bOccupied;
+		uint8 bHasTransferred;
+		uint16 LastTransferredIndex;
+		int64 LastSeenUnixMs;
+		int64 LastTransferUnixMs;
+		uint16 FirmwareVersionMajor;
+		uint16 FirmwareVersionMinor;
+		uint16 CollectionCount;
+		uint16 Reserved;
+		ANSICHAR SatelliteId[96];	// UTF-8, NUL-padded
+	};
+	static_assert(sizeof(FRecord) == 128, "Cache slots must keep their on-disk size");
+
+	static uint32 ComputeChecksum(const FRecord& Record);
+
+	int32 FindOrAddSlotLocked(const FString& SatelliteId);
+	bool Tick(float DeltaTime);
+
+	FString Filename;
+
+	mutable FCriticalSection Mutex;
+	TArray<FRecord> Records;
+	TMap<FString, int32> SlotsById;
+	TArray<int32> FreeSlots;
+	TBitArray<> DirtySlots;
+	bool bAnyDirty = false;
+
+	// Flushes can come from the timer and from Shutdown; only one may write at a time
+	FCriticalSection FileMutex;
+	TUniquePtr<IFileHandle> WriteHandle;
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,60 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSatelliteStateCacheTest.cpp
+// UnrealHaversineDemo
+//
+// Automation test: flushing a slot again overwrites it rather than growing the cache file
+//
+
+#include "HaversineSatelliteStateCache.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHaversineSatelliteStateCacheFlushInPlaceTest, "Haversine.SatelliteStateCache.FlushInPlace",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FHaversineSatelliteStateCacheFlushInPlaceTest::RunTest(const FString& Parameters)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString Filename = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("Haversine"), TEXT("SatelliteStateCacheTest.bin"));
+	PlatformFile.DeleteFile(*Filename);
+
+	{
+		FHaversineSatelliteStateCache Cache(Filename);
+		Cache.Load();
+
+		Cache.RecordSeen(TEXT("SAT-1"), 10, 0, 3);
+		Cache.Flush();
+		const int64 SizeAfterFirstFlush = PlatformFile.FileSize(*Filename);
+
+		Cache.RecordSeen(TEXT("SAT-1"), 10, 0, 4);
+		Cache.Flush();
+		TestEqual(TEXT("Flushing the same slot twice keeps the file size"), PlatformFile.FileSize(*Filename), SizeAfterFirstFlush);
+
+		Cache.Shutdown();
+	}
+
+	// The rewritten slot, not a stale copy, is what the next launch reads
+	{
+		FHaversineSatelliteStateCache Cache(Filename);
+		Cache.Load();
+
+		FHaversineCachedSatelliteState State;
+		TestEqual(TEXT("One satellite after reload"), Cache.Num(), 1);
+		if (TestTrue(TEXT("Satellite found after reload"), Cache.Find(TEXT("SAT-1"), State)))
+		{
+			TestEqual(TEXT("Latest collection count after reload"), State.CollectionCount, static_cast<uint16>(4));
+		}
+
+		Cache.Shutdown();
+	}
+
+	PlatformFile.DeleteFile(*Filename);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
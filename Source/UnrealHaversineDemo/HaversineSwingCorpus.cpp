@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSwingCorpus.cpp
+// UnrealHaversineDemo
+//
+// Records transferred collections to disk and loads them back for simulation and benchmarks
+//
+
+#include "HaversineSwingCorpus.h"
+#include "SuperTagKitPlugin.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<bool> CVarHaversineCorpusRecord(
+	TEXT("haversine.Corpus.Record"),
+	false,
+	TEXT("Save every transferred collection to the corpus directory."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<FString> CVarHaversineCorpusDirectory(
+	TEXT("haversine.Corpus.Directory"),
+	TEXT(""),
+	TEXT("Directory of recorded collections. Defaults to Saved/Haversine/Corpus."),
+	ECVF_Default);
+
+FString FHaversineSwingCorpus::GetDirectory()
+{
+	const FString Directory = CVarHaversineCorpusDirectory.GetValueOnAnyThread();
+	return Directory.IsEmpty()
+		? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Haversine"), TEXT("Corpus"))
+		: Directory;
+}
+
+bool FHaversineSwingCorpus::IsRecording()
+{
+	return CVarHaversineCorpusRecord.GetValueOnAnyThread();
+}
+
+TArray<FHaversineCollectionBufferRef> FHaversineSwingCorpus::Load(const FString& Directory)
+{
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *FPaths::Combine(Directory, TEXT("*.bin")), /*Files*/ true, /*Directories*/ false);
+	Filenames.Sort();
+
+	TArray<FHaversineCollectionBufferRef> Result;
+	Result.Reserve(Filenames.Num());
+	for (const FString& Filename : Filenames)
+	{
+		TArray<uint8> Bytes;
+		if (FFileHelper::LoadFileToArray(Bytes, *FPaths::Combine(Directory, Filename)) && !Bytes.IsEmpty())
+		{
+			Result.Add(FHaversineCollectionBuffer::Create(std::vector<uint8_t>(Bytes.GetData(), Bytes.GetData() + Bytes.Num())));
+		}
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Loaded %d recorded collections from %s"), Result.Num(), *Directory);
+	return Result;
+}
+
+void FHaversineSwingCorpus::SaveAsync(const FString& Directory, const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection)
+{
+	FString Filename = FPaths::Combine(Directory, FString::Printf(TEXT("%s_%05u.bin"), *FPaths::MakeValidFileName(SatelliteId), CollectionIndex));
+	Async(EAsyncExecution::ThreadPool, [Filename = MoveTemp(Filename), Collection]()
+	{
+		if (!FFileHelper::SaveArrayToFile(Collection->GetView(), *Filename))
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Could not record collection to %s"), *Filename);
+		}
+	});
+}
@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineCollectionBuffer.h"
+
+/**
+ * A directory of recorded collections, one raw `.bin` file per transferred collection.
+ *
+ * Set `haversine.Corpus.Record` to save every collection the real SDK transfers; the simulated fleet plays the
+ * recordings back as its swing payloads.
+ */
+class FHaversineSwingCorpus
+{
+public:
+	/** `haversine.Corpus.Directory`, or Saved/Haversine/Corpus if that is empty */
+	static FString GetDirectory();
+
+	/** Whether transferred collections should be recorded (`haversine.Corpus.Record`) */
+	static bool IsRecording();
+
+	/** Reads every recording in `Directory`. Runs on the calling thread. */
+	static TArray<FHaversineCollectionBufferRef> Load(const FString& Directory);
+
+	/** Writes one collection into `Directory` from a background thread */
+	static void SaveAsync(const FString& Directory, const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection);
+};
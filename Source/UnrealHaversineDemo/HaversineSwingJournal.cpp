@@ -0,0 +1,476 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSwingJournal.cpp
+// UnrealHaversineDemo
+//
+// Crash-safe journal of transferred collections, replayed at startup until their swings are uploaded
+//
+
+#include "HaversineSwingJournal.h"
+#include "SuperTagKitPlugin.h"
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Crc.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<bool> CVarHaversineJournalEnabled(
+	TEXT("haversine.Journal.Enabled"),
+	true,
+	TEXT("Journal transferred collections to disk until they are uploaded (Saved/Haversine/SwingJournal.bin). Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineJournalSyncIntervalMs(
+	TEXT("haversine.Journal.SyncIntervalMs"),
+	50.0f,
+	TEXT("How often journal appends are forced to disk. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineJournalMaxReplays(
+	TEXT("haversine.Journal.MaxReplays"),
+	3,
+	TEXT("Launches that may retry an unfinished collection before it is dropped from the journal. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+namespace
+{
+	struct FJournalFileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 RecordHeaderSize;
+		uint32 Reserved;
+	};
+
+	/** Followed by the UTF-8 satellite ID and the payload, padded to `RecordAlignment` */
+	struct FJournalRecordHeader
+	{
+		uint32 Magic;
+		uint32 Checksum;
+		uint64 Sequence;
+		uint32 PayloadBytes;
+		uint16 CollectionIndex;
+		uint16 SatelliteIdBytes;
+		uint8 Type;
+		uint8 ReplayCount;
+		uint16 Reserved0;
+		uint32 Reserved1;
+	};
+	static_assert(sizeof(FJournalRecordHeader) == 32, "Journal record header layout is part of the file format");
+
+	constexpr uint32 JournalMagic = 0x4A534148; // "HASJ"
+	constexpr uint32 RecordMagic = 0x52534148; // "HASR"
+	constexpr uint32 JournalVersion = 1;
+	constexpr int64 RecordAlignment = 8;
+
+	// How often refused replays are offered to the pipeline again, in seconds
+	constexpr float ReplayRetryIntervalSeconds = 0.1f;
+
+	/** CRC of the header (everything after `Checksum`) followed by the body */
+	uint32 ComputeChecksum(const FJournalRecordHeader& Header, const uint8* SatelliteId, const uint8* Payload)
+	{
+		const uint8* HeaderBytes = reinterpret_cast<const uint8*>(&Header);
+		constexpr int32 Skip = sizeof(Header.Magic) + sizeof(Header.Checksum);
+		uint32 Crc = FCrc::MemCrc32(HeaderBytes + Skip, sizeof(Header) - Skip);
+		Crc = FCrc::MemCrc32(SatelliteId, Header.SatelliteIdBytes, Crc);
+		return FCrc::MemCrc32(Payload, Header.PayloadBytes, Crc);
+	}
+
+	int64 RecordBodySize(const FJournalRecordHeader& Header)
+	{
+		return Align(static_cast<int64>(Header.SatelliteIdBytes) + Header.PayloadBytes, RecordAlignment);
+	}
+}
+
+FHaversineSwingJournalConfig FHaversineSwingJournalConfig::FromConsoleVariables()
+{
+	FHaversineSwingJournalConfig Result;
+	Result.bEnabled = CVarHaversineJournalEnabled.GetValueOnAnyThread();
+	Result.SyncIntervalMs = FMath::Max(1.0f, CVarHaversineJournalSyncIntervalMs.GetValueOnAnyThread());
+	Result.MaxReplays = FMath::Clamp(CVarHaversineJournalMaxReplays.GetValueOnAnyThread(), 0, 255);
+	return Result;
+}
+
+FHaversineSwingJournal::FHaversineSwingJournal(const FString& InFilename, const FHaversineSwingJournalConfig& InConfig)
+	: Filename(InFilename)
+	, Config(InConfig)
+{
+}
+
+FHaversineSwingJournal::~FHaversineSwingJournal()
+{
+	Shutdown();
+}
+
+FString FHaversineSwingJournal::GetDefaultFilename(bool bSimulatedFleet)
+{
+	return bSimulatedFleet
+		? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Haversine"), TEXT("Simulated"), TEXT("SwingJournal.bin"))
+		: FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Haversine"), TEXT("SwingJournal.bin"));
+}
+
+TArray<FHaversineJournalEntry> FHaversineSwingJournal::Open()
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	// The previous journal is set aside and only deleted once its unfinished collections are synced into the new one.
+	// If it is still there, the last recovery was interrupted and the current file may be incomplete.
+	const FString PreviousFilename = Filename + TEXT(".previous");
+	if (PlatformFile.FileExists(*PreviousFilename))
+	{
+		PlatformFile.DeleteFile(*Filename);
+	}
+	else if (PlatformFile.FileExists(*Filename))
+	{
+		PlatformFile.MoveFile(*PreviousFilename, *Filename);
+	}
+
+	int64 TornBytes = 0;
+	TArray<FHaversineJournalEntry> Unfinished;
+	if (PlatformFile.FileExists(*PreviousFilename))
+	{
+		Unfinished = Recover(PreviousFilename, TornBytes);
+	}
+	Recovered = Unfinished.Num();
+
+	{
+		FScopeLock FileLock(&FileMutex);
+		WriteHandle.Reset(PlatformFile.OpenWrite(*Filename, /*bAppend*/ false, /*bAllowRead*/ true));
+		if (WriteHandle)
+		{
+			FJournalFileHeader Header = { JournalMagic, JournalVersion, sizeof(FJournalRecordHeader), 0 };
+			WriteHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+		}
+	}
+
+	if (!WriteHandle)
+	{
+		// Keep the previous journal for the next launch rather than replaying collections we cannot track
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("Swing journal %s is not writable; transferred swings will not survive a crash"), *Filename);
+		return TArray<FHaversineJournalEntry>();
+	}
+
+	TArray<FHaversineJournalEntry> Replayable;
+	Replayable.Reserve(Unfinished.Num());
+	for (FHaversineJournalEntry& Entry : Unfinished)
+	{
+		if (Entry.ReplayCount >= Config.MaxReplays)
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("  ⚠ Collection %d from satellite %s was not uploaded after %d launches, dropped from the journal"),
+				Entry.CollectionIndex, *Entry.SatelliteId, Entry.ReplayCount + 1);
+			++DroppedAfterMaxReplays;
+			continue;
+		}
+
+		Entry.Sequence = NextSequence.fetch_add(1, std::memory_order_relaxed);
+		Entry.ReplayCount += 1;
+		if (WriteRecord(ERecordType::Collection, Entry.Sequence, Entry.ReplayCount, Entry.SatelliteId, Entry.CollectionIndex, Entry.Collection->GetView()))
+		{
+			Replayable.Add(MoveTemp(Entry));
+		}
+	}
+
+	{
+		FScopeLock FileLock(&FileMutex);
+		WriteHandle->Flush(/*bFullFlush*/ true);
+	}
+	PlatformFile.DeleteFile(*PreviousFilename);
+
+	bStopRequested = false;
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("HaversineSwingJournalSync"), 0, TPri_BelowNormal);
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Swing journal recovered %d unfinished collections in %.2f ms (%d dropped, %lld torn bytes discarded) from %s"),
+		Replayable.Num(), FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles), DroppedAfterMaxReplays, TornBytes, *Filename);
+	return Replayable;
+}
+
+TArray<FHaversineJournalEntry> FHaversineSwingJournal::Recover(const FString& SourceFilename, int64& OutTornBytes) const
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const int64 FileSize = PlatformFile.FileSize(*SourceFilename);
+	OutTornBytes = FMath::Max<int64>(0, FileSize);
+	if (FileSize < static_cast<int64>(sizeof(FJournalFileHeader)))
+	{
+		return TArray<FHaversineJournalEntry>();
+	}
+
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*SourceFilename));
+	TUniquePtr<IMappedFileRegion> Region(MappedFile ? MappedFile->MapRegion(0, FileSize) : nullptr);
+	if (!Region)
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("Swing journal %s could not be mapped; its collections are lost"), *SourceFilename);
+		return TArray<FHaversineJournalEntry>();
+	}
+
+	const uint8* Data = Region->GetMappedPtr();
+	FJournalFileHeader FileHeader;
+	FMemory::Memcpy(&FileHeader, Data, sizeof(FileHeader));
+	if (FileHeader.Magic != JournalMagic || FileHeader.Version != JournalVersion || FileHeader.RecordHeaderSize != sizeof(FJournalRecordHeader))
+	{
+		return TArray<FHaversineJournalEntry>();
+	}
+
+	// First pass: find the collections that never got a marker. Only their payloads are copied out.
+	TMap<uint64, int64> UnfinishedOffsets;
+	int64 Offset = sizeof(FJournalFileHeader);
+	while (Offset + static_cast<int64>(sizeof(FJournalRecordHeader)) <= FileSize)
+	{
+		FJournalRecordHeader Header;
+		FMemory::Memcpy(&Header, Data + Offset, sizeof(Header));
+		const int64 RecordEnd = Offset + sizeof(Header) + RecordBodySize(Header);
+		if (Header.Magic != RecordMagic || RecordEnd > FileSize)
+		{
+			break;
+		}
+
+		const uint8* SatelliteId = Data + Offset + sizeof(Header);
+		if (Header.Checksum != ComputeChecksum(Header, SatelliteId, SatelliteId + Header.SatelliteIdBytes))
+		{
+			break;
+		}
+
+		switch (static_cast<ERecordType>(Header.Type))
+		{
+			case ERecordType::Collection:	UnfinishedOffsets.Add(Header.Sequence, Offset); break;
+			case ERecordType::Completed:
+			case ERecordType::Abandoned:	UnfinishedOffsets.Remove(Header.Sequence); break;
+			default: break;
+		}
+		Offset = RecordEnd;
+	}
+	OutTornBytes = FileSize - Offset;
+
+	// Second pass: copy the unfinished collections out before the mapping goes away
+	UnfinishedOffsets.KeySort(TLess<uint64>());
+	TArray<FHaversineJournalEntry> Entries;
+	Entries.Reserve(UnfinishedOffsets.Num());
+	for (const TPair<uint64, int64>& Pair : UnfinishedOffsets)
+	{
+		FJournalRecordHeader Header;
+		FMemory::Memcpy(&Header, Data + Pair.Value, sizeof(Header));
+		const uint8* SatelliteId = Data + Pair.Value + sizeof(Header);
+		const uint8* Payload = SatelliteId + Header.SatelliteIdBytes;
+
+		FHaversineJournalEntry& Entry = Entries.AddDefaulted_GetRef();
+		FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(SatelliteId), Header.SatelliteIdBytes);
+		Entry.SatelliteId = FString(Converted.Length(), Converted.Get());
+		Entry.CollectionIndex = Header.CollectionIndex;
+		Entry.ReplayCount = Header.ReplayCount;
+		Entry.Collection = FHaversineCollectionBuffer::Create(std::vector<uint8_t>(Payload, Payload + Header.PayloadBytes));
+	}
+	return Entries;
+}
+
+void FHaversineSwingJournal::Replay(TArray<FHaversineJournalEntry>&& Entries, TFunction<bool(const FHaversineJournalEntry&)>&& Submit)
+{
+	check(IsInGameThread());
+	if (Entries.IsEmpty())
+	{
+		return;
+	}
+
+	PendingReplay.Append(MoveTemp(Entries));
+	ReplaySubmit = MoveTemp(Submit);
+	if (TickReplay(0.0f) && !ReplayTickerHandle.IsValid())
+	{
+		ReplayTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FHaversineSwingJournal::TickReplay), ReplayRetryIntervalSeconds);
+	}
+}
+
+bool FHaversineSwingJournal::TickReplay(float DeltaTime)
+{
+	int32 Submitted = 0;
+	while (Submitted < PendingReplay.Num() && ReplaySubmit(PendingReplay[Submitted]))
+	{
+		++Submitted;
+	}
+	PendingReplay.RemoveAt(0, Submitted, EAllowShrinking::No);
+	Replayed += Submitted;
+
+	if (!PendingReplay.IsEmpty())
+	{
+		return true;
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Swing journal replayed %d unfinished collections"), Replayed);
+	PendingReplay.Empty();
+	ReplaySubmit.Reset();
+	ReplayTickerHandle.Reset();
+	return false;
+}
+
+void FHaversineSwingJournal::Shutdown()
+{
+	if (ReplayTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ReplayTickerHandle);
+		ReplayTickerHandle.Reset();
+	}
+	PendingReplay.Empty();
+	ReplaySubmit.Reset();
+
+	if (Thread)
+	{
+		bStopRequested = true;
+		WakeEvent->Trigger();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+
+	Sync();
+
+	FScopeLock FileLock(&FileMutex);
+	WriteHandle.Reset();
+}
+
+uint64 FHaversineSwingJournal::Append(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection)
+{
+	const uint64 Sequence = NextSequence.fetch_add(1, std::memory_order_relaxed);
+	return WriteRecord(ERecordType::Collection, Sequence, 0, SatelliteId, CollectionIndex, Collection->GetView()) ? Sequence : 0;
+}
+
+void FHaversineSwingJournal::MarkCompleted(uint64 Sequence)
+{
+	AppendMarker(ERecordType::Completed, Sequence);
+}
+
+void FHaversineSwingJournal::MarkAbandoned(uint64 Sequence)
+{
+	AppendMarker(ERecordType::Abandoned, Sequence);
+}
+
+void FHaversineSwingJournal::AppendMarker(ERecordType Type, uint64 Sequence)
+{
+	// A marker lost to a power cut only means the swing is replayed (and uploaded) once more
+	if (Sequence != 0 && WriteRecord(Type, Sequence, 0, FString(), 0, TConstArrayView<uint8>()))
+	{
+		(Type == ERecordType::Completed ? Completed : Abandoned).fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+bool FHaversineSwingJournal::WriteRecord(ERecordType Type, uint64 Sequence, uint8 ReplayCount, const FString& SatelliteId, uint16 CollectionIndex, TConstArrayView<uint8> Payload)
+{
+	static const uint8 Padding[RecordAlignment] = {};
+
+	// Everything but the write itself happens outside the lock
+	FTCHARToUTF8 SatelliteIdUtf8(*SatelliteId);
+	FJournalRecordHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = RecordMagic;
+	Header.Sequence = Sequence;
+	Header.PayloadBytes = static_cast<uint32>(Payload.Num());
+	Header.CollectionIndex = CollectionIndex;
+	Header.SatelliteIdBytes = static_cast<uint16>(SatelliteIdUtf8.Length());
+	Header.Type = static_cast<uint8>(Type);
+	Header.ReplayCount = ReplayCount;
+
+	const uint8* SatelliteIdBytes = reinterpret_cast<const uint8*>(SatelliteIdUtf8.Get());
+	Header.Checksum = ComputeChecksum(Header, SatelliteIdBytes, Payload.GetData());
+	const int64 UnpaddedBytes = static_cast<int64>(Header.SatelliteIdBytes) + Header.PayloadBytes;
+	const int64 PaddingBytes = RecordBodySize(Header) - UnpaddedBytes;
+
+	{
+		FScopeLock FileLock(&FileMutex);
+		if (!WriteHandle)
+		{
+			return false;
+		}
+
+		const bool bWritten = WriteHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header))
+			&& WriteHandle->Write(SatelliteIdBytes, Header.SatelliteIdBytes)
+			&& WriteHandle->Write(Payload.GetData(), Header.PayloadBytes)
+			&& WriteHandle->Write(Padding, PaddingBytes);
+		if (!bWritten)
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("Swing journal write failed; collection %d from satellite %s is not journaled"),
+				CollectionIndex, *SatelliteId);
+			return false;
+		}
+	}
+
+	if (Type == ERecordType::Collection)
+	{
+		Appended.fetch_add(1, std::memory_order_relaxed);
+	}
+	BytesAppended.fetch_add(sizeof(Header) + UnpaddedBytes + PaddingBytes, std::memory_order_relaxed);
+	UnsyncedRecords.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+uint32 FHaversineSwingJournal::Run()
+{
+	while (!bStopRequested)
+	{
+		WakeEvent->Wait(static_cast<uint32>(Config.SyncIntervalMs));
+		Sync();
+	}
+	return 0;
+}
+
+void FHaversineSwingJournal::Sync()
+{
+	if (UnsyncedRecords.exchange(0, std::memory_order_acquire) == 0)
+	{
+		return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	{
+		FScopeLock FileLock(&FileMutex);
+		if (!WriteHandle)
+		{
+			return;
+		}
+		WriteHandle->Flush(/*bFullFlush*/ true);
+	}
+	const uint64 ElapsedCycles = FPlatformTime::Cycles64() - StartCycles;
+
+	Syncs.fetch_add(1, std::memory_order_relaxed);
+	SyncCycles.fetch_add(ElapsedCycles, std::memory_order_relaxed);
+	uint64 PreviousMax = MaxSyncCycles.load(std::memory_order_relaxed);
+	while (ElapsedCycles > PreviousMax
+		&& !MaxSyncCycles.compare_exchange_weak(PreviousMax, ElapsedCycles, std::memory_order_relaxed))
+	{
+	}
+}
+
+FHaversineSwingJournalStats FHaversineSwingJournal::GetStats() const
+{
+	FHaversineSwingJournalStats Stats;
+	Stats.Appended = Appended.load(std::memory_order_relaxed);
+	Stats.Completed = Completed.load(std::memory_order_relaxed);
+	Stats.Abandoned = Abandoned.load(std::memory_order_relaxed);
+	Stats.BytesAppended = BytesAppended.load(std::memory_order_relaxed);
+	Stats.Outstanding = static_cast<int64>(Stats.Appended) - static_cast<int64>(Stats.Completed + Stats.Abandoned);
+	Stats.Syncs = Syncs.load(std::memory_order_relaxed);
+	Stats.AverageSyncMs = Stats.Syncs > 0 ? FPlatformTime::ToMilliseconds64(SyncCycles.load(std::memory_order_relaxed)) / Stats.Syncs : 0.0;
+	Stats.MaxSyncMs = FPlatformTime::ToMilliseconds64(MaxSyncCycles.load(std::memory_order_relaxed));
+	Stats.Recovered = Recovered;
+	Stats.Replayed = Replayed;
+	Stats.DroppedAfterMaxReplays = DroppedAfterMaxReplays;
+	return Stats;
+}
+
+void FHaversineSwingJournal::LogStats() const
+{
+	const FHaversineSwingJournalStats Stats = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Swing journal stats: appended=%llu completed=%llu abandoned=%llu outstanding=%lld (%.1f KB) | syncs=%llu avg %.2f ms max %.2f ms | recovered=%d replayed=%d dropped=%d"),
+		Stats.Appended, Stats.Completed, Stats.Abandoned, Stats.Outstanding, Stats.BytesAppended / 1024.0,
+		Stats.Syncs, Stats.AverageSyncMs, Stats.MaxSyncMs, Stats.Recovered, Stats.Replayed, Stats.DroppedAfterMaxReplays);
+}
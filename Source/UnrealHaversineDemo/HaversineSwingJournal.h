@@ -0,0 +1,172 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineCollectionBuffer.h"
+#include "Containers/Ticker.h"
+#include "HAL/Runnable.h"
+#include "Templates/UniquePtr.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+
+/** A journaled collection that was never uploaded, recovered at startup */
+struct FHaversineJournalEntry
+{
+	/** Sequence of the entry in the current journal; pass it to the pipeline so the upload can be marked complete */
+	uint64 Sequence = 0;
+	FString SatelliteId;
+	uint16 CollectionIndex = 0;
+	FHaversineCollectionBufferPtr Collection;
+
+	/** How many launches have already tried (and failed) to finish this collection */
+	uint8 ReplayCount = 0;
+};
+
+struct FHaversineSwingJournalConfig
+{
+	bool bEnabled = true;
+
+	/** Appends reach the OS immediately, but are only forced to the disk this often */
+	float SyncIntervalMs = 50.0f;
+
+	/** A collection that has not been uploaded after this many launches is dropped from the journal */
+	int32 MaxReplays = 3;
+
+	/** Reads `haversine.Journal.*` console variables */
+	static FHaversineSwingJournalConfig FromConsoleVariables();
+};
+
+/** Point-in-time counters for `FHaversineSwingJournal` */
+struct FHaversineSwingJournalStats
+{
+	uint64 Appended = 0;
+	uint64 Completed = 0;
+	uint64 Abandoned = 0;
+	uint64 BytesAppended = 0;
+
+	/** Collections appended this launch that are neither completed nor abandoned yet */
+	int64 Outstanding = 0;
+
+	uint64 Syncs = 0;
+	double AverageSyncMs = 0.0;
+	double MaxSyncMs = 0.0;
+
+	/** Unfinished collections found at startup, and how many of those have been handed back to the pipeline */
+	int32 Recovered = 0;
+	int32 Replayed = 0;
+	int32 DroppedAfterMaxReplays = 0;
+};
+
+/**
+ * Append-only, checksummed record of every transferred collection, written before the swing is reconstructed.
+ *
+ * The satellite never offers a collection again once it has been transferred, so a crash between the transfer and
+ * the upload would otherwise lose the swing for good. Each collection is appended with its satellite ID and index
+ * as it arrives, and a completion marker is appended once SkyGolf has accepted the upload. Collections that fail in
+ * a way a retry cannot fix (unparseable hardware ID, failed reconstruction) are marked abandoned instead.
+ *
+ * Appends go straight to the OS under a mutex, so a swing survives a process crash as soon as `Append` returns.
+ * Forcing the data to the disk is batched on a background thread every `SyncIntervalMs`, keeping fsync off the hot
+ * path; a power loss can cost at most that window.
+ *
+ * At startup `Open` maps the journal, validates every record and stops at the first torn or corrupt one. Collections
+ * without a completion marker are copied into a fresh journal (the old one is kept until the copy is synced, so
+ * recovery itself is crash-safe) and returned for `Replay`. The journal therefore only ever holds one launch's worth
+ * of collections.
+ */
+class FHaversineSwingJournal : public FRunnable
+{
+public:
+	FHaversineSwingJournal(const FString& InFilename, const FHaversineSwingJournalConfig& InConfig);
+	virtual ~FHaversineSwingJournal() override;
+
+	FHaversineSwingJournal(const FHaversineSwingJournal&) = delete;
+	FHaversineSwingJournal& operator=(const FHaversineSwingJournal&) = delete;
+
+	/** Saved/Haversine/SwingJournal.bin, or Saved/Haversine/Simulated/SwingJournal.bin for a simulated fleet */
+	static FString GetDefaultFilename(bool bSimulatedFleet = false);
+
+	/**
+	 * Recover the previous launch's journal, start a fresh one and start the sync thread. Any thread (the subsystem
+	 * opens it on its startup task), but once, before the first `Append` and not concurrently with `Shutdown`.
+	 * @return collections that were never uploaded, already re-appended to the fresh journal, in transfer order
+	 */
+	TArray<FHaversineJournalEntry> Open();
+
+	/**
+	 * Hand recovered collections back to the pipeline. Entries `Submit` refuses (queue full) are retried every
+	 * tick until they are all accepted or the journal shuts down. Game thread only.
+	 */
+	void Replay(TArray<FHaversineJournalEntry>&& Entries, TFunction<bool(const FHaversineJournalEntry&)>&& Submit);
+
+	/** Stop replaying, sync and close the journal. Unfinished collections are replayed at the next launch. */
+	void Shutdown();
+
+	/**
+	 * Record a transferred collection. Safe to call from any thread.
+	 * @return the sequence to complete or abandon it with, or 0 if the journal is not open
+	 */
+	uint64 Append(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection);
+
+	/** The collection's swing was uploaded. Safe to call from any thread; 0 is ignored. */
+	void MarkCompleted(uint64 Sequence);
+
+	/** The collection can never become a swing; do not replay it. Safe to call from any thread; 0 is ignored. */
+	void MarkAbandoned(uint64 Sequence);
+
+	FHaversineSwingJournalStats GetStats() const;
+	void LogStats() const;
+
+	// FRunnable interface (sync thread)
+	virtual uint32 Run() override;
+
+private:
+	enum class ERecordType : uint8
+	{
+		Collection = 1,
+		Completed = 2,
+		Abandoned = 3,
+	};
+
+	/** Reads every valid record of `SourceFilename` and returns the collections without a marker */
+	TArray<FHaversineJournalEntry> Recover(const FString& SourceFilename, int64& OutTornBytes) const;
+
+	/** Checksums one record and appends it. @return false if the journal is closed or the write failed. */
+	bool WriteRecord(ERecordType Type, uint64 Sequence, uint8 ReplayCount, const FString& SatelliteId, uint16 CollectionIndex, TConstArrayView<uint8> Payload);
+
+	void AppendMarker(ERecordType Type, uint64 Sequence);
+	void Sync();
+	bool TickReplay(float DeltaTime);
+
+	FString Filename;
+	FHaversineSwingJournalConfig Config;
+
+	mutable FCriticalSection FileMutex;
+	TUniquePtr<IFileHandle> WriteHandle;
+	std::atomic<uint64> NextSequence{1};
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeEvent = nullptr;
+	std::atomic<bool> bStopRequested{false};
+	std::atomic<uint32> UnsyncedRecords{0};
+
+	// Game thread only
+	TArray<FHaversineJournalEntry> PendingReplay;
+	TFunction<bool(const FHaversineJournalEntry&)> ReplaySubmit;
+	FTSTicker::FDelegateHandle ReplayTickerHandle;
+
+	std::atomic<uint64> Appended{0};
+	std::atomic<uint64> Completed{0};
+	std::atomic<uint64> Abandoned{0};
+	std::atomic<uint64> BytesAppended{0};
+	std::atomic<uint64> Syncs{0};
+	std::atomic<uint64> SyncCycles{0};
+	std::atomic<uint64> MaxSyncCycles{0};
+	int32 Recovered = 0;
+	int32 Replayed = 0;
+	int32 DroppedAfterMaxReplays = 0;
+};
@@ -0,0 +1,564 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSwingPipeline.cpp
+// UnrealHaversineDemo
+//
+// Staged worker pipeline that turns transferred collections into published swings
+// without blocking the Haversine SDK callback thread
+//
+
+#include "HaversineSwingPipeline.h"
+#include "HaversineLatencyTracker.h"
+#include "HaversineSatelliteStateCache.h"
+#include "HaversineSwingReconstructor.h"
+#include "SuperTagKitPlugin.h"
+#include "SuperTagAuthenticationManager.h"
+#include "Async/Async.h"
+#include "Engine/Engine.h"
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_CYCLE_STAT(TEXT("Swing reconstruction"), STAT_HaversineSwingReconstruction, STATGROUP_Haversine);
+
+static TAutoConsoleVariable<int32> CVarHaversinePipelineWorkers(
+	TEXT("haversine.Pipeline.Workers"),
+	4,
+	TEXT("Number of worker threads processing transferred swings. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversinePipelineQueueCapacity(
+	TEXT("haversine.Pipeline.QueueCapacity"),
+	256,
+	TEXT("Capacity of each swing pipeline stage queue (rounded up to a power of two). Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+// How long an idle worker sleeps before re-checking the queues, in milliseconds.
+static constexpr uint32 WorkerIdleWaitMs = 10;
+
+FHaversineSwingPipelineConfig FHaversineSwingPipelineConfig::FromConsoleVariables()
+{
+	FHaversineSwingPipelineConfig Result;
+	Result.NumWorkers = FMath::Max(1, CVarHaversinePipelineWorkers.GetValueOnAnyThread());
+	Result.QueueCapacity = FMath::Max(2, CVarHaversinePipelineQueueCapacity.GetValueOnAnyThread());
+	return Result;
+}
+
+class FHaversineSwingPipeline::FWorker : public FRunnable
+{
+public:
+	explicit FWorker(FHaversineSwingPipeline& InPipeline)
+		: Pipeline(InPipeline)
+	{
+	}
+
+	virtual uint32 Run() override
+	{
+		Pipeline.WorkerLoop();
+		return 0;
+	}
+
+private:
+	FHaversineSwingPipeline& Pipeline;
+};
+
+FHaversineSwingPipeline::FHaversineSwingPipeline(
+	USuperTagAuthenticationManager* InAuthManager,
+	TSharedRef<FHaversineAuthTokenCache, ESPMode::ThreadSafe> InTokenCache,
+	TSharedRef<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> InUploadQueue,
+	TSharedPtr<FHaversineSwingJournal, ESPMode::ThreadSafe> InJournal,
+	FHaversineSwingStore* InSwingStore,
+	FHaversineBlueprintEventBatcher* InBlueprintEvents,
+	const FHaversineSwingPipelineConfig& InConfig)
+	: AuthManager(InAuthManager)
+	, TokenCache(MoveTemp(InTokenCache))
+	, UploadQueue(MoveTemp(InUploadQueue))
+	, Journal(MoveTemp(InJournal))
+	, SwingStore(InSwingStore)
+	, BlueprintEvents(InBlueprintEvents)
+	, Config(InConfig)
+{
+	StartCycles = FPlatformTime::Cycles64();
+	WorkAvailable = FPlatformProcess::GetSynchEventFromPool(false);
+
+	for (int32 StageIndex = 0; StageIndex < NumStages; ++StageIndex)
+	{
+		Queues.Add(MakeUnique<THaversineBoundedQueue<FJobPtr>>(Config.QueueCapacity));
+	}
+
+	for (int32 WorkerIndex = 0; WorkerIndex < Config.NumWorkers; ++WorkerIndex)
+	{
+		TUniquePtr<FWorker>& Worker = Workers.Add_GetRef(MakeUnique<FWorker>(*this));
+		FString ThreadName = FString::Printf(TEXT("HaversineSwingWorker%d"), WorkerIndex);
+		Threads.Add(FRunnableThread::Create(Worker.Get(), *ThreadName));
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Swing pipeline started: %d workers, %u slots per stage queue"),
+		Config.NumWorkers, Queues[0]->GetCapacity());
+}
+
+FHaversineSwingPipeline::~FHaversineSwingPipeline()
+{
+	Shutdown();
+}
+
+bool FHaversineSwingPipeline::Submit(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection, uint64 TransferStartCycles, uint64 JournalSequence,
+	const TSharedPtr<FHaversineSwingUploadQueue, ESPMode::ThreadSafe>& UploadQueueOverride)
+{
+	if (!bAcceptingWork.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	FJobPtr Job = MakeUnique<FHaversineSwingJob>();
+	Job->SatelliteId = SatelliteId;
+	Job->CollectionIndex = CollectionIndex;
+	Job->Collection = Collection;
+	Job->EnqueueCycles = FPlatformTime::Cycles64();
+	Job->TransferStartCycles = TransferStartCycles;
+	Job->TransferredCycles = Job->EnqueueCycles;
+	Job->JournalSequence = JournalSequence;
+	Job->UploadQueue = UploadQueueOverride;
+
+	if (!Queues[static_cast<int32>(EHaversineSwingStage::Transfer)]->TryEnqueue(MoveTemp(Job)))
+	{
+		Counters[static_cast<int32>(EHaversineSwingStage::Transfer)].Overflowed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	WorkAvailable->Trigger();
+	return true;
+}
+
+void FHaversineSwingPipeline::Shutdown()
+{
+	if (Threads.IsEmpty())
+	{
+		return;
+	}
+
+	bAcceptingWork.store(false, std::memory_order_release);
+	bStopRequested.store(true, std::memory_order_release);
+
+	// Workers only exit once no swing is parked, i.e. no `Resume` is still running on a token fetch's thread, so the
+	// event can be returned once they are joined
+	for (FRunnableThread* Thread : Threads)
+	{
+		WorkAvailable->Trigger();
+		Thread->WaitForCompletion();
+		delete Thread;
+	}
+	Threads.Reset();
+	Workers.Reset();
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkAvailable);
+	WorkAvailable = nullptr;
+}
+
+void FHaversineSwingPipeline::WorkerLoop()
+{
+	for (;;)
+	{
+		if (TryRunOne())
+		{
+			continue;
+		}
+
+		// Parked swings are checked before the queues: a resume queues its swing before it stops counting as parked
+		if (bStopRequested.load(std::memory_order_acquire) && NumParked.load(std::memory_order_acquire) == 0 && !HasQueuedWork())
+		{
+			// Wake a sibling so it can notice the stop request too
+			WorkAvailable->Trigger();
+			return;
+		}
+
+		WorkAvailable->Wait(WorkerIdleWaitMs);
+	}
+}
+
+bool FHaversineSwingPipeline::TryRunOne()
+{
+	// Resumed swings that found their stage's queue full have waited longest of all
+	if (NumResumeOverflow.load(std::memory_order_acquire) > 0)
+	{
+		TPair<EHaversineSwingStage, FJobPtr> Resumed;
+		{
+			FScopeLock Lock(&ResumeOverflowMutex);
+			if (!ResumeOverflow.IsEmpty())
+			{
+				Resumed = MoveTemp(ResumeOverflow[0]);
+				ResumeOverflow.RemoveAt(0, EAllowShrinking::No);
+				NumResumeOverflow.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+		if (Resumed.Value)
+		{
+			RunStage(Resumed.Key, MoveTemp(Resumed.Value));
+			return true;
+		}
+	}
+
+	// Drain downstream stages first so accepted swings finish before new ones are started
+	for (int32 StageIndex = NumStages - 1; StageIndex >= 0; --StageIndex)
+	{
+		FJobPtr Job;
+		if (Queues[StageIndex]->TryDequeue(Job))
+		{
+			// More work may be waiting; hand the wake-up on to an idle sibling
+			if (HasQueuedWork())
+			{
+				WorkAvailable->Trigger();
+			}
+
+			RunStage(static_cast<EHaversineSwingStage>(StageIndex), MoveTemp(Job));
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FHaversineSwingPipeline::HasQueuedWork() const
+{
+	if (NumResumeOverflow.load(std::memory_order_acquire) > 0)
+	{
+		return true;
+	}
+	for (const TUniquePtr<THaversineBoundedQueue<FJobPtr>>& Queue : Queues)
+	{
+		if (Queue->ApproximateNum() > 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FHaversineSwingPipeline::RunStage(EHaversineSwingStage Stage, FJobPtr Job)
+{
+	FStageCounters& StageCounters = Counters[static_cast<int32>(Stage)];
+
+	const uint64 StartedCycles = FPlatformTime::Cycles64();
+	const uint64 WaitCycles = StartedCycles - Job->EnqueueCycles;
+
+	bool bContinue = false;
+	switch (Stage)
+	{
+		case EHaversineSwingStage::Transfer:		bContinue = RunTransfer(*Job); break;
+		case EHaversineSwingStage::HardwareId:		bContinue = RunHardwareId(*Job); break;
+		case EHaversineSwingStage::TokenLookup:		bContinue = RunTokenLookup(Job); break;
+		case EHaversineSwingStage::Reconstruction:	bContinue = RunReconstruction(*Job); break;
+		case EHaversineSwingStage::Publish:			bContinue = RunPublish(*Job); break;
+		default:									checkNoEntry(); break;
+	}
+
+	// A parked job is counted and timed once, when it is resumed and runs the stage again
+	if (!Job)
+	{
+		StageCounters.Parked.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	const uint64 ServiceCycles = FPlatformTime::Cycles64() - StartedCycles;
+	StageCounters.WaitCycles.fetch_add(WaitCycles, std::memory_order_relaxed);
+	StageCounters.Processed.fetch_add(1, std::memory_order_relaxed);
+	StageCounters.ServiceCycles.fetch_add(ServiceCycles, std::memory_order_relaxed);
+	StageCounters.Latency.Record(FPlatformTime::ToMilliseconds64(WaitCycles + ServiceCycles));
+
+	uint64 PreviousMax = StageCounters.MaxServiceCycles.load(std::memory_order_relaxed);
+	while (ServiceCycles > PreviousMax
+		&& !StageCounters.MaxServiceCycles.compare_exchange_weak(PreviousMax, ServiceCycles, std::memory_order_relaxed))
+	{
+	}
+
+	if (!bContinue)
+	{
+		StageCounters.Discarded.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Advance(Stage, MoveTemp(Job));
+}
+
+void FHaversineSwingPipeline::Advance(EHaversineSwingStage Stage, FJobPtr Job)
+{
+	const int32 NextIndex = static_cast<int32>(Stage) + 1;
+	if (NextIndex >= NumStages)
+	{
+		return;
+	}
+
+	Job->EnqueueCycles = FPlatformTime::Cycles64();
+	if (Queues[NextIndex]->TryEnqueue(MoveTemp(Job)))
+	{
+		WorkAvailable->Trigger();
+		return;
+	}
+
+	// Next stage is saturated: carry the job through it on this worker rather than block or drop it
+	Counters[NextIndex].Overflowed.fetch_add(1, std::memory_order_relaxed);
+	RunStage(static_cast<EHaversineSwingStage>(NextIndex), MoveTemp(Job));
+}
+
+void FHaversineSwingPipeline::Resume(EHaversineSwingStage Stage, FJobPtr Job)
+{
+	// Runs on whichever thread finished the token fetch (a pool thread, or the game thread while the token cache
+	// shuts down), so the stage itself is always left to the workers. A saturated queue overflows into a list they
+	// drain first.
+	const int32 StageIndex = static_cast<int32>(Stage);
+	Job->EnqueueCycles = FPlatformTime::Cycles64();
+	if (!Queues[StageIndex]->TryEnqueue(MoveTemp(Job)))
+	{
+		Counters[StageIndex].Overflowed.fetch_add(1, std::memory_order_relaxed);
+		FScopeLock Lock(&ResumeOverflowMutex);
+		ResumeOverflow.Emplace(Stage, MoveTemp(Job));
+		NumResumeOverflow.fetch_add(1, std::memory_order_release);
+	}
+	WorkAvailable->Trigger();
+
+	// Last touch of the pipeline: once no swing is parked the workers may exit and `Shutdown` free everything
+	NumParked.fetch_sub(1, std::memory_order_release);
+}
+
+//
+// Stage bodies
+//
+
+bool FHaversineSwingPipeline::RunTransfer(FHaversineSwingJob& Job)
+{
+	UE_LOG(LogHaversineSatellite, Log, TEXT("  ✓ Collection %d transferred successfully (%d bytes) from satellite %s"),
+		Job.CollectionIndex, Job.Collection->Num(), *Job.SatelliteId);
+	return true;
+}
+
+bool FHaversineSwingPipeline::RunHardwareId(FHaversineSwingJob& Job)
+{
+	// Parse hardware ID from swing data
+	Job.HardwareId = FSuperTagGolfSwing::ParseHardwareId(Job.Collection->GetBytes());
+	if (Job.HardwareId.IsEmpty())
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ Failed to parse hardware ID from swing data"));
+		if (Journal)
+		{
+			Journal->MarkAbandoned(Job.JournalSequence);
+		}
+		return false;
+	}
+
+	// From now on the token is fetched whenever this satellite is seen, before its next swing arrives
+	TokenCache->AssociateSatellite(Job.SatelliteId, Job.HardwareId);
+	return true;
+}
+
+bool FHaversineSwingPipeline::RunTokenLookup(FJobPtr& Job)
+{
+	// Get authentication token for this hardware
+	if (!AuthManager)
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ AuthManager is null, cannot process swing"));
+		return false;
+	}
+
+	switch (TokenCache->Lookup(Job->HardwareId, Job->AuthToken))
+	{
+		case EHaversineTokenLookup::Found:
+			return true;
+
+		case EHaversineTokenLookup::Pending:
+		{
+			// Park the swing on the fetch; it comes back through this stage whether or not a token arrives
+			const FString HardwareId = Job->HardwareId;
+			NumParked.fetch_add(1, std::memory_order_relaxed);
+			TokenCache->WhenFetched(HardwareId, [this, ParkedJob = MoveTemp(Job)]() mutable
+			{
+				Resume(EHaversineSwingStage::TokenLookup, MoveTemp(ParkedJob));
+			});
+			return false;
+		}
+
+		default:
+			UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ No authentication token for satellite %s, swing discarded"), *Job->HardwareId);
+			return false;
+	}
+}
+
+bool FHaversineSwingPipeline::RunReconstruction(FHaversineSwingJob& Job)
+{
+	// Create and parse swing object
+	// *** This is where we get an actual golf swing with metrics! ***
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(HaversineSwingReconstruction, HaversineChannel);
+	SCOPE_CYCLE_COUNTER(STAT_HaversineSwingReconstruction);
+
+	Job.Swing = FHaversineSwingReconstructor::Reconstruct(AuthManager, Job.Collection.ToSharedRef(), Job.AuthToken);
+	if (!Job.Swing->IsValid())
+	{
+		UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ Swing failed reconstruction from satellite %s"), *Job.HardwareId);
+		if (Journal)
+		{
+			Journal->MarkAbandoned(Job.JournalSequence);
+		}
+		return false;
+	}
+
+	Job.ReconstructedCycles = FPlatformTime::Cycles64();
+	FHaversineLatencyTracker::Get().OnSwingReconstructed(Job.SatelliteId, Job.CollectionIndex, Job.TransferredCycles);
+	return true;
+}
+
+bool FHaversineSwingPipeline::RunPublish(FHaversineSwingJob& Job)
+{
+	const FSuperTagGolfSwing& Swing = *Job.Swing;
+
+	// For now, we just log some example properties of the swing.  See `SuperTagGolfSwing.h` for more information
+	FString ClubName = Swing.GetClub();
+	float Speed = Swing.GetClubheadSpeed();
+	FString Handedness = Swing.IsRightHanded() ? TEXT("Right") : TEXT("Left");
+	UE_LOG(LogHaversineSatellite, Log, TEXT("  ✓ Swing processed: Club=%s, Speed=%.1f MPH, %s"),
+		*ClubName, Speed, *Handedness);
+
+	if (SwingStore)
+	{
+		SwingStore->Add(Job.SatelliteId, ClubName, Speed, Swing.IsRightHanded());
+	}
+
+	// Gameplay code hears about it at the end of the frame, together with any other swings that finished this frame
+	if (BlueprintEvents)
+	{
+		FHaversineSwingEvent Event;
+		Event.SatelliteId = Job.SatelliteId;
+		Event.CollectionIndex = Job.CollectionIndex;
+		Event.UserId = SwingStore ? SwingStore->FindUser(Job.SatelliteId) : 0;
+		Event.Club = ClubName;
+		Event.ClubheadSpeedMph = Speed;
+		Event.bRightHanded = Swing.IsRightHanded();
+		Event.TimestampUnixMs = FHaversineSatelliteStateCache::NowUnixMs();
+		BlueprintEvents->AddSwing(MoveTemp(Event));
+	}
+
+	// Display on-screen message. GEngine is only safe to touch from the game thread.
+	FString Message = FString::Printf(TEXT("Swing: %s @ %.1f MPH (%s)"), *ClubName, Speed, *Handedness);
+	AsyncTask(ENamedThreads::GameThread, [Message = MoveTemp(Message)]()
+	{
+		if (GEngine)
+		{
+			GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Cyan, Message);
+		}
+	});
+
+	// Upload the swing to SkyGolf API
+	// The upload queue coalesces swings into batches and retries failures in order (see `HaversineSwingUploadQueue.h`)
+	FHaversineSwingUploadRef Upload = MakeShared<FHaversineSwingUpload, ESPMode::ThreadSafe>();
+	Upload->SatelliteId = Job.SatelliteId;
+	Upload->CollectionIndex = Job.CollectionIndex;
+	Upload->Collection = Job.Collection;
+	Upload->HardwareId = Job.HardwareId;
+	Upload->AuthToken = Job.AuthToken;
+	Upload->Swing = Job.Swing;
+	Upload->OnComplete = [SatID = Job.SatelliteId, CollectionIndex = Job.CollectionIndex, TransferStartCycles = Job.TransferStartCycles,
+		ReconstructedCycles = Job.ReconstructedCycles, WeakJournal = TWeakPtr<FHaversineSwingJournal, ESPMode::ThreadSafe>(Journal),
+		JournalSequence = Job.JournalSequence](bool bSuccess, const FString& ErrorMessage)
+	{
+		if (bSuccess)
+		{
+			// Uploads can complete after the pipeline is gone, so the journal is only held weakly
+			if (TSharedPtr<FHaversineSwingJournal, ESPMode::ThreadSafe> PinnedJournal = WeakJournal.Pin())
+			{
+				PinnedJournal->MarkCompleted(JournalSequence);
+			}
+			FHaversineLatencyTracker::Get().OnSwingUploaded(SatID, CollectionIndex, TransferStartCycles, ReconstructedCycles);
+			UE_LOG(LogHaversineSatellite, Log, TEXT("  ✓ Successfully uploaded swing to SkyGolf API for satellite %s"), *SatID);
+		}
+		else
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("  ⚠ Failed to upload swing to SkyGolf API: %s"), *ErrorMessage);
+		}
+	};
+	// The spool keeps the swing on disk until it is uploaded, so the journal no longer needs to
+	Upload->OnSpooled = [SatID = Job.SatelliteId, CollectionIndex = Job.CollectionIndex,
+		WeakJournal = TWeakPtr<FHaversineSwingJournal, ESPMode::ThreadSafe>(Journal), JournalSequence = Job.JournalSequence]()
+	{
+		if (TSharedPtr<FHaversineSwingJournal, ESPMode::ThreadSafe> PinnedJournal = WeakJournal.Pin())
+		{
+			PinnedJournal->MarkCompleted(JournalSequence);
+		}
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("  ⚠ SkyGolf API unreachable; swing %d from satellite %s spooled for later upload"), CollectionIndex, *SatID);
+	};
+	(Job.UploadQueue ? Job.UploadQueue.ToSharedRef() : UploadQueue)->Enqueue(Upload);
+	return true;
+}
+
+//
+// Statistics
+//
+
+FHaversineStageStats FHaversineSwingPipeline::GetStageStats(EHaversineSwingStage Stage) const
+{
+	const int32 StageIndex = static_cast<int32>(Stage);
+	const FStageCounters& StageCounters = Counters[StageIndex];
+
+	FHaversineStageStats Stats;
+	Stats.Processed = StageCounters.Processed.load(std::memory_order_relaxed);
+	Stats.Discarded = StageCounters.Discarded.load(std::memory_order_relaxed);
+	Stats.Overflowed = StageCounters.Overflowed.load(std::memory_order_relaxed);
+	Stats.Parked = StageCounters.Parked.load(std::memory_order_relaxed);
+	Stats.Queued = Queues[StageIndex]->ApproximateNum();
+	Stats.MaxServiceMs = FPlatformTime::ToMilliseconds64(StageCounters.MaxServiceCycles.load(std::memory_order_relaxed));
+
+	const double UptimeSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	if (UptimeSeconds > 0.0)
+	{
+		Stats.ThroughputPerSecond = Stats.Processed / UptimeSeconds;
+	}
+
+	if (Stats.Processed > 0)
+	{
+		Stats.AverageWaitMs = FPlatformTime::ToMilliseconds64(StageCounters.WaitCycles.load(std::memory_order_relaxed)) / Stats.Processed;
+		Stats.AverageServiceMs = FPlatformTime::ToMilliseconds64(StageCounters.ServiceCycles.load(std::memory_order_relaxed)) / Stats.Processed;
+	}
+	Stats.Latency = StageCounters.Latency.Summarize();
+	return Stats;
+}
+
+void FHaversineSwingPipeline::ResetLatency()
+{
+	for (FStageCounters& StageCounters : Counters)
+	{
+		StageCounters.Latency.Reset();
+	}
+}
+
+void FHaversineSwingPipeline::LogStats() const
+{
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Swing pipeline stats (%d workers):"), Config.NumWorkers);
+	for (int32 StageIndex = 0; StageIndex < NumStages; ++StageIndex)
+	{
+		const EHaversineSwingStage Stage = static_cast<EHaversineSwingStage>(StageIndex);
+		const FHaversineStageStats Stats = GetStageStats(Stage);
+		UE_LOG(LogHaversineSatellite, Log,
+			TEXT("  • %-14s processed=%llu discarded=%llu overflowed=%llu parked=%llu queued=%u | %.2f/s | wait %.3f ms | service avg %.3f ms max %.3f ms | in stage p50 %.3f p99 %.3f ms"),
+			GetStageName(Stage), Stats.Processed, Stats.Discarded, Stats.Overflowed, Stats.Parked, Stats.Queued,
+			Stats.ThroughputPerSecond, Stats.AverageWaitMs, Stats.AverageServiceMs, Stats.MaxServiceMs, Stats.Latency.P50Ms, Stats.Latency.P99Ms);
+	}
+}
+
+const TCHAR* FHaversineSwingPipeline::GetStageName(EHaversineSwingStage Stage)
+{
+	switch (Stage)
+	{
+		case EHaversineSwingStage::Transfer:
+			return TEXT("Transfer");
+		case EHaversineSwingStage::HardwareId:
+			return TEXT("HardwareId");
+		case EHaversineSwingStage::TokenLookup:
+			return TEXT("TokenLookup");
+		case EHaversineSwingStage::Reconstruction:
+			return TEXT("Reconstruction");
+		case EHaversineSwingStage::Publish:
+			return TEXT("Publish");
+		default:
+			return TEXT("Invalid");
+	}
+}
@@ -0,0 +1,211 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineBoundedQueue.h"
+#include "HaversineCollectionBuffer.h"
+#include "HaversineAuthTokenCache.h"
+#include "HaversineSwingUploadQueue.h"
+#include "HaversineSwingJournal.h"
+#include "HaversineSwingStore.h"
+#include "HaversineBlueprintEventBatcher.h"
+#include "HaversineLatencyTracker.h"
+#include "SuperTagGolfSwing.h"
+#include "Misc/ScopeLock.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+class USuperTagAuthenticationManager;
+
+/**
+ * Stages a transferred collection passes through on its way to becoming a published swing.
+ * Each stage has its own bounded queue; a job waits in a stage's queue until a worker runs that stage on it.
+ */
+enum class EHaversineSwingStage : uint8
+{
+	Transfer,		// Collection handed over by the SDK transfer callback
+	HardwareId,		// Hardware ID parsed from the raw collection
+	TokenLookup,	// SkyGolf authentication token resolved for the hardware ID
+	Reconstruction,	// Physics engine reconstructs the swing
+	Publish,		// Swing is logged, shown on screen and queued for upload
+	Num
+};
+
+/** One collection travelling through the pipeline. Fields are filled in as the stages run. */
+struct FHaversineSwingJob
+{
+	FString SatelliteId;
+	uint16 CollectionIndex = 0;
+	FHaversineCollectionBufferPtr Collection;
+
+	FString HardwareId;
+	FString AuthToken;
+	TSharedPtr<FSuperTagGolfSwing, ESPMode::ThreadSafe> Swing;
+
+	/** FPlatformTime::Cycles64() when the job entered its current stage's queue */
+	uint64 EnqueueCycles = 0;
+
+	/** Latency milestones (see `HaversineLatencyTracker.h`), in FPlatformTime::Cycles64() */
+	uint64 TransferStartCycles = 0;
+	uint64 TransferredCycles = 0;
+	uint64 ReconstructedCycles = 0;
+
+	/** Entry in `FHaversineSwingJournal`, completed once the upload is accepted; 0 if not journaled */
+	uint64 JournalSequence = 0;
+
+	/** Uploads the swing instead of the pipeline's own queue (replayed swings); null for the pipeline's */
+	TSharedPtr<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> UploadQueue;
+};
+
+/** Sizing of the worker pool and the per-stage queues */
+struct FHaversineSwingPipelineConfig
+{
+	int32 NumWorkers = 4;
+	int32 QueueCapacity = 256;
+
+	/** Reads `haversine.Pipeline.*` console variables */
+	static FHaversineSwingPipelineConfig FromConsoleVariables();
+};
+
+/** Point-in-time counters for one stage */
+struct FHaversineStageStats
+{
+	uint64 Processed = 0;
+	uint64 Discarded = 0;
+	uint64 Overflowed = 0;
+
+	/** Jobs set aside until something they wait on (an auth token) is ready; they re-enter the same stage */
+	uint64 Parked = 0;
+	uint32 Queued = 0;
+	double ThroughputPerSecond = 0.0;
+	double AverageWaitMs = 0.0;
+	double AverageServiceMs = 0.0;
+	double MaxServiceMs = 0.0;
+
+	/** Time from entering the stage's queue to leaving the stage (wait plus service), per job */
+	FHaversineLatencySummary Latency;
+};
+
+/**
+ * Processes transferred collections off the SDK callback thread.
+ *
+ * `Submit` only wraps the shared collection buffer in a job and pushes it onto the Transfer queue, so the SDK
+ * callback returns in microseconds. A fixed pool of workers then moves each job through the stages. Workers always
+ * service the most downstream non-empty queue first so finished work leaves the pipeline before new work is
+ * started. If a downstream queue is full, the worker carries the job through that stage itself instead of
+ * blocking, so a burst can never deadlock the pool or drop a swing that has already been accepted.
+ *
+ * Tokens come from a shared `FHaversineAuthTokenCache`. A swing whose token is still being fetched is parked on
+ * the fetch and re-queued for TokenLookup when it completes, rather than discarded. The fetch may complete on any
+ * thread, so a resumed swing is never run there: if TokenLookup's queue is full it waits in an overflow list that the
+ * workers drain before their queues.
+ *
+ * When given a journal, the pipeline marks each journaled swing completed once SkyGolf accepts its upload, or
+ * abandoned if its collection cannot be turned into a swing at all. Anything else stays in the journal for replay.
+ * Published swings are also added to the swing store, if one is given, for queries, and handed to the Blueprint event
+ * batcher, if one is given, for gameplay code.
+ */
+class FHaversineSwingPipeline
+{
+public:
+	FHaversineSwingPipeline(
+		USuperTagAuthenticationManager* InAuthManager,
+		TSharedRef<FHaversineAuthTokenCache, ESPMode::ThreadSafe> InTokenCache,
+		TSharedRef<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> InUploadQueue,
+		TSharedPtr<FHaversineSwingJournal, ESPMode::ThreadSafe> InJournal,
+		FHaversineSwingStore* InSwingStore,
+		FHaversineBlueprintEventBatcher* InBlueprintEvents,
+		const FHaversineSwingPipelineConfig& InConfig);
+	~FHaversineSwingPipeline();
+
+	FHaversineSwingPipeline(const FHaversineSwingPipeline&) = delete;
+	FHaversineSwingPipeline& operator=(const FHaversineSwingPipeline&) = delete;
+
+	/**
+	 * Queue a transferred collection for processing. Safe to call from any thread.
+	 * @param TransferStartCycles when the collection's transfer started, from `FHaversineLatencyTracker`
+	 * @param JournalSequence the collection's entry in the swing journal, or 0 if it was not journaled
+	 * @param UploadQueueOverride where to upload the swing instead of the pipeline's queue, e.g. for replayed swings
+	 * @return false if the pipeline is shutting down or the Transfer queue is full
+	 */
+	bool Submit(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection, uint64 TransferStartCycles = 0, uint64 JournalSequence = 0,
+		const TSharedPtr<FHaversineSwingUploadQueue, ESPMode::ThreadSafe>& UploadQueueOverride = nullptr);
+
+	/**
+	 * Stop accepting work, finish everything already queued and join the workers.
+	 * Parked swings are waited for too; shut the token cache down first to release them without waiting on fetches.
+	 */
+	void Shutdown();
+
+	FHaversineStageStats GetStageStats(EHaversineSwingStage Stage) const;
+
+	/** Forget the per-stage latency distributions, e.g. before a benchmark run; counters keep counting */
+	void ResetLatency();
+
+	/** Log a one-line summary per stage */
+	void LogStats() const;
+
+	static const TCHAR* GetStageName(EHaversineSwingStage Stage);
+
+private:
+	using FJobPtr = TUniquePtr<FHaversineSwingJob>;
+
+	class FWorker;
+
+	struct FStageCounters
+	{
+		std::atomic<uint64> Processed{0};
+		std::atomic<uint64> Discarded{0};
+		std::atomic<uint64> Overflowed{0};
+		std::atomic<uint64> Parked{0};
+		std::atomic<uint64> WaitCycles{0};
+		std::atomic<uint64> ServiceCycles{0};
+		std::atomic<uint64> MaxServiceCycles{0};
+		FHaversineLatencyHistogram Latency;
+	};
+
+	static constexpr int32 NumStages = static_cast<int32>(EHaversineSwingStage::Num);
+
+	void WorkerLoop();
+	bool TryRunOne();
+	bool HasQueuedWork() const;
+	void RunStage(EHaversineSwingStage Stage, FJobPtr Job);
+	void Advance(EHaversineSwingStage Stage, FJobPtr Job);
+	void Resume(EHaversineSwingStage Stage, FJobPtr Job);
+
+	// Stage bodies. Returning false discards the job; a stage that takes the job parks it and must `Resume` it later.
+	bool RunTransfer(FHaversineSwingJob& Job);
+	bool RunHardwareId(FHaversineSwingJob& Job);
+	bool RunTokenLookup(FJobPtr& Job);
+	bool RunReconstruction(FHaversineSwingJob& Job);
+	bool RunPublish(FHaversineSwingJob& Job);
+
+	USuperTagAuthenticationManager* AuthManager;
+	TSharedRef<FHaversineAuthTokenCache, ESPMode::ThreadSafe> TokenCache;
+	TSharedRef<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> UploadQueue;
+	TSharedPtr<FHaversineSwingJournal, ESPMode::ThreadSafe> Journal;
+	FHaversineSwingStore* SwingStore;
+	FHaversineBlueprintEventBatcher* BlueprintEvents;
+	FHaversineSwingPipelineConfig Config;
+
+	TArray<TUniquePtr<THaversineBoundedQueue<FJobPtr>>> Queues;
+	FStageCounters Counters[NumStages];
+
+	TArray<TUniquePtr<FWorker>> Workers;
+	TArray<FRunnableThread*> Threads;
+	FEvent* WorkAvailable = nullptr;
+
+	std::atomic<bool> bAcceptingWork{true};
+	std::atomic<bool> bStopRequested{false};
+
+	// Swings parked on a token fetch, counted until their `Resume` has returned
+	std::atomic<int32> NumParked{0};
+
+	// Resumed swings whose stage queue was full, for the workers to run
+	FCriticalSection ResumeOverflowMutex;
+	TArray<TPair<EHaversineSwingStage, FJobPtr>> ResumeOverflow;
+	std::atomic<int32> NumResumeOverflow{0};
+	uint64 StartCycles = 0;
+};
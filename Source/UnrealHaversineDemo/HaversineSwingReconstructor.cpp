@@ -0,0 +1,149 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSwingReconstructor.cpp
+// UnrealHaversineDemo
+//
+// Single and batched swing reconstruction, and a benchmark comparing the two
+//
+
+#include "HaversineSwingReconstructor.h"
+#include "SuperTagKitPlugin.h"
+#include "SuperTagAuthenticationManager.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
+
+// Forward declaration for GolfSwingKit types
+struct GSAuthTokenCache_s;
+typedef struct GSAuthTokenCache_s GSAuthTokenCache_t;
+
+namespace
+{
+	GSAuthTokenCache_t* GetTokenCacheHandle(USuperTagAuthenticationManager* AuthManager)
+	{
+		return AuthManager ? static_cast<GSAuthTokenCache_t*>(AuthManager->GetAuthTokenCacheHandle()) : nullptr;
+	}
+
+	TSharedRef<FSuperTagGolfSwing, ESPMode::ThreadSafe> MakeSwing(const FHaversineCollectionBuffer& Collection, const FString& AuthToken, GSAuthTokenCache_t* TokenCache)
+	{
+		return MakeShared<FSuperTagGolfSwing, ESPMode::ThreadSafe>(Collection.GetBytes(), AuthToken, TokenCache);
+	}
+}
+
+TSharedRef<FSuperTagGolfSwing, ESPMode::ThreadSafe> FHaversineSwingReconstructor::Reconstruct(USuperTagAuthenticationManager* AuthManager,
+	const FHaversineCollectionBufferRef& Collection, const FString& AuthToken)
+{
+	return MakeSwing(*Collection, AuthToken, GetTokenCacheHandle(AuthManager));
+}
+
+int32 FHaversineSwingReconstructor::ReconstructBatch(USuperTagAuthenticationManager* AuthManager, TArray<FHaversineSwingReconstruction>& Batch)
+{
+	// Index order, counted from each satellite's first entry so a 16-bit index that wrapped still sorts after the ones
+	// before it. Comparing indexes pairwise by wrapped difference is not a consistent order once a batch spans more
+	// than half the index range.
+	TMap<FString, uint16> BaseIndexBySatellite;
+	for (const FHaversineSwingReconstruction& Entry : Batch)
+	{
+		BaseIndexBySatellite.FindOrAdd(Entry.SatelliteId, Entry.CollectionIndex);
+	}
+	Batch.StableSort([&BaseIndexBySatellite](const FHaversineSwingReconstruction& A, const FHaversineSwingReconstruction& B)
+	{
+		if (A.SatelliteId != B.SatelliteId)
+		{
+			return A.SatelliteId < B.SatelliteId;
+		}
+		const uint16 BaseIndex = BaseIndexBySatellite.FindChecked(A.SatelliteId);
+		return static_cast<uint16>(A.CollectionIndex - BaseIndex) < static_cast<uint16>(B.CollectionIndex - BaseIndex);
+	});
+
+	// Shared by every swing in the batch
+	GSAuthTokenCache_t* TokenCache = GetTokenCacheHandle(AuthManager);
+
+	std::atomic<int32> NumValid{0};
+	ParallelFor(Batch.Num(), [&Batch, TokenCache, &NumValid](int32 Index)
+	{
+		FHaversineSwingReconstruction& Entry = Batch[Index];
+		if (!Entry.Collection.IsValid())
+		{
+			return;
+		}
+
+		Entry.Swing = MakeSwing(*Entry.Collection, Entry.AuthToken, TokenCache);
+		NumValid.fetch_add(Entry.Swing->IsValid() ? 1 : 0, std::memory_order_relaxed);
+	});
+	return NumValid.load();
+}
+
+void FHaversineSwingReconstructor::RunBenchmark(USuperTagAuthenticationManager* AuthManager, const TArray<FHaversineCollectionBufferRef>& Corpus, int32 NumSwings, int32 BatchSize)
+{
+	if (Corpus.IsEmpty() || !AuthManager)
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("Reconstruction benchmark needs recorded collections and an authentication manager"));
+		return;
+	}
+
+	NumSwings = FMath::Max(1, NumSwings);
+	BatchSize = FMath::Clamp(BatchSize, 1, NumSwings);
+
+	// Tokens are resolved up front (this may hit the network) so only reconstruction is timed
+	TMap<FString, FString> TokensByHardwareId;
+	TArray<FHaversineSwingReconstruction> Inputs;
+	Inputs.Reserve(NumSwings);
+	for (int32 Index = 0; Index < NumSwings; ++Index)
+	{
+		const FHaversineCollectionBufferRef& Collection = Corpus[Index % Corpus.Num()];
+		const FString HardwareId = FSuperTagGolfSwing::ParseHardwareId(Collection->GetBytes());
+		if (HardwareId.IsEmpty())
+		{
+			continue;
+		}
+
+		FString* Token = TokensByHardwareId.Find(HardwareId);
+		if (!Token)
+		{
+			Token = &TokensByHardwareId.Add(HardwareId, AuthManager->CachedAuthenticationToken(HardwareId));
+		}
+		if (Token->IsEmpty())
+		{
+			continue;
+		}
+
+		FHaversineSwingReconstruction& Input = Inputs.AddDefaulted_GetRef();
+		Input.SatelliteId = TEXT("BENCHMARK");
+		Input.CollectionIndex = static_cast<uint16>(Index);
+		Input.Collection = Collection;
+		Input.AuthToken = *Token;
+	}
+
+	if (Inputs.IsEmpty())
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("Reconstruction benchmark: no recorded collection has a hardware ID with a token"));
+		return;
+	}
+
+	// One at a time, as the pipeline did before batching
+	int32 SingleValid = 0;
+	const uint64 SingleStartCycles = FPlatformTime::Cycles64();
+	for (const FHaversineSwingReconstruction& Input : Inputs)
+	{
+		SingleValid += Reconstruct(AuthManager, Input.Collection.ToSharedRef(), Input.AuthToken)->IsValid() ? 1 : 0;
+	}
+	const double SingleSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - SingleStartCycles);
+
+	// The same collections, `BatchSize` at a time
+	int32 BatchedValid = 0;
+	const uint64 BatchedStartCycles = FPlatformTime::Cycles64();
+	for (int32 First = 0; First < Inputs.Num(); First += BatchSize)
+	{
+		TArray<FHaversineSwingReconstruction> Batch(Inputs.GetData() + First, FMath::Min(BatchSize, Inputs.Num() - First));
+		BatchedValid += ReconstructBatch(AuthManager, Batch);
+	}
+	const double BatchedSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - BatchedStartCycles);
+
+	const double SingleRate = SingleSeconds > 0.0 ? Inputs.Num() / SingleSeconds : 0.0;
+	const double BatchedRate = BatchedSeconds > 0.0 ? Inputs.Num() / BatchedSeconds : 0.0;
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Reconstruction benchmark: %d swings from %d recordings | single %.1f swings/s (%.2f ms each, %d valid) | batches of %d %.1f swings/s (%d valid) | %.2fx on %d cores"),
+		Inputs.Num(), Corpus.Num(), SingleRate, SingleSeconds * 1000.0 / Inputs.Num(), SingleValid,
+		BatchSize, BatchedRate, BatchedValid, SingleRate > 0.0 ? BatchedRate / SingleRate : 0.0, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+}
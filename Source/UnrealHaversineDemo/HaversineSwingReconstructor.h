@@ -0,0 +1,53 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineCollectionBuffer.h"
+#include "SuperTagGolfSwing.h"
+
+class USuperTagAuthenticationManager;
+
+/** One collection to reconstruct, and the swing it became */
+struct FHaversineSwingReconstruction
+{
+	FString SatelliteId;
+	uint16 CollectionIndex = 0;
+	FHaversineCollectionBufferPtr Collection;
+	FString AuthToken;
+
+	/** Filled in by the reconstructor; null or invalid if reconstruction failed */
+	TSharedPtr<FSuperTagGolfSwing, ESPMode::ThreadSafe> Swing;
+
+	bool IsValid() const { return Swing.IsValid() && Swing->IsValid(); }
+};
+
+/**
+ * Turns raw collections into `FSuperTagGolfSwing`s, one at a time or many at once.
+ *
+ * `ReconstructBatch` fetches the shared token cache handle once for the whole batch and spreads the physics across
+ * the task graph's workers with `ParallelFor`. Reconstruction is the only expensive step, and separate swings share
+ * nothing but the (thread-safe) token cache, so it scales with cores. Only `RunBenchmark` uses it today: the swing
+ * pipeline already reconstructs on several workers, one job each, and does not gather jobs into batches.
+ */
+class FHaversineSwingReconstructor
+{
+public:
+	/** Reconstructs one collection on the calling thread. @return the swing, which may be invalid */
+	static TSharedRef<FSuperTagGolfSwing, ESPMode::ThreadSafe> Reconstruct(USuperTagAuthenticationManager* AuthManager,
+		const FHaversineCollectionBufferRef& Collection, const FString& AuthToken);
+
+	/**
+	 * Reconstructs every entry in parallel and blocks until all are done.
+	 * On return the batch is in index order: grouped by satellite, then by collection index counted from that
+	 * satellite's first entry in the batch (allowing for rollover).
+	 * @return how many entries produced a valid swing
+	 */
+	static int32 ReconstructBatch(USuperTagAuthenticationManager* AuthManager, TArray<FHaversineSwingReconstruction>& Batch);
+
+	/**
+	 * Reconstructs `NumSwings` collections from `Corpus` one at a time, then again in batches of `BatchSize`, and logs
+	 * the throughput of each. Tokens are resolved before timing starts. Blocks the calling thread.
+	 */
+	static void RunBenchmark(USuperTagAuthenticationManager* AuthManager, const TArray<FHaversineCollectionBufferRef>& Corpus, int32 NumSwings, int32 BatchSize);
+};
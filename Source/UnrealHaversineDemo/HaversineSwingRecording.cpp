@@ -0,0 +1,340 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSwingRecording.cpp
+// UnrealHaversineDemo
+//
+// Records transferred collections with their timing to one compressed file, and replays it
+//
+
+#include "HaversineSwingRecording.h"
+#include "SuperTagKitPlugin.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<bool> CVarHaversineReplayRecord(
+	TEXT("haversine.Replay.Record"),
+	false,
+	TEXT("Record every transferred collection with its satellite, index and arrival time to Saved/Haversine/Recordings, for haversine.Replay.Start and the ingest benchmark. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+namespace
+{
+	struct FRecordingFileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 RecordHeaderSize;
+		uint32 Reserved;
+	};
+
+	/** Followed by the UTF-8 satellite ID and `StoredBytes` of payload */
+	struct FRecordingRecordHeader
+	{
+		uint32 Magic;
+		uint32 Checksum;
+		int64 OffsetMicroseconds;
+		uint32 RawBytes;
+		uint32 StoredBytes;
+		uint16 CollectionIndex;
+		uint16 SatelliteIdBytes;
+		uint8 bCompressed;
+		uint8 Reserved0;
+		uint16 Reserved1;
+	};
+	static_assert(sizeof(FRecordingRecordHeader) == 32, "Recording record header layout is part of the file format");
+
+	constexpr uint32 RecordingMagic = 0x52564148; // "HAVR"
+	constexpr uint32 RecordMagic = 0x43564148; // "HAVC"
+	constexpr uint32 RecordingVersion = 1;
+
+	/** CRC of the header (everything after `Checksum`) followed by the body */
+	uint32 ComputeChecksum(const FRecordingRecordHeader& Header, const uint8* SatelliteId, const uint8* Payload)
+	{
+		const uint8* HeaderBytes = reinterpret_cast<const uint8*>(&Header);
+		constexpr int32 Skip = sizeof(Header.Magic) + sizeof(Header.Checksum);
+		uint32 Crc = FCrc::MemCrc32(HeaderBytes + Skip, sizeof(Header) - Skip);
+		Crc = FCrc::MemCrc32(SatelliteId, Header.SatelliteIdBytes, Crc);
+		return FCrc::MemCrc32(Payload, Header.StoredBytes, Crc);
+	}
+}
+
+//
+// Recorder
+//
+
+bool FHaversineSwingRecorder::IsEnabled()
+{
+	return CVarHaversineReplayRecord.GetValueOnAnyThread();
+}
+
+FString FHaversineSwingRecorder::GetDefaultFilename()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Haversine"), TEXT("Recordings"), FString::Printf(TEXT("Swings-%s.hvrec"), *FDateTime::Now().ToString()));
+}
+
+FHaversineSwingRecorder::FHaversineSwingRecorder(const FString& InFilename)
+	: Filename(InFilename)
+{
+}
+
+FHaversineSwingRecorder::~FHaversineSwingRecorder()
+{
+	Close();
+}
+
+bool FHaversineSwingRecorder::Open()
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	FScopeLock FileLock(&FileMutex);
+	WriteHandle.Reset(PlatformFile.OpenWrite(*Filename, /*bAppend*/ false, /*bAllowRead*/ true));
+	if (!WriteHandle)
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Could not create swing recording %s"), *Filename);
+		return false;
+	}
+
+	const FRecordingFileHeader Header = { RecordingMagic, RecordingVersion, sizeof(FRecordingRecordHeader), 0 };
+	WriteHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	FileBytes.store(sizeof(Header), std::memory_order_relaxed);
+	StartSeconds = FPlatformTime::Seconds();
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("✓ Recording transferred collections to %s"), *Filename);
+	return true;
+}
+
+void FHaversineSwingRecorder::Record(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection)
+{
+	// Arrival time is taken before anything else, so compression does not skew the recorded pacing
+	const double NowSeconds = FPlatformTime::Seconds();
+
+	// Compression happens outside the lock; a collection is a few KB, which Oodle handles in microseconds
+	const TConstArrayView<uint8> Raw = Collection->GetView();
+	TArray<uint8> Compressed;
+	int64 CompressedBytes = FCompression::CompressMemoryBound(NAME_Oodle, Raw.Num());
+	Compressed.SetNumUninitialized(CompressedBytes);
+	const bool bCompressed = FCompression::CompressMemory(NAME_Oodle, Compressed.GetData(), CompressedBytes, Raw.GetData(), Raw.Num(), COMPRESS_BiasSpeed)
+		&& CompressedBytes < Raw.Num();
+	const TConstArrayView<uint8> Stored = bCompressed ? TConstArrayView<uint8>(Compressed.GetData(), CompressedBytes) : Raw;
+
+	FTCHARToUTF8 SatelliteIdUtf8(*SatelliteId);
+	const uint8* SatelliteIdBytes = reinterpret_cast<const uint8*>(SatelliteIdUtf8.Get());
+
+	FRecordingRecordHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = RecordMagic;
+	Header.RawBytes = static_cast<uint32>(Raw.Num());
+	Header.StoredBytes = static_cast<uint32>(Stored.Num());
+	Header.CollectionIndex = CollectionIndex;
+	Header.SatelliteIdBytes = static_cast<uint16>(SatelliteIdUtf8.Length());
+	Header.bCompressed = bCompressed ? 1 : 0;
+
+	FScopeLock FileLock(&FileMutex);
+	if (!WriteHandle)
+	{
+		return;
+	}
+
+	// The offset is stamped under the lock so records are in arrival order and their offsets never go backwards
+	Header.OffsetMicroseconds = static_cast<int64>((NowSeconds - StartSeconds) * 1000000.0);
+	Header.Checksum = ComputeChecksum(Header, SatelliteIdBytes, Stored.GetData());
+
+	const bool bWritten = WriteHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header))
+		&& WriteHandle->Write(SatelliteIdBytes, Header.SatelliteIdBytes)
+		&& WriteHandle->Write(Stored.GetData(), Header.StoredBytes);
+	if (!bWritten)
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Swing recording write failed; recording stopped at %llu collections"), Recorded.load());
+		WriteHandle.Reset();
+		return;
+	}
+
+	Recorded.fetch_add(1, std::memory_order_relaxed);
+	RawBytes.fetch_add(Raw.Num(), std::memory_order_relaxed);
+	FileBytes.fetch_add(sizeof(Header) + Header.SatelliteIdBytes + Header.StoredBytes, std::memory_order_relaxed);
+}
+
+void FHaversineSwingRecorder::Close()
+{
+	FScopeLock FileLock(&FileMutex);
+	if (WriteHandle)
+	{
+		WriteHandle->Flush(/*bFullFlush*/ true);
+		WriteHandle.Reset();
+	}
+}
+
+void FHaversineSwingRecorder::LogStats() const
+{
+	const uint64 Raw = RawBytes.load(std::memory_order_relaxed);
+	const uint64 File = FileBytes.load(std::memory_order_relaxed);
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Swing recording: %llu collections, %.1f KB of payload in a %.1f KB file (%.0f%%) | %s"),
+		Recorded.load(std::memory_order_relaxed), Raw / 1024.0, File / 1024.0, Raw > 0 ? 100.0 * File / Raw : 0.0, *Filename);
+}
+
+bool FHaversineSwingRecorder::Load(const FString& Filename, TArray<FHaversineRecordedCollection>& OutCollections)
+{
+	TArray64<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Could not read swing recording %s"), *Filename);
+		return false;
+	}
+
+	FRecordingFileHeader FileHeader;
+	if (Bytes.Num() < static_cast<int64>(sizeof(FileHeader)))
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ %s is not a swing recording"), *Filename);
+		return false;
+	}
+	FMemory::Memcpy(&FileHeader, Bytes.GetData(), sizeof(FileHeader));
+	if (FileHeader.Magic != RecordingMagic || FileHeader.Version != RecordingVersion || FileHeader.RecordHeaderSize != sizeof(FRecordingRecordHeader))
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ %s is not a swing recording (or is from another version)"), *Filename);
+		return false;
+	}
+
+	OutCollections.Reset();
+	int64 Offset = sizeof(FileHeader);
+	int64 TornBytes = 0;
+	while (Offset < Bytes.Num())
+	{
+		FRecordingRecordHeader Header;
+		if (Offset + static_cast<int64>(sizeof(Header)) > Bytes.Num())
+		{
+			TornBytes = Bytes.Num() - Offset;
+			break;
+		}
+		FMemory::Memcpy(&Header, Bytes.GetData() + Offset, sizeof(Header));
+
+		const int64 BodyOffset = Offset + sizeof(Header);
+		const uint8* SatelliteIdBytes = Bytes.GetData() + BodyOffset;
+		const uint8* Stored = SatelliteIdBytes + Header.SatelliteIdBytes;
+		if (Header.Magic != RecordMagic
+			|| BodyOffset + Header.SatelliteIdBytes + Header.StoredBytes > Bytes.Num()
+			|| Header.Checksum != ComputeChecksum(Header, SatelliteIdBytes, Stored))
+		{
+			TornBytes = Bytes.Num() - Offset;
+			break;
+		}
+
+		std::vector<uint8_t> Payload(Header.RawBytes);
+		bool bDecoded = false;
+		if (Header.bCompressed)
+		{
+			bDecoded = FCompression::UncompressMemory(NAME_Oodle, Payload.data(), Header.RawBytes, Stored, Header.StoredBytes);
+		}
+		else if (Header.RawBytes == Header.StoredBytes)
+		{
+			FMemory::Memcpy(Payload.data(), Stored, Header.RawBytes);
+			bDecoded = true;
+		}
+		if (!bDecoded)
+		{
+			TornBytes = Bytes.Num() - Offset;
+			break;
+		}
+
+		FHaversineRecordedCollection& Entry = OutCollections.AddDefaulted_GetRef();
+		Entry.SatelliteId = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(SatelliteIdBytes), Header.SatelliteIdBytes));
+		Entry.CollectionIndex = Header.CollectionIndex;
+		Entry.OffsetSeconds = Header.OffsetMicroseconds / 1000000.0;
+		Entry.Collection = FHaversineCollectionBuffer::Create(MoveTemp(Payload));
+
+		Offset = BodyOffset + Header.SatelliteIdBytes + Header.StoredBytes;
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Loaded %d recorded collections spanning %.1f s from %s%s"),
+		OutCollections.Num(), OutCollections.IsEmpty() ? 0.0 : OutCollections.Last().OffsetSeconds, *Filename,
+		TornBytes > 0 ? *FString::Printf(TEXT(" (%lld torn bytes at the end ignored)"), TornBytes) : TEXT(""));
+	return true;
+}
+
+//
+// Replay
+//
+
+FHaversineSwingReplay::FHaversineSwingReplay(TArray<FHaversineRecordedCollection>&& InCollections, double InSpeed, FSubmitFunction&& InSubmit)
+	: Collections(MoveTemp(InCollections))
+	, Speed(FMath::Max(0.0, InSpeed))
+	, Submit(MoveTemp(InSubmit))
+{
+}
+
+FHaversineSwingReplay::~FHaversineSwingReplay()
+{
+	Stop();
+}
+
+void FHaversineSwingReplay::Start()
+{
+	if (Thread)
+	{
+		return;
+	}
+
+	bStopRequested = false;
+	bFinished = false;
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("HaversineSwingReplay"));
+	UE_LOG(LogHaversineSatellite, Log, TEXT("→ Replaying %d collections at %s"), Collections.Num(),
+		Speed > 0.0 ? *FString::Printf(TEXT("%gx recorded speed"), Speed) : TEXT("maximum speed"));
+}
+
+void FHaversineSwingReplay::Stop()
+{
+	if (!Thread)
+	{
+		return;
+	}
+
+	bStopRequested = true;
+	WakeEvent->Trigger();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+	bFinished = true;
+}
+
+uint32 FHaversineSwingReplay::Run()
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+	const double FirstOffsetSeconds = Collections.IsEmpty() ? 0.0 : Collections[0].OffsetSeconds;
+
+	for (const FHaversineRecordedCollection& Entry : Collections)
+	{
+		// Pace to the recording, starting from its first collection rather than from when recording began
+		if (Speed > 0.0)
+		{
+			const double DueSeconds = StartSeconds + (Entry.OffsetSeconds - FirstOffsetSeconds) / Speed;
+			for (double Remaining = DueSeconds - FPlatformTime::Seconds(); Remaining > 0.0 && !bStopRequested; Remaining = DueSeconds - FPlatformTime::Seconds())
+			{
+				WakeEvent->Wait(FMath::Max(1u, static_cast<uint32>(Remaining * 1000.0)));
+			}
+		}
+
+		if (bStopRequested || !Submit(Entry))
+		{
+			break;
+		}
+		NumSubmitted.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Replay submitted %d of %d collections in %.2f s"),
+		NumSubmitted.load(), Collections.Num(), FPlatformTime::Seconds() - StartSeconds);
+	bFinished = true;
+	return 0;
+}
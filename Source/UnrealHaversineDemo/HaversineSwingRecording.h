@@ -0,0 +1,121 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HaversineCollectionBuffer.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+
+/** One `collection_transfer_did_finish`, as recorded */
+struct FHaversineRecordedCollection
+{
+	FString SatelliteId;
+	uint16 CollectionIndex = 0;
+
+	/** When the transfer finished, in seconds since the recording started */
+	double OffsetSeconds = 0.0;
+
+	FHaversineCollectionBufferPtr Collection;
+};
+
+/**
+ * Records real swing traffic to a single compact file for replay: every transferred collection with its satellite,
+ * index and arrival time. Payloads are Oodle-compressed when that makes them smaller.
+ *
+ * Enabled with `haversine.Replay.Record`; the file is Saved/Haversine/Recordings/Swings-<timestamp>.hvrec. Unlike the
+ * corpus directory (`HaversineSwingCorpus.h`), which keeps bare payloads for the simulated fleet to draw from, a
+ * recording keeps the order and timing of the traffic so `FHaversineSwingReplay` can reproduce it.
+ *
+ * `Record` is safe to call from any thread; like the swing journal it writes straight to the OS under a mutex.
+ */
+class FHaversineSwingRecorder
+{
+public:
+	/** Whether the subsystem should record (`haversine.Replay.Record`) */
+	static bool IsEnabled();
+
+	/** Saved/Haversine/Recordings/Swings-<timestamp>.hvrec */
+	static FString GetDefaultFilename();
+
+	/**
+	 * Reads a whole recording, stopping at the first torn or corrupt record (the tail of a crashed session).
+	 * @return false if the file cannot be read or is not a recording
+	 */
+	static bool Load(const FString& Filename, TArray<FHaversineRecordedCollection>& OutCollections);
+
+	explicit FHaversineSwingRecorder(const FString& InFilename);
+	~FHaversineSwingRecorder();
+
+	/** Create the file. @return false if it cannot be written. */
+	bool Open();
+
+	void Record(const FString& SatelliteId, uint16 CollectionIndex, const FHaversineCollectionBufferRef& Collection);
+
+	/** Flush and close the file; later `Record` calls are ignored */
+	void Close();
+
+	const FString& GetFilename() const { return Filename; }
+	void LogStats() const;
+
+private:
+	FString Filename;
+
+	mutable FCriticalSection FileMutex;
+	TUniquePtr<IFileHandle> WriteHandle;
+	double StartSeconds = 0.0;
+
+	std::atomic<uint64> Recorded{0};
+	std::atomic<uint64> RawBytes{0};
+	std::atomic<uint64> FileBytes{0};
+};
+
+/**
+ * Plays a recording back into the swing path on its own thread, the way the SDK's Bluetooth thread delivers
+ * transfers, so benchmarks see real payloads with real arrival patterns.
+ *
+ * At speed 1 collections arrive at their recorded times, at speed N N times faster, and at speed 0 as fast as
+ * `Submit` accepts them. `Submit` may block to apply back-pressure, but should give up once `IsStopRequested`;
+ * returning false stops the replay.
+ */
+class FHaversineSwingReplay : public FRunnable
+{
+public:
+	using FSubmitFunction = TFunction<bool(const FHaversineRecordedCollection&)>;
+
+	FHaversineSwingReplay(TArray<FHaversineRecordedCollection>&& InCollections, double InSpeed, FSubmitFunction&& InSubmit);
+	virtual ~FHaversineSwingReplay() override;
+
+	/** Start delivering on the replay thread */
+	void Start();
+
+	/** Stop delivering and join the replay thread. No `Submit` calls are made after this returns. */
+	void Stop();
+
+	/** Every collection has been submitted, or the replay was stopped */
+	bool IsFinished() const { return bFinished.load(); }
+
+	bool IsStopRequested() const { return bStopRequested.load(); }
+
+	int32 GetNumCollections() const { return Collections.Num(); }
+	int32 GetNumSubmitted() const { return NumSubmitted.load(std::memory_order_relaxed); }
+	double GetSpeed() const { return Speed; }
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+
+private:
+	TArray<FHaversineRecordedCollection> Collections;
+	double Speed;
+	FSubmitFunction Submit;
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeEvent = nullptr;
+	std::atomic<bool> bStopRequested{false};
+	std::atomic<bool> bFinished{false};
+	std::atomic<int32> NumSubmitted{0};
+};
@@ -0,0 +1,460 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSwingStore.cpp
+// UnrealHaversineDemo
+//
+// Columnar store of published swings with filtered and grouped speed aggregates
+//
+
+#include "HaversineSwingStore.h"
+#include "HaversineSatelliteStateCache.h"
+#include "SuperTagKitPlugin.h"
+#include "HAL/IConsoleManager.h"
+#include <type_traits>
+
+static TAutoConsoleVariable<int32> CVarHaversineSwingsMaxRows(
+	TEXT("haversine.Swings.MaxRows"),
+	4 * 1024 * 1024,
+	TEXT("Swings kept in memory for queries (about 23 bytes each); the oldest are dropped 65536 at a time. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+namespace
+{
+	// Filters are inclusive ranges of codes; one unsigned compare tests both ends
+	template <typename T>
+	FORCEINLINE bool InRange(T Value, T Lo, T Hi)
+	{
+		using U = std::make_unsigned_t<T>;
+		return static_cast<U>(Value - Lo) <= static_cast<U>(Hi - Lo);
+	}
+
+	// Independent partial sums per lane let the ungrouped scan vectorize without reassociating float adds
+	constexpr int32 ScanLanes = 8;
+}
+
+//
+// Query
+//
+
+FHaversineSwingQuery FHaversineSwingQuery::LastMinutes(double Minutes)
+{
+	FHaversineSwingQuery Query;
+	Query.FromUnixMs = FHaversineSatelliteStateCache::NowUnixMs() - static_cast<int64>(Minutes * 60.0 * 1000.0);
+	return Query;
+}
+
+bool FHaversineSwingQuery::FromConsoleArgs(const TArray<FString>& Args, FHaversineSwingQuery& OutQuery)
+{
+	OutQuery = FHaversineSwingQuery();
+	for (const FString& Arg : Args)
+	{
+		FString Key;
+		FString Value;
+		if (!Arg.Split(TEXT("="), &Key, &Value) || Value.IsEmpty())
+		{
+			return false;
+		}
+
+		if (Key == TEXT("user"))
+		{
+			OutQuery.UserId = static_cast<uint32>(FCString::Strtoui64(*Value, nullptr, 10));
+		}
+		else if (Key == TEXT("club"))
+		{
+			OutQuery.Club = Value;
+		}
+		else if (Key == TEXT("hand"))
+		{
+			OutQuery.bRightHanded = Value.StartsWith(TEXT("R"));
+		}
+		else if (Key == TEXT("satellite"))
+		{
+			OutQuery.SatelliteId = Value;
+		}
+		else if (Key == TEXT("minutes"))
+		{
+			OutQuery.FromUnixMs = LastMinutes(FCString::Atod(*Value)).FromUnixMs;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+FString FHaversineSwingQuery::ToString() const
+{
+	TArray<FString> Parts;
+	if (UserId.IsSet())
+	{
+		Parts.Add(FString::Printf(TEXT("user=%u"), UserId.GetValue()));
+	}
+	if (Club.IsSet())
+	{
+		Parts.Add(FString::Printf(TEXT("club=%s"), *Club.GetValue()));
+	}
+	if (bRightHanded.IsSet())
+	{
+		Parts.Add(bRightHanded.GetValue() ? TEXT("hand=R") : TEXT("hand=L"));
+	}
+	if (SatelliteId.IsSet())
+	{
+		Parts.Add(FString::Printf(TEXT("satellite=%s"), *SatelliteId.GetValue()));
+	}
+	if (FromUnixMs != MIN_int64)
+	{
+		Parts.Add(FString::Printf(TEXT("last %.1f min"), (FHaversineSatelliteStateCache::NowUnixMs() - FromUnixMs) / 60000.0));
+	}
+	return Parts.IsEmpty() ? TEXT("all swings") : FString::Join(Parts, TEXT(" "));
+}
+
+//
+// Store
+//
+
+FHaversineSwingAggregate FHaversineSwingStore::FAccumulator::ToAggregate() const
+{
+	FHaversineSwingAggregate Aggregate;
+	Aggregate.Count = Count;
+	if (Count > 0)
+	{
+		Aggregate.AverageSpeed = Sum / Count;
+		Aggregate.MinSpeed = Min;
+		Aggregate.MaxSpeed = Max;
+	}
+	return Aggregate;
+}
+
+FHaversineSwingStore::FHaversineSwingStore()
+	: MaxRows(FMath::Max<int64>(RowsPerBlock, CVarHaversineSwingsMaxRows.GetValueOnAnyThread()))
+{
+	// Code 0 of every dictionary stands for "unknown"
+	Clubs.Add(FString());
+	Users.Add(0);
+	Satellites.Add(FString());
+}
+
+template <typename ValueType>
+uint32 FHaversineSwingStore::Encode(TMap<ValueType, uint32>& Codes, TArray<ValueType>& Values, const ValueType& Value)
+{
+	if (const uint32* Code = Codes.Find(Value))
+	{
+		return *Code;
+	}
+
+	const uint32 Code = Values.Add(Value);
+	Codes.Add(Value, Code);
+	return Code;
+}
+
+void FHaversineSwingStore::AssociateUser(const FString& SatelliteId, uint32 UserId)
+{
+	FWriteScopeLock WriteLock(Lock);
+	const uint32 SatelliteCode = Encode(SatelliteCodes, Satellites, SatelliteId);
+	if (UserBySatellite.Num() <= static_cast<int32>(SatelliteCode))
+	{
+		UserBySatellite.SetNumZeroed(SatelliteCode + 1);
+	}
+	UserBySatellite[SatelliteCode] = Encode(UserCodes, Users, UserId);
+}
+
+uint32 FHaversineSwingStore::FindUser(const FString& SatelliteId) const
+{
+	FReadScopeLock ReadLock(Lock);
+	const uint32* SatelliteCode = SatelliteCodes.Find(SatelliteId);
+	const uint32 UserCode = SatelliteCode && UserBySatellite.IsValidIndex(*SatelliteCode) ? UserBySatellite[*SatelliteCode] : 0;
+	return UserCode != 0 ? Users[UserCode] : 0;
+}
+
+void FHaversineSwingStore::Add(const FString& SatelliteId, const FString& Club, float ClubheadSpeed, bool bRightHanded, int64 TimestampUnixMs)
+{
+	const int64 Timestamp = TimestampUnixMs != 0 ? TimestampUnixMs : FHaversineSatelliteStateCache::NowUnixMs();
+
+	FWriteScopeLock WriteLock(Lock);
+
+	// More than 65535 distinct club names is not a real fleet; fold the excess into "unknown" rather than wrap
+	const uint32 ClubCode = Club.IsEmpty() ? 0 : Encode(ClubCodes, Clubs, Club);
+	const uint32 SatelliteCode = Encode(SatelliteCodes, Satellites, SatelliteId);
+
+	if (Blocks.IsEmpty() || Blocks.Last()->Num == RowsPerBlock)
+	{
+		Blocks.Add(MakeShared<FBlock, ESPMode::ThreadSafe>());
+	}
+
+	FBlock& Block = *Blocks.Last();
+	const int32 Row = Block.Num;
+	Block.Speed[Row] = ClubheadSpeed;
+	Block.TimestampUnixMs[Row] = Timestamp;
+	Block.User[Row] = UserBySatellite.IsValidIndex(SatelliteCode) ? UserBySatellite[SatelliteCode] : 0;
+	Block.Satellite[Row] = SatelliteCode;
+	Block.Club[Row] = ClubCode <= MAX_uint16 ? static_cast<uint16>(ClubCode) : 0;
+	Block.RightHanded[Row] = bRightHanded ? 1 : 0;
+	Block.MinTimestampUnixMs = FMath::Min(Block.MinTimestampUnixMs, Timestamp);
+	Block.MaxTimestampUnixMs = FMath::Max(Block.MaxTimestampUnixMs, Timestamp);
+	Block.Num = Row + 1;
+	++Rows;
+	Added.fetch_add(1, std::memory_order_relaxed);
+
+	// Queries in flight keep their snapshot of the block alive
+	if (Rows > MaxRows && Blocks.Num() > 1)
+	{
+		Rows -= Blocks[0]->Num;
+		Evicted.fetch_add(Blocks[0]->Num, std::memory_order_relaxed);
+		Blocks.RemoveAt(0);
+	}
+}
+
+void FHaversineSwingStore::Reset()
+{
+	FWriteScopeLock WriteLock(Lock);
+	Blocks.Reset();
+	Rows = 0;
+}
+
+bool FHaversineSwingStore::Prepare(const FHaversineSwingQuery& Query, FColumnRanges& OutRanges, TArray<FBlockView>& OutBlocks, int32& OutNumClubs, int32& OutNumUsers) const
+{
+	FReadScopeLock ReadLock(Lock);
+
+	if (Query.UserId.IsSet())
+	{
+		const uint32* Code = UserCodes.Find(Query.UserId.GetValue());
+		if (!Code)
+		{
+			return false;
+		}
+		OutRanges.UserLo = OutRanges.UserHi = *Code;
+	}
+
+	if (Query.Club.IsSet())
+	{
+		const uint32* Code = ClubCodes.Find(Query.Club.GetValue());
+		if (!Code || *Code > MAX_uint16)
+		{
+			return false;
+		}
+		OutRanges.ClubLo = OutRanges.ClubHi = static_cast<uint16>(*Code);
+	}
+
+	if (Query.SatelliteId.IsSet())
+	{
+		const uint32* Code = SatelliteCodes.Find(Query.SatelliteId.GetValue());
+		if (!Code)
+		{
+			return false;
+		}
+		OutRanges.SatelliteLo = OutRanges.SatelliteHi = *Code;
+	}
+
+	if (Query.bRightHanded.IsSet())
+	{
+		OutRanges.HandLo = OutRanges.HandHi = Query.bRightHanded.GetValue() ? 1 : 0;
+	}
+
+	OutRanges.FromUnixMs = Query.FromUnixMs;
+	OutRanges.ToUnixMs = Query.ToUnixMs;
+
+	for (const FBlockRef& Block : Blocks)
+	{
+		if (Block->MaxTimestampUnixMs >= Query.FromUnixMs && Block->MinTimestampUnixMs < Query.ToUnixMs)
+		{
+			OutBlocks.Add(FBlockView{ Block, Block->Num });
+		}
+	}
+
+	OutNumClubs = Clubs.Num();
+	OutNumUsers = Users.Num();
+	return true;
+}
+
+template <typename GroupType>
+void FHaversineSwingStore::ScanBlock(const FBlock& Block, int32 Num, const FColumnRanges& Ranges, const GroupType* GroupColumn, FAccumulator* Groups)
+{
+	auto Matches = [&Block, &Ranges](int32 Row)
+	{
+		// Bitwise rather than logical ands: no branches, so the loop body is straight-line code
+		return InRange(Block.User[Row], Ranges.UserLo, Ranges.UserHi)
+			& InRange(Block.Satellite[Row], Ranges.SatelliteLo, Ranges.SatelliteHi)
+			& InRange(Block.Club[Row], Ranges.ClubLo, Ranges.ClubHi)
+			& InRange(Block.RightHanded[Row], Ranges.HandLo, Ranges.HandHi)
+			& (Block.TimestampUnixMs[Row] >= Ranges.FromUnixMs)
+			& (Block.TimestampUnixMs[Row] < Ranges.ToUnixMs);
+	};
+
+	if (GroupColumn)
+	{
+		for (int32 Row = 0; Row < Num; ++Row)
+		{
+			if (Matches(Row))
+			{
+				FAccumulator& Group = Groups[GroupColumn[Row]];
+				const float Speed = Block.Speed[Row];
+				++Group.Count;
+				Group.Sum += Speed;
+				Group.Min = FMath::Min(Group.Min, Speed);
+				Group.Max = FMath::Max(Group.Max, Speed);
+			}
+		}
+		return;
+	}
+
+	uint32 LaneCount[ScanLanes] = {};
+	float LaneSum[ScanLanes] = {};
+	float LaneMin[ScanLanes];
+	float LaneMax[ScanLanes];
+	for (int32 Lane = 0; Lane < ScanLanes; ++Lane)
+	{
+		LaneMin[Lane] = MAX_flt;
+		LaneMax[Lane] = -MAX_flt;
+	}
+
+	int32 Row = 0;
+	for (; Row + ScanLanes <= Num; Row += ScanLanes)
+	{
+		for (int32 Lane = 0; Lane < ScanLanes; ++Lane)
+		{
+			const bool bMatch = Matches(Row + Lane);
+			const float Speed = Block.Speed[Row + Lane];
+			LaneCount[Lane] += bMatch ? 1 : 0;
+			LaneSum[Lane] += bMatch ? Speed : 0.0f;
+			LaneMin[Lane] = FMath::Min(LaneMin[Lane], bMatch ? Speed : MAX_flt);
+			LaneMax[Lane] = FMath::Max(LaneMax[Lane], bMatch ? Speed : -MAX_flt);
+		}
+	}
+	for (int32 Lane = 0; Row < Num; ++Row, ++Lane)
+	{
+		const bool bMatch = Matches(Row);
+		const float Speed = Block.Speed[Row];
+		LaneCount[Lane] += bMatch ? 1 : 0;
+		LaneSum[Lane] += bMatch ? Speed : 0.0f;
+		LaneMin[Lane] = FMath::Min(LaneMin[Lane], bMatch ? Speed : MAX_flt);
+		LaneMax[Lane] = FMath::Max(LaneMax[Lane], bMatch ? Speed : -MAX_flt);
+	}
+
+	FAccumulator& Total = Groups[0];
+	for (int32 Lane = 0; Lane < ScanLanes; ++Lane)
+	{
+		Total.Count += LaneCount[Lane];
+		Total.Sum += LaneSum[Lane];
+		Total.Min = FMath::Min(Total.Min, LaneMin[Lane]);
+		Total.Max = FMath::Max(Total.Max, LaneMax[Lane]);
+	}
+}
+
+TArray<FHaversineSwingStore::FAccumulator> FHaversineSwingStore::Scan(const FHaversineSwingQuery& Query, EGroupBy GroupBy) const
+{
+	Queries.fetch_add(1, std::memory_order_relaxed);
+
+	FColumnRanges Ranges;
+	TArray<FBlockView> Views;
+	int32 NumClubs = 0;
+	int32 NumUsers = 0;
+	if (!Prepare(Query, Ranges, Views, NumClubs, NumUsers))
+	{
+		return TArray<FAccumulator>();
+	}
+
+	TArray<FAccumulator> Groups;
+	Groups.SetNum(GroupBy == EGroupBy::Club ? NumClubs : GroupBy == EGroupBy::User ? NumUsers : 1);
+
+	// Only rows [0, Num) of each snapshot are read; those are never written again
+	for (const FBlockView& View : Views)
+	{
+		switch (GroupBy)
+		{
+			case EGroupBy::Club:	ScanBlock(*View.Block, View.Num, Ranges, View.Block->Club, Groups.GetData()); break;
+			case EGroupBy::User:	ScanBlock(*View.Block, View.Num, Ranges, View.Block->User, Groups.GetData()); break;
+			default:				ScanBlock<uint8>(*View.Block, View.Num, Ranges, nullptr, Groups.GetData()); break;
+		}
+	}
+	return Groups;
+}
+
+FHaversineSwingAggregate FHaversineSwingStore::Aggregate(const FHaversineSwingQuery& Query) const
+{
+	const TArray<FAccumulator> Groups = Scan(Query, EGroupBy::None);
+	return Groups.IsEmpty() ? FHaversineSwingAggregate() : Groups[0].ToAggregate();
+}
+
+TMap<FString, FHaversineSwingAggregate> FHaversineSwingStore::AggregateByClub(const FHaversineSwingQuery& Query) const
+{
+	const TArray<FAccumulator> Groups = Scan(Query, EGroupBy::Club);
+
+	TMap<FString, FHaversineSwingAggregate> Result;
+	FReadScopeLock ReadLock(Lock);
+	for (int32 Code = 0; Code < Groups.Num(); ++Code)
+	{
+		if (Groups[Code].Count > 0)
+		{
+			Result.Add(Code == 0 ? FString(TEXT("(unknown)")) : Clubs[Code], Groups[Code].ToAggregate());
+		}
+	}
+	return Result;
+}
+
+TMap<uint32, FHaversineSwingAggregate> FHaversineSwingStore::AggregateByUser(const FHaversineSwingQuery& Query) const
+{
+	const TArray<FAccumulator> Groups = Scan(Query, EGroupBy::User);
+
+	// Swings from satellites without a known user are left out
+	TMap<uint32, FHaversineSwingAggregate> Result;
+	FReadScopeLock ReadLock(Lock);
+	for (int32 Code = 1; Code < Groups.Num(); ++Code)
+	{
+		if (Groups[Code].Count > 0)
+		{
+			Result.Add(Users[Code], Groups[Code].ToAggregate());
+		}
+	}
+	return Result;
+}
+
+FHaversineSwingStoreStats FHaversineSwingStore::GetStats() const
+{
+	FHaversineSwingStoreStats Stats;
+	{
+		FReadScopeLock ReadLock(Lock);
+		Stats.Rows = Rows;
+		Stats.Blocks = Blocks.Num();
+		Stats.BytesAllocated = static_cast<int64>(Blocks.Num()) * sizeof(FBlock);
+		Stats.Clubs = Clubs.Num() - 1;
+		Stats.Users = Users.Num() - 1;
+		Stats.Satellites = Satellites.Num() - 1;
+	}
+	Stats.Added = Added.load(std::memory_order_relaxed);
+	Stats.Evicted = Evicted.load(std::memory_order_relaxed);
+	Stats.Queries = Queries.load(std::memory_order_relaxed);
+	return Stats;
+}
+
+void FHaversineSwingStore::LogStats() const
+{
+	const FHaversineSwingStoreStats Stats = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Swing store stats: %lld rows in %d blocks (%.1f MB) | %d clubs, %d users, %d satellites | added=%llu evicted=%llu queries=%llu"),
+		Stats.Rows, Stats.Blocks, Stats.BytesAllocated / (1024.0 * 1024.0), Stats.Clubs, Stats.Users, Stats.Satellites,
+		Stats.Added, Stats.Evicted, Stats.Queries);
+}
+
+void FHaversineSwingStore::LogQuery(const FHaversineSwingQuery& Query) const
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const FHaversineSwingAggregate Total = Aggregate(Query);
+	const double TotalMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Swings (%s): %llu, avg %.1f MPH (%.1f - %.1f) in %.3f ms"),
+		*Query.ToString(), Total.Count, Total.AverageSpeed, Total.MinSpeed, Total.MaxSpeed, TotalMs);
+
+	const uint64 GroupStartCycles = FPlatformTime::Cycles64();
+	TMap<FString, FHaversineSwingAggregate> ByClub = AggregateByClub(Query);
+	const double GroupMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - GroupStartCycles);
+
+	ByClub.ValueSort([](const FHaversineSwingAggregate& A, const FHaversineSwingAggregate& B) { return A.Count > B.Count; });
+	for (const TPair<FString, FHaversineSwingAggregate>& Pair : ByClub)
+	{
+		UE_LOG(LogHaversineSatellite, Log, TEXT("  • %s: %llu, avg %.1f MPH (%.1f - %.1f)"),
+			*Pair.Key, Pair.Value.Count, Pair.Value.AverageSpeed, Pair.Value.MinSpeed, Pair.Value.MaxSpeed);
+	}
+	UE_LOG(LogHaversineSatellite, Log, TEXT("  (per-club breakdown in %.3f ms)"), GroupMs);
+}
@@ -0,0 +1,187 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+#include <atomic>
+
+/** Filter over the swing store. Unset fields match every swing. */
+struct FHaversineSwingQuery
+{
+	TOptional<uint32> UserId;
+	TOptional<FString> Club;
+	TOptional<bool> bRightHanded;
+	TOptional<FString> SatelliteId;
+
+	/** Unix milliseconds, inclusive start and exclusive end */
+	int64 FromUnixMs = MIN_int64;
+	int64 ToUnixMs = MAX_int64;
+
+	/** Convenience for "in the last N minutes" */
+	static FHaversineSwingQuery LastMinutes(double Minutes);
+
+	/** Parses `user=<id> club=<name> hand=<L|R> satellite=<id> minutes=<n>`. @return false on an unknown argument. */
+	static bool FromConsoleArgs(const TArray<FString>& Args, FHaversineSwingQuery& OutQuery);
+
+	FString ToString() const;
+};
+
+/** Clubhead speed statistics (MPH) over the swings matching a query */
+struct FHaversineSwingAggregate
+{
+	uint64 Count = 0;
+	double AverageSpeed = 0.0;
+	float MinSpeed = 0.0f;
+	float MaxSpeed = 0.0f;
+};
+
+/** Point-in-time counters for `FHaversineSwingStore` */
+struct FHaversineSwingStoreStats
+{
+	int64 Rows = 0;
+	int32 Blocks = 0;
+	int64 BytesAllocated = 0;
+	int32 Clubs = 0;
+	int32 Users = 0;
+	int32 Satellites = 0;
+	uint64 Added = 0;
+
+	/** Rows dropped, oldest block first, to stay under `MaxRows` */
+	uint64 Evicted = 0;
+	uint64 Queries = 0;
+};
+
+/**
+ * In-memory columnar store of published swings: clubhead speed, club, handedness, user ID, satellite and time.
+ *
+ * Rows are appended to fixed-size blocks holding one contiguous array per column. Club, user and satellite are
+ * dictionary-encoded to small integer codes, so every filter becomes a range check on an integer column and a scan
+ * is a branchless loop over plain arrays that the compiler vectorizes. Each block keeps the time span it covers;
+ * a query for the last hour skips every older block without reading it. Grouped aggregates (per club, per user)
+ * accumulate into arrays indexed by dictionary code rather than hash maps.
+ *
+ * Rows never change once written and blocks are never reallocated, so a query only holds the lock long enough to
+ * snapshot the block list and scans without it; appends from the pipeline workers are never blocked by a scan.
+ * Once `MaxRows` is exceeded the oldest block is dropped. Thread-safe.
+ */
+class FHaversineSwingStore
+{
+public:
+	FHaversineSwingStore();
+
+	/** Record a published swing. `TimestampUnixMs` of 0 means now. */
+	void Add(const FString& SatelliteId, const FString& Club, float ClubheadSpeed, bool bRightHanded, int64 TimestampUnixMs = 0);
+
+	/** Swings from this satellite are attributed to this user from now on (from its SuperTag metadata) */
+	void AssociateUser(const FString& SatelliteId, uint32 UserId);
+
+	/** @return the user this satellite's swings are attributed to, or 0 if none is known */
+	uint32 FindUser(const FString& SatelliteId) const;
+
+	FHaversineSwingAggregate Aggregate(const FHaversineSwingQuery& Query) const;
+	TMap<FString, FHaversineSwingAggregate> AggregateByClub(const FHaversineSwingQuery& Query) const;
+	TMap<uint32, FHaversineSwingAggregate> AggregateByUser(const FHaversineSwingQuery& Query) const;
+
+	/** Drop every row; dictionaries and user associations are kept */
+	void Reset();
+
+	FHaversineSwingStoreStats GetStats() const;
+	void LogStats() const;
+
+	/** Logs the overall aggregate and the per-club breakdown for a query, with the time it took */
+	void LogQuery(const FHaversineSwingQuery& Query) const;
+
+private:
+	static constexpr int32 RowsPerBlock = 64 * 1024;
+
+	/** Rows `[0, Num)` are immutable; only the block at the end of `Blocks` is ever appended to */
+	struct FBlock
+	{
+		alignas(64) float Speed[RowsPerBlock];
+		alignas(64) int64 TimestampUnixMs[RowsPerBlock];
+		alignas(64) uint32 User[RowsPerBlock];
+		alignas(64) uint32 Satellite[RowsPerBlock];
+		alignas(64) uint16 Club[RowsPerBlock];
+		alignas(64) uint8 RightHanded[RowsPerBlock];
+
+		int32 Num = 0;
+		int64 MinTimestampUnixMs = MAX_int64;
+		int64 MaxTimestampUnixMs = MIN_int64;
+	};
+
+	using FBlockRef = TSharedRef<FBlock, ESPMode::ThreadSafe>;
+
+	struct FBlockView
+	{
+		FBlockRef Block;
+		int32 Num;
+	};
+
+	/** A query with every field reduced to an inclusive range of column values */
+	struct FColumnRanges
+	{
+		uint32 UserLo = 0, UserHi = MAX_uint32;
+		uint32 SatelliteLo = 0, SatelliteHi = MAX_uint32;
+		uint16 ClubLo = 0, ClubHi = MAX_uint16;
+		uint8 HandLo = 0, HandHi = 1;
+		int64 FromUnixMs = MIN_int64;
+		int64 ToUnixMs = MAX_int64;
+	};
+
+	/** Running totals for one group */
+	struct FAccumulator
+	{
+		uint64 Count = 0;
+		double Sum = 0.0;
+		float Min = MAX_flt;
+		float Max = -MAX_flt;
+
+		FHaversineSwingAggregate ToAggregate() const;
+	};
+
+	enum class EGroupBy : uint8
+	{
+		None,
+		Club,
+		User,
+	};
+
+	/** Encodes a value, adding it to the dictionary if new. Caller holds the write lock. */
+	template <typename ValueType>
+	static uint32 Encode(TMap<ValueType, uint32>& Codes, TArray<ValueType>& Values, const ValueType& Value);
+
+	/**
+	 * Resolves the query against the dictionaries and snapshots the blocks whose time span it overlaps.
+	 * @return false if the query names a club, user or satellite the store has never seen (nothing can match)
+	 */
+	bool Prepare(const FHaversineSwingQuery& Query, FColumnRanges& OutRanges, TArray<FBlockView>& OutBlocks, int32& OutNumClubs, int32& OutNumUsers) const;
+
+	/** @return one accumulator per group code (a single one for `EGroupBy::None`) */
+	TArray<FAccumulator> Scan(const FHaversineSwingQuery& Query, EGroupBy GroupBy) const;
+
+	/** Adds each matching row of a block to `Groups[GroupColumn[Row]]`, or to `Groups[0]` if `GroupColumn` is null */
+	template <typename GroupType>
+	static void ScanBlock(const FBlock& Block, int32 Num, const FColumnRanges& Ranges, const GroupType* GroupColumn, FAccumulator* Groups);
+
+	int64 MaxRows;
+
+	mutable FRWLock Lock;
+	TArray<FBlockRef> Blocks;
+	int64 Rows = 0;
+
+	// Dictionaries. Code 0 of each is reserved for "unknown".
+	TMap<FString, uint32> ClubCodes;
+	TArray<FString> Clubs;
+	TMap<uint32, uint32> UserCodes;
+	TArray<uint32> Users;
+	TMap<FString, uint32> SatelliteCodes;
+	TArray<FString> Satellites;
+
+	/** Satellite code → user code, from `AssociateUser` */
+	TArray<uint32> UserBySatellite;
+
+	std::atomic<uint64> Added{0};
+	std::atomic<uint64> Evicted{0};
+	mutable std::atomic<uint64> Queries{0};
+};
@@ -0,0 +1,744 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineSwingUploadQueue.cpp
+// UnrealHaversineDemo
+//
+// Batching, order-preserving swing uploader and the transports it can send through
+//
+
+#include "HaversineSwingUploadQueue.h"
+#include "HaversineUploadSpool.h"
+#include "SuperTagKitPlugin.h"
+#include "SuperTagAuthenticationManager.h"
+#include "SuperTagSwingUploader.h"
+#include "Dom/JsonObject.h"
+#include "HAL/IConsoleManager.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Misc/ScopeLock.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include <atomic>
+
+// Forward declaration for GolfSwingKit types
+struct GSAuthTokenCache_s;
+typedef struct GSAuthTokenCache_s GSAuthTokenCache_t;
+
+static TAutoConsoleVariable<FString> CVarHaversineUploadBatchUrl(
+	TEXT("haversine.Upload.BatchUrl"),
+	TEXT(""),
+	TEXT("Batch upload endpoint. When empty, swings are uploaded one request each through SuperTagKit. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineUploadMaxBatchSize(
+	TEXT("haversine.Upload.MaxBatchSize"),
+	16,
+	TEXT("Number of waiting swings that triggers an upload batch."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineUploadMaxBatchDelayMs(
+	TEXT("haversine.Upload.MaxBatchDelayMs"),
+	250.0f,
+	TEXT("Longest a swing waits for its batch to fill before the batch is sent anyway."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineUploadMaxInFlightBatches(
+	TEXT("haversine.Upload.MaxInFlightBatches"),
+	4,
+	TEXT("Maximum number of upload batches outstanding at once."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineUploadMaxAttempts(
+	TEXT("haversine.Upload.MaxAttempts"),
+	5,
+	TEXT("Number of times a swing is sent before its upload is reported as failed."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineUploadRetryBackoffMs(
+	TEXT("haversine.Upload.RetryBackoffMs"),
+	500.0f,
+	TEXT("Delay before retrying a satellite's failed uploads. Doubles with each consecutive failure."),
+	ECVF_ReadOnly);
+
+// How often the flush timer checks for overdue batches.
+static constexpr float UploadTickIntervalSeconds = 0.02f;
+
+// Batch request body header
+static constexpr uint32 BatchMagic = 0x31425348; // "HSB1"
+static constexpr int32 BatchVersion = 1;
+static constexpr int32 MaxSwingsPerBatchBody = 4096;
+
+FHaversineSwingUploadQueueConfig FHaversineSwingUploadQueueConfig::FromConsoleVariables()
+{
+	FHaversineSwingUploadQueueConfig Result;
+	Result.BatchUrl = CVarHaversineUploadBatchUrl.GetValueOnAnyThread();
+	Result.MaxBatchSize = FMath::Max(1, CVarHaversineUploadMaxBatchSize.GetValueOnAnyThread());
+	Result.MaxBatchDelayMs = FMath::Max(0.0f, CVarHaversineUploadMaxBatchDelayMs.GetValueOnAnyThread());
+	Result.MaxInFlightBatches = FMath::Max(1, CVarHaversineUploadMaxInFlightBatches.GetValueOnAnyThread());
+	Result.MaxAttempts = FMath::Max(1, CVarHaversineUploadMaxAttempts.GetValueOnAnyThread());
+	Result.RetryBackoffMs = FMath::Max(0.0f, CVarHaversineUploadRetryBackoffMs.GetValueOnAnyThread());
+	return Result;
+}
+
+//
+// Transports
+//
+
+FHaversineDirectUploadTransport::FHaversineDirectUploadTransport(USuperTagAuthenticationManager* InAuthManager)
+	: AuthManager(InAuthManager)
+{
+}
+
+void FHaversineDirectUploadTransport::SendBatch(const TArray<FHaversineSwingUploadRef>& Batch, FOnBatchComplete&& OnBatchComplete)
+{
+	struct FBatchState
+	{
+		TArray<FHaversineSwingUploadResult> Results;
+		std::atomic<int32> Remaining{0};
+		FOnBatchComplete OnBatchComplete;
+
+		void Complete(int32 Index, bool bSuccess, const FString& ErrorMessage)
+		{
+			Results[Index].bSuccess = bSuccess;
+			Results[Index].ErrorMessage = ErrorMessage;
+			if (Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				OnBatchComplete(MoveTemp(Results));
+			}
+		}
+	};
+
+	if (Batch.IsEmpty())
+	{
+		OnBatchComplete({});
+		return;
+	}
+
+	TSharedRef<FBatchState, ESPMode::ThreadSafe> State = MakeShared<FBatchState, ESPMode::ThreadSafe>();
+	State->Results.SetNum(Batch.Num());
+	State->Remaining.store(Batch.Num(), std::memory_order_relaxed);
+	State->OnBatchComplete = MoveTemp(OnBatchComplete);
+
+	GSAuthTokenCache_t* TokenCache = AuthManager ? static_cast<GSAuthTokenCache_t*>(AuthManager->GetAuthTokenCacheHandle()) : nullptr;
+
+	for (int32 Index = 0; Index < Batch.Num(); ++Index)
+	{
+		const FHaversineSwingUpload& Upload = *Batch[Index];
+		if (!Upload.Swing.IsValid() || !Upload.Collection.IsValid())
+		{
+			State->Complete(Index, false, TEXT("No reconstructed swing to upload"));
+			continue;
+		}
+
+		// The uploader will parse metadata internally from collection data
+		TArray<uint8> CollectionDataArray(Upload.Collection->GetView());
+		FSuperTagSwingUploader::UploadSwing(
+			CollectionDataArray,
+			*Upload.Swing,
+			Upload.HardwareId,
+			Upload.AuthToken,
+			TokenCache,
+			[State, Index](bool bSuccess, const FString& ErrorMessage)
+			{
+				State->Complete(Index, bSuccess, ErrorMessage);
+			}
+		);
+	}
+}
+
+void FHaversineDiscardUploadTransport::SendBatch(const TArray<FHaversineSwingUploadRef>& Batch, FOnBatchComplete&& OnBatchComplete)
+{
+	TArray<FHaversineSwingUploadResult> Results;
+	Results.Init(FHaversineSwingUploadResult{true, FString()}, Batch.Num());
+	OnBatchComplete(MoveTemp(Results));
+}
+
+FHaversineHttpBatchTransport::FHaversineHttpBatchTransport(const FString& InUrl)
+	: Url(InUrl)
+{
+}
+
+void FHaversineHttpBatchTransport::SendBatch(const TArray<FHaversineSwingUploadRef>& Batch, FOnBatchComplete&& OnBatchComplete)
+{
+	// Guards against the completion delegate and a failed ProcessRequest both reporting the batch
+	struct FPendingBatch
+	{
+		FOnBatchComplete OnBatchComplete;
+		int32 Count = 0;
+		std::atomic<bool> bCompleted{false};
+
+		void Complete(TArray<FHaversineSwingUploadResult>&& Results)
+		{
+			if (!bCompleted.exchange(true, std::memory_order_acq_rel))
+			{
+				OnBatchComplete(MoveTemp(Results));
+			}
+		}
+
+		void Fail(const FString& ErrorMessage)
+		{
+			TArray<FHaversineSwingUploadResult> Results;
+			Results.Init(FHaversineSwingUploadResult{false, ErrorMessage}, Count);
+			Complete(MoveTemp(Results));
+		}
+	};
+
+	TSharedRef<FPendingBatch, ESPMode::ThreadSafe> Pending = MakeShared<FPendingBatch, ESPMode::ThreadSafe>();
+	Pending->OnBatchComplete = MoveTemp(OnBatchComplete);
+	Pending->Count = Batch.Num();
+
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+	Request->SetURL(Url);
+	Request->SetVerb(TEXT("POST"));
+	Request->SetHeader(TEXT("Content-Type"), TEXT("application/octet-stream"));
+	Request->SetContent(FHaversineSwingBatchCodec::Encode(Batch));
+
+	// Completion only touches the upload queue, which is thread-safe, so don't wait for the game thread to tick
+	Request->SetDelegateThreadPolicy(EHttpRequestDelegateThreadPolicy::CompleteOnHttpThread);
+	Request->OnProcessRequestComplete().BindLambda(
+		[Pending](FHttpRequestPtr, FHttpResponsePtr Response, bool bConnectedSuccessfully)
+		{
+			if (!bConnectedSuccessfully || !Response.IsValid())
+			{
+				Pending->Fail(TEXT("Could not reach batch upload endpoint"));
+				return;
+			}
+
+			if (!EHttpResponseCodes::IsOk(Response->GetResponseCode()))
+			{
+				Pending->Fail(FString::Printf(TEXT("Batch upload endpoint returned HTTP %d"), Response->GetResponseCode()));
+				return;
+			}
+
+			TArray<FHaversineSwingUploadResult> Results;
+			if (!FHaversineSwingBatchCodec::DecodeResults(Response->GetContentAsString(), Pending->Count, Results))
+			{
+				Pending->Fail(TEXT("Malformed batch upload response"));
+				return;
+			}
+			Pending->Complete(MoveTemp(Results));
+		});
+
+	if (!Request->ProcessRequest())
+	{
+		Pending->Fail(TEXT("Could not start batch upload request"));
+	}
+}
+
+//
+// Wire format
+//
+
+TArray<uint8> FHaversineSwingBatchCodec::Encode(const TArray<FHaversineSwingUploadRef>& Batch)
+{
+	TArray<uint8> Body;
+	FMemoryWriter Writer(Body);
+
+	uint32 Magic = BatchMagic;
+	int32 Version = BatchVersion;
+	int32 Count = Batch.Num();
+	Writer << Magic << Version << Count;
+
+	for (const FHaversineSwingUploadRef& Upload : Batch)
+	{
+		FString SatelliteId = Upload->SatelliteId;
+		uint16 CollectionIndex = Upload->CollectionIndex;
+		FString HardwareId = Upload->HardwareId;
+		FString AuthToken = Upload->AuthToken;
+		Writer << SatelliteId << CollectionIndex << HardwareId << AuthToken;
+
+		TConstArrayView<uint8> Payload = Upload->Collection.IsValid() ? Upload->Collection->GetView() : TConstArrayView<uint8>();
+		int32 PayloadSize = Payload.Num();
+		Writer << PayloadSize;
+		if (PayloadSize > 0)
+		{
+			Writer.Serialize(const_cast<uint8*>(Payload.GetData()), PayloadSize);
+		}
+	}
+	return Body;
+}
+
+bool FHaversineSwingBatchCodec::Decode(TConstArrayView<uint8> Body, TArray<FEntry>& OutEntries)
+{
+	FMemoryReaderView Reader(Body);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	int32 Count = 0;
+	Reader << Magic << Version << Count;
+	if (Reader.IsError() || Magic != BatchMagic || Version != BatchVersion || Count < 0 || Count > MaxSwingsPerBatchBody)
+	{
+		return false;
+	}
+
+	OutEntries.Reset(Count);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		FEntry& Entry = OutEntries.AddDefaulted_GetRef();
+		Reader << Entry.SatelliteId << Entry.CollectionIndex << Entry.HardwareId << Entry.AuthToken;
+
+		int32 PayloadSize = 0;
+		Reader << PayloadSize;
+		if (Reader.IsError() || PayloadSize < 0 || PayloadSize > Reader.TotalSize() - Reader.Tell())
+		{
+			return false;
+		}
+
+		Entry.Payload.SetNumUninitialized(PayloadSize);
+		Reader.Serialize(Entry.Payload.GetData(), PayloadSize);
+	}
+	return !Reader.IsError();
+}
+
+FString FHaversineSwingBatchCodec::EncodeResults(const TArray<FHaversineSwingUploadResult>& Results)
+{
+	TArray<TSharedPtr<FJsonValue>> ResultValues;
+	ResultValues.Reserve(Results.Num());
+	for (const FHaversineSwingUploadResult& Result : Results)
+	{
+		TSharedRef<FJsonObject> ResultObject = MakeShared<FJsonObject>();
+		ResultObject->SetBoolField(TEXT("ok"), Result.bSuccess);
+		if (!Result.bSuccess)
+		{
+			ResultObject->SetStringField(TEXT("error"), Result.ErrorMessage);
+		}
+		ResultValues.Add(MakeShared<FJsonValueObject>(ResultObject));
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetArrayField(TEXT("results"), ResultValues);
+
+	FString Json;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+	return Json;
+}
+
+bool FHaversineSwingBatchCodec::DecodeResults(const FString& Json, int32 ExpectedCount, TArray<FHaversineSwingUploadResult>& OutResults)
+{
+	TSharedPtr<FJsonObject> Root;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Root) || !Root.IsValid())
+	{
+		return false;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* ResultValues = nullptr;
+	if (!Root->TryGetArrayField(TEXT("results"), ResultValues) || ResultValues->Num() != ExpectedCount)
+	{
+		return false;
+	}
+
+	OutResults.Reset(ExpectedCount);
+	for (const TSharedPtr<FJsonValue>& Value : *ResultValues)
+	{
+		const TSharedPtr<FJsonObject>* ResultObject = nullptr;
+		if (!Value.IsValid() || !Value->TryGetObject(ResultObject))
+		{
+			return false;
+		}
+
+		FHaversineSwingUploadResult& Result = OutResults.AddDefaulted_GetRef();
+		(*ResultObject)->TryGetBoolField(TEXT("ok"), Result.bSuccess);
+		(*ResultObject)->TryGetStringField(TEXT("error"), Result.ErrorMessage);
+	}
+	return true;
+}
+
+//
+// Upload queue
+//
+
+TSharedRef<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> FHaversineSwingUploadQueue::Create(USuperTagAuthenticationManager* AuthManager, const FHaversineSwingUploadQueueConfig& Config)
+{
+	TSharedRef<IHaversineSwingUploadTransport, ESPMode::ThreadSafe> Transport = Config.BatchUrl.IsEmpty()
+		? StaticCastSharedRef<IHaversineSwingUploadTransport>(MakeShared<FHaversineDirectUploadTransport, ESPMode::ThreadSafe>(AuthManager))
+		: StaticCastSharedRef<IHaversineSwingUploadTransport>(MakeShared<FHaversineHttpBatchTransport, ESPMode::ThreadSafe>(Config.BatchUrl));
+	return MakeShared<FHaversineSwingUploadQueue, ESPMode::ThreadSafe>(Transport, Config);
+}
+
+FHaversineSwingUploadQueue::FHaversineSwingUploadQueue(TSharedRef<IHaversineSwingUploadTransport, ESPMode::ThreadSafe> InTransport, const FHaversineSwingUploadQueueConfig& InConfig)
+	: Transport(MoveTemp(InTransport))
+	, Config(InConfig)
+{
+}
+
+FHaversineSwingUploadQueue::~FHaversineSwingUploadQueue()
+{
+	Shutdown();
+}
+
+void FHaversineSwingUploadQueue::Start()
+{
+	check(IsInGameThread());
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateSP(AsShared(), &FHaversineSwingUploadQueue::Tick), UploadTickIntervalSeconds);
+	}
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Swing upload queue started: %s, batches of up to %d, %.0f ms max delay, %d in flight"),
+		*Transport->Describe(), Config.MaxBatchSize, Config.MaxBatchDelayMs, Config.MaxInFlightBatches);
+}
+
+void FHaversineSwingUploadQueue::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	TArray<TPair<FHaversineSwingUploadRef, FHaversineSwingUploadResult>> Abandoned;
+	{
+		FScopeLock Lock(&Mutex);
+		if (bShutdown)
+		{
+			return;
+		}
+		bShutdown = true;
+
+		for (TPair<FString, FSatelliteQueue>& Pair : Satellites)
+		{
+			for (const FHaversineSwingUploadRef& Upload : Pair.Value.Waiting)
+			{
+				Abandoned.Emplace(Upload, FHaversineSwingUploadResult{false, TEXT("Upload queue shut down before the swing was sent")});
+			}
+			Pair.Value.Waiting.Reset();
+		}
+		PendingCount = 0;
+	}
+
+	GiveUp(MoveTemp(Abandoned));
+}
+
+void FHaversineSwingUploadQueue::Enqueue(const FHaversineSwingUploadRef& Upload)
+{
+	bool bAccepted = false;
+	bool bBatchFull = false;
+	{
+		FScopeLock Lock(&Mutex);
+		bAccepted = !bShutdown;
+		if (bAccepted)
+		{
+			Upload->EnqueueCycles = FPlatformTime::Cycles64();
+			Satellites.FindOrAdd(Upload->SatelliteId).Waiting.Add(Upload);
+			++PendingCount;
+			++Stats.Enqueued;
+			bBatchFull = PendingCount >= Config.MaxBatchSize;
+		}
+	}
+
+	if (!bAccepted)
+	{
+		TArray<TPair<FHaversineSwingUploadRef, FHaversineSwingUploadResult>> Abandoned;
+		Abandoned.Emplace(Upload, FHaversineSwingUploadResult{false, TEXT("Upload queue is shut down")});
+		GiveUp(MoveTemp(Abandoned));
+		return;
+	}
+
+	if (bBatchFull)
+	{
+		TryFlush(false);
+	}
+}
+
+void FHaversineSwingUploadQueue::Flush()
+{
+	TryFlush(true);
+}
+
+bool FHaversineSwingUploadQueue::Tick(float DeltaTime)
+{
+	TryFlush(false);
+	return true;
+}
+
+bool FHaversineSwingUploadQueue::IsEligibleLocked(const FSatelliteQueue& Queue, double NowSeconds) const
+{
+	return !Queue.bInFlight && !Queue.Waiting.IsEmpty() && NowSeconds >= Queue.RetryNotBeforeSeconds;
+}
+
+bool FHaversineSwingUploadQueue::IsBatchDueLocked(uint64 NowCycles, double NowSeconds) const
+{
+	if (PendingCount >= Config.MaxBatchSize)
+	{
+		return true;
+	}
+
+	for (const TPair<FString, FSatelliteQueue>& Pair : Satellites)
+	{
+		const FSatelliteQueue& Queue = Pair.Value;
+		if (IsEligibleLocked(Queue, NowSeconds)
+			&& FPlatformTime::ToMilliseconds64(NowCycles - Queue.Waiting[0]->EnqueueCycles) >= Config.MaxBatchDelayMs)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+TArray<FHaversineSwingUploadRef> FHaversineSwingUploadQueue::BuildBatchLocked(double NowSeconds)
+{
+	TArray<FSatelliteQueue*> Eligible;
+	for (TPair<FString, FSatelliteQueue>& Pair : Satellites)
+	{
+		if (IsEligibleLocked(Pair.Value, NowSeconds))
+		{
+			Eligible.Add(&Pair.Value);
+		}
+	}
+
+	TArray<FHaversineSwingUploadRef> Batch;
+	if (Eligible.IsEmpty())
+	{
+		return Batch;
+	}
+
+	// Take one swing per satellite per pass, starting from a rotating satellite, until the batch is full. Only one
+	// pass through a transport that could deliver a satellite's swings out of order.
+	const int32 FirstSatellite = RoundRobinCursor++ % Eligible.Num();
+	const int32 MaxPerSatellite = Transport->IsOrdered() ? MAX_int32 : 1;
+	TArray<int32> Taken;
+	Taken.SetNumZeroed(Eligible.Num());
+
+	bool bTookAny = true;
+	while (bTookAny && Batch.Num() < Config.MaxBatchSize)
+	{
+		bTookAny = false;
+		for (int32 Offset = 0; Offset < Eligible.Num() && Batch.Num() < Config.MaxBatchSize; ++Offset)
+		{
+			const int32 SatelliteIndex = (FirstSatellite + Offset) % Eligible.Num();
+			FSatelliteQueue& Queue = *Eligible[SatelliteIndex];
+			if (Taken[SatelliteIndex] < FMath::Min(Queue.Waiting.Num(), MaxPerSatellite))
+			{
+				const FHaversineSwingUploadRef& Upload = Queue.Waiting[Taken[SatelliteIndex]++];
+				++Upload->Attempts;
+				Batch.Add(Upload);
+				bTookAny = true;
+			}
+		}
+	}
+
+	for (int32 SatelliteIndex = 0; SatelliteIndex < Eligible.Num(); ++SatelliteIndex)
+	{
+		if (Taken[SatelliteIndex] > 0)
+		{
+			Eligible[SatelliteIndex]->Waiting.RemoveAt(0, Taken[SatelliteIndex]);
+			Eligible[SatelliteIndex]->bInFlight = true;
+		}
+	}
+
+	PendingCount -= Batch.Num();
+	return Batch;
+}
+
+void FHaversineSwingUploadQueue::TryFlush(bool bForce)
+{
+	TArray<TArray<FHaversineSwingUploadRef>> Batches;
+	{
+		FScopeLock Lock(&Mutex);
+		const uint64 NowCycles = FPlatformTime::Cycles64();
+		const double NowSeconds = FPlatformTime::Seconds();
+
+		while (!bShutdown && InFlightBatches < Config.MaxInFlightBatches && (bForce || IsBatchDueLocked(NowCycles, NowSeconds)))
+		{
+			TArray<FHaversineSwingUploadRef> Batch = BuildBatchLocked(NowSeconds);
+			if (Batch.IsEmpty())
+			{
+				break;
+			}
+
+			++InFlightBatches;
+			++Stats.BatchesSent;
+			SwingsSent += Batch.Num();
+			Batches.Add(MoveTemp(Batch));
+		}
+	}
+
+	for (TArray<FHaversineSwingUploadRef>& Batch : Batches)
+	{
+		SendBatch(MoveTemp(Batch));
+	}
+}
+
+void FHaversineSwingUploadQueue::SendBatch(TArray<FHaversineSwingUploadRef>&& Batch)
+{
+	TWeakPtr<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> WeakThis = AsShared();
+	TArray<FHaversineSwingUploadRef> SentBatch = Batch;
+
+	Transport->SendBatch(Batch, [WeakThis, SentBatch = MoveTemp(SentBatch)](TArray<FHaversineSwingUploadResult>&& Results) mutable
+	{
+		if (TSharedPtr<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> This = WeakThis.Pin())
+		{
+			This->OnBatchComplete(SentBatch, MoveTemp(Results));
+			return;
+		}
+
+		// The queue is gone; there is nobody left to retry, so report the outcome as it stands
+		for (int32 Index = 0; Index < SentBatch.Num(); ++Index)
+		{
+			if (SentBatch[Index]->OnComplete)
+			{
+				const bool bSuccess = Results.IsValidIndex(Index) && Results[Index].bSuccess;
+				SentBatch[Index]->OnComplete(bSuccess, bSuccess ? FString() : FString(TEXT("Upload queue destroyed before the swing was retried")));
+			}
+		}
+	});
+}
+
+void FHaversineSwingUploadQueue::OnBatchComplete(const TArray<FHaversineSwingUploadRef>& Batch, TArray<FHaversineSwingUploadResult>&& Results)
+{
+	if (Results.Num() != Batch.Num())
+	{
+		const FString ErrorMessage = FString::Printf(TEXT("Transport returned %d results for %d swings"), Results.Num(), Batch.Num());
+		Results.Init(FHaversineSwingUploadResult{false, ErrorMessage}, Batch.Num());
+	}
+
+	TArray<TPair<FHaversineSwingUploadRef, FHaversineSwingUploadResult>> Finished;
+	TArray<TPair<FHaversineSwingUploadRef, FHaversineSwingUploadResult>> Abandoned;
+	{
+		FScopeLock Lock(&Mutex);
+		--InFlightBatches;
+
+		const uint64 NowCycles = FPlatformTime::Cycles64();
+		const double NowSeconds = FPlatformTime::Seconds();
+
+		// Failed swings per satellite, in their original order
+		TMap<FString, TArray<FHaversineSwingUploadRef>> Retries;
+		TSet<FString> BatchSatellites;
+
+		for (int32 Index = 0; Index < Batch.Num(); ++Index)
+		{
+			const FHaversineSwingUploadRef& Upload = Batch[Index];
+			FHaversineSwingUploadResult& Result = Results[Index];
+			BatchSatellites.Add(Upload->SatelliteId);
+
+			if (Result.bSuccess)
+			{
+				++Stats.Uploaded;
+				TotalLatencyMs += FPlatformTime::ToMilliseconds64(NowCycles - Upload->EnqueueCycles);
+				Finished.Emplace(Upload, MoveTemp(Result));
+			}
+			else if (bShutdown || Upload->Attempts >= Config.MaxAttempts)
+			{
+				Abandoned.Emplace(Upload, MoveTemp(Result));
+			}
+			else
+			{
+				++Stats.Retried;
+				Retries.FindOrAdd(Upload->SatelliteId).Add(Upload);
+			}
+		}
+
+		for (const FString& SatelliteId : BatchSatellites)
+		{
+			FSatelliteQueue* Queue = Satellites.Find(SatelliteId);
+			if (!Queue)
+			{
+				continue;
+			}
+			Queue->bInFlight = false;
+
+			if (TArray<FHaversineSwingUploadRef>* SatelliteRetries = Retries.Find(SatelliteId))
+			{
+				// Retries go back in front of anything queued since, so the satellite's order is preserved
+				Queue->Waiting.Insert(*SatelliteRetries, 0);
+				PendingCount += SatelliteRetries->Num();
+
+				const double BackoffMs = Config.RetryBackoffMs * FMath::Pow(2.0, FMath::Min(Queue->ConsecutiveFailures, 10));
+				Queue->RetryNotBeforeSeconds = NowSeconds + BackoffMs / 1000.0;
+				++Queue->ConsecutiveFailures;
+			}
+			else
+			{
+				Queue->ConsecutiveFailures = 0;
+				if (Queue->Waiting.IsEmpty())
+				{
+					Satellites.Remove(SatelliteId);
+				}
+			}
+		}
+	}
+
+	for (TPair<FHaversineSwingUploadRef, FHaversineSwingUploadResult>& Pair : Finished)
+	{
+		if (Pair.Key->OnComplete)
+		{
+			Pair.Key->OnComplete(Pair.Value.bSuccess, Pair.Value.ErrorMessage);
+		}
+	}
+	GiveUp(MoveTemp(Abandoned));
+
+	TryFlush(false);
+}
+
+void FHaversineSwingUploadQueue::GiveUp(TArray<TPair<FHaversineSwingUploadRef, FHaversineSwingUploadResult>>&& Abandoned)
+{
+	if (Abandoned.IsEmpty())
+	{
+		return;
+	}
+
+	// Spooling compresses and writes each swing, so it happens outside the lock
+	TBitArray<> Spooled(false, Abandoned.Num());
+	int32 NumSpooled = 0;
+	if (Spool.IsValid())
+	{
+		for (int32 Index = 0; Index < Abandoned.Num(); ++Index)
+		{
+			if (Spool->Add(*Abandoned[Index].Key))
+			{
+				Spooled[Index] = true;
+				++NumSpooled;
+			}
+		}
+	}
+
+	{
+		FScopeLock Lock(&Mutex);
+		Stats.Spooled += NumSpooled;
+		Stats.Failed += Abandoned.Num() - NumSpooled;
+	}
+
+	for (int32 Index = 0; Index < Abandoned.Num(); ++Index)
+	{
+		const FHaversineSwingUploadRef& Upload = Abandoned[Index].Key;
+		if (Spooled[Index])
+		{
+			if (Upload->OnSpooled)
+			{
+				Upload->OnSpooled();
+			}
+		}
+		else if (Upload->OnComplete)
+		{
+			Upload->OnComplete(false, Abandoned[Index].Value.ErrorMessage);
+		}
+	}
+}
+
+FHaversineSwingUploadStats FHaversineSwingUploadQueue::GetStats() const
+{
+	FScopeLock Lock(&Mutex);
+	FHaversineSwingUploadStats Result = Stats;
+	Result.Pending = PendingCount;
+	Result.InFlightBatches = InFlightBatches;
+	Result.AverageBatchSize = Stats.BatchesSent > 0 ? static_cast<double>(SwingsSent) / Stats.BatchesSent : 0.0;
+	Result.AverageLatencyMs = Stats.Uploaded > 0 ? TotalLatencyMs / Stats.Uploaded : 0.0;
+	return Result;
+}
+
+void FHaversineSwingUploadQueue::LogStats() const
+{
+	const FHaversineSwingUploadStats Current = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Swing upload stats (%s): enqueued=%llu uploaded=%llu failed=%llu spooled=%llu retried=%llu | %llu batches, avg %.1f swings | pending=%d in-flight=%d | avg latency %.1f ms"),
+		*Transport->Describe(), Current.Enqueued, Current.Uploaded, Current.Failed, Current.Spooled, Current.Retried,
+		Current.BatchesSent, Current.AverageBatchSize, Current.Pending, Current.InFlightBatches, Current.AverageLatencyMs);
+}
@@ -0,0 +1,262 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "HaversineCollectionBuffer.h"
+#include "SuperTagGolfSwing.h"
+
+class FHaversineUploadSpool;
+class USuperTagAuthenticationManager;
+
+/** Called exactly once per swing when its upload finally succeeds or is given up on. May run on any thread. */
+using FHaversineSwingUploadComplete = TFunction<void(bool bSuccess, const FString& ErrorMessage)>;
+
+/** One swing waiting to be uploaded */
+struct FHaversineSwingUpload
+{
+	FString SatelliteId;
+	uint16 CollectionIndex = 0;
+	FHaversineCollectionBufferPtr Collection;
+	FString HardwareId;
+	FString AuthToken;
+
+	/** Reconstructed swing. Needed by the per-swing SuperTagKit uploader, not by the batch endpoint. */
+	TSharedPtr<FSuperTagGolfSwing, ESPMode::ThreadSafe> Swing;
+
+	FHaversineSwingUploadComplete OnComplete;
+
+	/**
+	 * Called instead of `OnComplete` when the queue gives up on the swing but the upload spool has taken it; the spool
+	 * uploads it later. May run on any thread.
+	 */
+	TFunction<void()> OnSpooled;
+
+	/** Number of times this swing has been sent */
+	int32 Attempts = 0;
+
+	/** FPlatformTime::Cycles64() when the swing was queued */
+	uint64 EnqueueCycles = 0;
+};
+
+using FHaversineSwingUploadRef = TSharedRef<FHaversineSwingUpload, ESPMode::ThreadSafe>;
+
+struct FHaversineSwingUploadResult
+{
+	bool bSuccess = false;
+	FString ErrorMessage;
+};
+
+/**
+ * Sends a batch of swings somewhere.
+ * `OnBatchComplete` must be called exactly once, from any thread, with one result per swing in batch order.
+ */
+class IHaversineSwingUploadTransport
+{
+public:
+	using FOnBatchComplete = TFunction<void(TArray<FHaversineSwingUploadResult>&& Results)>;
+
+	virtual ~IHaversineSwingUploadTransport() = default;
+	virtual void SendBatch(const TArray<FHaversineSwingUploadRef>& Batch, FOnBatchComplete&& OnBatchComplete) = 0;
+	virtual FString Describe() const = 0;
+
+	/** Whether swings must carry their reconstructed `Swing` */
+	virtual bool NeedsReconstructedSwing() const { return false; }
+
+	/** Whether a batch's swings reach the server in batch order; if not, the queue sends one swing per satellite per batch */
+	virtual bool IsOrdered() const { return false; }
+};
+
+/**
+ * Uploads each swing of a batch through `FSuperTagSwingUploader::UploadSwing`, all concurrently.
+ * This keeps the SkyGolf API's per-swing request format; batching then only limits how many requests are in flight.
+ */
+class FHaversineDirectUploadTransport : public IHaversineSwingUploadTransport
+{
+public:
+	explicit FHaversineDirectUploadTransport(USuperTagAuthenticationManager* InAuthManager);
+
+	virtual void SendBatch(const TArray<FHaversineSwingUploadRef>& Batch, FOnBatchComplete&& OnBatchComplete) override;
+	virtual FString Describe() const override { return TEXT("SuperTagKit per-swing uploads"); }
+	virtual bool NeedsReconstructedSwing() const override { return true; }
+
+private:
+	USuperTagAuthenticationManager* AuthManager;
+};
+
+/**
+ * POSTs a whole batch as one request to a batch endpoint (see `FHaversineSwingBatchCodec` for the wire format).
+ * The endpoint answers with `{"results":[{"ok":true},{"ok":false,"error":"..."}]}`, one entry per swing.
+ */
+class FHaversineHttpBatchTransport : public IHaversineSwingUploadTransport
+{
+public:
+	explicit FHaversineHttpBatchTransport(const FString& InUrl);
+
+	virtual void SendBatch(const TArray<FHaversineSwingUploadRef>& Batch, FOnBatchComplete&& OnBatchComplete) override;
+	virtual FString Describe() const override { return FString::Printf(TEXT("batch endpoint %s"), *Url); }
+	virtual bool IsOrdered() const override { return true; }
+
+private:
+	FString Url;
+};
+
+/**
+ * Reports every swing as uploaded without sending it anywhere. Replayed swings (see `HaversineSwingRecording.h`) go
+ * through this unless the mock upload server is running, so a benchmark never uploads recorded swings again.
+ */
+class FHaversineDiscardUploadTransport : public IHaversineSwingUploadTransport
+{
+public:
+	virtual void SendBatch(const TArray<FHaversineSwingUploadRef>& Batch, FOnBatchComplete&& OnBatchComplete) override;
+	virtual FString Describe() const override { return TEXT("discarded (replay)"); }
+	virtual bool IsOrdered() const override { return true; }
+};
+
+/** Wire format of a batch request body */
+struct FHaversineSwingBatchCodec
+{
+	struct FEntry
+	{
+		FString SatelliteId;
+		uint16 CollectionIndex = 0;
+		FString HardwareId;
+		FString AuthToken;
+		TArray<uint8> Payload;
+	};
+
+	static TArray<uint8> Encode(const TArray<FHaversineSwingUploadRef>& Batch);
+
+	/** @return false if the body is malformed */
+	static bool Decode(TConstArrayView<uint8> Body, TArray<FEntry>& OutEntries);
+
+	static FString EncodeResults(const TArray<FHaversineSwingUploadResult>& Results);
+
+	/** @return false if the response does not hold exactly ExpectedCount results */
+	static bool DecodeResults(const FString& Json, int32 ExpectedCount, TArray<FHaversineSwingUploadResult>& OutResults);
+};
+
+struct FHaversineSwingUploadQueueConfig
+{
+	/** Batch endpoint; empty to upload each swing through SuperTagKit */
+	FString BatchUrl;
+
+	/** A batch is sent as soon as this many swings are waiting */
+	int32 MaxBatchSize = 16;
+
+	/** ...or once the oldest waiting swing has waited this long */
+	float MaxBatchDelayMs = 250.0f;
+
+	int32 MaxInFlightBatches = 4;
+
+	/** Total sends per swing before it is reported as failed */
+	int32 MaxAttempts = 5;
+
+	/** Delay before a satellite's first retry; doubles with every further attempt */
+	float RetryBackoffMs = 500.0f;
+
+	/** Reads `haversine.Upload.*` console variables */
+	static FHaversineSwingUploadQueueConfig FromConsoleVariables();
+};
+
+struct FHaversineSwingUploadStats
+{
+	uint64 Enqueued = 0;
+	uint64 Uploaded = 0;
+	uint64 Failed = 0;
+
+	/** Given up on here but handed to the upload spool; not counted in `Failed` */
+	uint64 Spooled = 0;
+
+	uint64 Retried = 0;
+	uint64 BatchesSent = 0;
+	int32 Pending = 0;
+	int32 InFlightBatches = 0;
+	double AverageBatchSize = 0.0;
+	double AverageLatencyMs = 0.0;
+};
+
+/**
+ * Coalesces swing uploads into batches.
+ *
+ * Swings wait per satellite and are flushed when `MaxBatchSize` swings are waiting or the oldest has waited
+ * `MaxBatchDelayMs`, with at most `MaxInFlightBatches` outstanding. A satellite's swings are sent in order: while
+ * one of its batches is in flight its later swings wait, and failed swings are re-queued ahead of them and retried
+ * with exponential backoff. Batches are filled round-robin across satellites so one busy tag cannot starve the rest.
+ *
+ * Through a transport that is not ordered (per-swing SuperTagKit uploads, which all go out at once) a batch carries
+ * at most one swing per satellite. Through an ordered one (the batch endpoint) it may carry several, which reach the
+ * server in order; the server may still accept a later one while refusing an earlier one, which is then retried.
+ *
+ * Create with MakeShared and call `Start` before use; completions hold only weak references to the queue.
+ */
+class FHaversineSwingUploadQueue : public TSharedFromThis<FHaversineSwingUploadQueue, ESPMode::ThreadSafe>
+{
+public:
+	FHaversineSwingUploadQueue(TSharedRef<IHaversineSwingUploadTransport, ESPMode::ThreadSafe> InTransport, const FHaversineSwingUploadQueueConfig& InConfig);
+	~FHaversineSwingUploadQueue();
+
+	/** Creates a queue with the transport selected by `Config.BatchUrl` */
+	static TSharedRef<FHaversineSwingUploadQueue, ESPMode::ThreadSafe> Create(USuperTagAuthenticationManager* AuthManager, const FHaversineSwingUploadQueueConfig& Config);
+
+	/** Starts the flush timer. Must be called on the game thread. */
+	void Start();
+
+	/**
+	 * Hand swings the queue gives up on to an upload spool instead of failing them. Call before the first `Enqueue`;
+	 * the spool must outlive `Shutdown`.
+	 */
+	void SetSpool(const TSharedPtr<FHaversineUploadSpool, ESPMode::ThreadSafe>& InSpool) { Spool = InSpool; }
+
+	/** Stops the flush timer and fails (or spools) every swing that has not been sent. In-flight batches still complete. */
+	void Shutdown();
+
+	/** Queue a swing. Safe to call from any thread. */
+	void Enqueue(const FHaversineSwingUploadRef& Upload);
+
+	/** Send everything that is allowed to go now, ignoring the batch delay */
+	void Flush();
+
+	FHaversineSwingUploadStats GetStats() const;
+	void LogStats() const;
+
+	const TSharedRef<IHaversineSwingUploadTransport, ESPMode::ThreadSafe>& GetTransport() const { return Transport; }
+
+private:
+	struct FSatelliteQueue
+	{
+		TArray<FHaversineSwingUploadRef> Waiting;
+		bool bInFlight = false;
+		double RetryNotBeforeSeconds = 0.0;
+		int32 ConsecutiveFailures = 0;
+	};
+
+	bool Tick(float DeltaTime);
+	void TryFlush(bool bForce);
+	bool IsEligibleLocked(const FSatelliteQueue& Queue, double NowSeconds) const;
+	bool IsBatchDueLocked(uint64 NowCycles, double NowSeconds) const;
+	TArray<FHaversineSwingUploadRef> BuildBatchLocked(double NowSeconds);
+	void SendBatch(TArray<FHaversineSwingUploadRef>&& Batch);
+	void OnBatchComplete(const TArray<FHaversineSwingUploadRef>& Batch, TArray<FHaversineSwingUploadResult>&& Results);
+
+	/** Spools the swings, or fails those the spool cannot take, and reports them. `Mutex` must not be held. */
+	void GiveUp(TArray<TPair<FHaversineSwingUploadRef, FHaversineSwingUploadResult>>&& Abandoned);
+
+	TSharedRef<IHaversineSwingUploadTransport, ESPMode::ThreadSafe> Transport;
+	FHaversineSwingUploadQueueConfig Config;
+	TSharedPtr<FHaversineUploadSpool, ESPMode::ThreadSafe> Spool;
+
+	mutable FCriticalSection Mutex;
+	TMap<FString, FSatelliteQueue> Satellites;
+	int32 PendingCount = 0;
+	int32 InFlightBatches = 0;
+	int32 RoundRobinCursor = 0;
+	bool bShutdown = false;
+
+	FHaversineSwingUploadStats Stats;
+	uint64 SwingsSent = 0;
+	double TotalLatencyMs = 0.0;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,424 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineTrajectorySubsystem.cpp
+// UnrealHaversineDemo
+//
+// Instanced, cell-bucketed flight paths for every swing of the session
+//
+
+#include "HaversineTrajectorySubsystem.h"
+#include "HaversineBallLaunchSubsystem.h"
+#include "HaversineDemoSubsystem.h"
+#include "SuperTagKitPlugin.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Materials/MaterialInterface.h"
+
+static TAutoConsoleVariable<int32> CVarHaversineTrajectoriesMax(
+	TEXT("haversine.Trajectories.Max"),
+	20000,
+	TEXT("Most swing paths drawn at once; later swings are dropped until the paths are cleared. 0 disables drawing. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineTrajectoriesSwingsPerFrame(
+	TEXT("haversine.Trajectories.SwingsPerFrame"),
+	256,
+	TEXT("Most queued swings turned into paths in one frame. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineTrajectoriesCellSize(
+	TEXT("haversine.Trajectories.CellSize"),
+	2500.0f,
+	TEXT("Side in cm of the square cells path segments are bucketed into; each cell is drawn by its own pair of components. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineTrajectoriesDetailDistance(
+	TEXT("haversine.Trajectories.DetailDistance"),
+	15000.0f,
+	TEXT("Distance in cm from the camera up to which cells draw every path segment; beyond it they draw decimated paths. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineTrajectoriesCullDistance(
+	TEXT("haversine.Trajectories.CullDistance"),
+	100000.0f,
+	TEXT("Distance in cm from the camera beyond which cells are not drawn. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineTrajectoriesDecimation(
+	TEXT("haversine.Trajectories.Decimation"),
+	4,
+	TEXT("Far paths keep every Nth point. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineTrajectoriesThickness(
+	TEXT("haversine.Trajectories.Thickness"),
+	6.0f,
+	TEXT("Diameter in cm of a drawn path. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<FString> CVarHaversineTrajectoriesMaterial(
+	TEXT("haversine.Trajectories.Material"),
+	TEXT(""),
+	TEXT("Material for drawn paths; empty uses the cylinder's own. Read when the world begins play."),
+	ECVF_ReadOnly);
+
+namespace
+{
+	/** Unit cylinder from the engine content: 100 cm tall, 100 cm across, pivot at its centre, axis along Z */
+	const TCHAR* SegmentMeshPath = TEXT("/Engine/BasicShapes/Cylinder.Cylinder");
+
+	/** Time between recorded path points; a drive has about 60 */
+	constexpr float SampleSeconds = 0.1f;
+
+	/** Paths still in the air after this long (a solver edge case) are cut off */
+	constexpr float MaxFlightSeconds = 20.0f;
+
+	constexpr double MetersToUnits = 100.0;
+}
+
+bool UHaversineTrajectorySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHaversineTrajectorySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	MaxTrajectories = CVarHaversineTrajectoriesMax.GetValueOnGameThread();
+	if (MaxTrajectories <= 0)
+	{
+		return;
+	}
+
+	SegmentMesh = LoadObject<UStaticMesh>(nullptr, SegmentMeshPath);
+	if (!SegmentMesh)
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Swing paths disabled: %s could not be loaded"), SegmentMeshPath);
+		return;
+	}
+	const FString MaterialPath = CVarHaversineTrajectoriesMaterial.GetValueOnGameThread();
+	if (!MaterialPath.IsEmpty())
+	{
+		SegmentMaterial = LoadObject<UMaterialInterface>(nullptr, *MaterialPath);
+	}
+
+	SwingsPerFrame = FMath::Max(1, CVarHaversineTrajectoriesSwingsPerFrame.GetValueOnGameThread());
+	Decimation = FMath::Max(2, CVarHaversineTrajectoriesDecimation.GetValueOnGameThread());
+	CellSize = FMath::Max(100.0f, CVarHaversineTrajectoriesCellSize.GetValueOnGameThread());
+	CullDistance = CVarHaversineTrajectoriesCullDistance.GetValueOnGameThread();
+	DetailDistance = FMath::Min<double>(CVarHaversineTrajectoriesDetailDistance.GetValueOnGameThread(), CullDistance);
+	Thickness = CVarHaversineTrajectoriesThickness.GetValueOnGameThread();
+
+	// One solver for every batch; a batch fills its slots from the front
+	Solver = MakeUnique<FHaversineBallFlightSolver>(SwingsPerFrame);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Name = TEXT("HaversineTrajectories");
+	SpawnParams.ObjectFlags |= RF_Transient;
+	Host = InWorld.SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+	USceneComponent* Root = NewObject<USceneComponent>(Host, TEXT("Root"));
+	Host->SetRootComponent(Root);
+	Root->RegisterComponent();
+
+	UGameInstance* GameInstance = InWorld.GetGameInstance();
+	if (UHaversineDemoSubsystem* Haversine = GameInstance ? GameInstance->GetSubsystem<UHaversineDemoSubsystem>() : nullptr)
+	{
+		Haversine->OnSwingsProcessed.AddDynamic(this, &UHaversineTrajectorySubsystem::OnSwingsProcessed);
+	}
+}
+
+void UHaversineTrajectorySubsystem::Deinitialize()
+{
+	const UWorld* World = GetWorld();
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	if (UHaversineDemoSubsystem* Haversine = GameInstance ? GameInstance->GetSubsystem<UHaversineDemoSubsystem>() : nullptr)
+	{
+		Haversine->OnSwingsProcessed.RemoveDynamic(this, &UHaversineTrajectorySubsystem::OnSwingsProcessed);
+	}
+
+	if (Solver)
+	{
+		LogStats();
+	}
+
+	// The components belong to the host actor and go with the world
+	Solver.Reset();
+	Pending.Reset();
+	Cells.Reset();
+	CellIndexByCoord.Reset();
+	DirtyCells.Reset();
+	Host = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UHaversineTrajectorySubsystem::OnSwingsProcessed(const TArray<FHaversineSwingEvent>& Swings)
+{
+	for (const FHaversineSwingEvent& Swing : Swings)
+	{
+		AddTrajectory(Swing);
+	}
+}
+
+void UHaversineTrajectorySubsystem::AddTrajectory(const FHaversineSwingEvent& Swing)
+{
+	if (!Solver)
+	{
+		return;
+	}
+	if (NumTrajectories + Pending.Num() >= MaxTrajectories)
+	{
+		++Dropped;
+		return;
+	}
+	Pending.Add(Swing);
+}
+
+void UHaversineTrajectorySubsystem::ClearTrajectories()
+{
+	// Components are kept, empty, for the next paths in the same cells
+	for (FCell& Cell : Cells)
+	{
+		Cell.Detail->ClearInstances();
+		Cell.Coarse->ClearInstances();
+		Cell.PendingDetail.Reset();
+		Cell.PendingCoarse.Reset();
+	}
+	DirtyCells.Reset();
+	Pending.Reset();
+	NumTrajectories = 0;
+	NumDetailSegments = 0;
+	NumCoarseSegments = 0;
+}
+
+void UHaversineTrajectorySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if (Pending.IsEmpty() || !Solver)
+	{
+		return;
+	}
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	const int32 NumSwings = FMath::Min(Pending.Num(), Solver->GetCapacity());
+	BuildBatch(NumSwings);
+	Pending.RemoveAt(0, NumSwings, EAllowShrinking::No);
+	FlushCells();
+	LastBatchMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+}
+
+void UHaversineTrajectorySubsystem::BuildBatch(int32 NumSwings)
+{
+	const UHaversineBallLaunchSubsystem* Balls = GetWorld()->GetSubsystem<UHaversineBallLaunchSubsystem>();
+
+	Paths.SetNum(NumSwings, EAllowShrinking::No);
+	Origins.SetNum(NumSwings, EAllowShrinking::No);
+	for (int32 Slot = 0; Slot < NumSwings; ++Slot)
+	{
+		const FHaversineSwingEvent& Swing = Pending[Slot];
+
+		// Same tee as the ball this swing launched
+		FVector Origin = FVector::ZeroVector;
+		FVector Forward = FVector::ForwardVector;
+		if (Balls)
+		{
+			Balls->GetTee(Swing.SatelliteId, Origin, Forward);
+		}
+
+		Solver->Launch(Slot, FHaversineBallLaunchEstimate::FromSwing(Swing.ClubheadSpeedMph, Swing.Club, Swing.bRightHanded,
+			FVector3f(Forward), FVector3f::UpVector));
+		Origins[Slot] = Origin;
+		Paths[Slot].Reset();
+		Paths[Slot].Add(Origin);
+	}
+
+	// The whole batch flies together; each sample appends a point to every path still being recorded
+	for (float FlightSeconds = 0.0f; Solver->NumAirborne() > 0 && FlightSeconds < MaxFlightSeconds; FlightSeconds += SampleSeconds)
+	{
+		LandedScratch.Reset();
+		Solver->Advance(SampleSeconds, LandedScratch);
+		for (int32 Slot = 0; Slot < NumSwings; ++Slot)
+		{
+			if (Solver->IsAirborne(Slot))
+			{
+				Paths[Slot].Add(Origins[Slot] + FVector(Solver->GetPosition(Slot)) * MetersToUnits);
+			}
+		}
+		for (const int32 Slot : LandedScratch)
+		{
+			Paths[Slot].Add(Origins[Slot] + FVector(Solver->GetPosition(Slot)) * MetersToUnits);
+		}
+	}
+
+	for (int32 Slot = 0; Slot < NumSwings; ++Slot)
+	{
+		Solver->Remove(Slot);
+
+		const TArray<FVector>& Path = Paths[Slot];
+		const int32 Last = Path.Num() - 1;
+		for (int32 Point = 1; Point <= Last; ++Point)
+		{
+			AddSegment(Path[Point - 1], Path[Point], true);
+		}
+
+		int32 Previous = 0;
+		for (int32 Point = Decimation; Point < Last; Point += Decimation)
+		{
+			AddSegment(Path[Previous], Path[Point], false);
+			Previous = Point;
+		}
+		if (Last > 0)
+		{
+			AddSegment(Path[Previous], Path[Last], false);
+		}
+	}
+	NumTrajectories += NumSwings;
+}
+
+void UHaversineTrajectorySubsystem::AddSegment(const FVector& Start, const FVector& End, bool bDetail)
+{
+	const FVector Delta = End - Start;
+	const double Length = Delta.Size();
+	if (Length < 1.0)
+	{
+		return;
+	}
+
+	const FVector Scale(Thickness / 100.0, Thickness / 100.0, Length / 100.0);
+	const FTransform Transform(FRotationMatrix::MakeFromZ(Delta / Length).ToQuat(), (Start + End) * 0.5, Scale);
+
+	FCell& Cell = FindOrAddCell(Transform.GetLocation());
+	if (bDetail)
+	{
+		Cell.PendingDetail.Add(Transform);
+		++NumDetailSegments;
+	}
+	else
+	{
+		Cell.PendingCoarse.Add(Transform);
+		++NumCoarseSegments;
+	}
+}
+
+UHaversineTrajectorySubsystem::FCell& UHaversineTrajectorySubsystem::FindOrAddCell(const FVector& Location)
+{
+	const FIntPoint Coord(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+	int32 Index;
+	if (const int32* Found = CellIndexByCoord.Find(Coord))
+	{
+		Index = *Found;
+	}
+	else
+	{
+		// Both components of a cell cover the same segments, so their bounds (and the distance the renderer measures
+		// to them) match and the switch from detailed to decimated happens at the same point for both
+		Index = Cells.AddDefaulted();
+		Cells[Index].Detail = CreateCellComponent(0.0f, DetailDistance);
+		Cells[Index].Coarse = CreateCellComponent(DetailDistance, CullDistance);
+		CellIndexByCoord.Add(Coord, Index);
+	}
+
+	FCell& Cell = Cells[Index];
+	if (Cell.PendingDetail.IsEmpty() && Cell.PendingCoarse.IsEmpty())
+	{
+		DirtyCells.Add(Index);
+	}
+	return Cell;
+}
+
+UInstancedStaticMeshComponent* UHaversineTrajectorySubsystem::CreateCellComponent(float MinDrawDistance, float MaxDrawDistance)
+{
+	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(Host, NAME_None, RF_Transient);
+	Component->SetStaticMesh(SegmentMesh);
+	if (SegmentMaterial)
+	{
+		Component->SetMaterial(0, SegmentMaterial);
+	}
+	Component->SetMobility(EComponentMobility::Movable);
+	Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Component->SetCanEverAffectNavigation(false);
+	Component->SetCastShadow(false);
+	Component->MinDrawDistance = MinDrawDistance;
+	Component->LDMaxDrawDistance = MaxDrawDistance;
+	Component->SetCachedMaxDrawDistance(MaxDrawDistance);
+	Component->SetupAttachment(Host->GetRootComponent());
+	Component->RegisterComponent();
+	Host->AddInstanceComponent(Component);
+	return Component;
+}
+
+void UHaversineTrajectorySubsystem::FlushCells()
+{
+	for (const int32 Index : DirtyCells)
+	{
+		FCell& Cell = Cells[Index];
+		if (!Cell.PendingDetail.IsEmpty())
+		{
+			Cell.Detail->AddInstances(Cell.PendingDetail, false, true, false);
+			Cell.PendingDetail.Reset();
+		}
+		if (!Cell.PendingCoarse.IsEmpty())
+		{
+			Cell.Coarse->AddInstances(Cell.PendingCoarse, false, true, false);
+			Cell.PendingCoarse.Reset();
+		}
+	}
+	DirtyCells.Reset();
+}
+
+TStatId UHaversineTrajectorySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHaversineTrajectorySubsystem, STATGROUP_Tickables);
+}
+
+FHaversineTrajectoryStats UHaversineTrajectorySubsystem::GetStats() const
+{
+	FHaversineTrajectoryStats Stats;
+	Stats.Trajectories = NumTrajectories;
+	Stats.DetailSegments = NumDetailSegments;
+	Stats.CoarseSegments = NumCoarseSegments;
+	Stats.Cells = Cells.Num();
+	Stats.Pending = Pending.Num();
+	Stats.Dropped = Dropped;
+	Stats.LastBatchMs = LastBatchMs;
+	return Stats;
+}
+
+void UHaversineTrajectorySubsystem::LogStats() const
+{
+	const FHaversineTrajectoryStats Stats = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Swing path stats: %d paths (%d pending, %llu dropped) | segments: %lld detailed, %lld decimated | %d cells, %d components | last batch %.2f ms"),
+		Stats.Trajectories, Stats.Pending, Stats.Dropped, Stats.DetailSegments, Stats.CoarseSegments, Stats.Cells, Stats.Cells * 2, Stats.LastBatchMs);
+}
+
+//
+// Console commands
+//
+
+static FAutoConsoleCommandWithWorldAndArgs HaversineTrajectoriesStatsCommand(
+	TEXT("haversine.Trajectories.Stats"),
+	TEXT("Logs how many swing paths are drawn, their segments and cells."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (const UHaversineTrajectorySubsystem* Trajectories = World ? World->GetSubsystem<UHaversineTrajectorySubsystem>() : nullptr)
+		{
+			Trajectories->LogStats();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs HaversineTrajectoriesClearCommand(
+	TEXT("haversine.Trajectories.Clear"),
+	TEXT("Removes every drawn swing path."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UHaversineTrajectorySubsystem* Trajectories = World ? World->GetSubsystem<UHaversineTrajectorySubsystem>() : nullptr)
+		{
+			Trajectories->ClearTrajectories();
+		}
+	}));
@@ -0,0 +1,135 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HaversineBallFlightSolver.h"
+#include "HaversineBlueprintTypes.h"
+#include "HaversineTrajectorySubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UMaterialInterface;
+class UStaticMesh;
+
+/** Point-in-time counters for `UHaversineTrajectorySubsystem` */
+struct FHaversineTrajectoryStats
+{
+	int32 Trajectories = 0;
+	int64 DetailSegments = 0;
+	int64 CoarseSegments = 0;
+	int32 Cells = 0;
+
+	/** Swings received but not yet drawn */
+	int32 Pending = 0;
+
+	/** Swings not drawn because `haversine.Trajectories.Max` was reached */
+	uint64 Dropped = 0;
+
+	double LastBatchMs = 0.0;
+};
+
+/**
+ * Draws the flight path of every swing processed this session, for a picture of shot dispersion that can grow to
+ * thousands of paths.
+ *
+ * Paths are computed with the same flight model and tees as the launched balls, but all at once rather than in real
+ * time, and drawn as instanced cylinder segments. Segments are bucketed into square world cells
+ * (`haversine.Trajectories.CellSize`); each cell has two instanced mesh components, one with every segment and one with
+ * the path decimated to every Nth point. The detailed one is drawn up to `haversine.Trajectories.DetailDistance` and
+ * the decimated one beyond it, so far paths cost a fraction of the instances. The number of components, and so of draw
+ * calls, depends on the area the paths cover rather than on how many there are.
+ *
+ * New swings are queued and turned into instances at most `haversine.Trajectories.SwingsPerFrame` at a time, with one
+ * `AddInstances` per touched cell per frame; existing instances are never rebuilt.
+ */
+UCLASS()
+class UNREALHAVERSINEDEMO_API UHaversineTrajectorySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Deinitialize() override;
+
+	// UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Queue this swing's path to be drawn */
+	UFUNCTION(BlueprintCallable, Category = "Haversine")
+	void AddTrajectory(const FHaversineSwingEvent& Swing);
+
+	/** Remove every drawn path */
+	UFUNCTION(BlueprintCallable, Category = "Haversine")
+	void ClearTrajectories();
+
+	FHaversineTrajectoryStats GetStats() const;
+	void LogStats() const;
+
+protected:
+	// UWorldSubsystem interface
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FCell
+	{
+		/** Owned and kept alive by `Host` */
+		UInstancedStaticMeshComponent* Detail = nullptr;
+		UInstancedStaticMeshComponent* Coarse = nullptr;
+
+		/** Segments added this frame, flushed in one call per component */
+		TArray<FTransform> PendingDetail;
+		TArray<FTransform> PendingCoarse;
+	};
+
+	UFUNCTION()
+	void OnSwingsProcessed(const TArray<FHaversineSwingEvent>& Swings);
+
+	/** Fly a batch of queued swings and bucket the segments of their paths */
+	void BuildBatch(int32 NumSwings);
+
+	/** Cylinder from `Start` to `End`, in the cell containing its midpoint */
+	void AddSegment(const FVector& Start, const FVector& End, bool bDetail);
+
+	FCell& FindOrAddCell(const FVector& Location);
+	UInstancedStaticMeshComponent* CreateCellComponent(float MinDrawDistance, float MaxDrawDistance);
+	void FlushCells();
+
+	UPROPERTY()
+	TObjectPtr<AActor> Host;
+
+	UPROPERTY()
+	TObjectPtr<UStaticMesh> SegmentMesh;
+
+	UPROPERTY()
+	TObjectPtr<UMaterialInterface> SegmentMaterial;
+
+	TUniquePtr<FHaversineBallFlightSolver> Solver;
+	TArray<FHaversineSwingEvent> Pending;
+	TMap<FIntPoint, int32> CellIndexByCoord;
+	TArray<FCell> Cells;
+	TArray<int32> DirtyCells;
+
+	// Per-batch scratch, reused
+	TArray<TArray<FVector>> Paths;
+	TArray<FVector> Origins;
+	TArray<int32> LandedScratch;
+
+	int32 MaxTrajectories = 0;
+	int32 SwingsPerFrame = 0;
+	int32 Decimation = 4;
+	double CellSize = 0.0;
+	double DetailDistance = 0.0;
+	double CullDistance = 0.0;
+	double Thickness = 0.0;
+
+	int32 NumTrajectories = 0;
+	int64 NumDetailSegments = 0;
+	int64 NumCoarseSegments = 0;
+	uint64 Dropped = 0;
+	double LastBatchMs = 0.0;
+};
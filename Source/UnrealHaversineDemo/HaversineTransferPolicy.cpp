@@ -0,0 +1,265 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineTransferPolicy.cpp
+// UnrealHaversineDemo
+//
+// Decides how much of a satellite's collection backlog each connection transfers
+//
+
+#include "HaversineTransferPolicy.h"
+#include "SuperTagKitPlugin.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<FString> CVarHaversineTransferPolicy(
+	TEXT("haversine.Transfer.Policy"),
+	TEXT("All"),
+	TEXT("Which collections to transfer on each connection: All, LastN or MaxAge. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineTransferLastN(
+	TEXT("haversine.Transfer.LastN"),
+	1,
+	TEXT("Number of newest collections the LastN policy transfers."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineTransferMaxAgeSeconds(
+	TEXT("haversine.Transfer.MaxAgeSeconds"),
+	3600.0f,
+	TEXT("Oldest collection, by estimated age, the MaxAge policy transfers."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineTransferBytesPerConnection(
+	TEXT("haversine.Transfer.BytesPerConnection"),
+	0,
+	TEXT("If positive, caps the selected policy at this many collection bytes per connection."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineTransferEstimatedCollectionBytes(
+	TEXT("haversine.Transfer.EstimatedCollectionBytes"),
+	8192,
+	TEXT("Assumed collection size for the byte budget until real transfers have been measured."),
+	ECVF_ReadOnly);
+
+//
+// Built-in policies
+//
+
+uint16 FHaversineDrainAllTransferPolicy::NumToTransfer(const FHaversineTransferContext& Context) const
+{
+	return Context.NumAvailable();
+}
+
+FString FHaversineDrainAllTransferPolicy::Describe() const
+{
+	return TEXT("drain all");
+}
+
+FHaversineLastNTransferPolicy::FHaversineLastNTransferPolicy(uint16 InCount)
+	: Count(InCount)
+{
+}
+
+uint16 FHaversineLastNTransferPolicy::NumToTransfer(const FHaversineTransferContext& Context) const
+{
+	return FMath::Min(Count, Context.NumAvailable());
+}
+
+FString FHaversineLastNTransferPolicy::Describe() const
+{
+	return FString::Printf(TEXT("last %u"), Count);
+}
+
+FHaversineMaxAgeTransferPolicy::FHaversineMaxAgeTransferPolicy(double InMaxAgeSeconds)
+	: MaxAgeSeconds(InMaxAgeSeconds)
+{
+}
+
+uint16 FHaversineMaxAgeTransferPolicy::NumToTransfer(const FHaversineTransferContext& Context) const
+{
+	const uint16 Available = Context.NumAvailable();
+	if (!Context.bHasHistory || !Context.History.bHasTransferred || Available == 0)
+	{
+		return Available;
+	}
+
+	const double BacklogSeconds = (Context.NowUnixMs - Context.History.LastTransferUnixMs) / 1000.0;
+	if (BacklogSeconds <= MaxAgeSeconds)
+	{
+		return Available;
+	}
+
+	// Collections spread evenly over the backlog window: keep the share recorded within the age limit
+	const double Fraction = FMath::Max(0.0, MaxAgeSeconds) / BacklogSeconds;
+	return static_cast<uint16>(FMath::Min<double>(Available, FMath::CeilToDouble(Available * Fraction)));
+}
+
+FString FHaversineMaxAgeTransferPolicy::Describe() const
+{
+	return FString::Printf(TEXT("max age %.0f s"), MaxAgeSeconds);
+}
+
+FHaversineByteBudgetTransferPolicy::FHaversineByteBudgetTransferPolicy(int64 InBytesPerConnection, TUniquePtr<IHaversineTransferPolicy> InInner)
+	: BytesPerConnection(InBytesPerConnection)
+	, Inner(MoveTemp(InInner))
+{
+	check(Inner);
+}
+
+uint16 FHaversineByteBudgetTransferPolicy::NumToTransfer(const FHaversineTransferContext& Context) const
+{
+	const uint16 Wanted = Inner->NumToTransfer(Context);
+	if (Wanted == 0 || Context.EstimatedCollectionBytes <= 0)
+	{
+		return Wanted;
+	}
+
+	const int64 Affordable = FMath::Max<int64>(1, BytesPerConnection / Context.EstimatedCollectionBytes);
+	return static_cast<uint16>(FMath::Min<int64>(Wanted, Affordable));
+}
+
+FString FHaversineByteBudgetTransferPolicy::Describe() const
+{
+	return FString::Printf(TEXT("%s, at most %lld bytes per connection"), *Inner->Describe(), BytesPerConnection);
+}
+
+//
+// FHaversineTransferPolicyEngine
+//
+
+FHaversineTransferPolicyEngine::FHaversineTransferPolicyEngine(TUniquePtr<IHaversineTransferPolicy> InPolicy, FHaversineSatelliteStateCache* InStateCache)
+	: StateCache(InStateCache)
+	, EstimatedCollectionBytes(FMath::Max(1, CVarHaversineTransferEstimatedCollectionBytes.GetValueOnAnyThread()))
+{
+	SetPolicy(MoveTemp(InPolicy));
+}
+
+TUniquePtr<IHaversineTransferPolicy> FHaversineTransferPolicyEngine::CreatePolicyFromConsoleVariables()
+{
+	const FString Name = CVarHaversineTransferPolicy.GetValueOnAnyThread();
+
+	TUniquePtr<IHaversineTransferPolicy> Result;
+	if (Name.Equals(TEXT("LastN"), ESearchCase::IgnoreCase))
+	{
+		Result = MakeUnique<FHaversineLastNTransferPolicy>(static_cast<uint16>(FMath::Clamp(CVarHaversineTransferLastN.GetValueOnAnyThread(), 0, MAX_uint16)));
+	}
+	else if (Name.Equals(TEXT("MaxAge"), ESearchCase::IgnoreCase))
+	{
+		Result = MakeUnique<FHaversineMaxAgeTransferPolicy>(CVarHaversineTransferMaxAgeSeconds.GetValueOnAnyThread());
+	}
+	else
+	{
+		if (!Name.Equals(TEXT("All"), ESearchCase::IgnoreCase))
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Unknown transfer policy '%s', draining all collections"), *Name);
+		}
+		Result = MakeUnique<FHaversineDrainAllTransferPolicy>();
+	}
+
+	const int32 BytesPerConnection = CVarHaversineTransferBytesPerConnection.GetValueOnAnyThread();
+	if (BytesPerConnection > 0)
+	{
+		Result = MakeUnique<FHaversineByteBudgetTransferPolicy>(BytesPerConnection, MoveTemp(Result));
+	}
+	return Result;
+}
+
+void FHaversineTransferPolicyEngine::SetPolicy(TUniquePtr<IHaversineTransferPolicy> InPolicy)
+{
+	check(InPolicy);
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Collection transfer policy: %s"), *InPolicy->Describe());
+
+	TSharedPtr<IHaversineTransferPolicy, ESPMode::ThreadSafe> NewPolicy(InPolicy.Release());
+	FScopeLock Lock(&PolicyMutex);
+	Policy = MoveTemp(NewPolicy);
+}
+
+uint16 FHaversineTransferPolicyEngine::FirstCollectionToTransfer(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex)
+{
+	FHaversineTransferContext Context;
+	Context.SatelliteId = SatelliteId;
+	Context.StartIndex = StartIndex;
+	Context.EndIndex = EndIndex;
+	Context.NowUnixMs = FHaversineSatelliteStateCache::NowUnixMs();
+	Context.EstimatedCollectionBytes = EstimatedCollectionBytes.load(std::memory_order_relaxed);
+	Context.bHasHistory = StateCache && StateCache->Find(SatelliteId, Context.History);
+
+	const uint16 Offered = Context.NumAvailable();
+
+	// Never transfer again what a previous launch already received. Offsets from StartIndex survive the rollover.
+	if (Context.bHasHistory && Context.History.bHasTransferred)
+	{
+		const uint16 ReceivedOffset = static_cast<uint16>(Context.History.LastTransferredIndex + 1 - StartIndex);
+		if (ReceivedOffset <= Offered)
+		{
+			Context.StartIndex = static_cast<uint16>(StartIndex + ReceivedOffset);
+		}
+	}
+
+	TSharedPtr<IHaversineTransferPolicy, ESPMode::ThreadSafe> CurrentPolicy;
+	{
+		FScopeLock Lock(&PolicyMutex);
+		CurrentPolicy = Policy;
+	}
+
+	const uint16 Available = Context.NumAvailable();
+	const uint16 Requested = FMath::Min(CurrentPolicy->NumToTransfer(Context), Available);
+
+	Decisions.fetch_add(1, std::memory_order_relaxed);
+	CollectionsOffered.fetch_add(Offered, std::memory_order_relaxed);
+	CollectionsAlreadyReceived.fetch_add(Offered - Available, std::memory_order_relaxed);
+	CollectionsRequested.fetch_add(Requested, std::memory_order_relaxed);
+
+	if (Offered != Available || Requested != Available)
+	{
+		UE_LOG(LogHaversineSatellite, Log, TEXT("  → Satellite %s: %u offered, %u already received, transferring newest %u (%s)"),
+			*SatelliteId, Offered, Offered - Available, Requested, *CurrentPolicy->Describe());
+	}
+
+	return static_cast<uint16>(EndIndex - Requested);
+}
+
+void FHaversineTransferPolicyEngine::RecordTransferred(const FString& SatelliteId, uint16 CollectionIndex, int32 NumBytes)
+{
+	if (StateCache)
+	{
+		StateCache->RecordTransferred(SatelliteId, CollectionIndex);
+	}
+
+	CollectionsTransferred.fetch_add(1, std::memory_order_relaxed);
+	BytesTransferred.fetch_add(NumBytes, std::memory_order_relaxed);
+
+	// Moving average with weight 1/8; a lost update under contention only delays convergence
+	const int32 Previous = EstimatedCollectionBytes.load(std::memory_order_relaxed);
+	EstimatedCollectionBytes.store(FMath::Max(1, Previous + (NumBytes - Previous) / 8), std::memory_order_relaxed);
+}
+
+FHaversineTransferPolicyStats FHaversineTransferPolicyEngine::GetStats() const
+{
+	FHaversineTransferPolicyStats Stats;
+	Stats.Decisions = Decisions.load(std::memory_order_relaxed);
+	Stats.CollectionsOffered = CollectionsOffered.load(std::memory_order_relaxed);
+	Stats.CollectionsAlreadyReceived = CollectionsAlreadyReceived.load(std::memory_order_relaxed);
+	Stats.CollectionsRequested = CollectionsRequested.load(std::memory_order_relaxed);
+	Stats.CollectionsTransferred = CollectionsTransferred.load(std::memory_order_relaxed);
+	Stats.BytesTransferred = BytesTransferred.load(std::memory_order_relaxed);
+	return Stats;
+}
+
+void FHaversineTransferPolicyEngine::LogStats() const
+{
+	const FHaversineTransferPolicyStats Stats = GetStats();
+
+	FString PolicyName;
+	{
+		FScopeLock Lock(&PolicyMutex);
+		PolicyName = Policy->Describe();
+	}
+
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Transfer policy stats (%s): %llu connections | offered=%llu already-received=%llu requested=%llu transferred=%llu | %.1f swings/connection | avg %d bytes/collection"),
+		*PolicyName, Stats.Decisions, Stats.CollectionsOffered, Stats.CollectionsAlreadyReceived, Stats.CollectionsRequested,
+		Stats.CollectionsTransferred, Stats.Decisions > 0 ? static_cast<double>(Stats.CollectionsTransferred) / Stats.Decisions : 0.0,
+		EstimatedCollectionBytes.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,162 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HaversineSatelliteStateCache.h"
+#include <atomic>
+
+/**
+ * Everything a transfer policy may base its decision on.
+ *
+ * `StartIndex`..`EndIndex` is the half-open range of collections still waiting on the satellite. Collections a
+ * previous launch already received have been removed from it, so a policy only ever chooses among new ones.
+ */
+struct FHaversineTransferContext
+{
+	FString SatelliteId;
+	uint16 StartIndex = 0;
+	uint16 EndIndex = 0;
+
+	/** What the satellite state cache knows about this satellite, if anything */
+	bool bHasHistory = false;
+	FHaversineCachedSatelliteState History;
+
+	int64 NowUnixMs = 0;
+
+	/** Running average size of a transferred collection */
+	int32 EstimatedCollectionBytes = 0;
+
+	/** Number of collections in the range. Indexes roll over at 2^16, so this is not simply `EndIndex - StartIndex` in int. */
+	uint16 NumAvailable() const { return static_cast<uint16>(EndIndex - StartIndex); }
+};
+
+/**
+ * Decides how much of a satellite's backlog to transfer while connected.
+ *
+ * Satellites only transfer forwards, so the decision is expressed as a count of the newest collections; anything
+ * older than those is never offered again. Called on the SDK's Bluetooth thread, so implementations must be cheap
+ * and must not block.
+ */
+class IHaversineTransferPolicy
+{
+public:
+	virtual ~IHaversineTransferPolicy() = default;
+
+	/** @return how many of the newest collections to transfer, from 0 to `Context.NumAvailable()` */
+	virtual uint16 NumToTransfer(const FHaversineTransferContext& Context) const = 0;
+
+	virtual FString Describe() const = 0;
+};
+
+/** Transfer the whole backlog */
+class FHaversineDrainAllTransferPolicy : public IHaversineTransferPolicy
+{
+public:
+	virtual uint16 NumToTransfer(const FHaversineTransferContext& Context) const override;
+	virtual FString Describe() const override;
+};
+
+/** Transfer the newest `N` collections. `N = 1` is the original demo behaviour. */
+class FHaversineLastNTransferPolicy : public IHaversineTransferPolicy
+{
+public:
+	explicit FHaversineLastNTransferPolicy(uint16 InCount);
+
+	virtual uint16 NumToTransfer(const FHaversineTransferContext& Context) const override;
+	virtual FString Describe() const override;
+
+private:
+	uint16 Count;
+};
+
+/**
+ * Transfer the collections recorded within the last `MaxAgeSeconds`.
+ *
+ * Satellites do not report when a collection was recorded, so its age is estimated: the backlog is assumed to have
+ * built up evenly since the last transfer from this satellite. Without history every collection is taken, since
+ * nothing can be said about its age and a skipped collection is lost for good.
+ */
+class FHaversineMaxAgeTransferPolicy : public IHaversineTransferPolicy
+{
+public:
+	explicit FHaversineMaxAgeTransferPolicy(double InMaxAgeSeconds);
+
+	virtual uint16 NumToTransfer(const FHaversineTransferContext& Context) const override;
+	virtual FString Describe() const override;
+
+private:
+	double MaxAgeSeconds;
+};
+
+/**
+ * Caps another policy at what one connection can carry, measured in bytes.
+ *
+ * At least one collection is always transferred, so a budget smaller than a single collection still makes progress.
+ */
+class FHaversineByteBudgetTransferPolicy : public IHaversineTransferPolicy
+{
+public:
+	FHaversineByteBudgetTransferPolicy(int64 InBytesPerConnection, TUniquePtr<IHaversineTransferPolicy> InInner);
+
+	virtual uint16 NumToTransfer(const FHaversineTransferContext& Context) const override;
+	virtual FString Describe() const override;
+
+private:
+	int64 BytesPerConnection;
+	TUniquePtr<IHaversineTransferPolicy> Inner;
+};
+
+/** Counters for `FHaversineTransferPolicyEngine` */
+struct FHaversineTransferPolicyStats
+{
+	uint64 Decisions = 0;
+	uint64 CollectionsOffered = 0;
+	uint64 CollectionsAlreadyReceived = 0;
+	uint64 CollectionsRequested = 0;
+	uint64 CollectionsTransferred = 0;
+	uint64 BytesTransferred = 0;
+};
+
+/**
+ * Answers `first_collection_to_transfer` for the transfer delegate.
+ *
+ * It trims the offered range by the satellite's history in the state cache, asks the current policy how much of the
+ * rest to take, and records completed transfers back into the cache along with their size for the byte budget.
+ * The policy can be swapped at any time with `SetPolicy`. All methods are thread-safe.
+ */
+class FHaversineTransferPolicyEngine
+{
+public:
+	FHaversineTransferPolicyEngine(TUniquePtr<IHaversineTransferPolicy> InPolicy, FHaversineSatelliteStateCache* InStateCache);
+
+	/** Builds the policy selected by the `haversine.Transfer.*` console variables */
+	static TUniquePtr<IHaversineTransferPolicy> CreatePolicyFromConsoleVariables();
+
+	void SetPolicy(TUniquePtr<IHaversineTransferPolicy> InPolicy);
+
+	/** @return the index to start transferring from; `EndIndex` means transfer nothing */
+	uint16 FirstCollectionToTransfer(const FString& SatelliteId, uint16 StartIndex, uint16 EndIndex);
+
+	/** Call when a collection has been received */
+	void RecordTransferred(const FString& SatelliteId, uint16 CollectionIndex, int32 NumBytes);
+
+	FHaversineTransferPolicyStats GetStats() const;
+	void LogStats() const;
+
+private:
+	FHaversineSatelliteStateCache* StateCache;
+
+	mutable FCriticalSection PolicyMutex;
+	TSharedPtr<IHaversineTransferPolicy, ESPMode::ThreadSafe> Policy;
+
+	/** Exponential moving average of collection sizes, in bytes */
+	std::atomic<int32> EstimatedCollectionBytes;
+
+	std::atomic<uint64> Decisions{0};
+	std::atomic<uint64> CollectionsOffered{0};
+	std::atomic<uint64> CollectionsAlreadyReceived{0};
+	std::atomic<uint64> CollectionsRequested{0};
+	std::atomic<uint64> CollectionsTransferred{0};
+	std::atomic<uint64> BytesTransferred{0};
+};
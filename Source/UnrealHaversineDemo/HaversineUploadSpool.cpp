@@ -0,0 +1,678 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineUploadSpool.cpp
+// UnrealHaversineDemo
+//
+// Compressed on-disk queue of swings that could not be uploaded, drained in the background with backoff
+//
+
+#include "HaversineUploadSpool.h"
+#include "HaversineAuthTokenCache.h"
+#include "HaversineSwingReconstructor.h"
+#include "SuperTagKitPlugin.h"
+#include "Algo/BinarySearch.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<bool> CVarHaversineSpoolEnabled(
+	TEXT("haversine.Spool.Enabled"),
+	true,
+	TEXT("Spool swings that could not be uploaded to Saved/Haversine/UploadSpool and keep retrying them in the background. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineSpoolMaxSwings(
+	TEXT("haversine.Spool.MaxSwings"),
+	20000,
+	TEXT("Most swings kept in the upload spool; the oldest are dropped beyond this. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineSpoolMaxMB(
+	TEXT("haversine.Spool.MaxMB"),
+	256,
+	TEXT("Most disk space the upload spool uses, in MB; the oldest swings are dropped beyond this. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineSpoolBatchSize(
+	TEXT("haversine.Spool.BatchSize"),
+	16,
+	TEXT("Spooled swings sent per drain request. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineSpoolInitialBackoffSeconds(
+	TEXT("haversine.Spool.InitialBackoffSeconds"),
+	2.0f,
+	TEXT("Wait after a drain request gets nothing through. Doubles with each further one. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarHaversineSpoolMaxBackoffSeconds(
+	TEXT("haversine.Spool.MaxBackoffSeconds"),
+	300.0f,
+	TEXT("Longest wait between drain requests while uploads are not getting through. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarHaversineSpoolMaxRejections(
+	TEXT("haversine.Spool.MaxRejections"),
+	5,
+	TEXT("Times a spooled swing may be refused while others in its request get through before it is discarded. Read when the subsystem initializes."),
+	ECVF_ReadOnly);
+
+// Longest the drain thread sleeps before re-checking for swings and shutdown
+static constexpr uint32 MaxIdleWaitMs = 1000;
+
+// How long a swing whose token is still being fetched is passed over, and how soon the spool looks again when every
+// swing is waiting for one
+static constexpr double TokenWaitSeconds = 1.0;
+
+// How often the drain rate is re-measured
+static constexpr double DrainRateWindowSeconds = 5.0;
+
+namespace
+{
+	/** Followed by the UTF-8 satellite ID, the UTF-8 hardware ID and `StoredBytes` of payload */
+	struct FSpoolFileHeader
+	{
+		uint32 Magic;
+		uint32 Checksum;
+		uint32 RawBytes;
+		uint32 StoredBytes;
+		uint16 CollectionIndex;
+		uint16 SatelliteIdBytes;
+		uint16 HardwareIdBytes;
+		uint8 bCompressed;
+		uint8 Version;
+	};
+	static_assert(sizeof(FSpoolFileHeader) == 24, "Spool file header layout is part of the file format");
+
+	constexpr uint32 SpoolMagic = 0x53564148; // "HAVS"
+	constexpr uint8 SpoolVersion = 1;
+	const TCHAR* SpoolExtension = TEXT(".hvspool");
+
+	/** CRC of the header (everything after `Checksum`) followed by the body */
+	uint32 ComputeChecksum(const FSpoolFileHeader& Header, const uint8* Body)
+	{
+		const uint8* HeaderBytes = reinterpret_cast<const uint8*>(&Header);
+		constexpr int32 Skip = sizeof(Header.Magic) + sizeof(Header.Checksum);
+		const uint32 Crc = FCrc::MemCrc32(HeaderBytes + Skip, sizeof(Header) - Skip);
+		return FCrc::MemCrc32(Body, Header.SatelliteIdBytes + Header.HardwareIdBytes + Header.StoredBytes, Crc);
+	}
+}
+
+FHaversineUploadSpoolConfig FHaversineUploadSpoolConfig::FromConsoleVariables()
+{
+	FHaversineUploadSpoolConfig Result;
+	Result.bEnabled = CVarHaversineSpoolEnabled.GetValueOnAnyThread();
+	Result.MaxSwings = FMath::Max(1, CVarHaversineSpoolMaxSwings.GetValueOnAnyThread());
+	Result.MaxBytes = FMath::Max(1, CVarHaversineSpoolMaxMB.GetValueOnAnyThread()) * 1024ll * 1024ll;
+	Result.BatchSize = FMath::Max(1, CVarHaversineSpoolBatchSize.GetValueOnAnyThread());
+	Result.InitialBackoffSeconds = FMath::Max(0.1f, CVarHaversineSpoolInitialBackoffSeconds.GetValueOnAnyThread());
+	Result.MaxBackoffSeconds = FMath::Max(Result.InitialBackoffSeconds, CVarHaversineSpoolMaxBackoffSeconds.GetValueOnAnyThread());
+	Result.MaxRejections = FMath::Max(1, CVarHaversineSpoolMaxRejections.GetValueOnAnyThread());
+	return Result;
+}
+
+FHaversineUploadSpool::FHaversineUploadSpool(const FString& InDirectory, const FHaversineUploadSpoolConfig& InConfig,
+	TSharedRef<IHaversineSwingUploadTransport, ESPMode::ThreadSafe> InTransport, USuperTagAuthenticationManager* InAuthManager,
+	TSharedRef<FHaversineAuthTokenCache, ESPMode::ThreadSafe> InTokenCache)
+	: Directory(InDirectory)
+	, Config(InConfig)
+	, Transport(MoveTemp(InTransport))
+	, AuthManager(InAuthManager)
+	, TokenCache(MoveTemp(InTokenCache))
+{
+}
+
+FHaversineUploadSpool::~FHaversineUploadSpool()
+{
+	Shutdown();
+}
+
+FString FHaversineUploadSpool::GetDefaultDirectory(bool bSimulatedFleet)
+{
+	return bSimulatedFleet
+		? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Haversine"), TEXT("Simulated"), TEXT("UploadSpool"))
+		: FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Haversine"), TEXT("UploadSpool"));
+}
+
+FString FHaversineUploadSpool::GetFilename(uint64 Id) const
+{
+	return FPaths::Combine(Directory, FString::Printf(TEXT("%016llx%s"), Id, SpoolExtension));
+}
+
+void FHaversineUploadSpool::Start()
+{
+	if (Thread)
+	{
+		return;
+	}
+
+	bStopRequested = false;
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("HaversineUploadSpool"), 0, TPri_BelowNormal);
+}
+
+void FHaversineUploadSpool::Shutdown()
+{
+	if (!Thread)
+	{
+		return;
+	}
+
+	{
+		FScopeLock Lock(&IndexMutex);
+		bAccepting = false;
+	}
+
+	bStopRequested = true;
+	WakeEvent->Trigger();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+void FHaversineUploadSpool::DrainNow()
+{
+	bDrainNow = true;
+	FScopeLock Lock(&IndexMutex);
+	if (bAccepting)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+bool FHaversineUploadSpool::Add(const FHaversineSwingUpload& Upload)
+{
+	if (!Upload.Collection.IsValid())
+	{
+		return false;
+	}
+
+	// Compression and the write happen outside the lock; only the ID and the index need it
+	const TConstArrayView<uint8> Raw = Upload.Collection->GetView();
+	TArray<uint8> Compressed;
+	int64 CompressedBytes = FCompression::CompressMemoryBound(NAME_Oodle, Raw.Num());
+	Compressed.SetNumUninitialized(CompressedBytes);
+	const bool bCompressed = FCompression::CompressMemory(NAME_Oodle, Compressed.GetData(), CompressedBytes, Raw.GetData(), Raw.Num(), COMPRESS_BiasSpeed)
+		&& CompressedBytes < Raw.Num();
+	const TConstArrayView<uint8> Stored = bCompressed ? TConstArrayView<uint8>(Compressed.GetData(), CompressedBytes) : Raw;
+
+	FTCHARToUTF8 SatelliteIdUtf8(*Upload.SatelliteId);
+	FTCHARToUTF8 HardwareIdUtf8(*Upload.HardwareId);
+
+	FSpoolFileHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = SpoolMagic;
+	Header.RawBytes = static_cast<uint32>(Raw.Num());
+	Header.StoredBytes = static_cast<uint32>(Stored.Num());
+	Header.CollectionIndex = Upload.CollectionIndex;
+	Header.SatelliteIdBytes = static_cast<uint16>(SatelliteIdUtf8.Length());
+	Header.HardwareIdBytes = static_cast<uint16>(HardwareIdUtf8.Length());
+	Header.bCompressed = bCompressed ? 1 : 0;
+	Header.Version = SpoolVersion;
+
+	TArray<uint8> Bytes;
+	Bytes.Reserve(sizeof(Header) + Header.SatelliteIdBytes + Header.HardwareIdBytes + Header.StoredBytes);
+	Bytes.AddZeroed(sizeof(Header));
+	Bytes.Append(reinterpret_cast<const uint8*>(SatelliteIdUtf8.Get()), Header.SatelliteIdBytes);
+	Bytes.Append(reinterpret_cast<const uint8*>(HardwareIdUtf8.Get()), Header.HardwareIdBytes);
+	Bytes.Append(Stored.GetData(), Header.StoredBytes);
+	Header.Checksum = ComputeChecksum(Header, Bytes.GetData() + sizeof(Header));
+	FMemory::Memcpy(Bytes.GetData(), &Header, sizeof(Header));
+
+	uint64 Id = 0;
+	{
+		FScopeLock Lock(&IndexMutex);
+		if (!bAccepting)
+		{
+			return false;
+		}
+		Id = NextId++;
+	}
+
+	// Written aside and renamed into place, so a crash mid-write never leaves a torn swing in the spool
+	const FString Filename = GetFilename(Id);
+	const FString TempFilename = Filename + TEXT(".tmp");
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!FFileHelper::SaveArrayToFile(Bytes, *TempFilename) || !PlatformFile.MoveFile(*Filename, *TempFilename))
+	{
+		PlatformFile.DeleteFile(*TempFilename);
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Could not spool swing %d from satellite %s to %s"), Upload.CollectionIndex, *Upload.SatelliteId, *Filename);
+		return false;
+	}
+
+	Spooled.fetch_add(1, std::memory_order_relaxed);
+
+	FScopeLock Lock(&IndexMutex);
+	FEntry Entry;
+	Entry.Id = Id;
+	Entry.StoredBytes = Bytes.Num();
+	Entry.RawBytes = Raw.Num();
+	Entry.HardwareId = Upload.HardwareId;
+	Entries.Insert(Entry, Algo::LowerBoundBy(Entries, Id, &FEntry::Id));
+	StoredBytes += Entry.StoredBytes;
+	RawBytes += Entry.RawBytes;
+	EnforceBoundsLocked();
+
+	// The file is on disk either way; a spool that has just shut down finds it at the next launch
+	if (bAccepting)
+	{
+		WakeEvent->Trigger();
+	}
+	return true;
+}
+
+void FHaversineUploadSpool::EnforceBoundsLocked()
+{
+	int32 NumDropped = 0;
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	while (!Entries.IsEmpty() && (Entries.Num() > Config.MaxSwings || StoredBytes > Config.MaxBytes))
+	{
+		const FEntry& Oldest = Entries[0];
+		PlatformFile.DeleteFile(*GetFilename(Oldest.Id));
+		StoredBytes -= Oldest.StoredBytes;
+		RawBytes -= Oldest.RawBytes;
+		Entries.RemoveAt(0, 1, EAllowShrinking::No);
+		++NumDropped;
+	}
+
+	if (NumDropped > 0)
+	{
+		Dropped.fetch_add(NumDropped, std::memory_order_relaxed);
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Upload spool full (%d swings, %.1f MB); dropped the oldest %d"),
+			Entries.Num(), StoredBytes / (1024.0 * 1024.0), NumDropped);
+	}
+}
+
+void FHaversineUploadSpool::Scan()
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*Directory);
+
+	// Leftovers of writes a crash interrupted
+	TArray<FString> TempFilenames;
+	IFileManager::Get().FindFiles(TempFilenames, *FPaths::Combine(Directory, FString(TEXT("*")) + SpoolExtension + TEXT(".tmp")), /*Files*/ true, /*Directories*/ false);
+	for (const FString& TempFilename : TempFilenames)
+	{
+		PlatformFile.DeleteFile(*FPaths::Combine(Directory, TempFilename));
+	}
+
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *FPaths::Combine(Directory, FString(TEXT("*")) + SpoolExtension), /*Files*/ true, /*Directories*/ false);
+
+	TArray<FEntry> Found;
+	Found.Reserve(Filenames.Num());
+	for (const FString& Filename : Filenames)
+	{
+		const FString Path = FPaths::Combine(Directory, Filename);
+		// The hardware ID is read as well, so token lookups never need the file
+		FSpoolFileHeader Header;
+		TArray<uint8> HardwareIdBytes;
+		TUniquePtr<IFileHandle> Handle(PlatformFile.OpenRead(*Path));
+		bool bValid = Handle && Handle->Read(reinterpret_cast<uint8*>(&Header), sizeof(Header)) && Header.Magic == SpoolMagic;
+		if (bValid)
+		{
+			HardwareIdBytes.SetNumUninitialized(Header.HardwareIdBytes);
+			bValid = Handle->Seek(sizeof(Header) + Header.SatelliteIdBytes) && Handle->Read(HardwareIdBytes.GetData(), HardwareIdBytes.Num());
+		}
+		if (!bValid)
+		{
+			Handle.Reset();
+			PlatformFile.DeleteFile(*Path);
+			Discarded.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+
+		FEntry& Entry = Found.AddDefaulted_GetRef();
+		Entry.Id = FCString::Strtoui64(*FPaths::GetBaseFilename(Filename), nullptr, 16);
+		Entry.StoredBytes = Handle->Size();
+		Entry.RawBytes = Header.RawBytes;
+		Entry.HardwareId = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(HardwareIdBytes.GetData()), HardwareIdBytes.Num()));
+	}
+	Found.Sort([](const FEntry& A, const FEntry& B) { return A.Id < B.Id; });
+
+	FScopeLock Lock(&IndexMutex);
+	Entries = MoveTemp(Found);
+	for (const FEntry& Entry : Entries)
+	{
+		StoredBytes += Entry.StoredBytes;
+		RawBytes += Entry.RawBytes;
+	}
+	NextId = Entries.IsEmpty() ? 1 : Entries.Last().Id + 1;
+	EnforceBoundsLocked();
+	bAccepting = !bStopRequested;
+
+	UE_LOG(LogHaversineSatellite, Log, TEXT("Upload spool started: %d swings (%.1f MB) waiting from earlier sessions in %s"),
+		Entries.Num(), StoredBytes / (1024.0 * 1024.0), *Directory);
+}
+
+bool FHaversineUploadSpool::Load(uint64 Id, FHaversineSwingUpload& OutUpload) const
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *GetFilename(Id), FILEREAD_Silent) || Bytes.Num() < static_cast<int32>(sizeof(FSpoolFileHeader)))
+	{
+		return false;
+	}
+
+	FSpoolFileHeader Header;
+	FMemory::Memcpy(&Header, Bytes.GetData(), sizeof(Header));
+	const uint8* Body = Bytes.GetData() + sizeof(Header);
+	if (Header.Magic != SpoolMagic || Header.Version != SpoolVersion
+		|| sizeof(Header) + Header.SatelliteIdBytes + Header.HardwareIdBytes + Header.StoredBytes != static_cast<uint64>(Bytes.Num())
+		|| Header.Checksum != ComputeChecksum(Header, Body))
+	{
+		return false;
+	}
+
+	const uint8* SatelliteIdBytes = Body;
+	const uint8* HardwareIdBytes = SatelliteIdBytes + Header.SatelliteIdBytes;
+	const uint8* Stored = HardwareIdBytes + Header.HardwareIdBytes;
+
+	std::vector<uint8_t> Payload(Header.RawBytes);
+	bool bDecoded = false;
+	if (Header.bCompressed)
+	{
+		bDecoded = FCompression::UncompressMemory(NAME_Oodle, Payload.data(), Header.RawBytes, Stored, Header.StoredBytes);
+	}
+	else if (Header.RawBytes == Header.StoredBytes)
+	{
+		FMemory::Memcpy(Payload.data(), Stored, Header.RawBytes);
+		bDecoded = true;
+	}
+	if (!bDecoded)
+	{
+		return false;
+	}
+
+	OutUpload.SatelliteId = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(SatelliteIdBytes), Header.SatelliteIdBytes));
+	OutUpload.HardwareId = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(HardwareIdBytes), Header.HardwareIdBytes));
+	OutUpload.CollectionIndex = Header.CollectionIndex;
+	OutUpload.Collection = FHaversineCollectionBuffer::Create(MoveTemp(Payload));
+	return true;
+}
+
+void FHaversineUploadSpool::Remove(uint64 Id)
+{
+	{
+		FScopeLock Lock(&IndexMutex);
+		const int32 Index = Algo::BinarySearchBy(Entries, Id, &FEntry::Id);
+		if (Index != INDEX_NONE)
+		{
+			StoredBytes -= Entries[Index].StoredBytes;
+			RawBytes -= Entries[Index].RawBytes;
+			Entries.RemoveAt(Index, 1, EAllowShrinking::No);
+		}
+	}
+	FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*GetFilename(Id));
+}
+
+//
+// Drain thread
+//
+
+uint32 FHaversineUploadSpool::Run()
+{
+	Scan();
+
+	double NextAttemptSeconds = 0.0;
+	double Backoff = 0.0;
+	while (!bStopRequested)
+	{
+		const double NowSeconds = FPlatformTime::Seconds();
+		UpdateDrainRate(NowSeconds);
+
+		if (bDrainNow.exchange(false))
+		{
+			NextAttemptSeconds = NowSeconds;
+		}
+
+		bool bEmpty = false;
+		{
+			FScopeLock Lock(&IndexMutex);
+			bEmpty = Entries.IsEmpty();
+		}
+
+		if (bEmpty || NowSeconds < NextAttemptSeconds)
+		{
+			const double WaitMs = bEmpty ? MaxIdleWaitMs : (NextAttemptSeconds - NowSeconds) * 1000.0;
+			WakeEvent->Wait(static_cast<uint32>(FMath::Clamp(WaitMs, 1.0, static_cast<double>(MaxIdleWaitMs))));
+			continue;
+		}
+
+		const EDrainResult Result = DrainBatch();
+		if (Result == EDrainResult::Progressed)
+		{
+			if (Backoff > 0.0)
+			{
+				FScopeLock Lock(&IndexMutex);
+				UE_LOG(LogHaversineSatellite, Log, TEXT("✓ Upload spool: uploads are getting through again, draining %d swings"), Entries.Num());
+			}
+			Backoff = 0.0;
+			NextAttemptSeconds = 0.0;
+		}
+		else if (Result == EDrainResult::WaitingForTokens)
+		{
+			// Not an outage (tokens are still being fetched at startup, or belong to other hardware); look again soon
+			NextAttemptSeconds = FPlatformTime::Seconds() + TokenWaitSeconds;
+		}
+		else if (!bStopRequested)
+		{
+			Backoff = Backoff > 0.0 ? FMath::Min(Backoff * 2.0, static_cast<double>(Config.MaxBackoffSeconds)) : Config.InitialBackoffSeconds;
+			NextAttemptSeconds = FPlatformTime::Seconds() + Backoff;
+			if (Backoff == Config.InitialBackoffSeconds)
+			{
+				FScopeLock Lock(&IndexMutex);
+				UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Upload spool: SkyGolf unreachable, %d swings waiting; retrying with backoff"), Entries.Num());
+			}
+		}
+		BackoffSeconds.store(Backoff, std::memory_order_relaxed);
+	}
+	return 0;
+}
+
+FHaversineUploadSpool::EDrainResult FHaversineUploadSpool::DrainBatch()
+{
+	// The oldest swings not passed over for want of a token
+	const double NowSeconds = FPlatformTime::Seconds();
+	TArray<FEntry> Candidates;
+	{
+		FScopeLock Lock(&IndexMutex);
+		for (int32 Index = 0; Index < Entries.Num() && Candidates.Num() < Config.BatchSize; ++Index)
+		{
+			if (Entries[Index].RetryNotBeforeSeconds <= NowSeconds)
+			{
+				Candidates.Add(Entries[Index]);
+			}
+		}
+	}
+
+	// Tokens are short-lived, so they are looked up now rather than kept on disk; the swing itself is reconstructed
+	// again only for transports that upload it rather than the raw collection
+	TArray<FHaversineSwingUploadRef> Batch;
+	TArray<uint64> BatchIds;
+	bool bDiscardedAny = false;
+	for (const FEntry& Candidate : Candidates)
+	{
+		FString AuthToken;
+		const EHaversineTokenLookup Lookup = TokenCache->Lookup(Candidate.HardwareId, AuthToken);
+		if (Lookup != EHaversineTokenLookup::Found)
+		{
+			// Passed over so the swings behind it can go: briefly while a fetch is in flight, for longer and longer
+			// while fetches fail. The token cache paces the fetches themselves.
+			FScopeLock Lock(&IndexMutex);
+			const int32 EntryIndex = Algo::BinarySearchBy(Entries, Candidate.Id, &FEntry::Id);
+			if (EntryIndex != INDEX_NONE)
+			{
+				FEntry& Entry = Entries[EntryIndex];
+				const double WaitSeconds = Lookup == EHaversineTokenLookup::Pending
+					? TokenWaitSeconds
+					: FMath::Min(Config.InitialBackoffSeconds * FMath::Pow(2.0, FMath::Min(Entry.TokenMisses, 16)), static_cast<double>(Config.MaxBackoffSeconds));
+				++Entry.TokenMisses;
+				Entry.RetryNotBeforeSeconds = NowSeconds + WaitSeconds;
+			}
+			continue;
+		}
+
+		FHaversineSwingUploadRef Upload = MakeShared<FHaversineSwingUpload, ESPMode::ThreadSafe>();
+		if (!Load(Candidate.Id, *Upload))
+		{
+			UE_LOG(LogHaversineSatellite, Warning, TEXT("⚠ Upload spool: discarding unreadable %s"), *GetFilename(Candidate.Id));
+			Remove(Candidate.Id);
+			Discarded.fetch_add(1, std::memory_order_relaxed);
+			bDiscardedAny = true;
+			continue;
+		}
+		Upload->AuthToken = MoveTemp(AuthToken);
+
+		if (Transport->NeedsReconstructedSwing())
+		{
+			Upload->Swing = FHaversineSwingReconstructor::Reconstruct(AuthManager, Upload->Collection.ToSharedRef(), Upload->AuthToken);
+			if (!Upload->Swing->IsValid())
+			{
+				UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ Spooled swing %d from satellite %s failed reconstruction, discarded"), Upload->CollectionIndex, *Upload->SatelliteId);
+				Remove(Candidate.Id);
+				Discarded.fetch_add(1, std::memory_order_relaxed);
+				bDiscardedAny = true;
+				continue;
+			}
+		}
+
+		Upload->Attempts = 1;
+		Upload->EnqueueCycles = FPlatformTime::Cycles64();
+		Batch.Add(Upload);
+		BatchIds.Add(Candidate.Id);
+	}
+
+	if (Batch.IsEmpty())
+	{
+		return bDiscardedAny ? EDrainResult::Progressed : EDrainResult::WaitingForTokens;
+	}
+
+	// The transport completes on its own threads; the request state outlives this call in case shutdown stops the wait
+	struct FRequest
+	{
+		TArray<FHaversineSwingUploadResult> Results;
+		std::atomic<bool> bCompleted{false};
+	};
+	TSharedRef<FRequest, ESPMode::ThreadSafe> Request = MakeShared<FRequest, ESPMode::ThreadSafe>();
+	Transport->SendBatch(Batch, [Request](TArray<FHaversineSwingUploadResult>&& Results)
+	{
+		Request->Results = MoveTemp(Results);
+		Request->bCompleted.store(true, std::memory_order_release);
+	});
+
+	while (!Request->bCompleted.load(std::memory_order_acquire))
+	{
+		if (bStopRequested)
+		{
+			// The files stay; whatever this request achieves is found out at the next launch
+			return EDrainResult::Failed;
+		}
+		FPlatformProcess::Sleep(0.005f);
+	}
+
+	Requests.fetch_add(1, std::memory_order_relaxed);
+	const TArray<FHaversineSwingUploadResult>& Results = Request->Results;
+
+	int32 NumUploaded = 0;
+	for (int32 Index = 0; Index < Batch.Num(); ++Index)
+	{
+		if (Results.IsValidIndex(Index) && Results[Index].bSuccess)
+		{
+			Remove(BatchIds[Index]);
+			++NumUploaded;
+		}
+	}
+
+	if (NumUploaded == 0)
+	{
+		FailedRequests.fetch_add(1, std::memory_order_relaxed);
+		return EDrainResult::Failed;
+	}
+	Drained.fetch_add(NumUploaded, std::memory_order_relaxed);
+
+	// Others got through, so these were refused for what they are; give up on a swing that keeps being refused
+	for (int32 Index = 0; Index < Batch.Num(); ++Index)
+	{
+		if (Results.IsValidIndex(Index) && Results[Index].bSuccess)
+		{
+			continue;
+		}
+
+		bool bDiscard = false;
+		{
+			FScopeLock Lock(&IndexMutex);
+			const int32 EntryIndex = Algo::BinarySearchBy(Entries, BatchIds[Index], &FEntry::Id);
+			bDiscard = EntryIndex != INDEX_NONE && ++Entries[EntryIndex].Rejections >= Config.MaxRejections;
+		}
+		if (bDiscard)
+		{
+			UE_LOG(LogHaversineSatellite, Error, TEXT("  ✗ Spooled swing %d from satellite %s refused %d times, discarded: %s"),
+				Batch[Index]->CollectionIndex, *Batch[Index]->SatelliteId, Config.MaxRejections,
+				Results.IsValidIndex(Index) ? *Results[Index].ErrorMessage : TEXT("no result"));
+			Remove(BatchIds[Index]);
+			Discarded.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	return EDrainResult::Progressed;
+}
+
+void FHaversineUploadSpool::UpdateDrainRate(double NowSeconds)
+{
+	if (RateWindowStartSeconds <= 0.0)
+	{
+		RateWindowStartSeconds = NowSeconds;
+		RateWindowStartDrained = Drained.load(std::memory_order_relaxed);
+		return;
+	}
+
+	const double Elapsed = NowSeconds - RateWindowStartSeconds;
+	if (Elapsed >= DrainRateWindowSeconds)
+	{
+		const uint64 NowDrained = Drained.load(std::memory_order_relaxed);
+		DrainPerSecond.store((NowDrained - RateWindowStartDrained) / Elapsed, std::memory_order_relaxed);
+		RateWindowStartSeconds = NowSeconds;
+		RateWindowStartDrained = NowDrained;
+	}
+}
+
+FHaversineUploadSpoolStats FHaversineUploadSpool::GetStats() const
+{
+	FHaversineUploadSpoolStats Result;
+	{
+		FScopeLock Lock(&IndexMutex);
+		Result.Swings = Entries.Num();
+		Result.StoredBytes = StoredBytes;
+		Result.RawBytes = RawBytes;
+	}
+	Result.Spooled = Spooled.load(std::memory_order_relaxed);
+	Result.Drained = Drained.load(std::memory_order_relaxed);
+	Result.Dropped = Dropped.load(std::memory_order_relaxed);
+	Result.Discarded = Discarded.load(std::memory_order_relaxed);
+	Result.Requests = Requests.load(std::memory_order_relaxed);
+	Result.FailedRequests = FailedRequests.load(std::memory_order_relaxed);
+	Result.BackoffSeconds = BackoffSeconds.load(std::memory_order_relaxed);
+	Result.DrainPerSecond = DrainPerSecond.load(std::memory_order_relaxed);
+	return Result;
+}
+
+void FHaversineUploadSpool::LogStats() const
+{
+	const FHaversineUploadSpoolStats Current = GetStats();
+	UE_LOG(LogHaversineSatellite, Log,
+		TEXT("Upload spool stats: backlog=%d swings (%.1f KB on disk, %.1f KB raw) | spooled=%llu drained=%llu dropped=%llu discarded=%llu | requests=%llu failed=%llu | backoff %.1f s | drain %.1f swings/s"),
+		Current.Swings, Current.StoredBytes / 1024.0, Current.RawBytes / 1024.0, Current.Spooled, Current.Drained, Current.Dropped,
+		Current.Discarded, Current.Requests, Current.FailedRequests, Current.BackoffSeconds, Current.DrainPerSecond);
+}
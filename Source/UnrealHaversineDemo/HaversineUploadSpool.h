@@ -0,0 +1,191 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HaversineSwingUploadQueue.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+class FHaversineAuthTokenCache;
+class USuperTagAuthenticationManager;
+
+struct FHaversineUploadSpoolConfig
+{
+	bool bEnabled = true;
+
+	/** Spooling past either bound pushes out the oldest swings */
+	int32 MaxSwings = 20000;
+	int64 MaxBytes = 256ll * 1024 * 1024;
+
+	/** Swings sent per drain request */
+	int32 BatchSize = 16;
+
+	/** Wait after a drain request gets nothing through; doubles with every further one, up to `MaxBackoffSeconds` */
+	float InitialBackoffSeconds = 2.0f;
+	float MaxBackoffSeconds = 300.0f;
+
+	/** A swing refused this many times while others in its request went through is discarded */
+	int32 MaxRejections = 5;
+
+	/** Reads `haversine.Spool.*` console variables */
+	static FHaversineUploadSpoolConfig FromConsoleVariables();
+};
+
+/** Point-in-time counters for `FHaversineUploadSpool` */
+struct FHaversineUploadSpoolStats
+{
+	/** Swings on disk now, their size there and before compression */
+	int32 Swings = 0;
+	int64 StoredBytes = 0;
+	int64 RawBytes = 0;
+
+	uint64 Spooled = 0;
+	uint64 Drained = 0;
+
+	/** Pushed out by the size bounds */
+	uint64 Dropped = 0;
+
+	/** Unreadable, failed reconstruction, or refused `MaxRejections` times */
+	uint64 Discarded = 0;
+
+	uint64 Requests = 0;
+	uint64 FailedRequests = 0;
+
+	/** Current wait between drain requests; 0 while they are getting through */
+	double BackoffSeconds = 0.0;
+
+	/** Swings uploaded per second over the last few seconds */
+	double DrainPerSecond = 0.0;
+};
+
+/**
+ * Bounded on-disk queue of swings the upload queue could not deliver, drained in the background.
+ *
+ * When SkyGolf is unreachable the upload queue retries a satellite's swings a few times and then gives up; the same
+ * happens to swings still waiting when the session ends. With a spool attached (`FHaversineSwingUploadQueue::SetSpool`)
+ * those swings are handed here instead: each is Oodle-compressed and written to its own file under
+ * Saved/Haversine/UploadSpool, so a swing is safe once `Add` returns and is removed only once it has been uploaded.
+ *
+ * A drain thread sends the oldest swings, `BatchSize` at a time, through the same transport as the upload queue.
+ * While nothing gets through it backs off exponentially from `InitialBackoffSeconds` to `MaxBackoffSeconds`; the
+ * first request that does resets the backoff and the spool drains at full rate. Tokens come from the token cache and
+ * swings are reconstructed again when the transport needs them, so nothing short-lived is kept on disk. A swing whose
+ * token is not available yet is passed over for a while instead of holding up the swings behind it, and waiting for
+ * tokens (as at every startup) does not count as an outage.
+ * Swings left over from an earlier launch are found when the spool starts and drained like the rest.
+ */
+class FHaversineUploadSpool : public FRunnable
+{
+public:
+	FHaversineUploadSpool(const FString& InDirectory, const FHaversineUploadSpoolConfig& InConfig,
+		TSharedRef<IHaversineSwingUploadTransport, ESPMode::ThreadSafe> InTransport, USuperTagAuthenticationManager* InAuthManager,
+		TSharedRef<FHaversineAuthTokenCache, ESPMode::ThreadSafe> InTokenCache);
+	virtual ~FHaversineUploadSpool() override;
+
+	FHaversineUploadSpool(const FHaversineUploadSpool&) = delete;
+	FHaversineUploadSpool& operator=(const FHaversineUploadSpool&) = delete;
+
+	/** Saved/Haversine/UploadSpool, or Saved/Haversine/Simulated/UploadSpool for a simulated fleet */
+	static FString GetDefaultDirectory(bool bSimulatedFleet = false);
+
+	/** Starts the drain thread, which first picks up swings spooled by earlier launches */
+	void Start();
+
+	/** Stops draining and joins the drain thread. Spooled swings stay on disk for the next launch. */
+	void Shutdown();
+
+	/**
+	 * Compress a swing and write it to the spool. Safe to call from any thread.
+	 * @return false if the spool is shut down or the swing could not be written
+	 */
+	bool Add(const FHaversineSwingUpload& Upload);
+
+	/** Forget the backoff and try to drain now, e.g. once connectivity is known to be back */
+	void DrainNow();
+
+	FHaversineUploadSpoolStats GetStats() const;
+	void LogStats() const;
+
+	// FRunnable interface (drain thread)
+	virtual uint32 Run() override;
+
+private:
+	/** A spooled swing, as indexed in memory */
+	struct FEntry
+	{
+		uint64 Id = 0;
+		int64 StoredBytes = 0;
+		int64 RawBytes = 0;
+		int32 Rejections = 0;
+
+		/** Kept in memory so a swing whose token is not available yet is passed over without reading its file */
+		FString HardwareId;
+
+		/** Lookups that found no token, and when the swing is next looked at */
+		int32 TokenMisses = 0;
+		double RetryNotBeforeSeconds = 0.0;
+	};
+
+	enum class EDrainResult : uint8
+	{
+		Progressed,			// Swings were uploaded or discarded; keep draining
+		WaitingForTokens,	// Nothing could be sent yet for want of tokens; not an outage
+		Failed,				// A request got nothing through; back off
+	};
+
+	/** Indexes spool files left by earlier launches */
+	void Scan();
+
+	/**
+	 * Sends the oldest swings that have a token, once. Swings without one are passed over for a while, so they never
+	 * hold up the rest of the spool.
+	 */
+	EDrainResult DrainBatch();
+
+	/** Reads and decompresses a spool file. @return false if it is missing or corrupt. */
+	bool Load(uint64 Id, FHaversineSwingUpload& OutUpload) const;
+
+	/** Deletes the swing's file and drops it from the index */
+	void Remove(uint64 Id);
+
+	/** Pushes out the oldest swings until the spool is within its bounds. `IndexMutex` must be held. */
+	void EnforceBoundsLocked();
+
+	FString GetFilename(uint64 Id) const;
+	void UpdateDrainRate(double NowSeconds);
+
+	FString Directory;
+	FHaversineUploadSpoolConfig Config;
+	TSharedRef<IHaversineSwingUploadTransport, ESPMode::ThreadSafe> Transport;
+	USuperTagAuthenticationManager* AuthManager;
+	TSharedRef<FHaversineAuthTokenCache, ESPMode::ThreadSafe> TokenCache;
+
+	// Guards the index and its totals; never held during file IO of the drain thread or while sending
+	mutable FCriticalSection IndexMutex;
+	TArray<FEntry> Entries;
+	uint64 NextId = 1;
+	int64 StoredBytes = 0;
+	int64 RawBytes = 0;
+	bool bAccepting = false;
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeEvent = nullptr;
+	std::atomic<bool> bStopRequested{false};
+	std::atomic<bool> bDrainNow{false};
+
+	std::atomic<uint64> Spooled{0};
+	std::atomic<uint64> Drained{0};
+	std::atomic<uint64> Dropped{0};
+	std::atomic<uint64> Discarded{0};
+	std::atomic<uint64> Requests{0};
+	std::atomic<uint64> FailedRequests{0};
+	std::atomic<double> BackoffSeconds{0.0};
+	std::atomic<double> DrainPerSecond{0.0};
+
+	// Drain thread only
+	double RateWindowStartSeconds = 0.0;
+	uint64 RateWindowStartDrained = 0;
+};
@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+//
+// HaversineWaitForSwingAction.cpp
+// UnrealHaversineDemo
+//
+// "Wait For Next Swing From User" latent Blueprint node
+//
+
+#include "HaversineWaitForSwingAction.h"
+#include "HaversineDemoSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+UHaversineWaitForSwingAction* UHaversineWaitForSwingAction::WaitForNextSwingFromUser(UObject* WorldContextObject, int64 UserId, float TimeoutSeconds)
+{
+	UHaversineWaitForSwingAction* Action = NewObject<UHaversineWaitForSwingAction>();
+	Action->UserId = UserId;
+	Action->TimeoutSeconds = TimeoutSeconds;
+
+	const UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull) : nullptr;
+	if (UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr)
+	{
+		Action->Subsystem = GameInstance->GetSubsystem<UHaversineDemoSubsystem>();
+		Action->RegisterWithGameInstance(GameInstance);
+	}
+	return Action;
+}
+
+void UHaversineWaitForSwingAction::Activate()
+{
+	UHaversineDemoSubsystem* HaversineSubsystem = Subsystem.Get();
+	if (!HaversineSubsystem)
+	{
+		UE_LOG(LogHaversineSatellite, Warning, TEXT("Wait For Next Swing From User: the Haversine subsystem is not running"));
+		OnTimedOut.Broadcast(FHaversineSwingEvent());
+		Finish();
+		return;
+	}
+
+	HaversineSubsystem->OnSwingsProcessed.AddDynamic(this, &UHaversineWaitForSwingAction::HandleSwings);
+	if (TimeoutSeconds > 0.0f)
+	{
+		TimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UHaversineWaitForSwingAction::HandleTimeout), TimeoutSeconds);
+	}
+}
+
+void UHaversineWaitForSwingAction::HandleSwings(const TArray<FHaversineSwingEvent>& Swings)
+{
+	for (const FHaversineSwingEvent& Swing : Swings)
+	{
+		if (UserId == 0 || Swing.UserId == UserId)
+		{
+			OnSwing.Broadcast(Swing);
+			Finish();
+			return;
+		}
+	}
+}
+
+bool UHaversineWaitForSwingAction::HandleTimeout(float DeltaTime)
+{
+	TimeoutHandle.Reset();
+	OnTimedOut.Broadcast(FHaversineSwingEvent());
+	Finish();
+	return false;
+}
+
+void UHaversineWaitForSwingAction::Finish()
+{
+	if (TimeoutHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TimeoutHandle);
+		TimeoutHandle.Reset();
+	}
+	if (UHaversineDemoSubsystem* HaversineSubsystem = Subsystem.Get())
+	{
+		HaversineSubsystem->OnSwingsProcessed.RemoveDynamic(this, &UHaversineWaitForSwingAction::HandleSwings);
+	}
+	SetReadyToDestroy();
+}
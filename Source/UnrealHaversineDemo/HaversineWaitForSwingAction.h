@@ -0,0 +1,55 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "Containers/Ticker.h"
+#include "HaversineBlueprintTypes.h"
+#include "HaversineWaitForSwingAction.generated.h"
+
+class UHaversineDemoSubsystem;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHaversineWaitForSwingPin, const FHaversineSwingEvent&, Swing);
+
+/**
+ * Latent Blueprint node that completes when the next swing from a user has been processed.
+ * Listens to `UHaversineDemoSubsystem::OnSwingsProcessed`, so it fires on the game thread in the frame the swing's batch is delivered.
+ */
+UCLASS()
+class UNREALHAVERSINEDEMO_API UHaversineWaitForSwingAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Wait for the next processed swing from a user.
+	 * @param UserId SkyGolf user to wait for, or 0 for a swing from anyone
+	 * @param TimeoutSeconds give up after this long; 0 waits indefinitely
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Haversine", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", DisplayName = "Wait For Next Swing From User"))
+	static UHaversineWaitForSwingAction* WaitForNextSwingFromUser(UObject* WorldContextObject, int64 UserId, float TimeoutSeconds = 0.0f);
+
+	/** The swing arrived */
+	UPROPERTY(BlueprintAssignable)
+	FHaversineWaitForSwingPin OnSwing;
+
+	/** No matching swing before the timeout, or the Haversine subsystem is not running. The swing is empty. */
+	UPROPERTY(BlueprintAssignable)
+	FHaversineWaitForSwingPin OnTimedOut;
+
+	// UBlueprintAsyncActionBase interface
+	virtual void Activate() override;
+
+private:
+	UFUNCTION()
+	void HandleSwings(const TArray<FHaversineSwingEvent>& Swings);
+
+	bool HandleTimeout(float DeltaTime);
+	void Finish();
+
+	TWeakObjectPtr<UHaversineDemoSubsystem> Subsystem;
+	int64 UserId = 0;
+	float TimeoutSeconds = 0.0f;
+	FTSTicker::FDelegateHandle TimeoutHandle;
+};
@@ -12,5 +12,7 @@ public class UnrealHaversineDemo : ModuleRules
 		CppStandard = CppStandardVersion.Cpp20;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "SuperTagKitPlugin" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "HTTP", "HTTPServer", "Json" });
 	}
 }
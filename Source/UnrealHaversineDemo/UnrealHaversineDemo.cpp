@@ -1,7 +1,22 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "UnrealHaversineDemo.h"
+#include "HaversineReplayBenchmark.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, UnrealHaversineDemo, "UnrealHaversineDemo" );
- 
\ No newline at end of file
+class FUnrealHaversineDemoModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		// The earliest point this module runs: before any game instance, SDK manager or swing pipeline thread exists
+		if (FParse::Param(FCommandLine::Get(), FHaversineReplayBenchmark::CountAllocationsSwitch))
+		{
+			FHaversineReplayBenchmark::InstallAllocationCounter();
+		}
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FUnrealHaversineDemoModule, UnrealHaversineDemo, "UnrealHaversineDemo" );
@@ -31,6 +31,22 @@ AUnrealHaversineDemoProjectile::AUnrealHaversineDemoProjectile()
 	InitialLifeSpan = 3.0f;
 }
 
+void AUnrealHaversineDemoProjectile::ReturnToPool()
+{
+	SetLifeSpan(0.0f);
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+	CollisionComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetActorHiddenInGame(true);
+	SetActorTickEnabled(false);
+}
+
+void AUnrealHaversineDemoProjectile::TakeFromPool(const FVector& Location)
+{
+	SetActorLocation(Location, false, nullptr, ETeleportType::TeleportPhysics);
+	SetActorHiddenInGame(false);
+}
+
 void AUnrealHaversineDemoProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
 	// Only add impulse and destroy projectile if we hit a physics
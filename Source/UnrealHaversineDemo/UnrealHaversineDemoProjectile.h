@@ -29,6 +29,15 @@ public:
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	/**
+	 * Take the projectile out of play so it can be reused: hidden, no collision, no movement and no life span.
+	 * Pooled projectiles are moved by whoever owns the pool rather than by ProjectileMovement.
+	 */
+	void ReturnToPool();
+
+	/** Show the projectile at `Location` for its pool owner to move */
+	void TakeFromPool(const FVector& Location);
+
 	/** Returns CollisionComp subobject **/
 	USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/